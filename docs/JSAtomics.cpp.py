@@ -0,0 +1,68 @@
+# Copyright 2016 Nidium Inc. All rights reserved.
+# Use of this source code is governed by a MIT license
+# that can be found in the LICENSE file.
+
+from dokumentor import *
+
+NamespaceDoc( "Atomics", """Atomic operations on integer typed arrays.
+
+Combined with a `SharedArrayBuffer`, it lets the main context and several `Thread` work on the same memory. A `SharedArrayBuffer` (or a typed array using one) given as an argument of `Thread.start` is shared, not copied. When sending a message, the `SharedArrayBuffer` it contains have to be listed in the transfer list of `send`.""",
+    [ SeeDoc( "Thread" ) ],
+    [ ExampleDoc( """var counter = new Int32Array(new SharedArrayBuffer(4));
+var t = new Thread(function(counter) {
+    for (var i = 0; i < 1000; i++) {
+        Atomics.add(counter, 0, 1);
+    }
+});
+t.oncomplete = function() {
+    console.log(Atomics.load(counter, 0));
+};
+t.start(counter);""") ],
+    section="Thread",
+    products=["Frontend", "Server"]
+)
+
+def AtomicsOp( name, desc, params, ret ):
+    FunctionDoc( "Atomics." + name, desc,
+        SeesDocs( "Atomics.load|Atomics.store|Atomics.wait" ),
+        NO_Examples,
+        IS_Static, IS_Public, IS_Fast,
+        [ ParamDoc( "array", "Integer typed array", "TypedArray", NO_Default, IS_Obligated ),
+          ParamDoc( "index", "Index of the element", "integer", NO_Default, IS_Obligated ) ] + params,
+        ret
+    )
+
+ValueParam = [ ParamDoc( "value", "Operand", "integer", NO_Default, IS_Obligated ) ]
+OldValue = ReturnDoc( "The previous value of the element", "integer" )
+
+AtomicsOp( "load", "Read an element.", [], ReturnDoc( "The value of the element", "integer" ) )
+AtomicsOp( "store", "Write an element.", ValueParam, ReturnDoc( "The value written", "integer" ) )
+AtomicsOp( "add", "Add a value to an element.", ValueParam, OldValue )
+AtomicsOp( "sub", "Subtract a value from an element.", ValueParam, OldValue )
+AtomicsOp( "and", "Bitwise and an element with a value.", ValueParam, OldValue )
+AtomicsOp( "or", "Bitwise or an element with a value.", ValueParam, OldValue )
+AtomicsOp( "xor", "Bitwise xor an element with a value.", ValueParam, OldValue )
+AtomicsOp( "exchange", "Replace an element.", ValueParam, OldValue )
+AtomicsOp( "compareExchange", "Replace an element if it's equal to an expected value.",
+    [ ParamDoc( "expected", "Expected value", "integer", NO_Default, IS_Obligated ),
+      ParamDoc( "value", "Replacement value", "integer", NO_Default, IS_Obligated ) ],
+    OldValue )
+
+AtomicsOp( "wait", """Block the thread while an element of a shared Int32Array is equal to a value, until `Atomics.wake` is called for this element or the timeout expires.
+
+Can't be used from the main context, as it would block the event loop.""",
+    [ ParamDoc( "value", "Expected value", "integer", NO_Default, IS_Obligated ),
+      ParamDoc( "timeout", "Timeout in milliseconds", "integer", "Infinity", IS_Optional ) ],
+    ReturnDoc( "'ok' once woken, 'not-equal' if the element didn't have the expected value, 'timed-out'", "string" ) )
+
+AtomicsOp( "wake", "Wake threads waiting on an element of a shared Int32Array (also available as `Atomics.notify`).",
+    [ ParamDoc( "count", "Maximum number of threads to wake", "integer", "Infinity", IS_Optional ) ],
+    ReturnDoc( "Number of threads woken", "integer" ) )
+
+FunctionDoc( "Atomics.isLockFree", "Tell if atomic operations on elements of the given size are lock free.",
+    NO_Sees,
+    NO_Examples,
+    IS_Static, IS_Public, IS_Fast,
+    [ ParamDoc( "size", "Size in bytes", "integer", NO_Default, IS_Obligated ) ],
+    ReturnDoc( "true for 1, 2 and 4", "boolean" )
+)
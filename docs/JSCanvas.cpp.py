@@ -571,6 +571,22 @@ canvas.overflow = false; """)],
     NO_Default
 )
 
+FieldDoc( "Canvas.opaque", """Get or set whether the canvas is opaque.
+
+An opaque canvas promises to cover its whole area with opaque pixels. Canvases below it that are entirely hidden are not composited anymore. The canvas own opacity (and the opacity inherited from its parents) must be 1 for it to hide other canvases.""",
+    SeesDocs( "Canvas.visible|Canvas.opacity|Canvas.overflow" ),
+    [ExampleDoc("""var background = new Canvas(window.innerWidth, window.innerHeight);
+background.opaque = true;
+document.canvas.add(background);
+
+var ctx = background.getContext("2d");
+ctx.fillStyle = "#336699";
+ctx.fillRect(0, 0, background.width, background.height);""")],
+    IS_Dynamic, IS_Public, IS_ReadWrite,
+    "boolean",
+    "false"
+)
+
 FieldDoc("Canvas.scrollable", "Enable or disable scrolling on a canvas.",
     SeesDocs("Canvas.scrollableX|Canvas.scrollableY"),
     [ExampleDoc("""var c = new Canvas(200, 400);
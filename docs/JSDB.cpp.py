@@ -38,6 +38,9 @@ fn(); // Will print "hello world" """)],
     [
         ParamDoc("key", "the key to set", "string", IS_Obligated),
         ParamDoc("value", "the value to set", "any", IS_Obligated),
+        CallbackDoc("callback", "When given, the value is written on a worker thread and the callback is called once done", [
+            ParamDoc("err", "Error message or `null`", "string", NO_Default, IS_Obligated)
+        ])
     ])
 
 FunctionDoc("DB.get", "Get the value for a key",
@@ -48,9 +51,13 @@ db.set("foo", "bar");
 console.log(db.get("foo"));""")],
     IS_Dynamic, IS_Public, IS_Fast,
     [
-        ParamDoc("key", "the key to get", "string", IS_Obligated)
+        ParamDoc("key", "the key to get", "string", IS_Obligated),
+        CallbackDoc("callback", "When given, the value is read on a worker thread and passed to the callback", [
+            ParamDoc("err", "Error message or `null`", "string", NO_Default, IS_Obligated),
+            ParamDoc("value", "The value (`undefined` if the key doesn't exist)", "any", NO_Default, IS_Obligated)
+        ])
     ],
-    ReturnDoc("value", "any"))
+    ReturnDoc("value (when called without callback)", "any"))
 
 FunctionDoc("DB.close", """Force the database to be closed
 
@@ -69,6 +76,7 @@ try {
 }
 
 // It's okay to re-use the same DB once it has been closed
+// (as soon as the pending asynchronous operations are done)
 var otherInstance = new DB("mydb");""")])
 
 FunctionDoc("DB.delete", "Delete a key from the DB",
@@ -81,7 +89,74 @@ console.log(db.get("foo"));
 
 db.delete("foo");
 console.log(db.get("foo"));
-""")])
+""")],
+    IS_Dynamic, IS_Public, IS_Fast,
+    [
+        ParamDoc("key", "the key to delete", "string", IS_Obligated),
+        CallbackDoc("callback", "When given, the key is deleted on a worker thread and the callback is called once done", [
+            ParamDoc("err", "Error message or `null`", "string", NO_Default, IS_Obligated)
+        ])
+    ])
+
+FunctionDoc("DB.batch", """Atomically apply a list of operations
+
+Either all the operations are applied, or none of them.""",
+    [SeeDoc("DB.set"), SeeDoc("DB.delete")],
+    [ExampleDoc("""var DB = require("DB");
+var db = new DB("mydb_batch");
+
+db.batch([
+    {type: "set", key: "foo", value: "bar"},
+    {type: "set", key: "hello", value: {"world": true}},
+    {type: "delete", key: "old"}
+]);
+
+// Asynchronous version
+db.batch([{type: "set", key: "foo", value: "baz"}], function(err) {
+    console.log(err, db.get("foo"));
+});""")],
+    IS_Dynamic, IS_Public, IS_Fast,
+    [
+        ParamDoc("operations", "Array of `{type: \"set\"|\"delete\", key: string, value: any}`", "[Object]", IS_Obligated),
+        CallbackDoc("callback", "When given, the batch is written on a worker thread and the callback is called once done", [
+            ParamDoc("err", "Error message or `null`", "string", NO_Default, IS_Obligated)
+        ])
+    ])
+
+FunctionDoc("DB.range", """Read the entries of a range of keys, in order
+
+All the entries are read from the same consistent view of the database.""",
+    NO_Sees,
+    [ExampleDoc("""var DB = require("DB");
+var db = new DB("mydb_range");
+
+db.set("user:1", "foo");
+db.set("user:2", "bar");
+
+db.range({prefix: "user:"}).forEach(function(entry) {
+    console.log(entry.key, entry.value);
+});
+
+console.log(db.range({start: "user:2", keys: true}));
+
+db.range({prefix: "user:", limit: 10}, function(err, entries) {
+    console.log(entries.length);
+});""")],
+    IS_Dynamic, IS_Public, IS_Fast,
+    [
+        ParamDoc("options", "Range options", ObjectDoc([
+            ("start", "First key of the range (included)", "string"),
+            ("end", "Last key of the range (excluded)", "string"),
+            ("prefix", "Only read the keys starting with `prefix`", "string"),
+            ("limit", "Maximum number of entries", "integer"),
+            ("keys", "Only read the keys", "boolean")
+        ]), NO_Default, IS_Optional),
+        CallbackDoc("callback", "When given, the range is read on a worker thread and passed to the callback", [
+            ParamDoc("err", "Error message or `null`", "string", NO_Default, IS_Obligated),
+            ParamDoc("entries", "Array of `{key, value}` (or of keys)", "[Object]", NO_Default, IS_Obligated)
+        ])
+    ],
+    ReturnDoc("Array of `{key, value}` objects, or of keys when `options.keys` is set (when called without callback)", "[Object]"))
 
 FunctionDoc("DB.drop", "Drop the database (delete it)",
     NO_Sees,
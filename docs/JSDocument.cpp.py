@@ -65,6 +65,28 @@ document.showFPS(true);
     NO_Returns
 )
 
+FunctionDoc( "NidiumDocument.getCompositionStats", "Get the composition counters of the last frame.",
+    SeesDocs( "global.document|NidiumDocument.showFPS|Canvas.opaque" ),
+    [ExampleDoc("""var stats = document.getCompositionStats();
+console.log(stats.composed + " layers, " + stats.culled + " culled, " + stats.pixels + " pixels");
+""")],
+    IS_Static, IS_Public, IS_Fast,
+    NO_Params,
+    ReturnDoc( "Composition counters", ObjectDoc([
+        ("composed", "Number of layers composited on the screen", "integer"),
+        ("culled", "Number of layers skipped because they were hidden by opaque layers", "integer"),
+        ("pixels", "Number of pixels composited (in logical pixels)", "integer"),
+        ("surfaces", "Canvas surfaces cache", ObjectDoc([
+            ("count", "Number of surfaces in the cache", "integer"),
+            ("bytes", "Memory used by the surfaces, in bytes", "integer"),
+            ("hits", "Number of canvases that reused a surface", "integer"),
+            ("misses", "Number of canvases that needed a new surface", "integer"),
+            ("evicted", "Number of unused surfaces released", "integer"),
+            ("evictedBytes", "Memory released by evicting unused surfaces, in bytes", "integer")
+        ]))
+    ]))
+)
+
 FunctionDoc( "NidiumDocument.run", "Run the application.",
     SeesDocs( "global.document|NidiumDocument.showFPS|NidiumDocument.run" ),
     NO_Examples,
@@ -13,6 +13,8 @@ optionParam = ParamDoc("params", "object with details", ObjectDoc([
     ("eval", "Evaluate the data based on the `content-type` header for now only `application/json` and `text/html` are supported, other content-type are converted to an `ArrayBuffer`, `", "boolean", True),
     ("path", "The requested path", "string"),
     ("followLocation", "Follow HTTP redirect", "boolean", False),
+    ("pipeline", "Send the queued `GET` requests without waiting for the previous responses (HTTP/1.1 pipelining)", "boolean", False),
+    ("stream", "Deliver the response body with `data` events instead of buffering it. A number sets the maximum size of a chunk (64KB otherwise)", "boolean|integer", False),
 ]), NO_Default, IS_Optional)
 
 responseEventObject = [
@@ -66,7 +68,11 @@ If `params` and  `callback` arguments are providen the HTTP request will be exec
 
 FunctionDoc( "HTTP.request", """Perform the HTTP request
 
-Once a request is finished (`response` or `error` event has been fired), you can call the `request` method once again to run a new HTTP request. The options from the first request wil be reset.""",
+Once a request is finished (`response` or `error` event has been fired), you can call the `request` method once again to run a new HTTP request. The options from the first request wil be reset.
+
+If a request is still pending, the new request is queued and run once the previous ones are done. The `response` events are fired in the order the requests were made. With the `pipeline` option, queued `GET` requests are sent right away on the same connection; if the server closes the connection, the requests left unanswered are sent again one at a time.
+
+The `callback` and the `eval`, `pipeline` and `stream` options only apply to the request they were given with, even when it's queued.""",
     SeesDocs("HTTP.error|HTTP.progress|HTTP.response|HTTP.stop"),
     [ExampleDoc( """var h = new HTTP("http://www.nidium.com/");
 
@@ -83,9 +89,23 @@ h.addEventListener("response", function(ev) {
 h.request({
     method: "GET",
     headers: {"foo": "bar"}
-});""")],
+});"""),
+    ExampleDoc( """var h = new HTTP("http://www.nidium.com/", {pipeline: true});
+
+h.addEventListener("response", function(ev) {
+    console.log("Received data ", ev.data);
+});
+
+h.request({path: "/a.json"});
+h.request({path: "/b.json"});
+h.request({path: "/c.json"});""", title="Pipelined requests")],
     IS_Dynamic, IS_Public, IS_Fast,
-    [optionParam],
+    [
+        optionParam,
+        CallbackDoc("callback", "Function called on error or when the request is finished", [
+            ParamDoc("event", "Event Object or Error Event Object. See `error` and `response` event. ", ObjectDoc([]))
+        ], NO_Default, IS_Optional)
+    ],
     ReturnDoc( "HTTP instance", "HTTP" )
 )
 
@@ -107,6 +127,68 @@ setImmediate(function() {
     NO_Params,
     ReturnDoc( "HTTP instance", "HTTP" )
 )
+
+FunctionDoc("HTTP.pause", """Stop receiving the response body.
+
+The connection isn't read anymore until `resume` is called, so that the server is slowed down. Only useful with the `stream` option.""",
+    SeesDocs("HTTP.resume|HTTP.data"),
+    [ExampleDoc("""var h = new HTTP("http://www.nidium.com/big.bin", {stream: true});
+
+h.addEventListener("data", function(ev) {
+    h.pause();
+
+    // Write the chunk somewhere slow, then
+    setTimeout(function() {
+        h.resume();
+    }, 100);
+});
+
+h.request();""")],
+    IS_Dynamic, IS_Public, IS_Fast,
+    NO_Params,
+    ReturnDoc( "HTTP instance", "HTTP" )
+)
+
+FunctionDoc("HTTP.resume", "Resume receiving the response body after a call to `pause`.",
+    SeesDocs("HTTP.pause|HTTP.data"),
+    NO_Examples,
+    IS_Dynamic, IS_Public, IS_Fast,
+    NO_Params,
+    ReturnDoc( "HTTP instance", "HTTP" )
+)
+
+FunctionDoc( "HTTP.setPoolOptions", """Configure the pool of keep-alive connections shared by every HTTP instance.
+
+Once a response is received on a keep-alive connection, the connection is kept idle in the pool and reused by the next request to the same host, port and scheme.""",
+    SeesDocs( "HTTP.getPoolStats|HTTP.request" ),
+    [ ExampleDoc( """HTTP.setPoolOptions({
+    idleTimeout: 5000,
+    maxPerHost: 2
+});""") ],
+    IS_Static, IS_Public, IS_Fast,
+    [ ParamDoc( "options", "Pool options", ObjectDoc([
+        ("idleTimeout", "Time in ms after which an idle connection is closed (defaults to 30000)", "integer"),
+        ("maxPerHost", "Maximum number of idle connections kept for a host, 0 disables the pool (defaults to 8)", "integer")
+    ]), NO_Default, IS_Obligated ) ],
+    NO_Returns
+)
+
+FunctionDoc( "HTTP.getPoolStats", "Get statistics about the pool of keep-alive connections.",
+    SeesDocs( "HTTP.setPoolOptions|HTTP.request" ),
+    [ ExampleDoc( """console.log(JSON.stringify(HTTP.getPoolStats()));""") ],
+    IS_Static, IS_Public, IS_Fast,
+    NO_Params,
+    ReturnDoc( "Pool statistics", ObjectDoc([
+        ("created", "Connections opened", "integer"),
+        ("reused", "Requests sent on a pooled connection", "integer"),
+        ("released", "Connections handed to the pool", "integer"),
+        ("expired", "Idle connections closed after the idle timeout", "integer"),
+        ("discarded", "Connections closed because the host had too many idle ones", "integer"),
+        ("closed", "Idle connections closed by the server", "integer"),
+        ("idle", "Connections currently idle", "integer"),
+        ("reuseRate", "Ratio of requests sent on a pooled connection", "float")
+    ]))
+)
 # }}}
 
 # {{{ Events
@@ -162,5 +244,28 @@ EventDoc("HTTP.progress", "Event called whenever new data is received (after the
             ]),  NO_Default, IS_Obligated )
         ]
 )
-# }}}
+EventDoc("HTTP.data", """Event called with a chunk of the response body, when the `stream` option is set.
+
+The body is not buffered : the `response` event is fired once the whole body was received, with a `null` data. At most the `stream` size is kept in memory.""",
+        SeesDocs("HTTP.pause|HTTP.resume|HTTP.response"),
+        [ExampleDoc("""var received = 0;
+var h = new HTTP("http://www.nidium.com/big.bin", {stream: true});
 
+h.addEventListener("data", function(ev) {
+    received += ev.data.byteLength;
+});
+
+h.addEventListener("response", function(ev) {
+    console.log("Received " + received + " bytes");
+});
+
+h.request();""")],
+        [
+            ParamDoc( "event", "Event object", ObjectDoc([
+                ("total","Total bytes (retrieved from the content-length or if no content-length is providen 0) ", "integer"),
+                ("read", "Number of bytes received so far", "integer"),
+                ("data", "Chunk of the response body", "ArrayBuffer")
+            ]),  NO_Default, IS_Obligated )
+        ]
+)
+# }}}
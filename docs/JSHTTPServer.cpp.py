@@ -38,13 +38,33 @@ EventDoc( "HTTPServer.ondata", "Event that fires on data.",
     NO_Params
 )
 
-EventDoc( "HTTPServer.onrequest", "Event that fires when the server has read the complete http request.",
+EventDoc( "HTTPServer.onrequest", """Event that fires when the server has read the complete http request.
+
+With the `stream` option, it fires as soon as the headers are read : the body is then delivered to `request.ondata` and `request.onend`.""",
     [ SeeDoc( "HTTPServer.ondisconnect" ), SeeDoc( "HTTPServer.ondata" ), SeeDoc( "HTTPServer.onrequest" ) ],
     NO_Examples,
     [   ParamDoc( "request", "Client request", "HTTPRequest", NO_Default, IS_Obligated ),
         ParamDoc( "response", "Response object", "HTTPServerResponse", NO_Default, IS_Obligated ) ]
 )
 
+FunctionDoc( "HTTPServer.getStats", "Get the counters of the server.",
+    [ SeeDoc( "HTTPRequest" ) ],
+    [ ExampleDoc( """var http = new HTTPServer("127.0.0.1", 8080);
+http.onrequest = function(request, response) {
+    response.end(request.headers["user-agent"]);
+};
+
+setInterval(function() {
+    console.log(JSON.stringify(http.getStats()));
+}, 1000);""") ],
+    IS_Dynamic, IS_Public, IS_Fast,
+    NO_Params,
+    ReturnDoc( "Object with the counters", ObjectDoc([
+        ("requests", "Number of requests handed to `onrequest`", "integer"),
+        ("strings", "Number of strings created for the requests (headers, url and data actually accessed)", "integer")
+    ]))
+)
+
 ConstructorDoc( "HTTPServer", "Constructor for HTTPServer object.",
     NO_Sees,
     NO_Examples,
@@ -54,6 +74,7 @@ ConstructorDoc( "HTTPServer", "Constructor for HTTPServer object.",
         ParamDoc("options", "HTTPServer options",
             ObjectDoc([
                 ("reusePort", "Allows multiple HTTPServer to bind to the same port,", "boolean", 'false'),
+                ("stream", "Deliver request bodies in chunks (`HTTPRequest.ondata`) instead of buffering them in `HTTPRequest.data`", "boolean", 'false'),
         ]), NO_Default, IS_Optional)
     ],
     ReturnDoc( "HTTPServer instance", "HTTPServer" )
@@ -61,7 +82,9 @@ ConstructorDoc( "HTTPServer", "Constructor for HTTPServer object.",
 # }}}
 
 # {{{ HTTPRequest
-ClassDoc( "HTTPRequest", "HTTP request object spawned by HTTPServer.",
+ClassDoc( "HTTPRequest", """HTTP request object spawned by HTTPServer.
+
+Its properties are only converted to JS values when they are first accessed : handlers that only look at a few headers don't pay for the others.""",
     [ SeeDoc( "HTTPServer" ), SeeDoc( "Socket" ), SeeDoc( "Http" ) ],
     NO_Examples,
     NO_Inherrits,
@@ -69,12 +92,12 @@ ClassDoc( "HTTPRequest", "HTTP request object spawned by HTTPServer.",
     section="HTTP Client & Server",
 )
 
-FieldDoc( "HTTPRequest.method", "Http request Method that was received. Can be 'POST'|'GET'|'PUT'|'DELETE'|'UNKNOWN'.",
+FieldDoc( "HTTPRequest.method", "Http request Method that was received (e.g. 'GET'|'POST'|'PUT'|'DELETE'|'PATCH'|'OPTIONS').",
     [ SeeDoc( "HTTPRequest.data" ), SeeDoc( "HTTPRequest.method" ), SeeDoc( "HTTPRequest.headers" ), SeeDoc( "HTTPRequest.client" ), SeeDoc( "HTTPRequest.url" ) ],
     NO_Examples,
     IS_Dynamic, IS_Public, IS_Readonly,
     'string',
-    "UNKNOWN"
+    NO_Default
 )
 
 FieldDoc( "HTTPRequest.url", "The url that was requested.",
@@ -90,7 +113,38 @@ FieldDoc( "HTTPRequest.data", "The data (utf-8') that was received by the server
     NO_Examples,
     IS_Dynamic, IS_Public, IS_Readonly,
     'string',
-    'null, if it was a non POST method'
+    "undefined if the request has no body (an empty string for 'POST'|'PUT'|'PATCH'), or if the server was created with the `stream` option"
+)
+
+EventDoc( "HTTPRequest.ondata", """Event that fires with a chunk of the request body, when the server was created with the `stream` option.
+
+The body is not buffered. Call `request.client.pause()` to stop reading the request until `request.client.resume()` is called, the client is then slowed down by TCP flow control.""",
+    [ SeeDoc( "HTTPRequest.onend" ), SeeDoc( "HTTPServerClientConnection.pause" ), SeeDoc( "HTTPServer" ) ],
+    [ ExampleDoc( """var http = new HTTPServer("127.0.0.1", 8080, {stream: true});
+http.onrequest = function(request, response) {
+    var received = 0;
+
+    request.ondata = function(data) {
+        received += data.byteLength;
+
+        // Write the chunk somewhere slow
+        request.client.pause();
+        setTimeout(function() {
+            request.client.resume();
+        }, 10);
+    };
+
+    request.onend = function() {
+        response.end("Received " + received + " bytes");
+    };
+};""") ],
+    [ ParamDoc( "data", "Chunk of the body", "ArrayBuffer", NO_Default, IS_Obligated ) ]
+)
+
+EventDoc( "HTTPRequest.onend", "Event that fires once the whole request body was delivered to `HTTPRequest.ondata` (`stream` option only).",
+    [ SeeDoc( "HTTPRequest.ondata" ) ],
+    NO_Examples,
+    NO_Params
 )
 
 FieldDoc( "HTTPRequest.headers", "An object of key/value pairs describing the headers.",
@@ -110,6 +164,32 @@ FieldDoc( "HTTPRequest.client", "An object that describes the connected client."
 )
 # }}}
 
+# {{{ HTTPServerClientConnection
+ClassDoc( "HTTPServerClientConnection", "Connection of a client to an HTTPServer (`HTTPRequest.client`).",
+    [ SeeDoc( "HTTPServer" ), SeeDoc( "HTTPRequest" ) ],
+    NO_Examples,
+    NO_Inherrits,
+    NO_Extends,
+    section="HTTP Client & Server",
+)
+
+FunctionDoc( "HTTPServerClientConnection.pause", "Stop reading from the client until `resume` is called. Nothing is received meanwhile and the connection doesn't time out.",
+    [ SeeDoc( "HTTPServerClientConnection.resume" ), SeeDoc( "HTTPRequest.ondata" ) ],
+    NO_Examples,
+    IS_Dynamic, IS_Public, IS_Fast,
+    NO_Params,
+    NO_Returns
+)
+
+FunctionDoc( "HTTPServerClientConnection.resume", "Resume reading from the client after a call to `pause`.",
+    [ SeeDoc( "HTTPServerClientConnection.pause" ), SeeDoc( "HTTPRequest.ondata" ) ],
+    NO_Examples,
+    IS_Dynamic, IS_Public, IS_Fast,
+    NO_Params,
+    NO_Returns
+)
+# }}}
+
 # {{{ HTTPServerResponse
 NamespaceDoc( "HTTPServerResponse", "Object for handling HTTP response",
     SeesDocs( "HTTPServer|HTTPRequest|HTTP" ),
@@ -143,4 +223,29 @@ FunctionDoc( "HTTPServerResponse.writeHead", "Set the headers on a response to a
       ParamDoc( "kvpairs", "Header data object", ObjectDoc([]), IS_Optional ) ],
     NO_Returns
 )
+
+FunctionDoc( "HTTPServerResponse.sendFile", """Respond with the content of a file.
+
+The headers are sent, then the file is sent by the kernel (`sendfile()`) as the client reads it, without going through the JS heap.
+
+When the whole file is sent, the `Range` header of the request is honoured : a single byte range is answered with a `206 Partial Content` response, an unsatisfiable one with `416`.
+
+> Requests received on the same connection are processed once the file is sent.""",
+    [ SeeDoc( "HTTPServer" ), SeeDoc( "HTTPServerResponse.end" ), SeeDoc( "HTTPServerResponse.writeHead" ) ],
+    [ ExampleDoc( """var server = new HTTPServer("0.0.0.0", 8080);
+server.onrequest = function(req, res) {
+    if (!res.sendFile("static/video.mp4", {headers: {"Content-Type": "video/mp4"}})) {
+        res.writeHead(404);
+        res.end();
+    }
+}""" ) ],
+    IS_Dynamic, IS_Public, IS_Fast,
+    [ ParamDoc( "path", "Path of the file", "string", NO_Default, IS_Obligated ),
+      ParamDoc( "options", "Options", ObjectDoc([
+            ("offset", "Offset of the first byte to send", "integer"),
+            ("length", "Number of bytes to send (up to the end of the file by default)", "integer"),
+            ("headers", "Headers of the response", "Object")
+        ]), NO_Default, IS_Optional ) ],
+    ReturnDoc( "`false` if the file can't be sent (e.g. it doesn't exist). Nothing was sent to the client in that case.", "boolean" )
+)
 # }}}
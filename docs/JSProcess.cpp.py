@@ -94,3 +94,56 @@ FunctionDoc( "NidiumProcess.cwd", "Get the current working directory.",
 )
 
 
+
+FunctionDoc( "NidiumProcess.getStats", "Get internal performance counters of the process.",
+    SeesDocs( "NidiumProcess|global.process" ),
+    [ExampleDoc( """console.log(JSON.stringify(process.getStats()));""" )],
+    IS_Dynamic, IS_Public, IS_Fast,
+    NO_Params,
+    ReturnDoc( "Object with the counters", ObjectDoc([
+        ("pool", "Message and task allocation pool", ObjectDoc([
+            ("allocated", "Number of objects allocated with malloc()", "integer"),
+            ("reused", "Number of allocations avoided by recycling an object", "integer"),
+            ("reusedPerSec", "Allocations avoided per second since the previous call (from the same thread)", "float")
+        ])),
+        ("messages", "Messages delivered by the event loop", ObjectDoc([
+            ("ticks", "Number of times the message queue was drained", "integer"),
+            ("handled", "Number of messages handled", "integer"),
+            ("countBudgetExhausted", "Number of ticks stopped by the message count budget", "integer"),
+            ("timeBudgetExhausted", "Number of ticks stopped by the time budget", "integer"),
+            ("statsEnabled", "Whether the per event counters are collected (see `NidiumProcess.setMessagesStats`)", "boolean"),
+            ("events", "Counters keyed by receiver class and event id (`Class:event`, `other` once the table is full) with `count`, `perSec`, `avgLatency` and `maxLatency` in ms", "Object")
+        ])),
+        ("cpu", "CPU time used by the process since it started", ObjectDoc([
+            ("user", "Time spent in user mode in ms", "float"),
+            ("system", "Time spent in the kernel in ms", "float")
+        ]))
+    ]))
+)
+
+FunctionDoc( "NidiumProcess.setMessagesBudget", """Limit the amount of work done on each event loop iteration to deliver native messages (file, socket, thread completions...).
+
+Lower values improve fairness with other events (timers, I/O), higher values improve throughput under bursts.""",
+    SeesDocs( "NidiumProcess|global.process|NidiumProcess.getStats" ),
+    [ExampleDoc( """// At most 64 messages or 4ms per iteration
+process.setMessagesBudget(64, 4);""" )],
+    IS_Dynamic, IS_Public, IS_Fast,
+    [
+        ParamDoc( "count", "Maximum number of messages per iteration", "integer", NO_Default, IS_Obligated ),
+        ParamDoc( "time", "Maximum time spent per iteration in ms (0 for no limit)", "float", 0, IS_Optional )
+    ],
+    NO_Returns
+)
+
+FunctionDoc( "NidiumProcess.setMessagesStats", """Enable or disable the per event counters reported by `NidiumProcess.getStats`.
+
+They are disabled by default since they time every message.""",
+    SeesDocs( "NidiumProcess|global.process|NidiumProcess.getStats" ),
+    [ExampleDoc( """process.setMessagesStats(true);
+setTimeout(function() {
+    console.log(JSON.stringify(process.getStats().messages.events));
+}, 1000);""" )],
+    IS_Dynamic, IS_Public, IS_Fast,
+    [ ParamDoc( "enable", "Whether to collect the counters", "boolean", NO_Default, IS_Obligated ) ],
+    NO_Returns
+)
@@ -62,6 +62,29 @@ socket.onread = function(clientSocket, data) {
     NO_Default
 )
 
+FieldDoc( "Socket.bufferPool", """Get or set the number of pooled receive buffers of a binary socket.
+
+By default, a new 'ArrayBuffer' is allocated for every packet received in binary mode.
+When 'Socket.bufferPool' is set to 'true' (64 buffers) or to a number of buffers, received data is instead copied into one of the pooled 64KB buffers and 'Socket.onread' (or 'Socket.onmessage') is called with an 'Uint8Array' view over it.
+Received data is still copied once : the pool saves the allocation of a new 'ArrayBuffer' (and the garbage collection that follows), not the copy.
+
+The buffer must be given back with 'Socket.release' once the data has been processed, its content is then overwritten by the next packets.
+When every buffer is in use, a non-pooled 'Uint8Array' is handed instead.
+
+On a listening socket, the pool is shared by every connected client.""",
+    SeesDocs( "Socket.binary|Socket.release|Socket.getBufferPoolStats|Socket" ),
+     [ ExampleDoc( """var socket = new Socket("0.0.0.0", 8001).listen()
+socket.binary = true;
+socket.bufferPool = true;
+socket.onread = function(clientSocket, data) {
+    clientSocket.write(data); // data is an Uint8Array
+    this.release(data);
+}""") ],
+    IS_Dynamic, IS_Public, IS_ReadWrite,
+    'boolean|integer',
+    'false'
+)
+
 FieldDoc( "Socket.timeout", """Get or set the timeout on a socket connection.""",
     #@TODO: what is 0? what is the unit? ms/sec
     SeesDocs( "Socket.encoding|Socket.timeout|Socket.readline|Socket.binary|Socket" ),
@@ -78,7 +101,7 @@ For instance, if an endpoint sends "hello" it doesn't mean you can't receive the
 The 'readline' property tells the socket to set boundaries around the newline char (\\n).
 This is particularly useful to design simple protocols like IRC which are line-based.
 
-The maximum length of a line is internally set to 8192 bytes.""",
+Incomplete lines are buffered until the delimiter is received. A line can't exceed 16MB, the connection is closed otherwise.""",
     SeesDocs( "Socket.encoding|Socket.onread|Socket.readline|Socket.binary|Socket" ),
     [ExampleDoc("""var socket = new Socket("irc.freenode.org", 6667).connect();
 socket.readline = true;
@@ -97,6 +120,52 @@ socket.onread = function(data) {
     'boolean',
     NO_Default
 )
+FieldDoc( "Socket.framing", """Reassemble messages of a binary protocol before calling 'Socket.onread'.
+
+Like 'Socket.readline', the data is buffered until a whole message is received and 'Socket.onread' is called once per message (with a string or a buffer depending on 'Socket.binary').
+Allowed values are:
+
+* 'uint16be'|'uint16le'|'uint32be'|'uint32le' : each message is prefixed by its length, as an unsigned big or little endian integer. The prefix is not part of the data handed to 'Socket.onread'.
+* a number : fixed size records of that many bytes.
+* 'readline' : same as setting 'Socket.readline' to 'true' (the delimiter previously given to 'Socket.readline' is kept).
+* 'null' : framing is disabled.
+
+A message can't exceed 16MB, the connection is closed otherwise.
+When 'Socket.readline' is enabled, the property reads 'readline'.""",
+    SeesDocs( "Socket.readline|Socket.binary|Socket.onread|Socket" ),
+    [ExampleDoc("""var socket = new Socket("127.0.0.1", 6667).connect();
+socket.binary = true;
+socket.framing = "uint32be";
+socket.onread = function(data) {
+    // data is a whole message, without its length prefix
+    console.log("=>", data.byteLength);
+}""") ],
+    IS_Dynamic, IS_Public, IS_ReadWrite,
+    'string|integer',
+    'null'
+)
+
+FieldDoc( "Socket.coalesce", """Hand the data received during an event loop iteration to a single 'Socket.onread' call.
+
+When many small packets (or messages, see 'Socket.readline' and 'Socket.framing') are received at once, calling 'Socket.onread' for each of them can be costly.
+When 'Socket.coalesce' is set to 'true', 'Socket.onread' is called once at the end of the loop iteration, with an array of all the received data instead.
+Writes issued from 'Socket.onread' are sent at once when the callback returns.
+
+The number of calls saved is reported by 'Socket.getReadStats'.""",
+    SeesDocs( "Socket.onread|Socket.getReadStats|Socket.framing|Socket" ),
+    [ExampleDoc("""var socket = new Socket("0.0.0.0", 8001).listen();
+socket.readline = true;
+socket.coalesce = true;
+socket.onread = function(clientSocket, lines) {
+    for (var i = 0; i < lines.length; i++) {
+        clientSocket.write(lines[i] + "\\n");
+    }
+}""") ],
+    IS_Dynamic, IS_Public, IS_ReadWrite,
+    'boolean',
+    'false'
+)
+
 FieldDoc( "Socket.encoding", """The encoding to read non-binary data.
 
 When the 'Socket.binary' property is set to 'false' (its default value), the 'Socket.encoding' property defines the encoding of received data.
@@ -243,7 +312,7 @@ In order to avoid high memory usage, one should stop calling 'Socket.write' when
     SeesDocs( "Socket.listen|SocketClient.sendFile|SocketClient.write|SocketClient.disconnect|HTTPServer" ).append( "Socket.write " ),
     NO_Examples,
     IS_Dynamic, IS_Public, IS_Fast,
-    [ParamDoc( 'data', "data to send", "string|ArrayBuffer", NO_Default, IS_Obligated ) ],
+    [ParamDoc( 'data', "data to send", "string|ArrayBuffer|ArrayBufferView", NO_Default, IS_Obligated ) ],
     ReturnDoc( "bytes written", "integer" )
 )
 
@@ -251,7 +320,7 @@ FunctionDoc( "Socket.write", "Write data.",
     SeesDocs( "Socket.listen|Socket.connect|Socket.write|Socket.disconnect|Socket.SendTo|SocketClient.write|SocketClient.disconnect|HTTPServer" ),
     NO_Examples,
     IS_Dynamic, IS_Public, IS_Fast,
-    [ParamDoc( 'data', "data to send", "string|ArrayBuffer", NO_Default, IS_Obligated ) ],
+    [ParamDoc( 'data', "data to send", "string|ArrayBuffer|ArrayBufferView", NO_Default, IS_Obligated ) ],
     ReturnDoc( "bytes written", "integer" )
 )
 
@@ -301,3 +370,40 @@ s.onaccept = function(clientSocket) {
     NO_Returns
 )
 
+FunctionDoc( "Socket.release", """Give back a buffer received from a pooled socket.
+
+The data must not be used after it has been released.""",
+    SeesDocs( "Socket.bufferPool|Socket.getBufferPoolStats" ),
+    NO_Examples,
+    IS_Dynamic, IS_Public, IS_Fast,
+    [ParamDoc( "data", "The data received by 'Socket.onread' or 'Socket.onmessage'", "Uint8Array", NO_Default, IS_Obligated ) ],
+    ReturnDoc( "true if the buffer belongs to the pool of the socket", "boolean" )
+)
+
+FunctionDoc( "Socket.getBufferPoolStats", "Get statistics about the receive buffer pool.",
+    SeesDocs( "Socket.bufferPool|Socket.release" ),
+    NO_Examples,
+    IS_Dynamic, IS_Public, IS_Fast,
+    NO_Params,
+    ReturnDoc( "Statistics, or null if the pool isn't enabled", ObjectDoc([
+        ("count", "Number of buffers in the pool", "integer"),
+        ("inUse", "Number of buffers not released yet", "integer"),
+        ("reused", "Number of packets received in an already allocated buffer", "integer"),
+        ("allocated", "Number of pooled buffers allocated", "integer"),
+        ("fallback", "Number of packets received in a non-pooled buffer", "integer"),
+        ("released", "Number of buffers released", "integer"),
+        ("bytes", "Number of bytes received", "integer")
+    ]), nullable=True )
+)
+
+FunctionDoc( "Socket.getReadStats", "Get statistics about the data handed to 'Socket.onread'. On a listening socket, the statistics of every connected client are included.",
+    SeesDocs( "Socket.coalesce|Socket.onread" ),
+    NO_Examples,
+    IS_Dynamic, IS_Public, IS_Fast,
+    NO_Params,
+    ReturnDoc( "Statistics", ObjectDoc([
+        ("messages", "Number of packets (or messages) received", "integer"),
+        ("callbacks", "Number of 'Socket.onread' calls", "integer"),
+        ("saved", "Number of 'Socket.onread' calls saved by 'Socket.coalesce'", "integer")
+    ]) )
+)
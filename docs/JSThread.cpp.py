@@ -12,7 +12,9 @@ NamespaceDoc( "_GLOBALThread", "Global threadnamespace.",
 
 ClassDoc( "Thread", """Run a CPU intensive task in the background, with out locking the main UI interface.
 
-This will run in a separate JS Runtime, which requires some cpu and memory overhead.""",
+This will run in a separate JS Runtime, which requires some cpu and memory overhead.
+
+Jobs are run by a pool of worker threads which keep their JS Runtime (and the functions they compiled) between jobs. Jobs don't share any state : globals defined by a job are removed once it's done. When every worker is busy, the job is run in a dedicated thread.""",
     [ SeeDoc( "_GLOBALThread" ), SeeDoc( "ThreadMessageEvent" ) ],
     [ExampleDoc( """var t = new Thread(function(foo){
    // something loud and heavy
@@ -60,23 +62,98 @@ t.start(5, 6, 6, 9);
     NO_Returns
 )
 
+FunctionDoc( "Thread.startWithTransfer", """Start a thread, moving the ArrayBuffers listed in `transfer` to it rather than copying them.
+
+They are detached once the thread is started and can't be used by the caller afterward.""",
+    SeesDocs( "Thread.start|_GLOBALThread.transferOnComplete" ),
+    [ ExampleDoc( """var pixels = new ArrayBuffer(1920 * 1080 * 4);
+var t = new Thread(function(pixels, width) {
+    // process the image
+    return pixels.byteLength;
+});
+t.oncomplete = function(event) {
+    console.log(event.data, pixels.byteLength); // 8294400 0
+};
+t.startWithTransfer([pixels, 1920], [pixels]);""" ) ],
+    IS_Dynamic, IS_Public, IS_Fast,
+    [ ParamDoc( "args", "Arguments of the function", "[any]", NO_Default, IS_Obligated ),
+      ParamDoc( "transfer", "ArrayBuffers (found in `args`) to transfer rather than copy", "[ArrayBuffer]", NO_Default, IS_Optional ) ],
+    NO_Returns
+)
+
 EventDoc( "Thread.onmessage", "Function that will be called when the thread posts a message.",
     SeesDocs( "Thread.oncomplete|Thread.onmessage" ),
     NO_Examples,
     [ ParamDoc( "event", "event object", ObjectDoc([("data", "The message data", "string")]), NO_Default, IS_Obligated ) ]
 )
 
-EventDoc( "Thread.oncomplete", "Function that will be called when the thread is complete.",
+EventDoc( "Thread.oncomplete", "Function that will be called when the thread is complete. `data` is `undefined` if the value returned by the thread can't be cloned (e.g. a function).",
     SeesDocs( "Thread.oncomplete|Thread.onmessage" ),
     NO_Examples,
     [ ParamDoc( "event", "event object", ObjectDoc([("data", "The message data", "string")]), NO_Default, IS_Obligated ) ]
 )
 
-FunctionDoc( "_GLOBALThread.send", "Send a message to a thread.",
-    NO_Sees,
-    NO_Examples,
+FunctionDoc( "_GLOBALThread.send", """Send a message to a thread.
+
+The ArrayBuffers listed in `transfer` are moved to the main thread without being copied. They can't be used by the thread afterward.
+
+A `SharedArrayBuffer` listed in `transfer` is shared with the main thread instead. The `message` itself is shared if it's a `SharedArrayBuffer` or a typed array using one, other `SharedArrayBuffer` found in `message` have to be listed in `transfer`.""",
+    SeesDocs( "_GLOBALThread.transferOnComplete" ),
+    [ ExampleDoc( """var t = new Thread(function() {
+    var buffer = new ArrayBuffer(16 * 1024 * 1024);
+    // fill the buffer
+    this.send(buffer, [buffer]);
+});
+t.onmessage = function(event) {
+    console.log(event.data.byteLength);
+};
+t.start();""") ],
     IS_Static, IS_Public, IS_Fast,
-    NO_Params,
+    [ ParamDoc( "message", "Message to send", "any", NO_Default, IS_Obligated ),
+      ParamDoc( "transfer", "ArrayBuffers to transfer (or SharedArrayBuffers to share) rather than copy", "[ArrayBuffer]", NO_Default, IS_Optional ) ],
     NO_Returns
 )
 
+FunctionDoc( "_GLOBALThread.transferOnComplete", """Set the ArrayBuffers to transfer (rather than copy) along with the value returned by the thread.
+
+They can't be used by the thread afterward.""",
+    SeesDocs( "_GLOBALThread.send|Thread.oncomplete" ),
+    [ ExampleDoc( """var t = new Thread(function() {
+    var buffer = new ArrayBuffer(16 * 1024 * 1024);
+    this.transferOnComplete([buffer]);
+    return buffer;
+});
+t.oncomplete = function(event) {
+    console.log(event.data.byteLength);
+};
+t.start();""") ],
+    IS_Static, IS_Public, IS_Fast,
+    [ ParamDoc( "transfer", "ArrayBuffers to transfer", "[ArrayBuffer]", NO_Default, IS_Obligated ) ],
+    NO_Returns
+)
+
+FunctionDoc( "Thread.setPoolSize", "Set the maximum number of worker threads kept alive to run jobs. Idle workers over the limit are stopped.",
+    SeesDocs( "Thread.getPoolStats|Thread.start" ),
+    [ ExampleDoc( """// Run every job in its own thread
+Thread.setPoolSize(0);""") ],
+    IS_Static, IS_Public, IS_Fast,
+    [ ParamDoc( "size", "Number of workers (0 disables the pool, defaults to 4)", "integer", NO_Default, IS_Obligated ) ],
+    NO_Returns
+)
+
+FunctionDoc( "Thread.getPoolStats", "Get statistics about the worker threads pool.",
+    SeesDocs( "Thread.setPoolSize|Thread.start" ),
+    [ ExampleDoc( """console.log(JSON.stringify(Thread.getPoolStats()));""") ],
+    IS_Static, IS_Public, IS_Fast,
+    NO_Params,
+    ReturnDoc( "Pool statistics", ObjectDoc([
+        ("size", "Maximum number of workers", "integer"),
+        ("workers", "Running workers", "integer"),
+        ("idle", "Workers waiting for a job", "integer"),
+        ("jobs", "Jobs run by a worker", "integer"),
+        ("reused", "Jobs run by an already warm worker", "integer"),
+        ("spawned", "Workers created", "integer"),
+        ("dedicated", "Jobs run in a dedicated thread because the pool was full", "integer"),
+        ("cacheHits", "Jobs whose function was already compiled by the worker", "integer")
+    ]))
+)
@@ -163,6 +163,7 @@
             '<(nidium_src_path)/Graphics/GLState.cpp',
             '<(nidium_src_path)/Graphics/CanvasContext.cpp',
             '<(nidium_src_path)/Graphics/CanvasHandler.cpp',
+            '<(nidium_src_path)/Graphics/DamageTracker.cpp',
             '<(nidium_src_path)/Graphics/Canvas3DContext.cpp',
             '<(nidium_src_path)/Graphics/SkiaContext.cpp',
             '<(nidium_src_path)/Graphics/SurfaceCache.cpp',
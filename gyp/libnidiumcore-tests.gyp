@@ -15,6 +15,7 @@
         'sources': [
             '<(nidium_tests_path)unittest.cpp',
             '<(nidium_tests_path)args.cpp',
+            '<(nidium_tests_path)audioprocessor.cpp',
             '<(nidium_tests_path)db.cpp',
             '<(nidium_tests_path)events.cpp',           #dummy
             '<(nidium_tests_path)file.cpp',             #dummy
@@ -27,9 +28,10 @@
             '<(nidium_tests_path)nfs.cpp',              #dummy
             '<(nidium_tests_path)nfsstream.cpp',        #dummy
             '<(nidium_tests_path)path.cpp',
+            '<(nidium_tests_path)pool.cpp',
             '<(nidium_tests_path)sharedmessages.cpp',   #dummy
             '<(nidium_tests_path)streaminterface.cpp',  #dummy
-            #'<(nidium_tests_path)taskmanager.cpp',     #segfault
+            '<(nidium_tests_path)taskmanager.cpp',
             '<(nidium_tests_path)utils.cpp',
 
             '<(nidium_tests_path)nidiumjs.cpp',         #dummy
@@ -129,9 +129,11 @@
         'sources': [
             '<(third_party_path)/jsoncpp/dist/jsoncpp.cpp',
             '../src/Net/HTTP.cpp',
+            '../src/Net/HTTPConnectionPool.cpp',
             '../src/Net/HTTPParser.cpp',
             '../src/Net/HTTPServer.cpp',
             '../src/Net/HTTPStream.cpp',
+            '../src/Net/TimerWheel.cpp',
             '../src/Net/WebSocket.cpp',
             '../src/Net/WebSocketClient.cpp',
 
@@ -145,6 +147,8 @@
             '../src/Binding/JSModules.cpp',
             '../src/Binding/JSSocket.cpp',
             '../src/Binding/JSThread.cpp',
+            '../src/Binding/JSThreadPool.cpp',
+            '../src/Binding/JSAtomics.cpp',
             '../src/Binding/JSDebug.cpp',
             '../src/Binding/JSDebugger.cpp',
             '../src/Binding/JSConsole.cpp',
@@ -160,6 +164,7 @@
             '../src/Binding/JSVM.cpp',
 
             '../src/Core/SharedMessages.cpp',
+            '../src/Core/Pool.cpp',
             '../src/Core/Utils.cpp',
             '../src/Core/Messages.cpp',
             '../src/Core/DB.cpp',
@@ -90,6 +90,8 @@ AVStreamReader::AVStreamReader(const char *src,
     : m_Source(source), m_ReadCallback(readCallback),
       m_CallbackPrivate(callbackPrivate),  m_GenesisThread(pthread_self())
 {
+    this->setStatsName("AVStreamReader");
+
     m_Async  = true;
     m_Stream = Stream::Create(Path(src));
     if (!m_Stream) {
@@ -434,6 +436,7 @@ AVSource::AVSource()
       m_MainCoro(NULL), m_Seeking(false), m_DoSemek(false), m_DoSeekTime(0.0f),
       m_SeekFlags(0), m_Error(0), m_SourceDoOpen(false)
 {
+    this->setStatsName("AVSource");
 }
 
 AVDictionary *AVSource::getMetadata()
@@ -174,11 +174,17 @@ void *Audio::queueThread(void *args)
                 // Copy output node frame data to output ring buffer
                 // XXX : Find a more efficient way to copy data to output right
                 // buffer
+                for (int j = 0; j < audio->m_OutputParameters->m_Channels;
+                     j++) {
+                    AudioVector::Scale(
+                        audio->m_Output->m_Frames[j], audio->m_volume,
+                        audio->m_OutputParameters->m_FramesPerBuffer);
+                }
+
                 for (int i = 0;
                      i < audio->m_OutputParameters->m_FramesPerBuffer; i++) {
                     for (int j = 0; j < audio->m_OutputParameters->m_Channels;
                          j++) {
-                        audio->m_Output->m_Frames[j][i] *= audio->m_volume;
                         PaUtil_WriteRingBuffer(audio->m_rBufferOut,
                                                &audio->m_Output->m_Frames[j][i],
                                                1);
@@ -412,10 +412,8 @@ void AudioNode::processQueue()
                       this));
                 SPAM(("    frames=%p from %p\n", m_Frames[i],
                       m_Input[i]->wire[j]->m_Frame));
-                for (int k = 0;
-                     k < m_Audio->m_OutputParameters->m_FramesPerBuffer; k++) {
-                    m_Frames[i][k] += m_Input[i]->wire[j]->m_Frame[k];
-                }
+                AudioVector::Mix(m_Frames[i], m_Input[i]->wire[j]->m_Frame,
+                                 m_Audio->m_OutputParameters->m_FramesPerBuffer);
             }
             NODE_IO_FOR_END(j)
         }
@@ -438,10 +436,8 @@ void AudioNode::processQueue()
             int j = 0;
             NODE_IO_FOR(j, m_Output[i])
             if (m_Output[i]->wire[j]->m_Frame != m_Frames[i]) {
-                for (int k = 0;
-                     k < m_Audio->m_OutputParameters->m_FramesPerBuffer; k++) {
-                    m_Output[i]->wire[j]->m_Frame[k] = m_Frames[i][k];
-                }
+                AudioVector::Copy(m_Output[i]->wire[j]->m_Frame, m_Frames[i],
+                                  m_Audio->m_OutputParameters->m_FramesPerBuffer);
             }
             NODE_IO_FOR_END(j)
         }
@@ -807,6 +803,8 @@ AudioSource::AudioSource(int out, Audio *audio, bool external)
       m_AvioBuffer(NULL), m_fBufferInData(NULL), m_fBufferOutData(NULL),
       m_rBufferOutData(NULL), m_Buffering(false)
 {
+    this->setStatsName("AudioSource");
+
     m_DoSemek = false;
     m_Seeking = false;
 
@@ -1798,9 +1796,5 @@ bool AudioSourceCustom::isActive()
 }
 // }}}
 
-// {{{ AudioProcessor
-AudioProcessor::~AudioProcessor(){};
-// }}}
-
 } // namespace AV
 } // namespace Nidium
@@ -15,6 +15,7 @@
 
 #include "AV.h"
 #include "Audio.h"
+#include "AudioProcessor.h"
 
 #define NIDIUM_AUDIO_NODE_ARGS_SIZE 32
 #define NIDIUM_AUDIO_NODE_WIRE_SIZE 256
@@ -433,15 +434,6 @@ public:
 };
 // }}}
 
-// {{{ AudioProcessor
-class AudioProcessor
-{
-public:
-    virtual void process(float *in, int *i) = 0;
-    virtual ~AudioProcessor() = 0;
-};
-// }}}
-
 // {{{ AudioNodeProcessor
 class AudioNodeProcessor : public AudioNode
 {
@@ -482,17 +474,16 @@ public:
 
     bool process()
     {
-        for (int i = 0; i < m_Audio->m_OutputParameters->m_FramesPerBuffer;
-             i++) {
-            for (int j = 0; j < m_InCount; j++) {
-                for (int k = 0; k < NIDIUM_AUDIO_NODE_CHANNEL_SIZE; k++) {
-                    AudioProcessor *p = m_Processor[m_Input[j]->m_Channel][k];
-                    if (p != NULL) {
-                        p->process(&m_Frames[m_Input[j]->m_Channel][i], &i);
-                    } else {
-                        break;
-                    }
+        int frames = m_Audio->m_OutputParameters->m_FramesPerBuffer;
+
+        for (int j = 0; j < m_InCount; j++) {
+            int channel = m_Input[j]->m_Channel;
+            for (int k = 0; k < NIDIUM_AUDIO_NODE_CHANNEL_SIZE; k++) {
+                AudioProcessor *p = m_Processor[channel][k];
+                if (p == NULL) {
+                    break;
                 }
+                p->process(m_Frames[channel], frames);
             }
         }
         return true;
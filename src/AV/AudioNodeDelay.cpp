@@ -18,26 +18,37 @@ AudioNodeDelay::AudioNodeDelay(int inCount, int outCount, Audio *audio)
     m_Args[2] = new ExportsArgs("feedback", DOUBLE, FEEDBACK,
                                 AudioNodeDelay::argCallback);
 
-    m_DelayProcessor = new AudioProcessorDelay(
-        m_Audio->m_OutputParameters->m_SampleRate, 2000);
+    for (int i = 0; i < 2; i++) {
+        m_DelayProcessor[i] = new AudioProcessorDelay(
+            m_Audio->m_OutputParameters->m_SampleRate, 2000);
 
-    this->setProcessor(0, m_DelayProcessor);
-    this->setProcessor(1, m_DelayProcessor);
+        this->setProcessor(i, m_DelayProcessor[i]);
+    }
 }
 
 void AudioNodeDelay::argCallback(AudioNode *node, int id, void *tmp, int size)
 {
     AudioNodeDelay *thiz = static_cast<AudioNodeDelay *>(node);
-    switch (id) {
-        case DELAY:
-            thiz->m_DelayProcessor->setDelay(*static_cast<int *>(tmp));
-            break;
-        case WET:
-            thiz->m_DelayProcessor->setWet(*static_cast<double *>(tmp));
-            break;
-        case FEEDBACK:
-            thiz->m_DelayProcessor->setFeedback(*static_cast<double *>(tmp));
-            break;
+    for (int i = 0; i < 2; i++) {
+        AudioProcessorDelay *p = thiz->m_DelayProcessor[i];
+        switch (id) {
+            case DELAY:
+                p->setDelay(*static_cast<int *>(tmp));
+                break;
+            case WET:
+                p->setWet(*static_cast<double *>(tmp));
+                break;
+            case FEEDBACK:
+                p->setFeedback(*static_cast<double *>(tmp));
+                break;
+        }
+    }
+}
+
+AudioNodeDelay::~AudioNodeDelay()
+{
+    for (int i = 0; i < 2; i++) {
+        delete m_DelayProcessor[i];
     }
 }
 
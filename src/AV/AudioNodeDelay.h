@@ -31,10 +31,13 @@ public:
 
     static void argCallback(AudioNode *node, int id, void *val, int size);
 
-    ~AudioNodeDelay(){};
+    ~AudioNodeDelay();
 
 private:
-    AudioProcessorDelay *m_DelayProcessor;
+    /*
+        The delay keeps a history of samples, each channel needs its own line
+    */
+    AudioProcessorDelay *m_DelayProcessor[2];
 };
 
 } // namespace AV
@@ -0,0 +1,42 @@
+/*
+   Copyright 2016 Nidium Inc. All rights reserved.
+   Use of this source code is governed by a MIT license
+   that can be found in the LICENSE file.
+*/
+#ifndef av_audioprocessor_h__
+#define av_audioprocessor_h__
+
+#include "AudioVector.h"
+
+namespace Nidium {
+namespace AV {
+
+// {{{ AudioProcessor
+/*
+    An AudioProcessor transforms the frames of one channel in place.
+
+    AudioNodeProcessor always calls the block variant once per channel and
+    per audio callback. Processors should override it with a vectorized
+    implementation ; the per sample variant is only kept as a fallback for
+    processors that can't be expressed as a block operation.
+*/
+class AudioProcessor
+{
+public:
+    virtual void process(float *in, int *i) = 0;
+
+    virtual void process(float *buf, int frames)
+    {
+        for (int i = 0; i < frames; i++) {
+            this->process(&buf[i], &i);
+        }
+    }
+
+    virtual ~AudioProcessor(){};
+};
+// }}}
+
+} // namespace AV
+} // namespace Nidium
+
+#endif
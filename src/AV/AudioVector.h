@@ -0,0 +1,100 @@
+/*
+   Copyright 2016 Nidium Inc. All rights reserved.
+   Use of this source code is governed by a MIT license
+   that can be found in the LICENSE file.
+*/
+#ifndef av_audiovector_h__
+#define av_audiovector_h__
+
+#include <string.h>
+
+namespace Nidium {
+namespace AV {
+
+// {{{ AudioVector
+/*
+    Block kernels used by the audio graph.
+
+    They are written with the GCC/Clang vector extension so the compiler
+    lowers them to whatever the target provides (SSE, AVX, NEON...).
+    Audio frames are not guaranteed to be aligned, the vector type is
+    therefore declared with a scalar alignment. The tail of the block
+    (frames % kWidth) is handled with plain scalar code.
+*/
+class AudioVector
+{
+public:
+#if defined(__GNUC__) || defined(__clang__)
+    static const int kWidth = 8;
+    typedef float Block __attribute__((vector_size(kWidth * sizeof(float)),
+                                       aligned(sizeof(float))));
+#define NIDIUM_AUDIO_VECTOR 1
+#else
+    static const int kWidth = 1;
+#endif
+
+    /*
+        buf[i] *= gain
+    */
+    static inline void Scale(float *buf, float gain, int frames)
+    {
+        int i = 0;
+#ifdef NIDIUM_AUDIO_VECTOR
+        for (; i + kWidth <= frames; i += kWidth) {
+            Block *b = reinterpret_cast<Block *>(&buf[i]);
+            *b = *b * gain;
+        }
+#endif
+        for (; i < frames; i++) {
+            buf[i] *= gain;
+        }
+    }
+
+    /*
+        dst[i] += src[i]
+    */
+    static inline void Mix(float *dst, const float *src, int frames)
+    {
+        int i = 0;
+#ifdef NIDIUM_AUDIO_VECTOR
+        for (; i + kWidth <= frames; i += kWidth) {
+            Block *d       = reinterpret_cast<Block *>(&dst[i]);
+            const Block *s = reinterpret_cast<const Block *>(&src[i]);
+            *d = *d + *s;
+        }
+#endif
+        for (; i < frames; i++) {
+            dst[i] += src[i];
+        }
+    }
+
+    /*
+        dst[i] += src[i] * gain
+    */
+    static inline void
+    MixScaled(float *dst, const float *src, float gain, int frames)
+    {
+        int i = 0;
+#ifdef NIDIUM_AUDIO_VECTOR
+        for (; i + kWidth <= frames; i += kWidth) {
+            Block *d       = reinterpret_cast<Block *>(&dst[i]);
+            const Block *s = reinterpret_cast<const Block *>(&src[i]);
+            *d = *d + *s * gain;
+        }
+#endif
+        for (; i < frames; i++) {
+            dst[i] += src[i] * gain;
+        }
+    }
+
+    static inline void Copy(float *dst, const float *src, int frames)
+    {
+        memcpy(dst, src, frames * sizeof(float));
+    }
+};
+// }}}
+
+} // namespace AV
+} // namespace Nidium
+
+#endif
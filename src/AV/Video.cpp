@@ -64,6 +64,8 @@ Video::Video(ape_global *n)
       m_SourceNeedWork(false), m_DoSetSize(false), m_NewWidth(0),
       m_NewHeight(0), m_NoDisplay(false), m_InDisplay(false)
 {
+    this->setStatsName("Video");
+
     NIDIUM_PTHREAD_VAR_INIT(&m_BufferCond);
     NIDIUM_PTHREAD_VAR_INIT(&m_NotInDisplay);
 
@@ -7,9 +7,11 @@
 #define av_processor_delay_h__
 
 #include <math.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include "Core/Utils.h"
-#include "../AudioNode.h"
+#include "../AudioProcessor.h"
 
 namespace Nidium {
 namespace AV {
@@ -23,16 +25,17 @@ public:
     {
         int size = ceil(m_MaxDelay / 1000) * sampleRate;
 
-        m_Buffer     = static_cast<float *>(calloc(size, Audio::FLOAT32));
+        m_Buffer     = static_cast<float *>(calloc(size, sizeof(float)));
         m_BufferSize = size;
-        m_MaxSamples = m_BufferSize * 0.5;
 
         this->setWet(1);
         this->setDelay(0);
         this->setFeedback(0.15);
     };
 
-    void process(float *in, int *i)
+    using AudioProcessor::process;
+
+    void process(float *in, int *i) override
     {
         int j = 0;
 
@@ -45,14 +48,43 @@ public:
         m_Buffer[m_Idx++] = *in;
     }
 
+    /*
+        The delay line is processed in runs that never cross the end of the
+        ring buffer and are never longer than the delay itself. Within such a
+        run the samples read from the line have all been written during a
+        previous run, so the feedback can be applied to the whole run at once.
+    */
+    void process(float *buf, int frames) override
+    {
+        float gain = m_Wet * m_Feedback;
+
+        while (frames > 0) {
+            if (m_Idx >= m_BufferSize) m_Idx = 0;
+
+            int j = m_Idx - m_BuffIndex;
+            if (j < 0) j += m_BufferSize;
+
+            int n = nidium_min(frames, m_BuffIndex);
+            n     = nidium_min(n, m_BufferSize - m_Idx);
+            n     = nidium_min(n, m_BufferSize - j);
+
+            AudioVector::MixScaled(buf, &m_Buffer[j], gain, n);
+            AudioVector::Copy(&m_Buffer[m_Idx], buf, n);
+
+            m_Idx += n;
+            buf += n;
+            frames -= n;
+        }
+    }
+
     void setDelay(int delay)
     {
-        int size = ceil(m_MaxDelay / 1000) * m_SamplRate * Audio::FLOAT32;
-        memset(m_Buffer, 0.0, size);
+        memset(m_Buffer, 0, m_BufferSize * sizeof(float));
 
         m_Idx       = 0;
         m_Delay     = nidium_max(nidium_min(delay, m_MaxDelay), 1);
-        m_BuffIndex = ceil((m_Delay / 1000) * m_MaxSamples);
+        m_BuffIndex = ceil((m_Delay / 1000) * m_SamplRate);
+        m_BuffIndex = nidium_max(nidium_min(m_BuffIndex, m_BufferSize), 1);
     }
 
     void setFeedback(double feedback)
@@ -78,7 +110,6 @@ private:
     int m_BufferSize;
     int m_BuffIndex;
     int m_Idx;
-    int m_MaxSamples;
     int m_MaxDelay;
     int m_SamplRate;
 };
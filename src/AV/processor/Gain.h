@@ -6,7 +6,7 @@
 #ifndef av_processor_gain_h__
 #define av_processor_gain_h__
 
-#include "../AudioNode.h"
+#include "../AudioProcessor.h"
 
 namespace Nidium {
 namespace AV {
@@ -16,11 +16,18 @@ class AudioProcessorGain : public AudioProcessor
 public:
     AudioProcessorGain() : m_Gain(1){};
 
-    void process(float *in, int *i)
+    using AudioProcessor::process;
+
+    void process(float *in, int *i) override
     {
         *in = *in * m_Gain;
     }
 
+    void process(float *buf, int frames) override
+    {
+        AudioVector::Scale(buf, m_Gain, frames);
+    }
+
     void setGain(double gain)
     {
         m_Gain = gain;
@@ -0,0 +1,562 @@
+/*
+   Copyright 2016 Nidium Inc. All rights reserved.
+   Use of this source code is governed by a MIT license
+   that can be found in the LICENSE file.
+*/
+#include "Binding/JSAtomics.h"
+
+#include <math.h>
+#include <pthread.h>
+#include <time.h>
+#include <list>
+
+#include <jsfriendapi.h>
+
+#include "Core/Utils.h"
+#include "Binding/NidiumJS.h"
+
+/* Interval at which a waiting thread checks if it has to stop */
+#define ATOMICS_WAIT_SLICE_MS 100
+
+namespace Nidium {
+namespace Binding {
+
+// {{{ Waiters
+/*
+    Threads blocked in Atomics.wait(), in the order they started waiting.
+    The list is shared by all the runtimes since the memory is.
+*/
+struct AtomicsWaiter
+{
+    int32_t *m_Addr;
+    pthread_cond_t m_Cond;
+    bool m_Woken;
+};
+
+static pthread_mutex_t g_AtomicsLock = PTHREAD_MUTEX_INITIALIZER;
+static std::list<AtomicsWaiter *> g_AtomicsWaiters;
+
+static double AtomicsNow()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+
+    return static_cast<double>(ts.tv_sec) * 1000.
+           + static_cast<double>(ts.tv_nsec) / 1000000.;
+}
+// }}}
+
+// {{{ Implementation
+template <typename T>
+static T AtomicsApply(JSAtomics::Operation op, T *addr, T value, T expected)
+{
+    switch (op) {
+        case JSAtomics::kOperation_Load:
+            return __atomic_load_n(addr, __ATOMIC_SEQ_CST);
+        case JSAtomics::kOperation_Store:
+            __atomic_store_n(addr, value, __ATOMIC_SEQ_CST);
+            return value;
+        case JSAtomics::kOperation_Add:
+            return __atomic_fetch_add(addr, value, __ATOMIC_SEQ_CST);
+        case JSAtomics::kOperation_Sub:
+            return __atomic_fetch_sub(addr, value, __ATOMIC_SEQ_CST);
+        case JSAtomics::kOperation_And:
+            return __atomic_fetch_and(addr, value, __ATOMIC_SEQ_CST);
+        case JSAtomics::kOperation_Or:
+            return __atomic_fetch_or(addr, value, __ATOMIC_SEQ_CST);
+        case JSAtomics::kOperation_Xor:
+            return __atomic_fetch_xor(addr, value, __ATOMIC_SEQ_CST);
+        case JSAtomics::kOperation_Exchange:
+            return __atomic_exchange_n(addr, value, __ATOMIC_SEQ_CST);
+        case JSAtomics::kOperation_CompareExchange:
+            /* |expected| is set to the previous value */
+            __atomic_compare_exchange_n(addr, &expected, value, false,
+                                        __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+            return expected;
+    }
+
+    return 0;
+}
+
+/*
+    Get the integer typed array and the index the operation applies to
+*/
+static bool AtomicsGetElement(JSContext *cx,
+                              JS::CallArgs &args,
+                              JS::MutableHandleObject view,
+                              uint32_t *index)
+{
+    if (!args[0].isObject() || !JS_IsTypedArrayObject(&args[0].toObject())) {
+        JS_ReportError(cx, "Atomics: first argument must be a typed array");
+        return false;
+    }
+
+    view.set(&args[0].toObject());
+
+    switch (JS_GetArrayBufferViewType(view)) {
+        case js::Scalar::Int8:
+        case js::Scalar::Uint8:
+        case js::Scalar::Int16:
+        case js::Scalar::Uint16:
+        case js::Scalar::Int32:
+        case js::Scalar::Uint32:
+            break;
+        default:
+            JS_ReportError(cx, "Atomics: typed array must be an integer array");
+            return false;
+    }
+
+    double idx;
+    if (!JS::ToNumber(cx, args.get(1), &idx)) {
+        return false;
+    }
+
+    if (idx < 0 || idx != floor(idx) || idx >= JS_GetTypedArrayLength(view)) {
+        JS_ReportError(cx, "Atomics: index out of range");
+        return false;
+    }
+
+    *index = static_cast<uint32_t>(idx);
+
+    return true;
+}
+
+bool JSAtomics::Operate(JSContext *cx, JS::CallArgs &args, Operation op)
+{
+    JS::RootedObject view(cx);
+    uint32_t index;
+    int32_t value    = 0;
+    int32_t expected = 0;
+
+    if (!AtomicsGetElement(cx, args, &view, &index)) {
+        return false;
+    }
+
+    switch (op) {
+        case kOperation_Load:
+            break;
+        case kOperation_CompareExchange:
+            if (!JS::ToInt32(cx, args.get(2), &expected)
+                || !JS::ToInt32(cx, args.get(3), &value)) {
+                return false;
+            }
+            break;
+        default:
+            if (!JS::ToInt32(cx, args.get(2), &value)) {
+                return false;
+            }
+            break;
+    }
+
+    /* The conversions may have run some JS, check again */
+    if (index >= JS_GetTypedArrayLength(view)) {
+        JS_ReportError(cx, "Atomics: index out of range");
+        return false;
+    }
+
+    bool shared;
+    double ret = 0;
+    JS::AutoCheckCannotGC nogc;
+    void *data = JS_GetArrayBufferViewData(view, &shared, nogc);
+
+#define ATOMICS_APPLY(type)                                                \
+    ret = AtomicsApply<type>(op, static_cast<type *>(data) + index,        \
+                             static_cast<type>(value),                     \
+                             static_cast<type>(expected));
+
+    switch (JS_GetArrayBufferViewType(view)) {
+        case js::Scalar::Int8:
+            ATOMICS_APPLY(int8_t);
+            break;
+        case js::Scalar::Uint8:
+            ATOMICS_APPLY(uint8_t);
+            break;
+        case js::Scalar::Int16:
+            ATOMICS_APPLY(int16_t);
+            break;
+        case js::Scalar::Uint16:
+            ATOMICS_APPLY(uint16_t);
+            break;
+        case js::Scalar::Int32:
+            ATOMICS_APPLY(int32_t);
+            break;
+        case js::Scalar::Uint32:
+            ATOMICS_APPLY(uint32_t);
+            break;
+        default:
+            break;
+    }
+#undef ATOMICS_APPLY
+
+    /* store() returns the value rather than its truncated version */
+    if (op == kOperation_Store) {
+        args.rval().setInt32(value);
+    } else {
+        args.rval().setNumber(ret);
+    }
+
+    return true;
+}
+// }}}
+
+// {{{ JSAtomics
+bool JSAtomics::JSStatic_load(JSContext *cx, JS::CallArgs &args)
+{
+    return JSAtomics::Operate(cx, args, kOperation_Load);
+}
+
+bool JSAtomics::JSStatic_store(JSContext *cx, JS::CallArgs &args)
+{
+    return JSAtomics::Operate(cx, args, kOperation_Store);
+}
+
+bool JSAtomics::JSStatic_add(JSContext *cx, JS::CallArgs &args)
+{
+    return JSAtomics::Operate(cx, args, kOperation_Add);
+}
+
+bool JSAtomics::JSStatic_sub(JSContext *cx, JS::CallArgs &args)
+{
+    return JSAtomics::Operate(cx, args, kOperation_Sub);
+}
+
+bool JSAtomics::JSStatic_bitAnd(JSContext *cx, JS::CallArgs &args)
+{
+    return JSAtomics::Operate(cx, args, kOperation_And);
+}
+
+bool JSAtomics::JSStatic_bitOr(JSContext *cx, JS::CallArgs &args)
+{
+    return JSAtomics::Operate(cx, args, kOperation_Or);
+}
+
+bool JSAtomics::JSStatic_bitXor(JSContext *cx, JS::CallArgs &args)
+{
+    return JSAtomics::Operate(cx, args, kOperation_Xor);
+}
+
+bool JSAtomics::JSStatic_exchange(JSContext *cx, JS::CallArgs &args)
+{
+    return JSAtomics::Operate(cx, args, kOperation_Exchange);
+}
+
+bool JSAtomics::JSStatic_compareExchange(JSContext *cx, JS::CallArgs &args)
+{
+    return JSAtomics::Operate(cx, args, kOperation_CompareExchange);
+}
+
+bool JSAtomics::JSStatic_isLockFree(JSContext *cx, JS::CallArgs &args)
+{
+    int32_t size;
+
+    if (!JS::ToInt32(cx, args[0], &size)) {
+        return false;
+    }
+
+    args.rval().setBoolean(size == 1 || size == 2 || size == 4);
+
+    return true;
+}
+
+bool JSAtomics::JSStatic_wait(JSContext *cx, JS::CallArgs &args)
+{
+    JS::RootedObject view(cx);
+    uint32_t index;
+    int32_t value;
+    double timeout = INFINITY;
+    bool shared;
+
+    if (!AtomicsGetElement(cx, args, &view, &index)) {
+        return false;
+    }
+
+    if (JS_GetArrayBufferViewType(view) != js::Scalar::Int32) {
+        JS_ReportError(cx, "Atomics.wait() expects an Int32Array");
+        return false;
+    }
+
+    if (!JS::ToInt32(cx, args.get(2), &value)) {
+        return false;
+    }
+
+    if (args.length() > 3 && !args[3].isUndefined()) {
+        if (!JS::ToNumber(cx, args[3], &timeout)) {
+            return false;
+        }
+
+        if (isnan(timeout)) {
+            timeout = INFINITY;
+        } else if (timeout < 0) {
+            timeout = 0;
+        }
+    }
+
+    /* Blocking the main thread would block the event loop */
+    NidiumJS *njs = NidiumJS::GetObject(cx);
+    if (njs && njs->getJSContext() == cx) {
+        JS_ReportError(cx, "Atomics.wait() can only be used from a Thread");
+        return false;
+    }
+
+    int32_t *addr;
+    {
+        JS::AutoCheckCannotGC nogc;
+        addr = static_cast<int32_t *>(
+                   JS_GetArrayBufferViewData(view, &shared, nogc)) + index;
+    }
+
+    if (!shared) {
+        JS_ReportError(cx, "Atomics.wait() expects a shared typed array");
+        return false;
+    }
+
+    pthread_mutex_lock(&g_AtomicsLock);
+
+    if (__atomic_load_n(addr, __ATOMIC_SEQ_CST) != value) {
+        pthread_mutex_unlock(&g_AtomicsLock);
+
+        JS::RootedString str(cx, JS_NewStringCopyZ(cx, "not-equal"));
+        args.rval().setString(str);
+
+        return true;
+    }
+
+    AtomicsWaiter waiter;
+    waiter.m_Addr  = addr;
+    waiter.m_Woken = false;
+    pthread_cond_init(&waiter.m_Cond, NULL);
+
+    g_AtomicsWaiters.push_back(&waiter);
+
+    double deadline  = AtomicsNow() + timeout;
+    bool interrupted = false;
+
+    while (!waiter.m_Woken) {
+        double now  = AtomicsNow();
+        double wait = nidium_min(deadline - now,
+                                 static_cast<double>(ATOMICS_WAIT_SLICE_MS));
+
+        if (wait <= 0) {
+            break;
+        }
+
+        double until = now + wait;
+        struct timespec ts;
+        ts.tv_sec  = static_cast<time_t>(until / 1000.);
+        ts.tv_nsec = static_cast<long>(fmod(until, 1000.) * 1000000.);
+
+        pthread_cond_timedwait(&waiter.m_Cond, &g_AtomicsLock, &ts);
+
+        /* Let the Thread be stopped while waiting */
+        if (!waiter.m_Woken) {
+            pthread_mutex_unlock(&g_AtomicsLock);
+            interrupted = !JS_CheckForInterrupt(cx);
+            pthread_mutex_lock(&g_AtomicsLock);
+
+            if (interrupted) {
+                break;
+            }
+        }
+    }
+
+    bool woken = waiter.m_Woken;
+    if (!woken) {
+        g_AtomicsWaiters.remove(&waiter);
+    }
+
+    pthread_mutex_unlock(&g_AtomicsLock);
+    pthread_cond_destroy(&waiter.m_Cond);
+
+    if (interrupted) {
+        return false;
+    }
+
+    JS::RootedString str(cx, JS_NewStringCopyZ(cx, woken ? "ok" : "timed-out"));
+    args.rval().setString(str);
+
+    return true;
+}
+
+bool JSAtomics::JSStatic_wake(JSContext *cx, JS::CallArgs &args)
+{
+    JS::RootedObject view(cx);
+    uint32_t index;
+    double count = INFINITY;
+    bool shared;
+
+    if (!AtomicsGetElement(cx, args, &view, &index)) {
+        return false;
+    }
+
+    if (JS_GetArrayBufferViewType(view) != js::Scalar::Int32) {
+        JS_ReportError(cx, "Atomics.wake() expects an Int32Array");
+        return false;
+    }
+
+    if (args.length() > 2 && !args[2].isUndefined()) {
+        if (!JS::ToNumber(cx, args[2], &count)) {
+            return false;
+        }
+
+        if (isnan(count) || count < 0) {
+            count = 0;
+        }
+    }
+
+    int32_t *addr;
+    {
+        JS::AutoCheckCannotGC nogc;
+        addr = static_cast<int32_t *>(
+                   JS_GetArrayBufferViewData(view, &shared, nogc)) + index;
+    }
+
+    uint32_t woken = 0;
+
+    pthread_mutex_lock(&g_AtomicsLock);
+
+    for (auto it = g_AtomicsWaiters.begin();
+         it != g_AtomicsWaiters.end() && woken < count;) {
+
+        AtomicsWaiter *waiter = *it;
+
+        if (waiter->m_Addr != addr) {
+            ++it;
+            continue;
+        }
+
+        waiter->m_Woken = true;
+        pthread_cond_signal(&waiter->m_Cond);
+
+        it = g_AtomicsWaiters.erase(it);
+        woken++;
+    }
+
+    pthread_mutex_unlock(&g_AtomicsLock);
+
+    args.rval().setNumber(woken);
+
+    return true;
+}
+
+/*
+    SharedArrayBuffer(length)
+*/
+static bool
+nidium_shared_array_buffer(JSContext *cx, unsigned argc, JS::Value *vp)
+{
+    JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
+    double len = 0;
+
+    if (args.length() > 0 && !JS::ToNumber(cx, args[0], &len)) {
+        return false;
+    }
+
+    if (isnan(len)) {
+        len = 0;
+    }
+
+    if (len < 0 || len != floor(len) || len > UINT32_MAX) {
+        JS_ReportError(cx, "SharedArrayBuffer: invalid length");
+        return false;
+    }
+
+    JS::RootedObject buffer(cx,
+        JS_NewSharedArrayBuffer(cx, static_cast<uint32_t>(len)));
+    if (!buffer) {
+        return false;
+    }
+
+    args.rval().setObject(*buffer);
+
+    return true;
+}
+
+/*
+    The release build of SpiderMonkey creates SharedArrayBuffers without
+    exposing their constructor. Alias the engine's one, reached through
+    the prototype of a SharedArrayBuffer, so that instanceof works.
+*/
+static bool DefineSharedArrayBuffer(JSContext *cx, JS::HandleObject global)
+{
+    JS::RootedObject buffer(cx, JS_NewSharedArrayBuffer(cx, 0));
+    JS::RootedObject proto(cx);
+    JS::RootedObject objectProto(cx, JS_GetObjectPrototype(cx, global));
+    JS::RootedValue ctor(cx);
+
+    if (!buffer || !JS_GetPrototype(cx, buffer, &proto)) {
+        return false;
+    }
+
+    if (proto && proto != objectProto
+        && JS_GetProperty(cx, proto, "constructor", &ctor)
+        && ctor.isObject() && JS::IsCallable(&ctor.toObject())) {
+
+        return JS_DefineProperty(cx, global, "SharedArrayBuffer", ctor, 0);
+    }
+
+    /* No usable constructor, use ours along with the engine prototype */
+    JSFunction *fn = JS_DefineFunction(cx, global, "SharedArrayBuffer",
+                                       nidium_shared_array_buffer, 1,
+                                       JSFUN_CONSTRUCTOR);
+    if (!fn) {
+        return false;
+    }
+
+    if (!proto || proto == objectProto) {
+        return true;
+    }
+
+    JS::RootedObject fnobj(cx, JS_GetFunctionObject(fn));
+
+    return JS_DefineProperty(cx, fnobj, "prototype", proto,
+                             JSPROP_PERMANENT | JSPROP_READONLY)
+           && JS_DefineProperty(cx, proto, "constructor", fnobj, 0);
+}
+
+JSFunctionSpec *JSAtomics::ListStaticMethods()
+{
+#define ATOMICS_FN(name, impl, argc)                                       \
+    JS_FN(name, (JSAtomics::JSCallStatic<&JSAtomics::JSStatic_##impl, argc>), \
+          argc, NIDIUM_JS_FNPROPS)
+
+    static JSFunctionSpec funcs[] = {
+        CLASSMAPPER_FN_STATIC(JSAtomics, load, 2),
+        CLASSMAPPER_FN_STATIC(JSAtomics, store, 3),
+        CLASSMAPPER_FN_STATIC(JSAtomics, add, 3),
+        CLASSMAPPER_FN_STATIC(JSAtomics, sub, 3),
+        ATOMICS_FN("and", bitAnd, 3),
+        ATOMICS_FN("or", bitOr, 3),
+        ATOMICS_FN("xor", bitXor, 3),
+        CLASSMAPPER_FN_STATIC(JSAtomics, exchange, 3),
+        CLASSMAPPER_FN_STATIC(JSAtomics, compareExchange, 4),
+        CLASSMAPPER_FN_STATIC(JSAtomics, isLockFree, 1),
+        CLASSMAPPER_FN_STATIC(JSAtomics, wait, 3),
+        CLASSMAPPER_FN_STATIC(JSAtomics, wake, 2),
+        ATOMICS_FN("notify", wake, 2),
+        JS_FS_END
+    };
+#undef ATOMICS_FN
+
+    return funcs;
+}
+
+void JSAtomics::RegisterObject(JSContext *cx)
+{
+    JS::RootedObject global(cx, JS::CurrentGlobalOrNull(cx));
+    bool found;
+
+    if (JS_HasProperty(cx, global, "SharedArrayBuffer", &found) && !found
+        && !DefineSharedArrayBuffer(cx, global)) {
+        ndm_log(NDM_LOG_ERROR, "Atomics", "Failed to define SharedArrayBuffer");
+        JS_ClearPendingException(cx);
+    }
+
+    if (JS_HasProperty(cx, global, "Atomics", &found) && !found) {
+        JSAtomics::ExposeObject(cx, "Atomics", global);
+    }
+}
+// }}}
+
+} // namespace Binding
+} // namespace Nidium
@@ -0,0 +1,65 @@
+/*
+   Copyright 2016 Nidium Inc. All rights reserved.
+   Use of this source code is governed by a MIT license
+   that can be found in the LICENSE file.
+*/
+#ifndef binding_jsatomics_h__
+#define binding_jsatomics_h__
+
+#include "Binding/ClassMapper.h"
+
+namespace Nidium {
+namespace Binding {
+
+/*
+    Shared memory between the main context and the Thread instances.
+
+    SharedArrayBuffer are shared (not copied, nor detached) when they
+    are passed to a Thread, so that several threads can work on the same
+    memory. Atomics provides atomic operations on integer typed arrays
+    backed by a SharedArrayBuffer along with wait/wake primitives.
+
+    Both are only defined when SpiderMonkey doesn't expose them (they are
+    not enabled in release builds of the engine).
+*/
+class JSAtomics : public ClassMapper<JSAtomics>
+{
+public:
+    enum Operation
+    {
+        kOperation_Load,
+        kOperation_Store,
+        kOperation_Add,
+        kOperation_Sub,
+        kOperation_And,
+        kOperation_Or,
+        kOperation_Xor,
+        kOperation_Exchange,
+        kOperation_CompareExchange
+    };
+
+    static void RegisterObject(JSContext *cx);
+    static JSFunctionSpec *ListStaticMethods();
+
+protected:
+    NIDIUM_DECL_JSCALL_STATIC(load);
+    NIDIUM_DECL_JSCALL_STATIC(store);
+    NIDIUM_DECL_JSCALL_STATIC(add);
+    NIDIUM_DECL_JSCALL_STATIC(sub);
+    NIDIUM_DECL_JSCALL_STATIC(bitAnd);
+    NIDIUM_DECL_JSCALL_STATIC(bitOr);
+    NIDIUM_DECL_JSCALL_STATIC(bitXor);
+    NIDIUM_DECL_JSCALL_STATIC(exchange);
+    NIDIUM_DECL_JSCALL_STATIC(compareExchange);
+    NIDIUM_DECL_JSCALL_STATIC(isLockFree);
+    NIDIUM_DECL_JSCALL_STATIC(wait);
+    NIDIUM_DECL_JSCALL_STATIC(wake);
+
+private:
+    static bool Operate(JSContext *cx, JS::CallArgs &args, Operation op);
+};
+
+} // namespace Binding
+} // namespace Nidium
+
+#endif
@@ -167,6 +167,8 @@ JSFunctionSpec *JSAudioNodeSource::ListMethods()
 // {{{ JSAudioNodeCustomBase
 JSAudioNodeCustomBase::JSAudioNodeCustomBase()
 {
+    this->setStatsName("JSAudioNodeCustomBase");
+
     NIDIUM_PTHREAD_VAR_INIT(&m_ShutdownWait);
     JSAudioContext *audioContext = JSAudioContext::GetContext();
 
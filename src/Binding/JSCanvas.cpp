@@ -820,6 +820,25 @@ bool JSCanvas::JSSetter_overflow(JSContext *cx, JS::MutableHandleValue vp)
     return true;
 }
 
+bool JSCanvas::JSGetter_opaque(JSContext *cx, JS::MutableHandleValue vp)
+{
+    vp.setBoolean(m_CanvasHandler->isOpaque());
+
+    return true;
+}
+
+bool JSCanvas::JSSetter_opaque(JSContext *cx, JS::MutableHandleValue vp)
+{
+    if (!vp.isBoolean()) {
+
+        return true;
+    }
+
+    m_CanvasHandler->setOpaque(vp.toBoolean());
+
+    return true;
+}
+
 bool JSCanvas::JSGetter_scrollable(JSContext *cx, JS::MutableHandleValue vp)
 {
     vp.setBoolean(m_CanvasHandler->m_ScrollableX && m_CanvasHandler->m_ScrollableY);
@@ -1356,6 +1375,7 @@ JSPropertySpec *JSCanvas::ListProperties()
     static JSPropertySpec props[] = {
         CLASSMAPPER_PROP_GS(JSCanvas, opacity),
         CLASSMAPPER_PROP_GS(JSCanvas, overflow),
+        CLASSMAPPER_PROP_GS(JSCanvas, opaque),
         CLASSMAPPER_PROP_GS(JSCanvas, scrollable),
         CLASSMAPPER_PROP_GS(JSCanvas, scrollableX),
         CLASSMAPPER_PROP_GS(JSCanvas, scrollableY),
@@ -1676,6 +1696,8 @@ void JSCanvas::onMessageLost(const SharedMessages::Message &msg)
 JSCanvas::JSCanvas(CanvasHandler *handler)
     : m_CanvasHandler(handler)
 {
+    this->setStatsName("JSCanvas");
+
     m_CanvasHandler->addListener(this);
 
     /*
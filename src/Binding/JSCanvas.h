@@ -102,6 +102,7 @@ protected:
 
     NIDIUM_DECL_JSGETTERSETTER(opacity);
     NIDIUM_DECL_JSGETTERSETTER(overflow);
+    NIDIUM_DECL_JSGETTERSETTER(opaque);
     NIDIUM_DECL_JSGETTERSETTER(scrollable);
     NIDIUM_DECL_JSGETTERSETTER(scrollableX);
     NIDIUM_DECL_JSGETTERSETTER(scrollableY);
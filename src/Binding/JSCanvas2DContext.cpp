@@ -1836,6 +1836,10 @@ void Canvas2DContext::flush()
     m_Skia->getCanvas()->flush();
 }
 
+/*
+    Size of the backing surface (what gets composed),
+    it can be slightly larger than the canvas itself
+*/
 void Canvas2DContext::getSize(int *width, int *height) const
 {
     SkISize size = m_Skia->getCanvas()->getBaseLayerSize();
@@ -1943,6 +1947,11 @@ void Canvas2DContext::markFrame(uint64_t frame)
     }
 }
 
+uint32_t Canvas2DContext::getContentGeneration()
+{
+    return m_Skia ? m_Skia->getGeneration() : 0;
+}
+
 void Canvas2DContext::contextIsGone()
 {
     if (m_Handler) {
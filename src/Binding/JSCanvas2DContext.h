@@ -128,6 +128,7 @@ public:
     bool m_SetterDisabled;
 
     void markFrame(uint64_t frame) override;
+    uint32_t getContentGeneration() override;
     void clear(uint32_t color = 0x00000000) override;
 
     uint8_t *getPixels() override;
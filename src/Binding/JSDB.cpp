@@ -11,10 +11,184 @@
 
 #include "Core/Path.h"
 #include "Binding/NidiumJS.h"
+#include "Binding/JSUtils.h"
+#include "Binding/ThreadLocalContext.h"
+
+using Nidium::Core::DBBatch;
+using Nidium::Core::DBEntries;
+using Nidium::Core::DBRange;
+using Nidium::Core::SharedMessages;
 
 namespace Nidium {
 namespace Binding {
 
+// {{{ Preamble
+/*
+    Serialize |val| (using the structured clone format) into |batch|
+*/
+static bool JSDB_WriteValue(JSContext *cx,
+                            DBBatch *batch,
+                            const char *key,
+                            JS::HandleValue val)
+{
+    uint64_t *data;
+    size_t data_len;
+
+    if (!JS_WriteStructuredClone(cx, val, &data, &data_len, NidiumJS::m_JsScc,
+                                 NULL, JS::NullHandleValue)) {
+        return false;
+    }
+
+    batch->set(key, reinterpret_cast<uint8_t *>(data), data_len);
+
+    JS_ClearStructuredClone(data, data_len, NidiumJS::m_JsScc, nullptr);
+
+    return true;
+}
+
+static bool JSDB_ReadValue(JSContext *cx,
+                           const std::string &data,
+                           JS::MutableHandleValue rval)
+{
+    uint64_t *aligned_data;
+
+    /*
+        ReadStructuredClone requires 8-bytes aligned memory
+    */
+    if (((uintptr_t)data.data() & 7) == 0) {
+        aligned_data = (uint64_t *)data.data();
+    } else {
+        if (posix_memalign((void **)&aligned_data, 8, data.length()) != 0) {
+            return false;
+        }
+
+        memcpy(aligned_data, data.data(), data.length());
+    }
+
+    bool success = JS_ReadStructuredClone(cx, aligned_data, data.length(),
+                                          JS_STRUCTURED_CLONE_VERSION, rval,
+                                          NidiumJS::m_JsScc, NULL);
+
+    if ((void *)aligned_data != data.data()) {
+        free(aligned_data);
+    }
+
+    return success;
+}
+
+/*
+    Returns the callback of an asynchronous operation
+    (rooted until it's called), or NULL for a synchronous one
+*/
+static nidiumRootedThingRef *
+JSDB_GetCallback(JSContext *cx, JS::CallArgs &args, unsigned idx, bool *err)
+{
+    *err = false;
+
+    if (args.length() <= idx || args[idx].isUndefined()) {
+        return NULL;
+    }
+
+    if (!JSUtils::ReportIfNotFunction(cx, args[idx])) {
+        *err = true;
+        return NULL;
+    }
+
+    return NidiumLocalContext::RootNonHeapObjectUntilShutdown(
+        args[idx].toObjectOrNull());
+}
+
+static bool
+JSDB_ParseRange(JSContext *cx, JS::HandleValue val, DBRange &range)
+{
+    if (val.isUndefined()) {
+        return true;
+    }
+
+    if (!val.isObject()) {
+        JS_ReportError(cx, "range() : options must be an object");
+        return false;
+    }
+
+    JS::RootedObject options(cx, &val.toObject());
+
+    NIDIUM_JS_INIT_OPT();
+
+    NIDIUM_JS_GET_OPT_TYPE(options, "start", String)
+    {
+        JSAutoByteString str(cx, __curopt.toString());
+        range.m_Start = str.ptr();
+    }
+
+    NIDIUM_JS_GET_OPT_TYPE(options, "end", String)
+    {
+        JSAutoByteString str(cx, __curopt.toString());
+        range.m_End = str.ptr();
+    }
+
+    NIDIUM_JS_GET_OPT_TYPE(options, "prefix", String)
+    {
+        JSAutoByteString str(cx, __curopt.toString());
+        range.m_Prefix = str.ptr();
+    }
+
+    NIDIUM_JS_GET_OPT_TYPE(options, "limit", Number)
+    {
+        double limit = __curopt.toNumber();
+        range.m_Limit = limit > 0 ? static_cast<size_t>(limit) : 0;
+    }
+
+    NIDIUM_JS_GET_OPT_TYPE(options, "keys", Boolean)
+    {
+        range.m_KeysOnly = __curopt.toBoolean();
+    }
+
+    return true;
+}
+
+/*
+    [{key: "key", value: value}, ...] or ["key", ...] for keys only ranges
+*/
+static bool JSDB_EntriesToJS(JSContext *cx,
+                             const DBEntries &entries,
+                             bool keysOnly,
+                             JS::MutableHandleValue rval)
+{
+    JS::RootedObject arr(cx, JS_NewArrayObject(cx, entries.size()));
+    if (!arr) {
+        return false;
+    }
+
+    for (size_t i = 0; i < entries.size(); i++) {
+        JS::RootedString key(cx, JS_NewStringCopyN(cx, entries[i].first.data(),
+                                                   entries[i].first.length()));
+        JS::RootedValue entryVal(cx);
+
+        if (keysOnly) {
+            entryVal.setString(key);
+        } else {
+            JS::RootedObject entry(cx, JS_NewPlainObject(cx));
+            JS::RootedValue value(cx);
+
+            if (!JSDB_ReadValue(cx, entries[i].second, &value)) {
+                return false;
+            }
+
+            JS_DefineProperty(cx, entry, "key", key, JSPROP_ENUMERATE);
+            JS_DefineProperty(cx, entry, "value", value, JSPROP_ENUMERATE);
+
+            entryVal.setObject(*entry);
+        }
+
+        JS_SetElement(cx, arr, i, entryVal);
+    }
+
+    rval.setObject(*arr);
+
+    return true;
+}
+// }}}
+
 // {{{ JSDB Bindings
 JSDB *JSDB::Constructor(JSContext *cx, JS::CallArgs &args,
     JS::HandleObject obj)
@@ -52,7 +226,30 @@ bool JSDB::JS_set(JSContext *cx, JS::CallArgs &args)
         return false;
     }
 
+    bool err;
+    nidiumRootedThingRef *ref = JSDB_GetCallback(cx, args, 2, &err);
+    if (err) {
+        return false;
+    }
+
     JSAutoByteString key(cx, args[0].toString());
+
+    if (ref) {
+        DBBatch *batch = new DBBatch();
+
+        if (this->isClosed() || !JSDB_WriteValue(cx, batch, key.ptr(), args[1])) {
+            delete batch;
+            NidiumLocalContext::UnrootObject(ref);
+            JS_ReportError(cx, "Failed to set data");
+            return false;
+        }
+
+        this->writeAsync(batch, ref);
+        this->root();
+
+        return true;
+    }
+
     if (!this->set(cx, key.ptr(), args[1])) {
         JS_ReportError(cx, "Failed to set data");
         return false;
@@ -68,7 +265,27 @@ bool JSDB::JS_get(JSContext *cx, JS::CallArgs &args)
         return false;
     }
 
+    bool err;
+    nidiumRootedThingRef *ref = JSDB_GetCallback(cx, args, 1, &err);
+    if (err) {
+        return false;
+    }
+
     JSAutoByteString key(cx, args[0].toString());
+
+    if (ref) {
+        if (this->isClosed()) {
+            NidiumLocalContext::UnrootObject(ref);
+            JS_ReportError(cx, "Failed to retreive data");
+            return false;
+        }
+
+        this->getAsync(key.ptr(), ref);
+        this->root();
+
+        return true;
+    }
+
     JS::RootedValue rval(cx);
 
     if (!this->get(cx, key.ptr(), &rval)) {
@@ -88,8 +305,26 @@ bool JSDB::JS_delete(JSContext *cx, JS::CallArgs &args)
         return false;
     }
 
+    bool err;
+    nidiumRootedThingRef *ref = JSDB_GetCallback(cx, args, 1, &err);
+    if (err) {
+        return false;
+    }
+
     JSAutoByteString key(cx, args[0].toString());
-    JS::RootedValue rval(cx);
+
+    if (ref) {
+        if (this->isClosed()) {
+            NidiumLocalContext::UnrootObject(ref);
+            JS_ReportError(cx, "Failed to delete data");
+            return false;
+        }
+
+        this->delAsync(key.ptr(), ref);
+        this->root();
+
+        return true;
+    }
 
     if (!this->del(key.ptr())) {
         JS_ReportError(cx, "Failed to delete data");
@@ -99,6 +334,144 @@ bool JSDB::JS_delete(JSContext *cx, JS::CallArgs &args)
     return true;
 }
 
+bool JSDB::JS_batch(JSContext *cx, JS::CallArgs &args)
+{
+    bool isArray = false;
+    JS::RootedObject ops(cx, args[0].isObject() ? &args[0].toObject()
+                                                : nullptr);
+
+    if (!ops || !JS_IsArrayObject(cx, ops, &isArray) || !isArray) {
+        JS_ReportError(cx, "batch() : operations must be an array");
+        return false;
+    }
+
+    bool err;
+    nidiumRootedThingRef *ref = JSDB_GetCallback(cx, args, 1, &err);
+    if (err) {
+        return false;
+    }
+
+    uint32_t len;
+    JS_GetArrayLength(cx, ops, &len);
+
+    DBBatch *batch = new DBBatch();
+
+#define BATCH_FAIL(...)                                                       \
+    do {                                                                      \
+        delete batch;                                                         \
+        if (ref) {                                                            \
+            NidiumLocalContext::UnrootObject(ref);                            \
+        }                                                                     \
+        JS_ReportError(cx, __VA_ARGS__);                                      \
+        return false;                                                         \
+    } while (0)
+
+    for (uint32_t i = 0; i < len; i++) {
+        JS::RootedValue opVal(cx);
+        JS::RootedValue type(cx);
+        JS::RootedValue keyVal(cx);
+
+        JS_GetElement(cx, ops, i, &opVal);
+
+        if (!opVal.isObject()) {
+            BATCH_FAIL("batch() : operation %u must be an object", i);
+        }
+
+        JS::RootedObject op(cx, &opVal.toObject());
+
+        JS_GetProperty(cx, op, "type", &type);
+        JS_GetProperty(cx, op, "key", &keyVal);
+
+        if (!keyVal.isString() || !type.isString()) {
+            BATCH_FAIL("batch() : operation %u must have a type and a key", i);
+        }
+
+        JSAutoByteString key(cx, keyVal.toString());
+        JSAutoByteString ctype(cx, type.toString());
+
+        if (strcmp(ctype.ptr(), "set") == 0) {
+            JS::RootedValue value(cx);
+            JS_GetProperty(cx, op, "value", &value);
+
+            if (!JSDB_WriteValue(cx, batch, key.ptr(), value)) {
+                BATCH_FAIL("batch() : failed to serialize the value of %s",
+                           key.ptr());
+            }
+        } else if (strcmp(ctype.ptr(), "delete") == 0) {
+            batch->del(key.ptr());
+        } else {
+            BATCH_FAIL("batch() : unknown operation type %s", ctype.ptr());
+        }
+    }
+
+    if (this->isClosed()) {
+        BATCH_FAIL("Failed to write data");
+    }
+
+#undef BATCH_FAIL
+
+    if (ref) {
+        this->writeAsync(batch, ref);
+        this->root();
+
+        return true;
+    }
+
+    bool success = this->write(batch);
+
+    delete batch;
+
+    if (!success) {
+        JS_ReportError(cx, "Failed to write data");
+        return false;
+    }
+
+    return true;
+}
+
+bool JSDB::JS_range(JSContext *cx, JS::CallArgs &args)
+{
+    DBRange range;
+
+    if (!JSDB_ParseRange(cx, args[0], range)) {
+        return false;
+    }
+
+    bool err;
+    nidiumRootedThingRef *ref = JSDB_GetCallback(cx, args, 1, &err);
+    if (err) {
+        return false;
+    }
+
+    if (this->isClosed()) {
+        if (ref) {
+            NidiumLocalContext::UnrootObject(ref);
+        }
+        JS_ReportError(cx, "Failed to read range");
+        return false;
+    }
+
+    if (ref) {
+        this->rangeAsync(range, ref);
+        this->root();
+
+        return true;
+    }
+
+    DBEntries entries;
+    JS::RootedValue rval(cx);
+
+    if (!this->DB::range(range, entries)
+        || !JSDB_EntriesToJS(cx, entries, range.m_KeysOnly, &rval)) {
+        JS_ReportError(cx, "Failed to read range");
+        return false;
+    }
+
+    args.rval().set(rval);
+
+    return true;
+}
+
 bool JSDB::JS_drop(JSContext *cx, JS::CallArgs &args)
 {
     if (!this->drop()) {
@@ -126,31 +499,25 @@ bool JSDB::JS_close(JSContext *cx, JS::CallArgs &args)
 JSDB::JSDB(const char *path)
     : DB(path)
 {
+    this->setStatsName("JSDB");
 }
 
 bool JSDB::set(JSContext *cx, const char *key, JS::HandleValue val)
 {
-    uint64_t *data;
-    size_t data_len;
-    bool success;
+    DBBatch batch;
 
-    if (!JS_WriteStructuredClone(cx, val, &data, &data_len, NidiumJS::m_JsScc, NULL,
-                                 JS::NullHandleValue)) {
+    if (!JSDB_WriteValue(cx, &batch, key, val)) {
         return false;
     }
 
-    success = DB::set(key, reinterpret_cast<uint8_t *>(data), data_len);
-
-    JS_ClearStructuredClone(data, data_len, NidiumJS::m_JsScc, nullptr);
-
-    return success;
+    return DB::write(&batch);
 }
 
 bool JSDB::get(JSContext *cx, const char *key, JS::MutableHandleValue rval)
 {
     std::string data;
 
-    if (m_Database == nullptr) {
+    if (this->isClosed()) {
         rval.setUndefined();
         return false;
     }
@@ -160,34 +527,86 @@ bool JSDB::get(JSContext *cx, const char *key, JS::MutableHandleValue rval)
         return true;
     }
 
-    uint64_t *aligned_data;
+    if (!JSDB_ReadValue(cx, data, rval)) {
+        JS_ReportError(cx, "Unable to read internal data");
+        return false;
+    }
 
-    /*
-        ReadStructuredClone requires 8-bytes aligned memory
-    */
-    if (((uintptr_t)data.data() & 7) == 0) {
-        aligned_data = (uint64_t *)data.data();
-    } else {
-        if (posix_memalign((void **)&aligned_data, 8, data.length()) != 0) {
-            return false;
-        }
+    return true;
+}
 
-        memcpy(aligned_data, data.data(), data.length());
+void JSDB::onResult(const SharedMessages::Message &msg)
+{
+    JSContext *cx = m_Cx;
+    nidiumRootedThingRef *ref = (nidiumRootedThingRef *)msg.m_Args[7].toPtr();
+
+    if (!ref) {
+        if (this->getPendingCount() == 0) {
+            this->unroot();
+        }
+        return;
     }
 
-    if (!JS_ReadStructuredClone(cx, aligned_data, data.length(),
-                                JS_STRUCTURED_CLONE_VERSION, rval, NidiumJS::m_JsScc,
-                                NULL)) {
+    JSAutoRequest ar(cx);
+    JS::AutoValueArray<2> params(cx);
+    JS::RootedValue rval(cx);
 
-        JS_ReportError(cx, "Unable to read internal data");
-        return false;
+    params[0].setNull();
+    params[1].setUndefined();
+
+    bool success = msg.m_Args[1].toBool();
+
+    switch (msg.event()) {
+        case kEvents_Get: {
+            std::string *data = static_cast<std::string *>(msg.m_Args[0].toPtr());
+
+            if (!success) {
+                params[0].setString(
+                    JS_NewStringCopyZ(cx, "Failed to retreive data"));
+            } else if (data && !JSDB_ReadValue(cx, *data, params[1])) {
+                params[0].setString(
+                    JS_NewStringCopyZ(cx, "Unable to read internal data"));
+            }
+            break;
+        }
+        case kEvents_Write:
+            if (!success) {
+                params[0].setString(JS_NewStringCopyZ(cx, "Failed to write data"));
+            }
+            break;
+        case kEvents_Range: {
+            DBEntries *entries = static_cast<DBEntries *>(msg.m_Args[0].toPtr());
+            bool keysOnly      = msg.m_Args[2].toBool();
+
+            if (!success
+                || !JSDB_EntriesToJS(cx, *entries, keysOnly, params[1])) {
+                params[0].setString(JS_NewStringCopyZ(cx, "Failed to read range"));
+                params[1].setUndefined();
+            }
+            break;
+        }
     }
 
-    if ((void *)aligned_data != data.data()) {
-        free(aligned_data);
+    JS::RootedObject callback(cx, ref->get());
+
+    if (JS::IsCallable(callback)) {
+        JS::RootedValue cb(cx, JS::ObjectValue(*callback));
+        JS::RootedObject jsthis(cx, this->getJSObject());
+
+        JS_CallFunctionValue(cx, jsthis, cb, params, &rval);
+
+        if (JS_IsExceptionPending(cx)) {
+            if (!JS_ReportPendingException(cx)) {
+                JS_ClearPendingException(cx);
+            }
+        }
     }
 
-    return true;
+    NidiumLocalContext::UnrootObject(ref);
+
+    if (this->getPendingCount() == 0) {
+        this->unroot();
+    }
 }
 // }}}
 
@@ -197,6 +616,8 @@ JSFunctionSpec *JSDB::ListMethods()
         CLASSMAPPER_FN(JSDB, get, 1),
         CLASSMAPPER_FN(JSDB, set, 2),
         CLASSMAPPER_FN(JSDB, delete, 1),
+        CLASSMAPPER_FN(JSDB, batch, 1),
+        CLASSMAPPER_FN(JSDB, range, 0),
         CLASSMAPPER_FN(JSDB, close, 0),
         CLASSMAPPER_FN(JSDB, drop, 0),
         JS_FS_END
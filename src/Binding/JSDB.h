@@ -23,6 +23,8 @@ public:
     bool get(JSContext *cx, const char *key, JS::MutableHandleValue val);
     static void RegisterObject(JSContext *cx);
 
+    void onResult(const Core::SharedMessages::Message &msg) override;
+
     static JSDB *Constructor(JSContext *cx, JS::CallArgs &args,
         JS::HandleObject obj);
 
@@ -34,6 +36,8 @@ protected:
     NIDIUM_DECL_JSCALL(delete);
     NIDIUM_DECL_JSCALL(close);
     NIDIUM_DECL_JSCALL(drop);
+    NIDIUM_DECL_JSCALL(batch);
+    NIDIUM_DECL_JSCALL(range);
 
 };
 
@@ -341,6 +341,44 @@ bool JSDocument::JS_showFPS(JSContext *cx, JS::CallArgs &args)
     return true;
 }
 
+bool JSDocument::JS_getCompositionStats(JSContext *cx, JS::CallArgs &args)
+{
+    Context *nctx = Context::GetObject<Frontend::Context>(cx);
+    JS::RootedObject obj(cx, JS_NewPlainObject(cx));
+
+    JS::RootedValue composed(cx, JS::Int32Value(nctx->getComposedLayers()));
+    JS::RootedValue culled(cx, JS::Int32Value(nctx->getCulledLayers()));
+    JS::RootedValue pixels(
+        cx, JS::NumberValue(static_cast<double>(nctx->getComposedPixels())));
+
+    JS_DefineProperty(cx, obj, "composed", composed, JSPROP_ENUMERATE);
+    JS_DefineProperty(cx, obj, "culled", culled, JSPROP_ENUMERATE);
+    JS_DefineProperty(cx, obj, "pixels", pixels, JSPROP_ENUMERATE);
+
+    const Graphics::SurfaceCache::Stats &cacheStats
+        = nctx->m_ContextCache.getStats();
+    JS::RootedObject surfaces(cx, JS_NewPlainObject(cx));
+
+    JS::RootedValue val(cx);
+
+#define SET_CACHE_STAT(name)                                          \
+    val.setNumber(static_cast<double>(cacheStats.name));              \
+    JS_DefineProperty(cx, surfaces, #name, val, JSPROP_ENUMERATE);
+
+    SET_CACHE_STAT(count);
+    SET_CACHE_STAT(bytes);
+    SET_CACHE_STAT(hits);
+    SET_CACHE_STAT(misses);
+    SET_CACHE_STAT(evicted);
+    SET_CACHE_STAT(evictedBytes);
+#undef SET_CACHE_STAT
+
+    JS_DefineProperty(cx, obj, "surfaces", surfaces, JSPROP_ENUMERATE);
+
+    args.rval().setObject(*obj);
+
+    return true;
+}
 
 bool JSDocument::populateStyle(JSContext *cx,
                                const char *data,
@@ -479,6 +517,7 @@ JSFunctionSpec *JSDocument::ListMethods()
     static JSFunctionSpec funcs[] = {
         CLASSMAPPER_FN(JSDocument, run, 1),
         CLASSMAPPER_FN(JSDocument, showFPS, 1),
+        CLASSMAPPER_FN(JSDocument, getCompositionStats, 0),
         CLASSMAPPER_FN(JSDocument, setPasteBuffer, 1),
         CLASSMAPPER_FN(JSDocument, getPasteBuffer, 0),
         CLASSMAPPER_FN(JSDocument, loadFont, 1),
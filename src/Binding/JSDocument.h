@@ -63,6 +63,7 @@ protected:
 
     NIDIUM_DECL_JSCALL(run);
     NIDIUM_DECL_JSCALL(showFPS);
+    NIDIUM_DECL_JSCALL(getCompositionStats);
     NIDIUM_DECL_JSCALL(setPasteBuffer);
     NIDIUM_DECL_JSCALL(getPasteBuffer);
     NIDIUM_DECL_JSCALL(loadFont);
@@ -20,11 +20,16 @@ class JSAsyncHandler : public Nidium::Core::Managed
 public:
     JSAsyncHandler(JSContext *ctx) : m_Ctx(ctx)
     {
+        this->setStatsName("JSAsyncHandler");
+
         memset(m_CallBack, 0, sizeof(m_CallBack));
     }
 
     virtual ~JSAsyncHandler()
     {
+        /* Tasks post back to the handler, stop them before it goes away */
+        this->stopTasks();
+
         if (m_Ctx == NULL) {
             return;
         }
@@ -78,6 +83,16 @@ private:
 class JSFS : public ClassMapper<JSFS>, public Nidium::Core::Managed
 {
 public:
+    JSFS()
+    {
+        this->setStatsName("JSFS");
+    }
+
+    ~JSFS()
+    {
+        this->stopTasks();
+    }
+
     static void RegisterObject(JSContext *cx);
     static JSFunctionSpec *ListMethods();
 protected:
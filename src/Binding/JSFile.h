@@ -40,7 +40,10 @@ public:
     JSFile(const char *path,
            bool allowAll = false)
         : m_Encoding(NULL), m_File(NULL),
-          m_Path(Core::Path(path, allowAll)){};
+          m_Path(Core::Path(path, allowAll))
+    {
+        this->setStatsName("JSFile");
+    }
 
     virtual ~JSFile();
 
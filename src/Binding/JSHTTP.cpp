@@ -11,8 +11,10 @@
 #include <string.h>
 
 #include "Binding/JSUtils.h"
+#include "Net/HTTPConnectionPool.h"
 
 using Nidium::Net::HTTP;
+using Nidium::Net::HTTPConnectionPool;
 using Nidium::Net::HTTPRequest;
 #ifdef NIDIUM_PRODUCT_FRONTEND
 #include "Graphics/Image.h"
@@ -120,13 +122,9 @@ bool JSHTTP::JS_request(JSContext *cx, JS::CallArgs &args)
     JS::RootedObject options(cx);
     JS::RootedValue callback(cx);
 
-    callback.set(JS::NullValue());
+    getOptionsAndCallback(cx, &args, 0, &options, &callback);
 
-    if (args.length() > 0 && args[0].isObject()) {
-        options = args[0].toObjectOrNull();
-    }
-
-    if (!this->request(cx, options)) {
+    if (!this->request(cx, options, callback)) {
         return false;
     }
 
@@ -135,10 +133,33 @@ bool JSHTTP::JS_request(JSContext *cx, JS::CallArgs &args)
     return true;
 }
 
+bool JSHTTP::JS_pause(JSContext *cx, JS::CallArgs &args)
+{
+    m_HTTP->pause();
+
+    args.rval().setObjectOrNull(m_Instance);
+
+    return true;
+}
+
+bool JSHTTP::JS_resume(JSContext *cx, JS::CallArgs &args)
+{
+    m_HTTP->resume();
+
+    args.rval().setObjectOrNull(m_Instance);
+
+    return true;
+}
+
 bool JSHTTP::JS_stop(JSContext *cx, JS::CallArgs &args)
 {
     m_HTTP->stopRequest();
 
+    /* The queued requests were dropped */
+    if (m_HTTP->getQueueSize() == 0) {
+        m_Pending.clear();
+    }
+
     args.rval().setObjectOrNull(m_Instance);
 
     return true;
@@ -171,29 +192,43 @@ bool JSHTTP::request(JSContext *cx,
                      JS::HandleObject options,
                      JS::HandleValue callback)
 {
-    HTTPRequest *req = m_HTTPRequest;
+    HTTPRequest *req;
 
     if (!m_HTTP->canDoRequest()) {
-        JS_ReportError(cx, "A request is already pending.");
-        return false;
-    }
+        /*
+            A request is already pending, queue a new one.
+            It's owned by m_HTTP once given.
+        */
+        req = new HTTPRequest(m_URL);
+    } else {
+        req = m_HTTP->getRequest();
 
-    if (m_HTTP->getRequest() != nullptr) {
-        req->recycle();
+        if (req != nullptr) {
+            req->recycle();
+        } else {
+            req = m_HTTPRequest;
+        }
     }
 
+    m_HTTPRequest = req;
+
     if (options) {
         this->parseOptions(cx, options);
     }
 
-    if (!callback.isNull()) {
-        m_JSCallback = callback;
-        JS_SetReservedSlot(m_Instance, 0, callback);
-    }
+    /*
+        The callback and the options are applied by onStart(),
+        the request may be queued behind others
+    */
+    m_Pending.emplace_back(req, callback, m_Options);
 
     this->root();
 
     if (!m_HTTP->request(req, this)) {
+        if (!m_Pending.empty() && m_Pending.back().m_Request == req) {
+            m_Pending.pop_back();
+        }
+
         JS_ReportError(cx, "Failed to exec request");
         return false;
     }
@@ -319,7 +354,24 @@ void JSHTTP::parseOptions(JSContext *cx, JS::HandleObject options)
 
     NIDIUM_JS_GET_OPT_TYPE(options, "eval", Boolean)
     {
-        m_Eval = __curopt.toBoolean();
+        m_Options.eval = __curopt.toBoolean();
+    }
+
+    NIDIUM_JS_GET_OPT_TYPE(options, "pipeline", Boolean)
+    {
+        m_Options.pipeline = __curopt.toBoolean();
+    }
+
+    NIDIUM_JS_GET_OPT_TYPE(options, "stream", Boolean)
+    {
+        m_Options.stream = __curopt.toBoolean() ? HTTP_STREAM_WINDOW : 0;
+    }
+
+    NIDIUM_JS_GET_OPT_TYPE(options, "stream", Number)
+    {
+        int32_t window = __curopt.toInt32();
+
+        m_Options.stream = window > 0 ? window : 0;
     }
 
     NIDIUM_JS_GET_OPT_TYPE(options, "path", String)
@@ -347,11 +399,43 @@ void JSHTTP::onError(int code, const char *error)
 
     ClassMapperWithEvents<JSHTTP>::fireJSEvent("error", &eventValue);
 
-    JS_SetReservedSlot(m_Instance, 0, JS::NullValue());
-    JS_SetReservedSlot(m_Instance, 1, JS::NullValue());
+    this->requestDone();
+}
+
+void JSHTTP::requestDone()
+{
+    /* Queued requests still need the callback and the instance */
+    if (m_HTTP->getQueueSize() > 0) {
+        return;
+    }
+
+    m_JSCallback = JS::NullValue();
     this->unroot();
 }
 
+void JSHTTP::onStart(HTTPRequest *req)
+{
+    /*
+        A redirect starts the current request again. Pending requests
+        in front of this one failed before being started.
+    */
+    for (auto it = m_Pending.begin(); it != m_Pending.end(); ++it) {
+        if (it->m_Request != req) {
+            continue;
+        }
+
+        m_JSCallback = it->m_Callback;
+        m_Eval       = it->m_Options.eval;
+
+        m_HTTP->setPipelining(it->m_Options.pipeline);
+        m_HTTP->setStreaming(it->m_Options.stream);
+
+        m_Pending.erase(m_Pending.begin(), it + 1);
+
+        return;
+    }
+}
+
 void JSHTTP::onProgress(size_t offset,
                         size_t len,
                         HTTP::HTTPData *h,
@@ -387,6 +471,25 @@ void JSHTTP::onProgress(size_t offset,
     ClassMapperWithEvents<JSHTTP>::fireJSEvent("progress", &eventValue);
 }
 
+void JSHTTP::onChunk(const uint8_t *data, size_t len)
+{
+    JSAutoRequest ar(m_Cx);
+
+    JS::RootedObject eventObject(m_Cx, JSEvents::CreateEventObject(m_Cx));
+    JSObjectBuilder eventBuilder(m_Cx, eventObject);
+    JS::RootedValue eventValue(m_Cx, eventBuilder.jsval());
+    JS::RootedValue arrVal(m_Cx);
+
+    arrVal.setObjectOrNull(
+        JSUtils::NewArrayBufferWithCopiedContents(m_Cx, len, data));
+
+    eventBuilder.set("total", (double)m_HTTP->m_HTTP.m_ContentLength);
+    eventBuilder.set("read", (double)m_HTTP->getStreamedBytes());
+    eventBuilder.set("data", arrVal);
+
+    ClassMapperWithEvents<JSHTTP>::fireJSEvent("data", &eventValue);
+}
+
 void JSHTTP::headersToJSObject(JS::MutableHandleObject obj)
 {
     buffer *k, *v;
@@ -454,10 +557,7 @@ void JSHTTP::onRequest(HTTP::HTTPData *h, HTTP::DataType type)
 
         this->fireJSEvent("response", &eventValue);
 
-        JS_SetReservedSlot(m_Instance, 0, JS::NullValue());
-        JS_SetReservedSlot(m_Instance, 1, JS::NullValue());
-
-        this->unroot();
+        this->requestDone();
         return;
     }
 
@@ -547,10 +647,7 @@ void JSHTTP::onRequest(HTTP::HTTPData *h, HTTP::DataType type)
 
     this->fireJSEvent("response", &eventValue);
 
-    this->unroot();
-
-    JS_SetReservedSlot(m_Instance, 0, JS::NullValue());
-    JS_SetReservedSlot(m_Instance, 1, JS::NullValue());
+    this->requestDone();
 }
 
 JSHTTP::JSHTTP(char *url)
@@ -567,11 +664,96 @@ JSHTTP::~JSHTTP()
     free(m_URL);
 }
 
+bool JSHTTP::JSStatic_getPoolStats(JSContext *cx, JS::CallArgs &args)
+{
+    HTTPConnectionPool *pool = HTTPConnectionPool::GetInstance(
+        static_cast<ape_global *>(JS_GetContextPrivate(cx)));
+    const HTTPConnectionPool::Stats &stats = pool->getStats();
+    uint64_t requests = stats.created + stats.reused;
+
+    JS::RootedObject ret(cx, JS_NewPlainObject(cx));
+    JS::RootedValue val(cx);
+
+#define SET_POOL_STAT(name, value)                               \
+    val.setNumber(static_cast<double>(value));                   \
+    JS_DefineProperty(cx, ret, name, val, JSPROP_ENUMERATE);
+
+    SET_POOL_STAT("created", stats.created);
+    SET_POOL_STAT("reused", stats.reused);
+    SET_POOL_STAT("released", stats.released);
+    SET_POOL_STAT("expired", stats.expired);
+    SET_POOL_STAT("discarded", stats.discarded);
+    SET_POOL_STAT("closed", stats.closed);
+    SET_POOL_STAT("idle", pool->getIdleCount());
+    SET_POOL_STAT("reuseRate",
+                  requests ? static_cast<double>(stats.reused) / requests : 0);
+#undef SET_POOL_STAT
+
+    args.rval().setObject(*ret);
+
+    return true;
+}
+
+bool JSHTTP::JSStatic_setPoolOptions(JSContext *cx, JS::CallArgs &args)
+{
+    JS::RootedObject options(cx);
+    HTTPConnectionPool *pool = HTTPConnectionPool::GetInstance(
+        static_cast<ape_global *>(JS_GetContextPrivate(cx)));
+
+    if (!JS_ConvertArguments(cx, args, "o", options.address())) {
+        return false;
+    }
+
+    NIDIUM_JS_INIT_OPT();
+
+    NIDIUM_JS_GET_OPT_TYPE(options, "idleTimeout", Number)
+    {
+        uint32_t ms;
+        if (!JS::ToUint32(cx, __curopt, &ms)) {
+            return false;
+        }
+        pool->setIdleTimeout(ms);
+    }
+
+    NIDIUM_JS_GET_OPT_TYPE(options, "maxPerHost", Number)
+    {
+        uint32_t max;
+        if (!JS::ToUint32(cx, __curopt, &max)) {
+            return false;
+        }
+        pool->setMaxPerHost(max);
+    }
+
+    return true;
+}
+
+void JSHTTP::jsTrace(class JSTracer *trc)
+{
+    JS_CallValueTracer(trc, &m_JSCallback, "nidiumhttpcallback");
+
+    for (PendingRequest &pending : m_Pending) {
+        JS_CallValueTracer(trc, &pending.m_Callback, "nidiumhttpcallback");
+    }
+}
+
 JSFunctionSpec *JSHTTP::ListMethods()
 {
     static JSFunctionSpec funcs[] = {
         CLASSMAPPER_FN(JSHTTP, request, 0),
         CLASSMAPPER_FN(JSHTTP, stop, 0),
+        CLASSMAPPER_FN(JSHTTP, pause, 0),
+        CLASSMAPPER_FN(JSHTTP, resume, 0),
+        JS_FS_END
+    };
+
+    return funcs;
+}
+
+JSFunctionSpec *JSHTTP::ListStaticMethods()
+{
+    static JSFunctionSpec funcs[] = {
+        CLASSMAPPER_FN_STATIC(JSHTTP, getPoolStats, 0),
+        CLASSMAPPER_FN_STATIC(JSHTTP, setPoolOptions, 1),
         JS_FS_END
     };
 
@@ -581,8 +763,7 @@ JSFunctionSpec *JSHTTP::ListMethods()
 void JSHTTP::RegisterObject(JSContext *cx)
 {
     /* TODO : canvas_props */
-    JSHTTP::ExposeClass(cx, "HTTP",
-        JSCLASS_HAS_RESERVED_SLOTS(2));
+    JSHTTP::ExposeClass(cx, "HTTP", 0, JSHTTP::kJSTracer_ExposeFlag);
 
 }
 
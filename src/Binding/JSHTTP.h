@@ -6,6 +6,8 @@
 #ifndef binding_jshttp_h__
 #define binding_jshttp_h__
 
+#include <deque>
+
 #include <ape_netlib.h>
 #include <ape_array.h>
 
@@ -28,6 +30,7 @@ public:
         JS::HandleObject obj);
 
     static JSFunctionSpec *ListMethods();
+    static JSFunctionSpec *ListStaticMethods();
 
     bool request(JSContext *cx,
                  JS::HandleObject options,
@@ -41,6 +44,8 @@ public:
     void onError(const char *err);
     void onError(int code, const char *err);
     void onHeader();
+    void onChunk(const uint8_t *data, size_t len);
+    void onStart(Net::HTTPRequest *req);
 
     void fireJSEvent(const char *name, JS::MutableHandleValue ev);
     void parseOptions(JSContext *cx, JS::HandleObject options);
@@ -50,15 +55,58 @@ public:
 
 protected:
 
+    NIDIUM_DECL_JSTRACER();
+
     NIDIUM_DECL_JSCALL(request);
     NIDIUM_DECL_JSCALL(stop);
+    NIDIUM_DECL_JSCALL(pause);
+    NIDIUM_DECL_JSCALL(resume);
+
+    NIDIUM_DECL_JSCALL_STATIC(getPoolStats);
+    NIDIUM_DECL_JSCALL_STATIC(setPoolOptions);
 
 private:
+    /*
+        Options that only apply to the request they were given with
+    */
+    struct RequestOptions
+    {
+        bool eval;
+        bool pipeline;
+        size_t stream;
+    };
+
+    /*
+        A request waiting for onStart(), along with its own
+        callback and options
+    */
+    struct PendingRequest
+    {
+        PendingRequest(Net::HTTPRequest *req,
+                       JS::HandleValue callback,
+                       const RequestOptions &options)
+            : m_Request(req), m_Callback(callback), m_Options(options)
+        {
+        }
+
+        Net::HTTPRequest *m_Request;
+        JS::Heap<JS::Value> m_Callback;
+        RequestOptions m_Options;
+    };
+
     void headersToJSObject(JS::MutableHandleObject obj);
 
+    /*
+        Release the callback and unroot once no request is left
+    */
+    void requestDone();
+
     Net::HTTP *m_HTTP = nullptr;
 
+    /* Given to the next requests, updated by parseOptions() */
+    RequestOptions m_Options        = { true, false, 0 };
     bool m_Eval                     = true;
+    std::deque<PendingRequest> m_Pending;
     char *m_URL                     = nullptr;
     Net::HTTPRequest *m_HTTPRequest = nullptr;
 };
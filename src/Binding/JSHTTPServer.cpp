@@ -5,6 +5,7 @@
 */
 #include "Binding/JSHTTPServer.h"
 #include "Binding/JSUtils.h"
+#include "Core/Path.h"
 
 
 #include <stdbool.h>
@@ -26,11 +27,302 @@ JSHTTPResponse::JSHTTPResponse(uint16_t code)
 }
 // }}}
 
+// {{{ JSHTTPRequest
+JSHTTPRequest::JSHTTPRequest(JSHTTPServer *server, JSHTTPClientConnection *con)
+    : m_Server(server), m_Con(con), m_Headers(NULL)
+{
+    HTTPClientConnection::HTTPData *state = con->getHTTPState();
+
+    /*
+        The url and the body are complete, the connection
+        starts with new buffers for the next request
+    */
+    m_URL       = state->url;
+    m_Data      = state->data;
+    state->url  = NULL;
+    state->data = NULL;
+
+    m_Method    = state->parser.method;
+    m_Streaming = server->isStreaming();
+
+    if (con->m_CurrentRequest) {
+        con->m_CurrentRequest->detach();
+    }
+
+    con->m_CurrentRequest = this;
+}
+
+JSHTTPRequest::~JSHTTPRequest()
+{
+    if (m_Con) {
+        m_Con->m_CurrentRequest = nullptr;
+    }
+
+    if (m_Headers) {
+        ape_array_destroy(m_Headers);
+    }
+
+    if (m_URL) {
+        buffer_destroy(m_URL);
+    }
+
+    if (m_Data) {
+        buffer_destroy(m_Data);
+    }
+}
+
+void JSHTTPRequest::detach()
+{
+    if (!m_Con) {
+        return;
+    }
+
+    HTTPClientConnection::HTTPData *state = m_Con->getHTTPState();
+
+    m_Headers = state->headers.list;
+
+    state->headers.list = NULL;
+    state->headers.tkey = NULL;
+    state->headers.tval = NULL;
+
+    m_Con->m_CurrentRequest = nullptr;
+    m_Con                   = nullptr;
+}
+
+ape_array_t *JSHTTPRequest::getHeaders() const
+{
+    return m_Con ? m_Con->getHTTPState()->headers.list : m_Headers;
+}
+
+buffer *JSHTTPRequest::getHeader(const char *key, size_t len) const
+{
+    ape_array_t *headers = this->getHeaders();
+
+    return headers ? ape_array_lookup_cstr(headers, key, len) : NULL;
+}
+
+void JSHTTPRequest::cache(const char *name, JS::HandleValue val)
+{
+    JS::RootedObject obj(m_Cx, m_Instance);
+
+    NIDIUM_JSOBJ_SET_PROP(obj, name, val);
+}
+
+bool JSHTTPRequest::JSGetter_url(JSContext *cx, JS::MutableHandleValue vp)
+{
+    if (m_URL == NULL) {
+        vp.setUndefined();
+        return true;
+    }
+
+    vp.setString(
+        JS_NewStringCopyN(cx, reinterpret_cast<char *>(m_URL->data),
+                          m_URL->used));
+
+    m_Server->m_Stats.strings++;
+
+    this->cache("url", vp);
+
+    return true;
+}
+
+bool JSHTTPRequest::JSGetter_method(JSContext *cx, JS::MutableHandleValue vp)
+{
+    /* Interned : the same string is shared by every request */
+    vp.setString(JS_AtomizeAndPinString(
+        cx, http_method_str(static_cast<enum http_method>(m_Method))));
+
+    return true;
+}
+
+bool JSHTTPRequest::JSGetter_headers(JSContext *cx, JS::MutableHandleValue vp)
+{
+    JSHTTPRequestHeaders *headers = new JSHTTPRequestHeaders(this);
+    JS::RootedObject obj(cx, JSHTTPRequestHeaders::CreateObject(cx, headers));
+    JS::RootedObject request(cx, m_Instance);
+
+    /* The request (and thus its headers) lives as long as the object */
+    JS_SetReservedSlot(obj, 0, JS::ObjectValue(*request));
+
+    vp.setObject(*obj);
+
+    this->cache("headers", vp);
+
+    return true;
+}
+
+bool JSHTTPRequest::JSGetter_data(JSContext *cx, JS::MutableHandleValue vp)
+{
+    /* Streamed bodies are given to ondata() */
+    if (m_Streaming) {
+        vp.setUndefined();
+        return true;
+    }
+
+    if (m_Data == NULL || m_Data->used == 0) {
+        /* Only the methods meant to carry a body get an empty one */
+        if (m_Method == HTTP_POST || m_Method == HTTP_PUT
+            || m_Method == HTTP_PATCH) {
+            vp.set(JS_GetEmptyStringValue(cx));
+        } else {
+            vp.setUndefined();
+        }
+    } else {
+        JSUtils::StrToJsval(cx, reinterpret_cast<char *>(m_Data->data),
+                            m_Data->used, vp, "utf8");
+
+        m_Server->m_Stats.strings++;
+    }
+
+    this->cache("data", vp);
+
+    return true;
+}
+// }}}
+
+// {{{ JSHTTPRequestHeaders
+static bool nidium_httpserver_defineheader(JSContext *cx,
+                                           JS::HandleObject obj,
+                                           JSHTTPRequest *request,
+                                           const char *key,
+                                           buffer *val)
+{
+    JS::RootedValue jval(cx);
+
+    jval.setString(JS_NewStringCopyN(
+        cx, reinterpret_cast<char *>(val->data), val->used - 1));
+
+    request->getServer()->m_Stats.strings++;
+
+    return JS_DefineProperty(cx, obj, key, jval, JSPROP_ENUMERATE);
+}
+
+bool JSHTTPRequestHeaders::Resolve(JSContext *cx,
+                                   JS::HandleObject obj,
+                                   JS::HandleId id,
+                                   bool *resolvedp)
+{
+    JSHTTPRequestHeaders *headers = JSHTTPRequestHeaders::GetInstance(obj);
+
+    *resolvedp = false;
+
+    if (!headers || !JSID_IS_STRING(id)) {
+        return true;
+    }
+
+    JS::RootedString str(cx, JSID_TO_STRING(id));
+
+    /* Header names are short, anything longer isn't one */
+    char key[128];
+    size_t len = JS_GetStringEncodingLength(cx, str);
+
+    if (len == static_cast<size_t>(-1) || len >= sizeof(key)) {
+        return true;
+    }
+
+    JS_EncodeStringToBuffer(cx, str, key, len);
+    key[len] = '\0';
+
+    buffer *val = headers->m_Request->getHeader(key, len);
+
+    if (val == NULL) {
+        return true;
+    }
+
+    if (!nidium_httpserver_defineheader(cx, obj, headers->m_Request, key,
+                                        val)) {
+        return false;
+    }
+
+    *resolvedp = true;
+
+    return true;
+}
+
+bool JSHTTPRequestHeaders::Enumerate(JSContext *cx, JS::HandleObject obj)
+{
+    JSHTTPRequestHeaders *headers = JSHTTPRequestHeaders::GetInstance(obj);
+    ape_array_t *list;
+    buffer *k, *v;
+
+    if (!headers || (list = headers->m_Request->getHeaders()) == NULL) {
+        return true;
+    }
+
+    APE_A_FOREACH(list, k, v)
+    {
+        const char *key = reinterpret_cast<const char *>(k->data);
+        bool found;
+
+        if (!JS_AlreadyHasOwnProperty(cx, obj, key, &found)) {
+            return false;
+        }
+
+        if (!found
+            && !nidium_httpserver_defineheader(cx, obj, headers->m_Request,
+                                               key, v)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void JSHTTPRequestHeaders::RegisterObject(JSContext *cx)
+{
+    JSClass *jsclass = JSHTTPRequestHeaders::GetJSClass();
+
+    jsclass->resolve   = JSHTTPRequestHeaders::Resolve;
+    jsclass->enumerate = JSHTTPRequestHeaders::Enumerate;
+
+    JSHTTPRequestHeaders::ExposeClass(cx, "HTTPServerRequestHeaders",
+                                      JSCLASS_HAS_RESERVED_SLOTS(1));
+}
+// }}}
+
+// {{{ JSHTTPClientConnection
+JSHTTPClientConnection::~JSHTTPClientConnection()
+{
+    if (m_CurrentRequest) {
+        m_CurrentRequest->detach();
+    }
+}
+
+void JSHTTPClientConnection::onRequestBegin()
+{
+    if (m_CurrentRequest) {
+        m_CurrentRequest->detach();
+    }
+}
+
+bool JSHTTPClientConnection::JS_pause(JSContext *cx, JS::CallArgs &args)
+{
+    this->pauseReading();
+
+    return true;
+}
+
+bool JSHTTPClientConnection::JS_resume(JSContext *cx, JS::CallArgs &args)
+{
+    this->resumeReading();
+
+    return true;
+}
+
+void JSHTTPClientConnection::jsTrace(class JSTracer *trc)
+{
+    if (m_Request) {
+        JS_CallObjectTracer(trc, &m_Request, "nidiumhttpserverrequest");
+    }
+}
+// }}}
+
 // {{{ JSHTTPServer
 JSHTTPServer::JSHTTPServer(uint16_t port,
                            const char *ip)
     : HTTPServer(port, ip)
 {
+    m_Stats = {};
 }
 
 JSHTTPServer::~JSHTTPServer()
@@ -63,80 +355,102 @@ void JSHTTPServer::onClientDisconnect(HTTPClientConnection *client)
 
 }
 
+void JSHTTPServer::onHeaders(HTTPClientConnection *client)
+{
+    JSHTTPClientConnection *subclient
+        = reinterpret_cast<JSHTTPClientConnection *>(client);
+
+    JS::RootedObject objrequest(m_Cx, this->createRequest(client));
+
+    subclient->m_Request = objrequest;
+
+    this->callRequest(client, objrequest);
+}
+
 void JSHTTPServer::onData(HTTPClientConnection *client,
                           const char *buf,
                           size_t len)
 {
-    // on progress
-}
+    JSHTTPClientConnection *subclient
+        = reinterpret_cast<JSHTTPClientConnection *>(client);
 
-bool JSHTTPServer::onEnd(HTTPClientConnection *client)
-{
-    buffer *k, *v;
+    if (!subclient->m_Request || len == 0) {
+        return;
+    }
 
+    JS::RootedObject objrequest(m_Cx, subclient->m_Request);
+    JS::RootedValue ondata(m_Cx);
     JS::RootedValue rval(m_Cx);
-    JS::RootedValue oncallback(m_Cx);
 
+    if (!JS_GetProperty(m_Cx, objrequest, "ondata", &ondata)
+        || JS_TypeOfValue(m_Cx, ondata) != JSTYPE_FUNCTION) {
+        return;
+    }
+
+    JS::AutoValueArray<1> arg(m_Cx);
+    arg[0].setObjectOrNull(JSUtils::NewArrayBufferWithCopiedContents(
+        m_Cx, len, reinterpret_cast<const uint8_t *>(buf)));
+
+    JS_CallFunctionValue(m_Cx, objrequest, ondata, arg, &rval);
+}
+
+bool JSHTTPServer::onEnd(HTTPClientConnection *client)
+{
     JSHTTPClientConnection *subclient
         = reinterpret_cast<JSHTTPClientConnection *>(client);
 
-    JS::RootedObject objrequest(
-        m_Cx,
-        JS_NewPlainObject(m_Cx));
-    JS::RootedObject headers(
-        m_Cx, JS_NewPlainObject(m_Cx));
-
-    if (client->getHTTPState()->headers.list) {
-        APE_A_FOREACH(client->getHTTPState()->headers.list, k, v)
-        {
-            JS::RootedString jstr(
-                m_Cx, JS_NewStringCopyN(m_Cx, (char *)v->data, v->used - 1));
-            NIDIUM_JSOBJ_SET_PROP_FLAGS(headers, k->data, jstr,
-                                        JSPROP_ENUMERATE);
+    if (this->isStreaming()) {
+        if (!subclient->m_Request) {
+            return false;
         }
-    }
 
-    buffer *url = client->getHTTPState()->url;
-    if (url) {
-        JS::RootedString jsurl(
-            m_Cx, JS_NewStringCopyN(m_Cx, (char *)url->data, url->used));
-        NIDIUM_JSOBJ_SET_PROP(objrequest, "url", jsurl);
-    }
+        JS::RootedObject objrequest(m_Cx, subclient->m_Request);
+        JS::RootedValue onend(m_Cx);
+        JS::RootedValue rval(m_Cx);
 
-    buffer *data = client->getHTTPState()->data;
-    if (client->getHTTPState()->parser.method == HTTP_POST) {
-        JS::RootedValue strdata(m_Cx);
-        if (data == NULL || data->used == 0) {
-            strdata.set(JS_GetEmptyStringValue(m_Cx));
-        } else {
-            JSUtils::StrToJsval(m_Cx, (const char *)data->data, data->used,
-                                &strdata, "utf8");
+        subclient->m_Request = nullptr;
+
+        if (JS_GetProperty(m_Cx, objrequest, "onend", &onend)
+            && JS_TypeOfValue(m_Cx, onend) == JSTYPE_FUNCTION) {
+
+            JS_CallFunctionValue(m_Cx, objrequest, onend,
+                                 JS::HandleValueArray::empty(), &rval);
         }
 
-        NIDIUM_JSOBJ_SET_PROP(objrequest, "data", strdata);
+        return false;
     }
 
-    JS::RootedValue method(m_Cx);
+    JS::RootedObject objrequest(m_Cx, this->createRequest(client));
+
+    this->callRequest(client, objrequest);
+
+    return false;
+}
+
+JSObject *JSHTTPServer::createRequest(HTTPClientConnection *client)
+{
+    JSHTTPClientConnection *subclient
+        = reinterpret_cast<JSHTTPClientConnection *>(client);
+
+    JSHTTPRequest *request = new JSHTTPRequest(this, subclient);
+
+    JS::RootedObject objrequest(m_Cx,
+        JSHTTPRequest::CreateObject(m_Cx, request));
     JS::RootedObject cli(m_Cx, subclient->getJSObject());
 
-    switch (client->getHTTPState()->parser.method) {
-        case HTTP_POST:
-            method.setString(JS_NewStringCopyN(m_Cx, CONST_STR_LEN("POST")));
-            break;
-        case HTTP_GET:
-            method.setString(JS_NewStringCopyN(m_Cx, CONST_STR_LEN("GET")));
-            break;
-        case HTTP_PUT:
-            method.setString(JS_NewStringCopyN(m_Cx, CONST_STR_LEN("PUT")));
-            break;
-        default:
-            method.setString(JS_NewStringCopyN(m_Cx, CONST_STR_LEN("UNKOWN")));
-            break;
-    }
-
-    NIDIUM_JSOBJ_SET_PROP(objrequest, "method", method);
-    NIDIUM_JSOBJ_SET_PROP(objrequest, "headers", headers);
     NIDIUM_JSOBJ_SET_PROP(objrequest, "client", cli);
+
+    m_Stats.requests++;
+
+    return objrequest;
+}
+
+void JSHTTPServer::callRequest(HTTPClientConnection *client,
+                               JS::HandleObject objrequest)
+{
+    JS::RootedValue rval(m_Cx);
+    JS::RootedValue oncallback(m_Cx);
+
     JS::RootedObject obj(m_Cx, m_Instance);
     if (JS_GetProperty(m_Cx, obj, "onrequest", &oncallback)
         && JS_TypeOfValue(m_Cx, oncallback) == JSTYPE_FUNCTION) {
@@ -148,8 +462,6 @@ bool JSHTTPServer::onEnd(HTTPClientConnection *client)
                 ->getJSObject());
         JS_CallFunctionValue(m_Cx, obj, oncallback, arg, &rval);
     }
-
-    return false;
 }
 // }}}
 
@@ -160,6 +472,7 @@ JSHTTPServer *JSHTTPServer::Constructor(JSContext *cx, JS::CallArgs &args,
     uint16_t port;
     JS::RootedString ip_bind(cx);
     bool reuseport = false;
+    bool stream    = false;
     JSHTTPServer *listener;
     JS::RootedObject options(cx);
 
@@ -175,6 +488,11 @@ JSHTTPServer *JSHTTPServer::Constructor(JSContext *cx, JS::CallArgs &args,
         reuseport = __curopt.toBoolean();
     }
 
+    NIDIUM_JS_GET_OPT_TYPE(options, "stream", Boolean)
+    {
+        stream = __curopt.toBoolean();
+    }
+
     if (ip_bind) {
         JSAutoByteString cip(cx, ip_bind);
         listener = new JSHTTPServer(port, cip.ptr());
@@ -182,6 +500,8 @@ JSHTTPServer *JSHTTPServer::Constructor(JSContext *cx, JS::CallArgs &args,
         listener = new JSHTTPServer(port);
     }
 
+    listener->setStreaming(stream);
+
     if (!listener->start((bool)reuseport)) {
         JS_ReportError(cx, "HTTPServer() couldn't listener on %d", port);
         delete listener;
@@ -198,6 +518,24 @@ JSHTTPServer *JSHTTPServer::Constructor(JSContext *cx, JS::CallArgs &args,
 }
 
 
+bool JSHTTPServer::JS_getStats(JSContext *cx, JS::CallArgs &args)
+{
+    JS::RootedObject ret(cx, JS_NewPlainObject(cx));
+    JS::RootedValue val(cx);
+
+#define SET_STAT(name, value)                                    \
+    val.setNumber(static_cast<double>(value));                   \
+    JS_DefineProperty(cx, ret, name, val, JSPROP_ENUMERATE);
+
+    SET_STAT("requests", m_Stats.requests);
+    SET_STAT("strings", m_Stats.strings);
+#undef SET_STAT
+
+    args.rval().setObject(*ret);
+
+    return true;
+}
+
 bool JSHTTPResponse::JS_write(JSContext *cx, JS::CallArgs &args)
 {
     if (args[0].isString()) {
@@ -263,6 +601,78 @@ bool JSHTTPResponse::JS_end(JSContext *cx, JS::CallArgs &args)
     return true;
 }
 
+bool JSHTTPResponse::JS_sendFile(JSContext *cx, JS::CallArgs &args)
+{
+    JS::RootedString file(cx);
+    JS::RootedObject options(cx);
+    double offset = 0, length = -1;
+
+    if (!JS_ConvertArguments(cx, args, "S/o", file.address(),
+                             options.address())) {
+        return false;
+    }
+
+    NIDIUM_JS_INIT_OPT();
+
+    NIDIUM_JS_GET_OPT_TYPE(options, "offset", Number)
+    {
+        offset = __curopt.toNumber();
+    }
+
+    NIDIUM_JS_GET_OPT_TYPE(options, "length", Number)
+    {
+        length = __curopt.toNumber();
+    }
+
+    NIDIUM_JS_GET_OPT_TYPE(options, "headers", Object)
+    {
+        JS::RootedObject headers(cx, __curopt.toObjectOrNull());
+        JS::Rooted<JS::IdVector> ida(cx, JS::IdVector(cx));
+        JS_Enumerate(cx, headers, &ida);
+        JS::RootedId id(cx);
+
+        for (size_t i = 0; i < ida.length(); i++) {
+            id = ida[i];
+
+            if (!JSID_IS_STRING(id)) {
+                continue;
+            }
+
+            JS::RootedString key(cx, JSID_TO_STRING(id));
+            JS::RootedValue val(cx);
+
+            if (!JS_GetPropertyById(cx, headers, id, &val)
+                || !val.isString()) {
+                continue;
+            }
+
+            JSAutoByteString ckey(cx, key);
+            JSAutoByteString cval(cx, val.toString());
+
+            this->setHeader(ckey.ptr(), cval.ptr());
+        }
+    }
+
+    if (offset < 0) {
+        JS_ReportError(cx, "sendFile() : offset must be positive");
+        return false;
+    }
+
+    JSAutoByteString cfile(cx, file);
+    Core::Path path(cfile.ptr());
+
+    if (!path.path()) {
+        JS_ReportError(cx, "sendFile() : invalid path");
+        return false;
+    }
+
+    args.rval().setBoolean(this->sendFile(path.path(),
+                                          static_cast<off_t>(offset),
+                                          static_cast<int64_t>(length)));
+
+    return true;
+}
+
 bool JSHTTPResponse::JS_writeHead(JSContext *cx, JS::CallArgs &args)
 {
     uint16_t statuscode;
@@ -323,16 +733,54 @@ JSFunctionSpec *JSHTTPResponse::ListMethods()
         CLASSMAPPER_FN(JSHTTPResponse, write, 1),
         CLASSMAPPER_FN(JSHTTPResponse, writeHead, 1),
         CLASSMAPPER_FN(JSHTTPResponse, end, 0),
+        CLASSMAPPER_FN(JSHTTPResponse, sendFile, 1),
+        JS_FS_END
+    };
+
+    return funcs;
+}
+
+JSFunctionSpec *JSHTTPClientConnection::ListMethods()
+{
+    static JSFunctionSpec funcs[] = {
+        CLASSMAPPER_FN(JSHTTPClientConnection, pause, 0),
+        CLASSMAPPER_FN(JSHTTPClientConnection, resume, 0),
+        JS_FS_END
+    };
+
+    return funcs;
+}
+
+JSFunctionSpec *JSHTTPServer::ListMethods()
+{
+    static JSFunctionSpec funcs[] = {
+        CLASSMAPPER_FN(JSHTTPServer, getStats, 0),
         JS_FS_END
     };
 
     return funcs;
 }
 
+JSPropertySpec *JSHTTPRequest::ListProperties()
+{
+    static JSPropertySpec props[] = {
+        CLASSMAPPER_PROP_G(JSHTTPRequest, url),
+        CLASSMAPPER_PROP_G(JSHTTPRequest, method),
+        CLASSMAPPER_PROP_G(JSHTTPRequest, headers),
+        CLASSMAPPER_PROP_G(JSHTTPRequest, data),
+        JS_PS_END
+    };
+
+    return props;
+}
+
 void JSHTTPServer::RegisterObject(JSContext *cx)
 {
     JSHTTPServer::ExposeClass<1>(cx, "HTTPServer");
-    JSHTTPClientConnection::ExposeClass(cx, "HTTPServerClientConnection");
+    JSHTTPRequest::ExposeClass(cx, "HTTPServerRequest");
+    JSHTTPRequestHeaders::RegisterObject(cx);
+    JSHTTPClientConnection::ExposeClass(cx, "HTTPServerClientConnection", 0,
+        JSHTTPClientConnection::kJSTracer_ExposeFlag);
     JSHTTPResponse::ExposeClass(cx, "HTTPServerResponse");
 }
 // }}}
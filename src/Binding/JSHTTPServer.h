@@ -13,6 +13,7 @@ namespace Nidium {
 namespace Binding {
 
 class JSHTTPClientConnection;
+class JSHTTPServer;
 
 // {{{ JSHTTPResponse
 class JSHTTPResponse : public Net::HTTPResponse,
@@ -30,6 +31,90 @@ protected:
     NIDIUM_DECL_JSCALL(write);
     NIDIUM_DECL_JSCALL(writeHead);
     NIDIUM_DECL_JSCALL(end);
+    NIDIUM_DECL_JSCALL(sendFile);
+};
+// }}}
+
+// {{{ JSHTTPRequest
+/*
+    Request handed to onrequest.
+
+    It's backed by the parsed request : JS strings are only created when
+    a property is first accessed. The headers are borrowed from the
+    connection until it moves on to the next request, they are then
+    taken over by the request.
+*/
+class JSHTTPRequest : public ClassMapper<JSHTTPRequest>
+{
+public:
+    JSHTTPRequest(JSHTTPServer *server, JSHTTPClientConnection *con);
+    virtual ~JSHTTPRequest();
+
+    static JSPropertySpec *ListProperties();
+
+    ape_array_t *getHeaders() const;
+    buffer *getHeader(const char *key, size_t len) const;
+
+    /*
+        Take over the headers of the connection
+    */
+    void detach();
+
+    JSHTTPServer *getServer() const
+    {
+        return m_Server;
+    }
+
+protected:
+    NIDIUM_DECL_JSGETTER(url);
+    NIDIUM_DECL_JSGETTER(method);
+    NIDIUM_DECL_JSGETTER(headers);
+    NIDIUM_DECL_JSGETTER(data);
+
+private:
+    /*
+        Define |name| on the instance so that the getter
+        isn't called anymore
+    */
+    void cache(const char *name, JS::HandleValue val);
+
+    JSHTTPServer *m_Server;
+
+    /* Connection the headers are borrowed from (if any) */
+    JSHTTPClientConnection *m_Con;
+
+    ape_array_t *m_Headers;
+    buffer *m_URL;
+    buffer *m_Data;
+    unsigned int m_Method;
+    bool m_Streaming;
+};
+// }}}
+
+// {{{ JSHTTPRequestHeaders
+/*
+    request.headers : each header string is created the first time
+    it's looked up (or when the headers are enumerated)
+*/
+class JSHTTPRequestHeaders : public ClassMapper<JSHTTPRequestHeaders>
+{
+public:
+    explicit JSHTTPRequestHeaders(JSHTTPRequest *request)
+        : m_Request(request)
+    {
+    }
+    virtual ~JSHTTPRequestHeaders(){};
+
+    static bool Resolve(JSContext *cx,
+                        JS::HandleObject obj,
+                        JS::HandleId id,
+                        bool *resolvedp);
+    static bool Enumerate(JSContext *cx, JS::HandleObject obj);
+
+    static void RegisterObject(JSContext *cx);
+
+private:
+    JSHTTPRequest *m_Request;
 };
 // }}}
 
@@ -40,7 +125,8 @@ class JSHTTPClientConnection : public Net::HTTPClientConnection,
 public:
     JSHTTPClientConnection(Net::HTTPServer *httpserver,
                            ape_socket *socket)
-        : Net::HTTPClientConnection(httpserver, socket)
+        : Net::HTTPClientConnection(httpserver, socket), m_Request(nullptr),
+          m_CurrentRequest(nullptr)
     {
     }
     virtual Net::HTTPResponse *onCreateResponse()
@@ -56,7 +142,27 @@ public:
         return resp;
     }
 
-    virtual ~JSHTTPClientConnection(){};
+    virtual ~JSHTTPClientConnection();
+
+    void onRequestBegin() override;
+
+    static JSFunctionSpec *ListMethods();
+
+    NIDIUM_DECL_JSTRACER();
+
+    /*
+        Request whose body is being streamed
+    */
+    JS::Heap<JSObject *> m_Request;
+
+    /*
+        Request whose headers are borrowed from this connection
+    */
+    JSHTTPRequest *m_CurrentRequest;
+
+protected:
+    NIDIUM_DECL_JSCALL(pause);
+    NIDIUM_DECL_JSCALL(resume);
 };
 // }}}
 
@@ -76,12 +182,32 @@ public:
         ape_global *ape) override;
 
     virtual void onClientDisconnect(Net::HTTPClientConnection *client) override;
+    virtual void onHeaders(Net::HTTPClientConnection *client) override;
     virtual void onData(Net::HTTPClientConnection *client,
                         const char *buf,
                         size_t len) override;
     virtual bool onEnd(Net::HTTPClientConnection *client) override;
 
+    static JSFunctionSpec *ListMethods();
+
     static void RegisterObject(JSContext *cx);
+
+    struct Stats
+    {
+        uint64_t requests;
+        /* JS strings created for the requests (headers, url, body) */
+        uint64_t strings;
+    };
+
+    Stats m_Stats;
+
+protected:
+    NIDIUM_DECL_JSCALL(getStats);
+
+private:
+    JSObject *createRequest(Net::HTTPClientConnection *client);
+    void callRequest(Net::HTTPClientConnection *client,
+                     JS::HandleObject request);
 };
 // }}}
 
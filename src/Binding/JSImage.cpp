@@ -224,6 +224,7 @@ bool JSImage::JSGetter_src(JSContext *cx, JS::MutableHandleValue vp)
 JSImage::JSImage()
     : m_Image(NULL), m_Stream(NULL), m_Path(NULL)
 {
+    this->setStatsName("JSImage");
 }
 
 JSImage::~JSImage()
@@ -9,19 +9,32 @@
 
 #include <pwd.h>
 #include <grp.h>
+#include <sys/resource.h>
 
 #include "Core/Path.h"
+#include "Core/Pool.h"
+#include "Core/Messages.h"
 #include "Binding/JSUtils.h"
 #include "Binding/NidiumJS.h"
 
 using Nidium::Core::Path;
+using Nidium::Core::Pool;
+using Nidium::Core::Messages;
 using Nidium::Binding::JSUtils;
 
 namespace Nidium {
 namespace Binding {
 
 // {{{ Preamble
+static void nidium_process_setnumber(JSContext *cx,
+                                     JS::HandleObject obj,
+                                     const char *name,
+                                     double val)
+{
+    JS::RootedValue jval(cx, JS::NumberValue(val));
 
+    JS_DefineProperty(cx, obj, name, jval, JSPROP_ENUMERATE);
+}
 
 static int ape_kill_handler(int code, ape_global *ape)
 {
@@ -240,6 +253,113 @@ bool JSProcess::JS_cwd(JSContext *cx, JS::CallArgs &args)
     return true;
 }
 
+bool JSProcess::JS_getStats(JSContext *cx, JS::CallArgs &args)
+{
+    Pool::Stats poolStats;
+    Pool::GetStats(&poolStats);
+
+    const Messages::Stats &msgStats = Messages::GetStats();
+
+    JS::RootedObject obj(cx, JS_NewPlainObject(cx));
+    JS::RootedObject pool(cx, JS_NewPlainObject(cx));
+    JS::RootedObject messages(cx, JS_NewPlainObject(cx));
+    JS::RootedObject events(cx, JS_NewPlainObject(cx));
+    JS::RootedObject cpu(cx, JS_NewPlainObject(cx));
+
+    nidium_process_setnumber(cx, pool, "allocated", poolStats.allocated);
+    nidium_process_setnumber(cx, pool, "reused", poolStats.reused);
+    nidium_process_setnumber(cx, pool, "reusedPerSec", poolStats.reusedPerSec);
+
+    nidium_process_setnumber(cx, messages, "ticks", msgStats.ticks);
+    nidium_process_setnumber(cx, messages, "handled", msgStats.handled);
+    nidium_process_setnumber(cx, messages, "countBudgetExhausted",
+                             msgStats.countBudgetExhausted);
+    nidium_process_setnumber(cx, messages, "timeBudgetExhausted",
+                             msgStats.timeBudgetExhausted);
+
+    JS::RootedValue enabled(cx, JS::BooleanValue(msgStats.enabled));
+    JS_DefineProperty(cx, messages, "statsEnabled", enabled, JSPROP_ENUMERATE);
+
+    for (const Messages::EventStats &evstats : msgStats.events) {
+        if (!evstats.count) {
+            continue;
+        }
+
+        JS::RootedObject event(cx, JS_NewPlainObject(cx));
+        char name[256];
+
+        if (evstats.className) {
+            snprintf(name, sizeof(name), "%s:%d", evstats.className,
+                     evstats.event);
+        } else {
+            snprintf(name, sizeof(name), "other");
+        }
+
+        /* Latencies are reported in ms */
+        nidium_process_setnumber(cx, event, "count", evstats.count);
+        nidium_process_setnumber(cx, event, "perSec", evstats.perSec);
+        nidium_process_setnumber(
+            cx, event, "avgLatency",
+            evstats.count ? evstats.totalLatency / 1e6 / evstats.count : 0);
+        nidium_process_setnumber(cx, event, "maxLatency",
+                                 evstats.maxLatency / 1e6);
+
+        JS_DefineProperty(cx, events, name, event, JSPROP_ENUMERATE);
+    }
+
+    JS_DefineProperty(cx, messages, "events", events, JSPROP_ENUMERATE);
+
+    /* CPU time used by the process so far, in ms */
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+        nidium_process_setnumber(cx, cpu, "user",
+                                 usage.ru_utime.tv_sec * 1000.
+                                     + usage.ru_utime.tv_usec / 1000.);
+        nidium_process_setnumber(cx, cpu, "system",
+                                 usage.ru_stime.tv_sec * 1000.
+                                     + usage.ru_stime.tv_usec / 1000.);
+    }
+
+    JS_DefineProperty(cx, obj, "pool", pool, JSPROP_ENUMERATE);
+    JS_DefineProperty(cx, obj, "messages", messages, JSPROP_ENUMERATE);
+    JS_DefineProperty(cx, obj, "cpu", cpu, JSPROP_ENUMERATE);
+
+    args.rval().setObject(*obj);
+
+    return true;
+}
+
+bool JSProcess::JS_setMessagesBudget(JSContext *cx, JS::CallArgs &args)
+{
+    int32_t count;
+    double time = 0;
+
+    if (!JS::ToInt32(cx, args[0], &count)) {
+        return false;
+    }
+
+    if (args.length() > 1 && !JS::ToNumber(cx, args[1], &time)) {
+        return false;
+    }
+
+    if (count < 1 || time < 0) {
+        JS_ReportError(cx, "Invalid budget");
+        return false;
+    }
+
+    /* |time| is given in ms */
+    Messages::SetBudget(count, static_cast<uint64_t>(time * 1000000));
+
+    return true;
+}
+
+bool JSProcess::JS_setMessagesStats(JSContext *cx, JS::CallArgs &args)
+{
+    Messages::SetStatsEnabled(JS::ToBoolean(args[0]));
+
+    return true;
+}
+
 // }}}
 
 // {{{ Registration
@@ -253,6 +373,9 @@ JSFunctionSpec *JSProcess::ListMethods()
         CLASSMAPPER_FN(JSProcess, exit, 0),
         CLASSMAPPER_FN(JSProcess, shutdown, 0),
         CLASSMAPPER_FN(JSProcess, cwd, 0),
+        CLASSMAPPER_FN(JSProcess, getStats, 0),
+        CLASSMAPPER_FN(JSProcess, setMessagesBudget, 1),
+        CLASSMAPPER_FN(JSProcess, setMessagesStats, 1),
         JS_FS_END
     };
 
@@ -27,6 +27,9 @@ protected:
     NIDIUM_DECL_JSCALL(exit);
     NIDIUM_DECL_JSCALL(shutdown);
     NIDIUM_DECL_JSCALL(cwd);
+    NIDIUM_DECL_JSCALL(getStats);
+    NIDIUM_DECL_JSCALL(setMessagesBudget);
+    NIDIUM_DECL_JSCALL(setMessagesStats);
 };
 
 } // namespace Binding
@@ -5,6 +5,7 @@
 */
 #include "Binding/JSSocket.h"
 
+#include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
 #include <string.h>
@@ -17,62 +18,505 @@
 #include <arpa/inet.h>
 #include <js/Conversions.h>
 
+#include "Core/Utils.h"
 #include "Binding/JSUtils.h"
 
 
 namespace Nidium {
 namespace Binding {
 
+// {{{ JSSocketBufferPool
+JSSocketBufferPool::JSSocketBufferPool(size_t count, size_t size)
+    : m_FreeCount(count), m_Count(count), m_Size(size)
+{
+    m_Buffers = new Buffer[count];
+    m_Free    = new size_t[count];
+
+    for (size_t i = 0; i < count; i++) {
+        m_Buffers[i].m_Data  = nullptr;
+        m_Buffers[i].m_InUse = false;
+        /* Lowest index on top of the stack */
+        m_Free[i] = count - i - 1;
+    }
+
+    m_Stats = {};
+}
+
+JSObject *JSSocketBufferPool::acquire(JSContext *cx,
+                                      const char *data,
+                                      size_t len)
+{
+    JS::RootedObject arrayBuffer(cx);
+    Buffer *buffer = nullptr;
+
+    if (m_FreeCount && len <= m_Size) {
+        size_t idx = m_Free[m_FreeCount - 1];
+        buffer     = &m_Buffers[idx];
+
+        /*
+            The buffer might have been detached by JS in the meantime,
+            in which case it's replaced with a new one.
+        */
+        if (!buffer->m_Obj
+            || JS_GetArrayBufferByteLength(buffer->m_Obj) != m_Size) {
+
+            if (buffer->m_Data) {
+                m_Index.erase(buffer->m_Data);
+                buffer->m_Data = nullptr;
+            }
+
+            buffer->m_Obj = JS_NewArrayBuffer(cx, m_Size);
+            if (buffer->m_Obj) {
+                JS::AutoCheckCannotGC nogc;
+                bool shared;
+
+                buffer->m_Data
+                    = JS_GetArrayBufferData(buffer->m_Obj, &shared, nogc);
+                m_Index[buffer->m_Data] = idx;
+            }
+            m_Stats.allocated++;
+        } else {
+            m_Stats.reused++;
+        }
+
+        arrayBuffer = buffer->m_Obj;
+    }
+
+    if (arrayBuffer) {
+        {
+            JS::AutoCheckCannotGC nogc;
+            bool shared;
+
+            memcpy(JS_GetArrayBufferData(arrayBuffer, &shared, nogc), data,
+                   len);
+        }
+
+        JSObject *view = JS_NewUint8ArrayWithBuffer(cx, arrayBuffer, 0, len);
+        if (!view) {
+            return nullptr;
+        }
+
+        buffer->m_InUse = true;
+        m_FreeCount--;
+        m_Stats.bytes += len;
+
+        return view;
+    }
+
+    /*
+        Pool exhausted : still hand an Uint8Array to JS so that pooled
+        and non-pooled packets can be processed the same way
+    */
+    arrayBuffer = JSUtils::NewArrayBufferWithCopiedContents(cx, len, data);
+    if (!arrayBuffer) {
+        return nullptr;
+    }
+
+    m_Stats.fallback++;
+    m_Stats.bytes += len;
+
+    return JS_NewUint8ArrayWithBuffer(cx, arrayBuffer, 0, len);
+}
+
+bool JSSocketBufferPool::release(JSContext *cx, JS::HandleObject view)
+{
+    JS::RootedObject arrayBuffer(cx, view);
+
+    if (JS_IsArrayBufferViewObject(view)) {
+        bool shared;
+        arrayBuffer = JS_GetArrayBufferViewBuffer(cx, view, &shared);
+    }
+
+    if (!arrayBuffer || !JS_IsArrayBufferObject(arrayBuffer)) {
+        return false;
+    }
+
+    void *data;
+    {
+        JS::AutoCheckCannotGC nogc;
+        bool shared;
+
+        data = JS_GetArrayBufferData(arrayBuffer, &shared, nogc);
+    }
+
+    auto it = m_Index.find(data);
+    if (!data || it == m_Index.end()) {
+        return false;
+    }
+
+    Buffer &buffer = m_Buffers[it->second];
+
+    if (!buffer.m_InUse || buffer.m_Obj.get() != arrayBuffer.get()) {
+        return false;
+    }
+
+    buffer.m_InUse        = false;
+    m_Free[m_FreeCount++] = it->second;
+    m_Stats.released++;
+
+    return true;
+}
+
+void JSSocketBufferPool::trace(class JSTracer *trc)
+{
+    for (size_t i = 0; i < m_Count; i++) {
+        if (m_Buffers[i].m_Obj) {
+            JS_CallObjectTracer(trc, &m_Buffers[i].m_Obj,
+                                "nidiumsocketbufferpool");
+        }
+    }
+}
+
+JSSocketBufferPool::~JSSocketBufferPool()
+{
+    delete[] m_Buffers;
+    delete[] m_Free;
+}
+// }}}
+
+// {{{ JSSocketBase
 JSSocketBase::JSSocketBase(JSContext *cx, const char *host,
                    unsigned short port)
-    : m_Socket(NULL), m_Flags(0),
-      m_FrameDelimiter('\n'), m_ParentServer(NULL), m_TCPTimeout(0), m_Cx(cx)
+    : m_Socket(NULL), m_Flags(0), m_FrameBuffer(NULL), m_BufferPool(NULL),
+      m_ParentServer(NULL), m_TCPTimeout(0), m_Cx(cx)
 {
     m_Host = strdup(host);
     m_Port = port;
 
-    m_LineBuffer.pos  = 0;
-    m_LineBuffer.data = NULL;
+    m_Coalesced.data  = NULL;
+    m_Coalesced.timer = 0;
+
+    m_ReadStats = {};
+
+    m_Framing            = {};
+    m_Framing.type       = kFraming_None;
+    m_Framing.delimiter  = '\n';
 
     m_Encoding = NULL;
 }
 
-void JSSocketBase::readFrame(const char *buf, size_t len)
+bool JSSocketBase::newFrameValue(const char *buf,
+                                 size_t len,
+                                 JS::MutableHandleValue val)
 {
-    JS::RootedValue onread(m_Cx);
-    JS::RootedValue rval(m_Cx);
-    JS::AutoValueArray<2> jdata(m_Cx);
-    JS::RootedString tstr(m_Cx, JSUtils::NewStringWithEncoding(
-                                    m_Cx, buf, len, this->getEncoding()));
-    JS::RootedString jstr(m_Cx);
-    jstr = tstr;
+    if (this->getFlags() & JSSocket::kSocketType_Binary) {
+        JS::RootedObject arrayBuffer(m_Cx, this->newBinaryData(buf, len));
 
-    if (m_LineBuffer.pos
-        && (this->getFlags() & JSSocket::kSocketType_Readline)) {
-        JS::RootedString left(m_Cx, JSUtils::NewStringWithEncoding(
-                                        m_Cx, m_LineBuffer.data,
-                                        m_LineBuffer.pos, this->getEncoding()));
+        if (!arrayBuffer) {
+            return false;
+        }
 
-        jstr             = JS_ConcatStrings(m_Cx, left, tstr);
-        m_LineBuffer.pos = 0;
+        val.setObject(*arrayBuffer);
+    } else {
+        JS::RootedString jstr(m_Cx, JSUtils::NewStringWithEncoding(
+                                        m_Cx, buf, len, this->getEncoding()));
+
+        val.setString(jstr);
     }
 
+    return true;
+}
+
+void JSSocketBase::callOnRead(JS::HandleValue data)
+{
+    JS::RootedValue onread(m_Cx);
+    JS::RootedValue rval(m_Cx);
+    JS::AutoValueArray<2> jparams(m_Cx);
+
     if (isClientFromOwnServer()) {
-        jdata[0].setObjectOrNull(this->getjsobj());
-        jdata[1].setString(jstr);
+        JS::RootedObject obj(m_Cx, this->getjsobj());
+        jparams[0].setObjectOrNull(obj);
+        jparams[1].set(data);
     } else {
-        jdata[0].setString(jstr);
+        jparams[0].set(data);
     }
 
+    JSSocketBase *owner = m_ParentServer ? m_ParentServer : this;
+    owner->m_ReadStats.callbacks++;
+
     JS::RootedObject obj(m_Cx, getReceiverJSObject());
     if (JS_GetProperty(m_Cx, obj, "onread", &onread)
         && JS_TypeOfValue(m_Cx, onread) == JSTYPE_FUNCTION) {
+        /* Writes issued from onread are sent at once */
         PACK_TCP(m_Socket->s.fd);
-        JS_CallFunctionValue(m_Cx, obj, onread, jdata, &rval);
+        JS_CallFunctionValue(m_Cx, obj, onread, jparams, &rval);
         FLUSH_TCP(m_Socket->s.fd);
     }
 }
 
+void JSSocketBase::readFrame(const char *buf, size_t len)
+{
+    JSSocketBase *owner = m_ParentServer ? m_ParentServer : this;
+    owner->m_ReadStats.messages++;
+
+    if (this->getFlags() & JSSocket::kSocketType_Coalesce) {
+        if (m_Coalesced.data == NULL) {
+            m_Coalesced.data = buffer_new(0);
+        }
+
+        buffer_append_data(m_Coalesced.data,
+                           reinterpret_cast<const unsigned char *>(buf), len);
+        m_Coalesced.lengths.push_back(len);
+
+        /*
+            Timers are processed once the pending socket events are, the
+            messages are handed to JS at the end of this loop iteration.
+        */
+        if (!m_Coalesced.timer) {
+            ape_global *ape
+                = static_cast<ape_global *>(JS_GetContextPrivate(m_Cx));
+
+            m_Coalesced.timer = APE_timer_getid(
+                APE_timer_create(ape, 0, JSSocketBase::FlushCoalesced, this));
+        }
+
+        return;
+    }
+
+    JS::RootedValue data(m_Cx);
+
+    if (!this->newFrameValue(buf, len, &data)) {
+        return;
+    }
+
+    this->callOnRead(data);
+}
+
+int JSSocketBase::FlushCoalesced(void *arg)
+{
+    JSSocketBase *socket = static_cast<JSSocketBase *>(arg);
+
+    socket->m_Coalesced.timer = 0;
+    socket->flushCoalesced();
+
+    return 0;
+}
+
+void JSSocketBase::flushCoalesced()
+{
+    if (m_Coalesced.timer) {
+        ape_global *ape = static_cast<ape_global *>(JS_GetContextPrivate(m_Cx));
+
+        APE_timer_clearbyid(ape, m_Coalesced.timer, 1);
+        m_Coalesced.timer = 0;
+    }
+
+    size_t count = m_Coalesced.lengths.size();
+
+    if (count == 0) {
+        return;
+    }
+
+    if (!this->isAttached() || !this->isJSCallable()) {
+        m_Coalesced.lengths.clear();
+        m_Coalesced.data->used = 0;
+
+        return;
+    }
+
+    JSAutoRequest ar(m_Cx);
+
+    JS::RootedObject messages(m_Cx, JS_NewArrayObject(m_Cx, count));
+    JS::RootedValue val(m_Cx);
+    const char *pBuf = reinterpret_cast<const char *>(m_Coalesced.data->data);
+
+    for (size_t i = 0; i < count; i++) {
+        size_t len = m_Coalesced.lengths[i];
+
+        if (!this->newFrameValue(pBuf, len, &val)) {
+            val.setNull();
+        }
+
+        JS_SetElement(m_Cx, messages, i, val);
+
+        pBuf += len;
+    }
+
+    m_Coalesced.lengths.clear();
+    m_Coalesced.data->used = 0;
+
+    JS::RootedValue data(m_Cx, JS::ObjectValue(*messages));
+
+    this->callOnRead(data);
+}
+
+static size_t nidium_socket_read_prefix(const JSSocketBase::Framing &framing,
+                                        const uint8_t *buf)
+{
+    if (framing.prefixSize == 2) {
+        return framing.littleEndian ? buf[0] | (buf[1] << 8)
+                                    : (buf[0] << 8) | buf[1];
+    }
+
+    return framing.littleEndian
+               ? buf[0] | (buf[1] << 8) | (buf[2] << 16)
+                     | (static_cast<uint32_t>(buf[3]) << 24)
+               : (static_cast<uint32_t>(buf[0]) << 24) | (buf[1] << 16)
+                     | (buf[2] << 8) | buf[3];
+}
+
+void JSSocketBase::frameOverflow()
+{
+    ndm_logf(NDM_LOG_ERROR, "Socket",
+             "Message exceeds %d bytes, closing the connection",
+             SOCKET_FRAMEBUFFER_MAX);
+
+    if (m_FrameBuffer) {
+        m_FrameBuffer->used = 0;
+    }
+
+    this->shutdown();
+}
+
+bool JSSocketBase::bufferFrame(const char *buf, size_t len)
+{
+    if (m_FrameBuffer == NULL) {
+        m_FrameBuffer = buffer_new(0);
+    }
+
+    if (m_FrameBuffer->used + len > SOCKET_FRAMEBUFFER_MAX) {
+        this->frameOverflow();
+
+        return false;
+    }
+
+    buffer_append_data(m_FrameBuffer,
+                       reinterpret_cast<const unsigned char *>(buf), len);
+
+    return true;
+}
+
+void JSSocketBase::readFramed(const char *data, size_t len)
+{
+    const char *pBuf = data;
+    size_t tlen      = len;
+
+    /* The socket can be closed or the framing changed from onread */
+    while (tlen > 0 && this->isAttached() && this->isJSCallable()) {
+        const Framing &framing = this->getFraming();
+        size_t pending = m_FrameBuffer ? m_FrameBuffer->used : 0;
+
+        if (framing.type == kFraming_None) {
+            /* Framing was disabled : flush what's left */
+            if (pending) {
+                m_FrameBuffer->used = 0;
+                this->readFrame(reinterpret_cast<char *>(m_FrameBuffer->data),
+                                pending);
+            } else {
+                this->readFrame(pBuf, tlen);
+                tlen = 0;
+            }
+            continue;
+        }
+
+        if (framing.type == kFraming_Delimiter) {
+            const char *eol = static_cast<const char *>(
+                memchr(pBuf, framing.delimiter, tlen));
+
+            if (eol == NULL) {
+                this->bufferFrame(pBuf, tlen);
+                return;
+            }
+
+            size_t pLen     = eol - pBuf;
+            const char *msg = pBuf;
+
+            pBuf = eol + 1;
+            tlen -= pLen + 1;
+
+            /* Line started in a previous packet */
+            if (pending) {
+                if (!this->bufferFrame(msg, pLen)) {
+                    return;
+                }
+
+                pLen                = m_FrameBuffer->used;
+                m_FrameBuffer->used = 0;
+                msg = reinterpret_cast<char *>(m_FrameBuffer->data);
+            }
+
+            this->readFrame(msg, pLen);
+
+            continue;
+        }
+
+        /* Length prefixed messages and fixed size records */
+        size_t header = framing.type == kFraming_Length ? framing.prefixSize
+                                                        : 0;
+
+        if (!pending && tlen >= header) {
+            size_t msgLen
+                = header ? nidium_socket_read_prefix(
+                               framing, reinterpret_cast<const uint8_t *>(pBuf))
+                         : framing.recordSize;
+
+            /* The whole message is available, no need to copy it */
+            if (msgLen <= SOCKET_FRAMEBUFFER_MAX && tlen - header >= msgLen) {
+                const char *msg = pBuf + header;
+
+                pBuf += header + msgLen;
+                tlen -= header + msgLen;
+
+                this->readFrame(msg, msgLen);
+
+                continue;
+            }
+        }
+
+        /* Gather the prefix first to know the message size */
+        if (pending < header) {
+            size_t n = nidium_min(header - pending, tlen);
+
+            if (!this->bufferFrame(pBuf, n)) {
+                return;
+            }
+
+            pBuf += n;
+            tlen -= n;
+
+            continue;
+        }
+
+        size_t frameLen
+            = header + (header ? nidium_socket_read_prefix(
+                                     framing, m_FrameBuffer->data)
+                               : framing.recordSize);
+
+        if (frameLen - header > SOCKET_FRAMEBUFFER_MAX) {
+            this->frameOverflow();
+            return;
+        }
+
+        size_t n = nidium_min(frameLen - pending, tlen);
+
+        if (!this->bufferFrame(pBuf, n)) {
+            return;
+        }
+
+        pBuf += n;
+        tlen -= n;
+
+        if (m_FrameBuffer->used == frameLen) {
+            m_FrameBuffer->used = 0;
+
+            this->readFrame(
+                reinterpret_cast<char *>(m_FrameBuffer->data) + header,
+                frameLen - header);
+        }
+    }
+}
+
+JSObject *JSSocketBase::newBinaryData(const char *data, size_t len)
+{
+    JSSocketBufferPool *pool = this->getBufferPool();
+
+    if (pool) {
+        return pool->acquire(m_Cx, data, len);
+    }
+
+    return JSUtils::NewArrayBufferWithCopiedContents(m_Cx, len, data);
+}
+
 bool JSSocketBase::isAttached()
 {
     return (m_Socket != NULL);
@@ -112,71 +556,19 @@ void JSSocketBase::disconnect()
 
 void JSSocketBase::onRead(const char *data, size_t len)
 {
-    JS::RootedValue onread(m_Cx);
-    JS::RootedValue rval(m_Cx);
-
     if (!isJSCallable()) {
         return;
     }
 
-    JS::AutoValueArray<2> jparams(m_Cx);
-    int dataPosition = 0;
-
-    if (isClientFromOwnServer()) {
-        dataPosition = 1;
-        JS::RootedObject obj(m_Cx, this->getjsobj());
-        jparams[0].setObjectOrNull(obj);
-    } else {
-        dataPosition = 0;
-    }
-
-    if (this->getFlags() & JSSocket::kSocketType_Binary) {
-        JS::RootedObject arrayBuffer(m_Cx,
-            JSUtils::NewArrayBufferWithCopiedContents(m_Cx, len, data));
-
-        jparams[dataPosition].setObject(*arrayBuffer);
-
-    } else if (this->getFlags() & JSSocket::kSocketType_Readline) {
-        const char *pBuf = data;
-        size_t tlen      = len;
-        char *eol;
-
-        // TODO: new style cast
-        while (
-            tlen > 0
-            && (eol = (char *)(memchr(pBuf, this->getFrameDelimiter(), tlen)))
-                   != NULL) {
-
-            size_t pLen = eol - pBuf;
-            tlen -= pLen;
-            if (tlen-- > 0) {
-                this->readFrame(pBuf, pLen);
-                pBuf = eol + 1;
-            }
-        }
+    if (this->getFraming().type != kFraming_None
+        || (m_FrameBuffer && m_FrameBuffer->used)) {
 
-        if (tlen && tlen + m_LineBuffer.pos <= SOCKET_LINEBUFFER_MAX) {
-            memcpy(m_LineBuffer.data + m_LineBuffer.pos, pBuf, tlen);
-            m_LineBuffer.pos += tlen;
-        } else if (tlen) {
-            m_LineBuffer.pos = 0;
-        }
+        this->readFramed(data, len);
 
         return;
-    } else {
-        JS::RootedString jstr(m_Cx, JSUtils::NewStringWithEncoding(
-                                        m_Cx, data, len, this->getEncoding()));
-
-        jparams[dataPosition].setString(jstr);
     }
 
-    JS::RootedObject obj(m_Cx, getReceiverJSObject());
-    if (JS_GetProperty(m_Cx, obj, "onread", &onread)
-        && JS_TypeOfValue(m_Cx, onread) == JSTYPE_FUNCTION) {
-        PACK_TCP(m_Socket->s.fd);
-        JS_CallFunctionValue(m_Cx, obj, onread, jparams, &rval);
-        FLUSH_TCP(m_Socket->s.fd);
-    }
+    this->readFrame(data, len);
 }
 
 void JSSocketBase::shutdown()
@@ -194,13 +586,25 @@ JSSocketBase::~JSSocketBase()
         this->disconnect();
     }
     free(m_Host);
-    if (m_LineBuffer.data) {
-        free(m_LineBuffer.data);
+    if (m_FrameBuffer) {
+        buffer_destroy(m_FrameBuffer);
+    }
+
+    if (m_Coalesced.timer) {
+        APE_timer_clearbyid(
+            static_cast<ape_global *>(JS_GetContextPrivate(m_Cx)),
+            m_Coalesced.timer, 1);
+    }
+
+    if (m_Coalesced.data) {
+        buffer_destroy(m_Coalesced.data);
     }
 
     if (m_Encoding) {
         free(m_Encoding);
     }
+
+    delete m_BufferPool;
 }
 
 
@@ -227,8 +631,13 @@ static void nidium_socket_wrapper_client_onmessage(ape_socket *socket_server,
     JS::RootedValue rval(cx);
 
     if (nsocket->m_Flags & JSSocket::kSocketType_Binary) {
-        JS::RootedObject arrayBuffer(cx,
-            JSUtils::NewArrayBufferWithCopiedContents(cx, len, packet));
+        JS::RootedObject arrayBuffer(
+            cx, nsocket->newBinaryData(
+                    reinterpret_cast<const char *>(packet), len));
+
+        if (!arrayBuffer) {
+            return;
+        }
 
         jparams[0].setObject(*arrayBuffer);
 
@@ -299,13 +708,6 @@ static void nidium_socket_wrapper_onaccept(ape_socket *socket_server,
     sobj->m_ParentServer = nsocket;
     sobj->m_Socket       = socket_client;
 
-    if (sobj->getFlags() & JSSocket::kSocketType_Readline) {
-        sobj->m_LineBuffer.data
-            = static_cast<char *>(malloc(sizeof(char) * SOCKET_LINEBUFFER_MAX));
-        sobj->m_LineBuffer.pos = 0;
-    }
-
-
     NIDIUM_JSOBJ_SET_PROP_CSTR(jclient, "ip",  APE_socket_ipv4(socket_client));
     NIDIUM_JSOBJ_SET_PROP_INT(jclient, "port", APE_socket_port(socket_client));
 
@@ -372,6 +774,8 @@ static void nidium_socket_wrapper_client_disconnect(ape_socket *socket_client,
 
     jparams[0].setObject(*csocket->getJSObject());
 
+    /* Deliver what was received before the disconnection */
+    csocket->flushCoalesced();
     csocket->dettach();
 
     JS::RootedObject obj(cx, ssocket->getJSObject());
@@ -411,24 +815,16 @@ bool JSSocket::JSSetter_readline(JSContext *cx, JS::MutableHandleValue vp)
         = ((vp.isBoolean() && vp.toBoolean() == true) || vp.isInt32());
 
     if (isactive) {
-
-        m_Flags |= kSocketType_Readline;
-
-        if (m_LineBuffer.data == NULL) {
-
-            m_LineBuffer.data = static_cast<char *>(
-                malloc(sizeof(char) * SOCKET_LINEBUFFER_MAX));
-            m_LineBuffer.pos = 0;
-        }
+        m_Framing.type = kFraming_Delimiter;
 
         /*
             Default delimiter is line feed.
         */
-        m_FrameDelimiter
+        m_Framing.delimiter
             = vp.isBoolean() ? '\n' : vp.toInt32() & 0xFF;
 
-    } else {
-        m_Flags &= ~kSocketType_Readline;
+    } else if (m_Framing.type == kFraming_Delimiter) {
+        m_Framing.type = kFraming_None;
     }
 
     return true;
@@ -436,7 +832,111 @@ bool JSSocket::JSSetter_readline(JSContext *cx, JS::MutableHandleValue vp)
 
 bool JSSocket::JSGetter_readline(JSContext *cx, JS::MutableHandleValue vp)
 {
-    vp.setBoolean(m_Flags & kSocketType_Readline);
+    vp.setBoolean(m_Framing.type == kFraming_Delimiter);
+
+    return true;
+}
+
+bool JSSocket::JSSetter_framing(JSContext *cx, JS::MutableHandleValue vp)
+{
+    if (vp.isNullOrUndefined() || (vp.isBoolean() && !vp.toBoolean())) {
+        m_Framing.type = kFraming_None;
+
+        return true;
+    }
+
+    if (vp.isNumber()) {
+        double size = vp.toNumber();
+
+        if (size < 1 || size > SOCKET_FRAMEBUFFER_MAX) {
+            JS_ReportError(cx, "Invalid record size (must be between 1 and %d)",
+                           SOCKET_FRAMEBUFFER_MAX);
+            return false;
+        }
+
+        m_Framing.type       = kFraming_Fixed;
+        m_Framing.recordSize = static_cast<size_t>(size);
+
+        return true;
+    }
+
+    if (vp.isString()) {
+        JSAutoByteString cframing(cx, vp.toString());
+        static const struct
+        {
+            const char *name;
+            uint8_t prefixSize;
+            bool littleEndian;
+        } prefixes[] = { { "uint16be", 2, false },
+                         { "uint16le", 2, true },
+                         { "uint32be", 4, false },
+                         { "uint32le", 4, true } };
+
+        /* Same as readline = true, keeps the current delimiter */
+        if (strcasecmp("readline", cframing.ptr()) == 0) {
+            m_Framing.type = kFraming_Delimiter;
+
+            return true;
+        }
+
+        for (size_t i = 0; i < sizeof(prefixes) / sizeof(prefixes[0]); i++) {
+            if (strcasecmp(prefixes[i].name, cframing.ptr()) == 0) {
+                m_Framing.type         = kFraming_Length;
+                m_Framing.prefixSize   = prefixes[i].prefixSize;
+                m_Framing.littleEndian = prefixes[i].littleEndian;
+
+                return true;
+            }
+        }
+    }
+
+    JS_ReportError(cx, "Invalid framing (must be either null, a record size or "
+                       "one of 'readline', 'uint16be', 'uint16le', "
+                       "'uint32be', 'uint32le')");
+
+    return false;
+}
+
+bool JSSocket::JSGetter_framing(JSContext *cx, JS::MutableHandleValue vp)
+{
+    switch (m_Framing.type) {
+        case kFraming_Delimiter:
+            vp.setString(JS_NewStringCopyZ(cx, "readline"));
+            break;
+        case kFraming_Length: {
+            char name[16];
+
+            snprintf(name, sizeof(name), "uint%d%s", m_Framing.prefixSize * 8,
+                     m_Framing.littleEndian ? "le" : "be");
+
+            vp.setString(JS_NewStringCopyZ(cx, name));
+            break;
+        }
+        case kFraming_Fixed:
+            vp.setNumber(static_cast<double>(m_Framing.recordSize));
+            break;
+        default:
+            vp.setNull();
+            break;
+    }
+
+    return true;
+}
+
+bool JSSocket::JSSetter_coalesce(JSContext *cx, JS::MutableHandleValue vp)
+{
+    if (vp.isBoolean()) {
+        m_Flags = (vp.toBoolean() == true
+                   ? m_Flags | kSocketType_Coalesce
+                   : m_Flags & ~kSocketType_Coalesce);
+    }
+
+    return true;
+}
+
+bool JSSocket::JSGetter_coalesce(JSContext *cx, JS::MutableHandleValue vp)
+{
+    vp.setBoolean(m_Flags & kSocketType_Coalesce);
 
     return true;
 }
@@ -490,6 +990,42 @@ bool JSSocket::JSGetter_timeout(JSContext *cx, JS::MutableHandleValue vp)
     return true;
 }
 
+bool JSSocket::JSSetter_bufferPool(JSContext *cx, JS::MutableHandleValue vp)
+{
+    uint32_t count = 0;
+
+    if (vp.isBoolean()) {
+        count = vp.toBoolean() ? SOCKET_BUFFERPOOL_COUNT : 0;
+    } else if (!JS::ToUint32(cx, vp, &count)) {
+        return true;
+    }
+
+    /*
+        Buffers still owned by JS are simply left to the GC
+    */
+    delete m_BufferPool;
+    m_BufferPool = NULL;
+
+    if (count) {
+        m_BufferPool
+            = new JSSocketBufferPool(count, SOCKET_BUFFERPOOL_SIZE);
+    }
+
+    return true;
+}
+
+bool JSSocket::JSGetter_bufferPool(JSContext *cx, JS::MutableHandleValue vp)
+{
+    if (!m_BufferPool) {
+        vp.setBoolean(false);
+        return true;
+    }
+
+    vp.setNumber(static_cast<uint32_t>(m_BufferPool->getCount()));
+
+    return true;
+}
+
 
 JSSocket *JSSocket::Constructor(JSContext *cx, JS::CallArgs &args,
         JS::HandleObject obj)
@@ -599,6 +1135,20 @@ bool JSSocket::JS_write(JSContext *cx, JS::CallArgs &args)
     } else if (args[0].isObject()) {
         JSObject *objdata = args[0].toObjectOrNull();
 
+        if (objdata && JS_IsArrayBufferViewObject(objdata)) {
+            /* e.g. a buffer received from a pooled socket */
+            uint32_t len = JS_GetArrayBufferViewByteLength(objdata);
+
+            bool shared;
+            JS::AutoCheckCannotGC nogc;
+            uint8_t *data = static_cast<uint8_t *>(
+                JS_GetArrayBufferViewData(objdata, &shared, nogc));
+
+            args.rval().setInt32(this->write(data, len, APE_DATA_COPY));
+
+            return true;
+        }
+
         if (!objdata || !JS_IsArrayBufferObject(objdata)) {
             JS_ReportError(cx,
                            "write() invalid data (must be either a string or "
@@ -692,6 +1242,77 @@ bool JSSocket::JS_sendTo(JSContext *cx, JS::CallArgs &args)
 
     return true;
 }
+
+bool JSSocket::JS_release(JSContext *cx, JS::CallArgs &args)
+{
+    if (!args[0].isObject()) {
+        JS_ReportError(cx, "release() invalid data (must be a buffer received "
+                           "by onread or onmessage)");
+        return false;
+    }
+
+    JS::RootedObject data(cx, &args[0].toObject());
+
+    args.rval().setBoolean(m_BufferPool && m_BufferPool->release(cx, data));
+
+    return true;
+}
+
+bool JSSocket::JS_getBufferPoolStats(JSContext *cx, JS::CallArgs &args)
+{
+    if (!m_BufferPool) {
+        args.rval().setNull();
+        return true;
+    }
+
+    const JSSocketBufferPool::Stats &stats = m_BufferPool->getStats();
+    JS::RootedObject ret(cx, JS_NewPlainObject(cx));
+    JS::RootedValue val(cx);
+
+#define SET_POOL_STAT(name, value)                               \
+    val.setNumber(static_cast<double>(value));                   \
+    JS_DefineProperty(cx, ret, name, val, JSPROP_ENUMERATE);
+
+    SET_POOL_STAT("count", m_BufferPool->getCount());
+    SET_POOL_STAT("inUse", m_BufferPool->getInUse());
+    SET_POOL_STAT("reused", stats.reused);
+    SET_POOL_STAT("allocated", stats.allocated);
+    SET_POOL_STAT("fallback", stats.fallback);
+    SET_POOL_STAT("released", stats.released);
+    SET_POOL_STAT("bytes", stats.bytes);
+#undef SET_POOL_STAT
+
+    args.rval().setObject(*ret);
+
+    return true;
+}
+
+bool JSSocket::JS_getReadStats(JSContext *cx, JS::CallArgs &args)
+{
+    JS::RootedObject ret(cx, JS_NewPlainObject(cx));
+    JS::RootedValue val(cx);
+
+#define SET_READ_STAT(name, value)                               \
+    val.setNumber(static_cast<double>(value));                   \
+    JS_DefineProperty(cx, ret, name, val, JSPROP_ENUMERATE);
+
+    SET_READ_STAT("messages", m_ReadStats.messages);
+    SET_READ_STAT("callbacks", m_ReadStats.callbacks);
+    /* onread calls avoided by coalescing */
+    SET_READ_STAT("saved", m_ReadStats.messages - m_ReadStats.callbacks);
+#undef SET_READ_STAT
+
+    args.rval().setObject(*ret);
+
+    return true;
+}
+
+void JSSocket::jsTrace(class JSTracer *trc)
+{
+    if (m_BufferPool) {
+        m_BufferPool->trace(trc);
+    }
+}
 // }}}
 
 // {{{ Socket client callbacks
@@ -754,6 +1375,8 @@ static void nidium_socket_wrapper_disconnect(ape_socket *s,
     JS::RootedValue ondisconnect(cx);
     JS::RootedValue rval(cx);
 
+    /* Deliver what was received before the disconnection */
+    nsocket->flushCoalesced();
     nsocket->dettach();
 
     JS::RootedObject obj(cx, nsocket->getJSObject());
@@ -910,6 +1533,20 @@ bool JSSocketClientConnection::JS_write(JSContext *cx, JS::CallArgs &args)
     } else if (args[0].isObject()) {
         JSObject *objdata = args[0].toObjectOrNull();
 
+        if (objdata && JS_IsArrayBufferViewObject(objdata)) {
+            /* e.g. a buffer received from a pooled socket */
+            uint32_t len = JS_GetArrayBufferViewByteLength(objdata);
+
+            bool shared;
+            JS::AutoCheckCannotGC nogc;
+            uint8_t *data = static_cast<uint8_t *>(
+                JS_GetArrayBufferViewData(objdata, &shared, nogc));
+
+            args.rval().setInt32(this->write(data, len, APE_DATA_COPY));
+
+            return true;
+        }
+
         if (!objdata || !JS_IsArrayBufferObject(objdata)) {
             JS_ReportError(cx,
                            "write() invalid data (must be either a string or "
@@ -960,6 +1597,9 @@ JSFunctionSpec *JSSocket::ListMethods()
         CLASSMAPPER_FN(JSSocket, write, 1),
         CLASSMAPPER_FN(JSSocket, disconnect, 0),
         CLASSMAPPER_FN(JSSocket, sendTo, 3),
+        CLASSMAPPER_FN(JSSocket, release, 1),
+        CLASSMAPPER_FN(JSSocket, getBufferPoolStats, 0),
+        CLASSMAPPER_FN(JSSocket, getReadStats, 0),
 
         JS_FS_END
     };
@@ -974,6 +1614,9 @@ JSPropertySpec *JSSocket::ListProperties()
         CLASSMAPPER_PROP_GS(JSSocket, readline),
         CLASSMAPPER_PROP_GS(JSSocket, encoding),
         CLASSMAPPER_PROP_GS(JSSocket, timeout),
+        CLASSMAPPER_PROP_GS(JSSocket, bufferPool),
+        CLASSMAPPER_PROP_GS(JSSocket, framing),
+        CLASSMAPPER_PROP_GS(JSSocket, coalesce),
 
         JS_PS_END
     };
@@ -983,7 +1626,7 @@ JSPropertySpec *JSSocket::ListProperties()
 
 void JSSocket::RegisterObject(JSContext *cx)
 {
-    JSSocket::ExposeClass<2>(cx, "Socket");
+    JSSocket::ExposeClass<2>(cx, "Socket", 0, JSSocket::kJSTracer_ExposeFlag);
     JSSocketClientConnection::ExposeClass(cx, "SocketClientConnection");
 }
 
@@ -6,6 +6,9 @@
 #ifndef binding_jssocket_h__
 #define binding_jssocket_h__
 
+#include <unordered_map>
+#include <vector>
+
 #include <ape_netlib.h>
 
 #include "Binding/ClassMapper.h"
@@ -13,7 +16,99 @@
 namespace Nidium {
 namespace Binding {
 
-#define SOCKET_LINEBUFFER_MAX 8192
+/*
+    Maximum size of a frame reassembled by a framed socket (readline,
+    length prefix or fixed size records)
+*/
+#define SOCKET_FRAMEBUFFER_MAX (16 * 1024 * 1024)
+
+/* Default number and size of the receive buffers of a pooled socket */
+#define SOCKET_BUFFERPOOL_COUNT 64
+#define SOCKET_BUFFERPOOL_SIZE 65536
+
+// {{{ JSSocketBufferPool
+/*
+    Reusable receive buffers for binary sockets.
+
+    Instead of allocating a new ArrayBuffer for every packet, received data
+    is copied into one of the pooled ArrayBuffers and handed to JS as an
+    Uint8Array view. The buffer is owned by JS until it's given back with
+    release(), after which its content will be overwritten by the next
+    packets.
+
+    When every buffer is in use (or when the packet is larger than a
+    buffer), a regular ArrayBuffer is allocated instead.
+
+    This saves the allocation (and the GC pressure), not the copy : APE
+    reads into its own buffer and reuses it once the callback returns.
+*/
+class JSSocketBufferPool
+{
+public:
+    struct Stats
+    {
+        /* Packets delivered in an already allocated buffer */
+        uint64_t reused;
+        /* Pooled buffers allocated */
+        uint64_t allocated;
+        /* Packets delivered in a non-pooled buffer */
+        uint64_t fallback;
+        uint64_t released;
+        uint64_t bytes;
+    };
+
+    JSSocketBufferPool(size_t count, size_t size);
+    ~JSSocketBufferPool();
+
+    /*
+        Copy |data| into a free buffer and return a view over it
+    */
+    JSObject *acquire(JSContext *cx, const char *data, size_t len);
+
+    /*
+        Give back the buffer backing |view| (or the buffer itself).
+        Returns false if it doesn't belong to the pool.
+    */
+    bool release(JSContext *cx, JS::HandleObject view);
+
+    void trace(class JSTracer *trc);
+
+    size_t getCount() const
+    {
+        return m_Count;
+    }
+
+    size_t getInUse() const
+    {
+        return m_Count - m_FreeCount;
+    }
+
+    const Stats &getStats() const
+    {
+        return m_Stats;
+    }
+
+private:
+    struct Buffer
+    {
+        JS::Heap<JSObject *> m_Obj;
+        /* Contents of m_Obj (they don't move, unlike the object) */
+        void *m_Data;
+        bool m_InUse;
+    };
+
+    Buffer *m_Buffers;
+    /* Buffers index by contents, to find back a released buffer */
+    std::unordered_map<void *, size_t> m_Index;
+    /* Stack of free buffers index */
+    size_t *m_Free;
+    size_t m_FreeCount;
+    size_t m_Count;
+    size_t m_Size;
+
+    Stats m_Stats;
+};
+// }}}
 
 class JSSocketBase
 {
@@ -26,9 +121,45 @@ public:
     enum SocketType
     {
         kSocketType_Binary          = 1 << 0,
-        kSocketType_Readline        = 1 << 1,
         kSocketType_Server          = 1 << 2,
-        kSocketType_ConnectedClient = 1 << 3
+        kSocketType_ConnectedClient = 1 << 3,
+        /* Reads of a loop iteration are handed to onread at once */
+        kSocketType_Coalesce        = 1 << 4
+    };
+
+    struct ReadStats
+    {
+        /* Messages handed to JS */
+        uint64_t messages;
+        /* Calls to onread */
+        uint64_t callbacks;
+    };
+
+    /*
+        Messages are reassembled before being handed to JS,
+        one onread callback per message
+    */
+    enum FramingType
+    {
+        kFraming_None,
+        /* Messages separated by a delimiter byte (readline) */
+        kFraming_Delimiter,
+        /* Messages prefixed by their uint16/uint32 length */
+        kFraming_Length,
+        /* Fixed size records */
+        kFraming_Fixed
+    };
+
+    struct Framing
+    {
+        FramingType type;
+        /* kFraming_Delimiter */
+        uint8_t delimiter;
+        /* kFraming_Length : 2 or 4 bytes prefix */
+        uint8_t prefixSize;
+        bool littleEndian;
+        /* kFraming_Fixed */
+        size_t recordSize;
     };
     int write(unsigned char *data,
               size_t len,
@@ -65,10 +196,14 @@ public:
         return m_ParentServer ? m_ParentServer->m_Encoding : m_Encoding;
     }
 
-    uint8_t getFrameDelimiter() const
+    const Framing &getFraming() const
     {
-        return m_ParentServer ? m_ParentServer->m_FrameDelimiter
-                              : m_FrameDelimiter;
+        return m_ParentServer ? m_ParentServer->m_Framing : m_Framing;
+    }
+
+    JSSocketBufferPool *getBufferPool() const
+    {
+        return m_ParentServer ? m_ParentServer->m_BufferPool : m_BufferPool;
     }
 
     bool isClientFromOwnServer() const
@@ -83,8 +218,41 @@ public:
     }
 
     virtual JSObject *getjsobj() const=0;
+
+    /*
+        Hand a message to onread
+    */
     void readFrame(const char *buf, size_t len);
 
+    /*
+        Call onread with the messages received during the current loop
+        iteration (coalesce mode)
+    */
+    void flushCoalesced();
+
+    /*
+        Reassemble the messages of a framed socket
+    */
+    void readFramed(const char *data, size_t len);
+
+    /*
+        Append to the incomplete message, closing the connection if it
+        exceeds SOCKET_FRAMEBUFFER_MAX
+    */
+    bool bufferFrame(const char *buf, size_t len);
+    void frameOverflow();
+
+    bool newFrameValue(const char *buf, size_t len,
+                       JS::MutableHandleValue val);
+    void callOnRead(JS::HandleValue data);
+
+    static int FlushCoalesced(void *arg);
+
+    /*
+        Create the JS object holding binary data received on the socket
+    */
+    JSObject *newBinaryData(const char *data, size_t len);
+
     /*
         These need to be public because we don't forward APE_socket callbacks
         to the class directly.
@@ -98,13 +266,22 @@ public:
 
     char *m_Encoding;
 
+    Framing m_Framing;
+
+    /* Incomplete message of a framed socket */
+    buffer *m_FrameBuffer;
+
+    /* Messages waiting for the end of the loop iteration */
     struct
     {
-        char *data;
-        size_t pos;
-    } m_LineBuffer;
+        buffer *data;
+        std::vector<size_t> lengths;
+        uint64_t timer;
+    } m_Coalesced;
 
-    uint8_t m_FrameDelimiter;
+    ReadStats m_ReadStats;
+
+    JSSocketBufferPool *m_BufferPool;
 
     JSSocketBase *m_ParentServer;
 
@@ -147,11 +324,19 @@ protected:
     NIDIUM_DECL_JSCALL(write);
     NIDIUM_DECL_JSCALL(disconnect);
     NIDIUM_DECL_JSCALL(sendTo);
+    NIDIUM_DECL_JSCALL(release);
+    NIDIUM_DECL_JSCALL(getBufferPoolStats);
+    NIDIUM_DECL_JSCALL(getReadStats);
+
+    NIDIUM_DECL_JSTRACER();
 
     NIDIUM_DECL_JSGETTERSETTER(binary);
     NIDIUM_DECL_JSGETTERSETTER(readline);
     NIDIUM_DECL_JSGETTERSETTER(encoding);
     NIDIUM_DECL_JSGETTERSETTER(timeout);
+    NIDIUM_DECL_JSGETTERSETTER(bufferPool);
+    NIDIUM_DECL_JSGETTERSETTER(framing);
+    NIDIUM_DECL_JSGETTERSETTER(coalesce);
 
 };
 
@@ -18,6 +18,8 @@ namespace Binding {
 JSStream::JSStream(ape_global *net,
                    const char *url)
 {
+    this->setStatsName("JSStream");
+
     std::string str = url;
     // str += NidiumJS::getNidiumClass(cx)->getPath();
 
@@ -16,6 +16,8 @@
 
 
 #include "Binding/JSConsole.h"
+#include "Binding/JSAtomics.h"
+#include "Binding/JSThreadPool.h"
 #include <js/StructuredClone.h>
 
 namespace Nidium {
@@ -32,6 +34,8 @@ struct nidium_thread_msg
 extern void
 reportError(JSContext *cx, const char *message, JSErrorReport *report);
 static bool nidium_post_message(JSContext *cx, unsigned argc, JS::Value *vp);
+static bool
+nidium_transfer_on_complete(JSContext *cx, unsigned argc, JS::Value *vp);
 
 static JSClass global_Thread_class = { "_GLOBALThread",
                                        JSCLASS_GLOBAL_FLAGS | JSCLASS_IS_GLOBAL,
@@ -49,7 +53,10 @@ static JSClass global_Thread_class = { "_GLOBALThread",
                                        JS_GlobalObjectTraceHook};
 
 static JSFunctionSpec glob_funcs_threaded[]
-    = { JS_FN("send", nidium_post_message, 1, NIDIUM_JS_FNPROPS), JS_FS_END };
+    = { JS_FN("send", nidium_post_message, 1, NIDIUM_JS_FNPROPS),
+        JS_FN("transferOnComplete", nidium_transfer_on_complete, 1,
+              NIDIUM_JS_FNPROPS),
+        JS_FS_END };
 
 static bool JSThreadCallback(JSContext *cx)
 {
@@ -62,7 +69,110 @@ static bool JSThreadCallback(JSContext *cx)
     return true;
 }
 
-JSObject *_CreateJSGlobal(JSContext *cx)
+static void *nidium_thread(void *arg)
+{
+    JSThread *nthread = static_cast<JSThread *>(arg);
+
+    JSRuntime *rt;
+    JSContext *tcx;
+
+    if (!JSThread::InitRuntime(nthread->m_ParentRuntime, nthread->m_Njs, &rt,
+                               &tcx)) {
+        return NULL;
+    }
+
+    nthread->m_JsRuntime = rt;
+    nthread->m_JsCx      = tcx;
+
+    {
+        JSAutoRequest ar(tcx);
+
+        JS::RootedObject gbl(tcx, JSThread::CreateGlobal(tcx));
+        if (gbl.get()) {
+            JSAutoCompartment ac(tcx, gbl);
+            JS::RootedFunction cf(tcx);
+
+            /* Hold the parent cx */
+            JS_SetContextPrivate(tcx, nthread);
+
+            nthread->compile(tcx, &cf);
+            nthread->run(tcx, gbl, cf);
+        }
+    }
+
+    nthread->postComplete();
+
+    NidiumLocalContext *nlc = NidiumLocalContext::Get();
+    nlc->shutdown();
+
+    JS_DestroyContext(tcx);
+    JS_DestroyRuntime(rt);
+    nthread->m_JsRuntime = NULL;
+    nthread->m_JsCx      = NULL;
+
+    return NULL;
+}
+// }}}
+
+// {{{ JSThread
+JSThread::JSThread()
+    : m_JsFunction(NULL), m_JsRuntime(NULL), m_JsCx(NULL),
+      m_Njs(NULL), m_Params({ 0, NULL, 0, false }),
+      m_MarkedStop(false), m_Pooled(false), m_CompleteTransfer(NULL),
+      m_CompleteMsg(NULL),
+      m_CallerFileName(NULL),
+      m_CallerLineNo(0)
+{
+    this->setStatsName("JSThread");
+
+    /* cx hold the main context (caller) */
+    /* jsCx hold the newly created context (along with jsRuntime) */
+    m_Cx = NULL;
+}
+
+bool JSThread::InitRuntime(JSRuntime *parent,
+                           NidiumJS *njs,
+                           JSRuntime **rt,
+                           JSContext **cx)
+{
+    JSRuntime *trt;
+    JSContext *tcx;
+
+    if ((trt = JS_NewRuntime(JS::DefaultHeapMaxBytes,
+        JS::DefaultNurseryBytes, parent)) == NULL) {
+        fprintf(stderr, "Failed to init JS runtime");
+        return false;
+    }
+
+    NidiumJS::SetJSRuntimeOptions(trt);
+
+    if ((tcx = JS_NewContext(trt, 8192)) == NULL) {
+        fprintf(stderr, "Failed to init JS context");
+        JS_DestroyRuntime(trt);
+        return false;
+    }
+
+    JSAutoRequest ar(tcx);
+    JS_SetGCParameterForThread(tcx, JSGC_MAX_CODE_CACHE_BYTES,
+                               16 * 1024 * 1024);
+
+    JS_SetInterruptCallback(trt, JSThreadCallback);
+
+    NidiumLocalContext::InitJSThread(trt, tcx);
+
+    /*
+        repportError read the runtime private to use the logger
+    */
+    JS_SetRuntimePrivate(trt, njs);
+    JS_SetErrorReporter(trt, reportError);
+
+    *rt = trt;
+    *cx = tcx;
+
+    return true;
+}
+
+JSObject *JSThread::CreateGlobal(JSContext *cx)
 {
     JS::CompartmentOptions options;
     options.setVersion(JSVERSION_LATEST);
@@ -70,12 +180,19 @@ JSObject *_CreateJSGlobal(JSContext *cx)
     JS::RootedObject glob(
         cx, JS_NewGlobalObject(cx, &global_Thread_class, nullptr,
                                JS::DontFireOnNewGlobalHook, options));
+    if (!glob) {
+        return nullptr;
+    }
+
     JSAutoCompartment ac(cx, glob);
     JS_InitStandardClasses(cx, glob);
     JS_DefineDebuggerObject(cx, glob);
     JS_DefineFunctions(cx, glob, glob_funcs_threaded);
     JS_FireOnNewGlobalObject(cx, glob);
 
+    JSConsole::RegisterObject(cx);
+    JSAtomics::RegisterObject(cx);
+
     return glob;
     // JS::RegisterPerfMeasurement(cx, glob);
 
@@ -83,135 +200,104 @@ JSObject *_CreateJSGlobal(JSContext *cx)
     // context option vs compile option?
 }
 
-static void *nidium_thread(void *arg)
+bool JSThread::compile(JSContext *tcx, JS::MutableHandleFunction fn)
 {
-    JSThread *nthread = static_cast<JSThread *>(arg);
+    size_t len   = strlen(m_JsFunction) + 128;
+    char *scoped = new char[len];
+    /*
+        JS_CompileFunction takes a function body.
+        This is a hack in order to catch the arguments name, etc...
 
-    JSRuntime *rt;
-    JSContext *tcx;
+        function() {
+            (function (a) {
+                this.send("hello" + a);
+            }).apply(this, Array.prototype.slice.apply(arguments));
+        };
+    */
+    snprintf(scoped, len, "return %c%s%s", '(', m_JsFunction,
+             ").apply(this, Array.prototype.slice.apply(arguments));");
 
-    if ((rt = JS_NewRuntime(JS::DefaultHeapMaxBytes,
-        JS::DefaultNurseryBytes, nthread->m_ParentRuntime))
-        == NULL) {
-        fprintf(stderr, "Failed to init JS runtime");
-        return NULL;
-    }
+    JS::CompileOptions options(tcx);
+    options.setFileAndLine(m_CallerFileName, m_CallerLineNo).setUTF8(true);
 
-    NidiumJS::SetJSRuntimeOptions(rt);
+    JS::AutoObjectVector scopeChain(tcx);
 
-    if ((tcx = JS_NewContext(rt, 8192)) == NULL) {
-        fprintf(stderr, "Failed to init JS context");
-        JS_DestroyRuntime(rt);
-        return NULL;
-    } else {
-        JSAutoRequest ar(tcx);
-        JS_SetGCParameterForThread(tcx, JSGC_MAX_CODE_CACHE_BYTES,
-                                   16 * 1024 * 1024);
-
-        JS_SetInterruptCallback(rt, JSThreadCallback);
-
-        NidiumLocalContext::InitJSThread(rt, tcx);
-
-        nthread->m_JsRuntime = rt;
-        nthread->m_JsCx      = tcx;
-
-        /*
-            repportError read the runtime private to use the logger
-        */
-        JS_SetRuntimePrivate(rt, nthread->m_Njs);
-        JS_SetErrorReporter(rt, reportError);
-
-        JS::RootedObject gbl(tcx, _CreateJSGlobal(tcx));
-        if (gbl.get()) {
-            JSAutoCompartment ac(tcx, gbl);
-            JS::RootedValue rval(tcx, JS::NullValue());
+    bool cret = JS::CompileFunction(tcx, scopeChain, options, NULL, 0, NULL,
+                                    scoped, strlen(scoped), fn);
 
-            JSConsole::RegisterObject(tcx);
+    delete[] scoped;
 
-            JSAutoByteString str(tcx, nthread->m_JsFunction);
-            char *scoped = new char[strlen(str.ptr()) + 128];
-            /*
-                JS_CompileFunction takes a function body.
-                This is a hack in order to catch the arguments name, etc...
-
-                function() {
-                    (function (a) {
-                        this.send("hello" + a);
-                    }).apply(this, Array.prototype.slice.apply(arguments));
-                };
-            */
-            sprintf(scoped, "return %c%s%s", '(', str.ptr(),
-                    ").apply(this, Array.prototype.slice.apply(arguments));");
-
-            /* Hold the parent cx */
-            JS_SetContextPrivate(tcx, nthread);
-
-            JS::CompileOptions options(tcx);
-            options.setFileAndLine(nthread->m_CallerFileName,
-                                   nthread->m_CallerLineNo)
-                .setUTF8(true);
+    if (!cret) {
+        fprintf(stderr, "Can't compile function");
+        return false;
+    }
 
-            JS::RootedFunction cf(tcx);
+    return true;
+}
 
-            JS::AutoObjectVector scopeChain(tcx);
+void JSThread::run(JSContext *tcx,
+                   JS::HandleObject global,
+                   JS::HandleFunction fn)
+{
+    JS::RootedValue rval(tcx, JS::NullValue());
+    JS::AutoValueVector arglst(tcx);
+    arglst.resize(m_Params.argc);
 
-            bool cret = JS::CompileFunction(tcx, scopeChain, options,
-                            NULL, 0, NULL, scoped,
-                            strlen(scoped), &cf);
+    for (size_t i = 0; i < m_Params.argc; i++) {
+        JS::RootedValue args(tcx);
+        JSTransferable::Read(tcx, m_Params.argv[i], m_Params.nbytes[i],
+                             &args);
 
-            NidiumLocalContext::UnrootObject(nthread->m_JsFunction);
+        arglst[i].set(args);
+    }
 
-            delete[] scoped;
+    /* startWithTransfer() : a single array holding the arguments */
+    if (m_Params.spread) {
+        JS::RootedValue list(tcx, arglst.length() ? arglst[0]
+                                                  : JS::UndefinedValue());
+        uint32_t len = 0;
 
-            if (!cret) {
-                fprintf(stderr, "Can't compile function");
-                return NULL;
-            }
+        arglst.clear();
 
-            JS::AutoValueVector arglst(tcx);
-            arglst.resize(nthread->m_Params.argc);
+        if (list.isObject()) {
+            JS::RootedObject listobj(tcx, &list.toObject());
 
-            for (size_t i = 0; i < nthread->m_Params.argc; i++) {
-                JS::RootedValue args(tcx);
-                JS_ReadStructuredClone(
-                    tcx, nthread->m_Params.argv[i], nthread->m_Params.nbytes[i],
-                    JS_STRUCTURED_CLONE_VERSION, &args, NidiumJS::m_JsScc, NULL);
+            if (JS_GetArrayLength(tcx, listobj, &len)) {
+                arglst.resize(len);
 
-                arglst[i].set(args);
-                JS_ClearStructuredClone(nthread->m_Params.argv[i],
-                                        nthread->m_Params.nbytes[i], NidiumJS::m_JsScc,
-                                        NULL);
-            }
+                for (uint32_t i = 0; i < len; i++) {
+                    JS::RootedValue arg(tcx);
 
-            if (JS_CallFunction(tcx, gbl, cf, arglst, &rval) == false) {
+                    JS_GetElement(tcx, listobj, i, &arg);
+                    arglst[i].set(arg);
+                }
             }
-
-            free(nthread->m_Params.argv);
-            free(nthread->m_Params.nbytes);
-            nthread->onComplete(rval);
         }
     }
-    NidiumLocalContext *nlc = NidiumLocalContext::Get();
-    nlc->shutdown();
 
-    JS_DestroyContext(tcx);
-    JS_DestroyRuntime(rt);
-    nthread->m_JsRuntime = NULL;
-    nthread->m_JsCx      = NULL;
+    free(m_Params.argv);
+    free(m_Params.nbytes);
+
+    m_Params.argv   = NULL;
+    m_Params.nbytes = NULL;
+    m_Params.argc   = 0;
+
+    /*
+        Properties set on |this| by the job stay on a fresh object
+        (inheriting send() and friends from the global)
+    */
+    JS::RootedObject thisobj(tcx, JS_NewPlainObject(tcx));
+    if (!thisobj || !JS_SetPrototype(tcx, thisobj, global)) {
+        JS_ClearPendingException(tcx);
+        thisobj = global;
+    }
 
-    return NULL;
-}
-// }}}
+    if (!fn || JS_CallFunction(tcx, thisobj, fn, arglst, &rval) == false) {
+        /* The context may be reused by the next job */
+        JS_ClearPendingException(tcx);
+    }
 
-// {{{ JSThread
-JSThread::JSThread()
-    : m_JsRuntime(NULL), m_JsCx(NULL),
-      m_Njs(NULL), m_Params({ 0, NULL, 0 }),
-      m_MarkedStop(false), m_CallerFileName(NULL), m_CallerLineNo(0)
-{
-    /* cx hold the main context (caller) */
-    /* jsCx hold the newly created context (along with jsRuntime) */
-    m_Cx = NULL;
+    this->onComplete(rval);
 }
 
 void JSThread::onMessage(const Core::SharedMessages::Message &msg)
@@ -224,15 +310,27 @@ void JSThread::onMessage(const Core::SharedMessages::Message &msg)
     ptr = static_cast<struct nidium_thread_msg *>(msg.dataPtr());
     memset(prop, 0, sizeof(prop));
 
-    JS::RootedValue inval(m_Cx, JS::NullValue());
-    if (!JS_ReadStructuredClone(m_Cx, ptr->data, ptr->nbytes,
-                                JS_STRUCTURED_CLONE_VERSION, &inval, NidiumJS::m_JsScc,
-                                NULL)) {
+    /*
+        data is NULL when the thread failed to write the value
+        (e.g. a function returned by the job)
+    */
+    JS::RootedValue inval(m_Cx, JS::UndefinedValue());
+    if (!ptr->data
+        || !JSTransferable::Read(m_Cx, ptr->data, ptr->nbytes, &inval)) {
 
         ndm_log(NDM_LOG_ERROR, "JSThread", "Failed to read input data (readMessage)");
 
-        delete ptr;
-        return;
+        if (JS_IsExceptionPending(m_Cx)) {
+            JS_ClearPendingException(m_Cx);
+        }
+
+        inval.setUndefined();
+
+        /* The complete event is still fired so that the Thread is unrooted */
+        if (ev != kThread_Complete) {
+            delete ptr;
+            return;
+        }
     }
 
     JS::RootedObject event(m_Cx, JSEvents::CreateEventObject(m_Cx));
@@ -242,9 +340,15 @@ void JSThread::onMessage(const Core::SharedMessages::Message &msg)
 
     this->fireJSEvent(eventName[ev], &eventVal);
 
-    JS_ClearStructuredClone(ptr->data, ptr->nbytes, NidiumJS::m_JsScc, NULL);
-
     delete ptr;
+
+    /*
+        Unrooted from the main thread, the rooted things
+        are local to each thread
+    */
+    if (ev == kThread_Complete) {
+        this->unroot();
+    }
 }
 
 
@@ -252,28 +356,80 @@ void JSThread::onComplete(JS::HandleValue vp)
 {
     struct nidium_thread_msg *msg = new struct nidium_thread_msg;
 
-    if (!JS_WriteStructuredClone(m_JsCx, vp, &msg->data, &msg->nbytes,
-                                 NidiumJS::m_JsScc,
-                                 NULL, JS::NullHandleValue)) {
+    JS::RootedValue transfer(m_JsCx);
+    if (m_CompleteTransfer) {
+        transfer = *m_CompleteTransfer;
+
+        delete m_CompleteTransfer;
+        m_CompleteTransfer = NULL;
+    }
+
+    if (!JSTransferable::Write(m_JsCx, vp, transfer, &msg->data,
+                               &msg->nbytes)) {
+
+        /* e.g. invalid transfer list */
+        JS_ReportPendingException(m_JsCx);
 
         msg->data   = NULL;
         msg->nbytes = 0;
     }
 
-    this->postMessage(msg, JSThread::kThread_Complete);
+    m_CompleteMsg = msg;
+}
+
+void JSThread::postComplete()
+{
+    struct nidium_thread_msg *msg = m_CompleteMsg;
+
+    m_CompleteMsg = NULL;
+
+    /* Being destroyed, nobody is listening anymore */
+    if (m_MarkedStop) {
+        if (msg) {
+            JSTransferable::Clear(msg->data, msg->nbytes);
+            delete msg;
+        }
+        return;
+    }
 
-    this->unroot();
+    if (!msg) {
+        msg         = new struct nidium_thread_msg;
+        msg->data   = NULL;
+        msg->nbytes = 0;
+    }
+
+    this->postMessage(msg, JSThread::kThread_Complete);
 }
 
 
 JSThread::~JSThread()
 {
     this->m_MarkedStop = true;
-    if (m_JsRuntime) {
+    if (m_Pooled) {
+        /* The pool is gone once NidiumJS started its shutdown */
+        JSThreadPool *pool = m_Njs->getThreadPool(false);
+        if (pool) {
+            pool->cancel(this);
+        }
+    } else if (m_JsRuntime) {
         JS_RequestInterruptCallback(m_JsRuntime);
         pthread_join(this->m_ThreadHandle, NULL);
     }
 
+    if (m_CompleteMsg) {
+        JSTransferable::Clear(m_CompleteMsg->data, m_CompleteMsg->nbytes);
+        delete m_CompleteMsg;
+    }
+
+    /* Never started (or cancelled before running) */
+    for (int i = 0; i < m_Params.argc; i++) {
+        JSTransferable::Clear(m_Params.argv[i], m_Params.nbytes[i]);
+    }
+    free(m_Params.argv);
+    free(m_Params.nbytes);
+
+    free(m_JsFunction);
+
     if (m_CallerFileName) {
         free(m_CallerFileName);
     }
@@ -283,6 +439,13 @@ bool JSThread::JS_start(JSContext *cx, JS::CallArgs &args)
 {
     int argc = args.length();
 
+    /* TODO: check if already running */
+    JSThreadPool *pool = m_Njs->getThreadPool();
+    if (!pool) {
+        JS_ReportError(cx, "Thread pool is shut down");
+        return false;
+    }
+
     this->m_Params.argv
         = (argc ? (uint64_t **)malloc(sizeof(*this->m_Params.argv) * argc)
                 : NULL);
@@ -291,24 +454,78 @@ bool JSThread::JS_start(JSContext *cx, JS::CallArgs &args)
                 : NULL);
 
     for (int i = 0; i < static_cast<int>(argc); i++) {
-        if (!JS_WriteStructuredClone(cx, args[i], &this->m_Params.argv[i],
-                                     &this->m_Params.nbytes[i], NidiumJS::m_JsScc, NULL,
-                                     JS::NullHandleValue)) {
+        if (!JSTransferable::Write(cx, args[i], JS::NullHandleValue,
+                                   &this->m_Params.argv[i],
+                                   &this->m_Params.nbytes[i])) {
 
             return false;
         }
     }
 
-    this->m_Params.argc = argc;
+    this->m_Params.argc   = argc;
+    this->m_Params.spread = false;
 
-    /* TODO: check if already running */
-    pthread_create(&this->m_ThreadHandle, NULL, nidium_thread, this);
+    this->launch(pool);
 
-    this->root();
+    return true;
+}
+
+bool JSThread::JS_startWithTransfer(JSContext *cx, JS::CallArgs &args)
+{
+    bool isArray = true;
+
+    JSThreadPool *pool = m_Njs->getThreadPool();
+    if (!pool) {
+        JS_ReportError(cx, "Thread pool is shut down");
+        return false;
+    }
+
+    if (!args.get(0).isNullOrUndefined()) {
+        JS::RootedObject list(cx,
+            args[0].isObject() ? &args[0].toObject() : nullptr);
+
+        if (!list || !JS_IsArrayObject(cx, list, &isArray) || !isArray) {
+            JS_ReportError(cx, "startWithTransfer() expects an array of "
+                               "arguments");
+            return false;
+        }
+    }
+
+    /*
+        The arguments are written at once, a buffer can only be
+        transferred a single time. run() spreads them back.
+    */
+    uint64_t *data;
+    size_t nbytes;
+
+    if (!JSTransferable::Write(cx, args.get(0), args.get(1), &data,
+                               &nbytes)) {
+        return false;
+    }
+
+    this->m_Params.argv   = (uint64_t **)malloc(sizeof(*this->m_Params.argv));
+    this->m_Params.nbytes = (size_t *)malloc(sizeof(*this->m_Params.nbytes));
+
+    this->m_Params.argv[0]   = data;
+    this->m_Params.nbytes[0] = nbytes;
+    this->m_Params.argc      = 1;
+    this->m_Params.spread    = true;
+
+    this->launch(pool);
 
     return true;
 }
 
+void JSThread::launch(JSThreadPool *pool)
+{
+    this->root();
+
+    m_Pooled = pool->run(this);
+    if (!m_Pooled) {
+        pthread_create(&this->m_ThreadHandle, NULL, nidium_thread, this);
+    }
+}
+
 static bool nidium_post_message(JSContext *cx, unsigned argc, JS::Value *vp)
 {
     uint64_t *datap;
@@ -331,10 +548,11 @@ static bool nidium_post_message(JSContext *cx, unsigned argc, JS::Value *vp)
 
     struct nidium_thread_msg *msg;
 
-    if (!JS_WriteStructuredClone(cx, args[0], &datap, &nbytes, NidiumJS::m_JsScc, NULL,
-                                 JS::NullHandleValue)) {
-        JS_ReportError(cx, "Failed to write strclone");
-        /* TODO: exception */
+    /* ArrayBuffers listed in args[1] are moved instead of being copied */
+    if (!JSTransferable::Write(cx, args[0], args.get(1), &datap, &nbytes)) {
+        if (!JS_IsExceptionPending(cx)) {
+            JS_ReportError(cx, "Failed to write strclone");
+        }
         return false;
     }
 
@@ -349,21 +567,62 @@ static bool nidium_post_message(JSContext *cx, unsigned argc, JS::Value *vp)
 }
 
 
+static bool
+nidium_transfer_on_complete(JSContext *cx, unsigned argc, JS::Value *vp)
+{
+    JSThread *nthread = static_cast<JSThread *>(JS_GetContextPrivate(cx));
+
+    JS::CallArgs args = JS::CallArgsFromVp(argc, vp);
+
+    if (!args.requireAtLeast(cx, "transferOnComplete", 1)) {
+        return false;
+    }
+
+    if (nthread == NULL || nthread->m_MarkedStop) {
+        JS_ReportError(cx, "thread.transferOnComplete() Could not retrieve "
+                           "thread (or marked for stopping)");
+        return false;
+    }
+
+    if (!args[0].isNullOrUndefined()) {
+        bool isArray;
+        JS::RootedObject list(cx, args[0].toObjectOrNull());
+
+        if (!list || !JS_IsArrayObject(cx, list, &isArray) || !isArray) {
+            JS_ReportError(cx, "transferOnComplete() expects an array");
+            return false;
+        }
+    }
+
+    /* Rooted in the thread runtime, released by onComplete() */
+    if (!nthread->m_CompleteTransfer) {
+        nthread->m_CompleteTransfer = new JS::PersistentRootedValue(cx);
+    }
+
+    nthread->m_CompleteTransfer->set(args[0]);
+
+    return true;
+}
+
 JSThread * JSThread::Constructor(JSContext *cx, JS::CallArgs &args,
     JS::HandleObject obj)
 {
     JS::RootedScript parent(cx);
 
-    JSThread *nthread = new JSThread();
     JS::RootedFunction nfn(cx);
+    JS::RootedString src(cx);
+    JSAutoByteString csrc;
 
     if ((nfn = JS_ValueToFunction(cx, args[0])) == NULL
-        || (nthread->m_JsFunction = JS_DecompileFunction(cx, nfn, 0)) == NULL) {
+        || (src = JS_DecompileFunction(cx, nfn, 0)) == NULL
+        || !csrc.encodeUtf8(cx, src)) {
         ndm_log(NDM_LOG_ERROR, "JSThread", "Failed to read Threaded function");
         return nullptr;
     }
 
-    NidiumLocalContext::RootObjectUntilShutdown(nthread->m_JsFunction);
+    JSThread *nthread = new JSThread();
+
+    nthread->m_JsFunction = strdup(csrc.ptr());
 
     nthread->m_ParentRuntime = JS_GetRuntime(cx);
     nthread->m_Njs      = NJS;
@@ -376,10 +635,77 @@ JSThread * JSThread::Constructor(JSContext *cx, JS::CallArgs &args,
     return nthread;
 }
 
+bool JSThread::JSStatic_setPoolSize(JSContext *cx, JS::CallArgs &args)
+{
+    uint32_t size;
+
+    if (!args.requireAtLeast(cx, "setPoolSize", 1)) {
+        return false;
+    }
+
+    if (!JS::ToUint32(cx, args[0], &size)) {
+        return false;
+    }
+
+    JSThreadPool *pool = NJS->getThreadPool();
+    if (!pool) {
+        JS_ReportError(cx, "Thread pool is shut down");
+        return false;
+    }
+
+    pool->setSize(size);
+
+    return true;
+}
+
+bool JSThread::JSStatic_getPoolStats(JSContext *cx, JS::CallArgs &args)
+{
+    JSThreadPool *pool = NJS->getThreadPool();
+    if (!pool) {
+        JS_ReportError(cx, "Thread pool is shut down");
+        return false;
+    }
+
+    JSThreadPool::Stats stats = pool->getStats();
+
+    JS::RootedObject ret(cx, JS_NewPlainObject(cx));
+    JS::RootedValue val(cx);
+
+#define SET_POOL_STAT(name, value)                               \
+    val.setNumber(static_cast<double>(value));                   \
+    JS_DefineProperty(cx, ret, name, val, JSPROP_ENUMERATE);
+
+    SET_POOL_STAT("size", pool->getSize());
+    SET_POOL_STAT("workers", pool->getWorkers());
+    SET_POOL_STAT("idle", pool->getIdle());
+    SET_POOL_STAT("jobs", stats.jobs);
+    SET_POOL_STAT("reused", stats.reused);
+    SET_POOL_STAT("spawned", stats.spawned);
+    SET_POOL_STAT("dedicated", stats.dedicated);
+    SET_POOL_STAT("cacheHits", stats.cacheHits);
+#undef SET_POOL_STAT
+
+    args.rval().setObject(*ret);
+
+    return true;
+}
+
 JSFunctionSpec *JSThread::ListMethods()
 {
     static JSFunctionSpec funcs[] = {
         CLASSMAPPER_FN(JSThread, start, 0),
+        CLASSMAPPER_FN(JSThread, startWithTransfer, 2),
+        JS_FS_END
+    };
+
+    return funcs;
+}
+
+JSFunctionSpec *JSThread::ListStaticMethods()
+{
+    static JSFunctionSpec funcs[] = {
+        CLASSMAPPER_FN_STATIC(JSThread, setPoolSize, 1),
+        CLASSMAPPER_FN_STATIC(JSThread, getPoolStats, 0),
         JS_FS_END
     };
 
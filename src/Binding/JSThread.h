@@ -17,6 +17,8 @@ namespace Nidium {
 namespace Binding {
 
 class NidiumJS;
+class JSThreadPool;
+struct nidium_thread_msg;
 
 class JSThread : public ClassMapperWithEvents<JSThread>,
                  public Nidium::Core::Messages
@@ -31,13 +33,46 @@ public:
     };
     virtual ~JSThread();
     static void RegisterObject(JSContext *cx);
+
+    /*
+        Serialize the value returned by the job, posted by postComplete()
+    */
     void onComplete(JS::HandleValue vp);
+
+    /*
+        Post the complete event (with undefined data if the job didn't
+        run). Called once the thread or the worker is done with the job.
+    */
+    void postComplete();
     void onMessage(const Nidium::Core::SharedMessages::Message &msg);
     static JSThread *Constructor(JSContext *cx, JS::CallArgs &args,
         JS::HandleObject obj);
     static JSFunctionSpec *ListMethods();
+    static JSFunctionSpec *ListStaticMethods();
+
+    /*
+        Create the runtime and global of a thread
+    */
+    static bool InitRuntime(JSRuntime *parent,
+                            NidiumJS *njs,
+                            JSRuntime **rt,
+                            JSContext **cx);
+    static JSObject *CreateGlobal(JSContext *cx);
+
+    /*
+        Compile the threaded function within the current compartment
+    */
+    bool compile(JSContext *tcx, JS::MutableHandleFunction fn);
 
-    JS::Heap<JSString *> m_JsFunction;
+    /*
+        Call the compiled function with the start() arguments and
+        prepare the complete event. It's also prepared when |fn| is
+        null (compilation failed) so that the Thread is unrooted.
+    */
+    void run(JSContext *tcx, JS::HandleObject global, JS::HandleFunction fn);
+
+    /* Source of the function (UTF-8) */
+    char *m_JsFunction;
     JSRuntime *m_JsRuntime;
     JSRuntime *m_ParentRuntime;
     JSContext *m_JsCx;
@@ -47,15 +82,35 @@ public:
         int argc;
         uint64_t **argv;
         size_t *nbytes;
+        /* argv[0] is an array of arguments (startWithTransfer()) */
+        bool spread;
     } m_Params;
     bool m_MarkedStop;
 
     pthread_t m_ThreadHandle;
+    /* Run by a worker of the thread pool rather than a dedicated thread */
+    bool m_Pooled;
+
+    /*
+        ArrayBuffers moved along with the value returned by the job
+        (set with transferOnComplete() from the thread)
+    */
+    JS::PersistentRootedValue *m_CompleteTransfer;
+
+    /* Set by onComplete(), posted by postComplete() */
+    struct nidium_thread_msg *m_CompleteMsg;
 
     char *m_CallerFileName;
     uint32_t m_CallerLineNo;
+private:
+    /* Run the job once its arguments are written */
+    void launch(JSThreadPool *pool);
 protected:
     NIDIUM_DECL_JSCALL(start);
+    NIDIUM_DECL_JSCALL(startWithTransfer);
+
+    NIDIUM_DECL_JSCALL_STATIC(setPoolSize);
+    NIDIUM_DECL_JSCALL_STATIC(getPoolStats);
 };
 #endif
 
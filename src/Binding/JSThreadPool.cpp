@@ -0,0 +1,484 @@
+/*
+   Copyright 2016 Nidium Inc. All rights reserved.
+   Use of this source code is governed by a MIT license
+   that can be found in the LICENSE file.
+*/
+#include "Binding/JSThreadPool.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <mozilla/Maybe.h>
+#include <jsfriendapi.h>
+
+#include "Binding/NidiumJS.h"
+#include "Binding/JSThread.h"
+#include "Binding/ThreadLocalContext.h"
+
+namespace Nidium {
+namespace Binding {
+
+#define GLOBAL_KEYS_FLAGS (JSITER_OWNONLY | JSITER_HIDDEN | JSITER_SYMBOLS)
+
+/*
+    Copy of the own properties of a freshly created global
+*/
+static JSObject *SnapshotGlobal(JSContext *cx, JS::HandleObject global)
+{
+    JS::AutoIdVector ids(cx);
+    JS::RootedObject snapshot(cx, JS_NewPlainObject(cx));
+
+    if (!snapshot || !js::GetPropertyKeys(cx, global, GLOBAL_KEYS_FLAGS, &ids)) {
+        return nullptr;
+    }
+
+    for (size_t i = 0; i < ids.length(); i++) {
+        JS::RootedId id(cx, ids[i]);
+        JS::RootedValue val(cx);
+
+        if (!JS_GetPropertyById(cx, global, id, &val)
+            || !JS_DefinePropertyById(cx, snapshot, id, val,
+                                      JSPROP_ENUMERATE)) {
+            return nullptr;
+        }
+    }
+
+    return snapshot;
+}
+
+/*
+    Undo what a job did to the global : remove the properties it added,
+    restore the ones it replaced or deleted
+*/
+static void ResetGlobal(JSContext *cx,
+                        JS::HandleObject global,
+                        JS::HandleObject snapshot)
+{
+    JS::AutoIdVector ids(cx);
+
+    if (js::GetPropertyKeys(cx, global, GLOBAL_KEYS_FLAGS, &ids)) {
+        for (size_t i = 0; i < ids.length(); i++) {
+            JS::RootedId id(cx, ids[i]);
+            JS::RootedValue cur(cx);
+            JS::RootedValue orig(cx);
+            bool found;
+
+            if (!JS_AlreadyHasOwnPropertyById(cx, snapshot, id, &found)) {
+                continue;
+            }
+
+            if (!found) {
+                JS::ObjectOpResult result;
+                JS_DeletePropertyById(cx, global, id, result);
+                continue;
+            }
+
+            if (JS_GetPropertyById(cx, global, id, &cur)
+                && JS_GetPropertyById(cx, snapshot, id, &orig)
+                && cur.get() != orig.get()) {
+                JS_SetPropertyById(cx, global, id, orig);
+            }
+        }
+    }
+
+    ids.clear();
+
+    if (js::GetPropertyKeys(cx, snapshot, GLOBAL_KEYS_FLAGS, &ids)) {
+        for (size_t i = 0; i < ids.length(); i++) {
+            JS::RootedId id(cx, ids[i]);
+            JS::RootedValue orig(cx);
+            bool found;
+
+            if (JS_AlreadyHasOwnPropertyById(cx, global, id, &found)
+                && !found && JS_GetPropertyById(cx, snapshot, id, &orig)) {
+                JS_DefinePropertyById(cx, global, id, orig, 0);
+            }
+        }
+    }
+
+    JS_ClearPendingException(cx);
+}
+
+// {{{ JSThreadPool
+JSThreadPool::JSThreadPool(JSRuntime *parent, NidiumJS *njs)
+    : m_ParentRuntime(parent), m_Njs(njs), m_Size(NIDIUM_THREAD_POOL_SIZE)
+{
+    m_Stats = {};
+
+    pthread_mutex_init(&m_Lock, NULL);
+    pthread_cond_init(&m_Done, NULL);
+}
+
+JSThreadPool::~JSThreadPool()
+{
+    pthread_mutex_lock(&m_Lock);
+
+    for (Worker *worker : m_Workers) {
+        worker->m_Stop = true;
+
+        if (worker->m_Job) {
+            worker->m_Job->m_MarkedStop = true;
+            if (worker->m_Runtime) {
+                JS_RequestInterruptCallback(worker->m_Runtime);
+            }
+        }
+
+        pthread_cond_signal(&worker->m_Wakeup);
+    }
+
+    pthread_mutex_unlock(&m_Lock);
+
+    for (Worker *worker : m_Workers) {
+        pthread_join(worker->m_Handle, NULL);
+        pthread_cond_destroy(&worker->m_Wakeup);
+
+        delete worker;
+    }
+
+    pthread_cond_destroy(&m_Done);
+    pthread_mutex_destroy(&m_Lock);
+}
+
+bool JSThreadPool::run(JSThread *job)
+{
+    Worker *worker = nullptr;
+    size_t alive   = 0;
+
+    pthread_mutex_lock(&m_Lock);
+
+    this->reap();
+
+    /*
+        Most recently used workers are last, their cache is the most
+        likely to hold the function
+    */
+    for (auto it = m_Workers.rbegin(); it != m_Workers.rend(); ++it) {
+        Worker *w = *it;
+
+        if (w->m_Stop) {
+            continue;
+        }
+
+        alive++;
+
+        if (!worker && !w->m_Job) {
+            worker = w;
+        }
+    }
+
+    if (!worker && alive < m_Size) {
+        worker = new Worker();
+
+        worker->m_Pool    = this;
+        worker->m_Runtime = NULL;
+        worker->m_Job     = NULL;
+        worker->m_Stop    = false;
+        worker->m_Exited  = false;
+        worker->m_Warm    = false;
+
+        pthread_cond_init(&worker->m_Wakeup, NULL);
+
+        if (pthread_create(&worker->m_Handle, NULL, JSThreadPool::Work,
+                           worker) != 0) {
+            pthread_cond_destroy(&worker->m_Wakeup);
+            delete worker;
+            worker = nullptr;
+        } else {
+            m_Workers.push_back(worker);
+            m_Stats.spawned++;
+        }
+    }
+
+    if (!worker) {
+        m_Stats.dedicated++;
+        pthread_mutex_unlock(&m_Lock);
+
+        return false;
+    }
+
+    if (worker->m_Warm) {
+        m_Stats.reused++;
+    }
+
+    m_Stats.jobs++;
+
+    worker->m_Job = job;
+    pthread_cond_signal(&worker->m_Wakeup);
+
+    pthread_mutex_unlock(&m_Lock);
+
+    return true;
+}
+
+void JSThreadPool::cancel(JSThread *job)
+{
+    pthread_mutex_lock(&m_Lock);
+
+    job->m_MarkedStop = true;
+
+    for (Worker *worker : m_Workers) {
+        if (worker->m_Job != job) {
+            continue;
+        }
+
+        if (worker->m_Runtime) {
+            JS_RequestInterruptCallback(worker->m_Runtime);
+        }
+
+        while (worker->m_Job == job) {
+            pthread_cond_wait(&m_Done, &m_Lock);
+        }
+    }
+
+    pthread_mutex_unlock(&m_Lock);
+}
+
+void JSThreadPool::setSize(size_t size)
+{
+    size_t alive = 0;
+
+    pthread_mutex_lock(&m_Lock);
+
+    m_Size = size;
+
+    for (Worker *worker : m_Workers) {
+        if (worker->m_Stop) {
+            continue;
+        }
+
+        /* Busy workers stop once their job is done */
+        if (++alive > m_Size) {
+            worker->m_Stop = true;
+            pthread_cond_signal(&worker->m_Wakeup);
+        }
+    }
+
+    pthread_mutex_unlock(&m_Lock);
+}
+
+size_t JSThreadPool::getWorkers()
+{
+    size_t count = 0;
+
+    pthread_mutex_lock(&m_Lock);
+    for (Worker *worker : m_Workers) {
+        if (!worker->m_Stop) {
+            count++;
+        }
+    }
+    pthread_mutex_unlock(&m_Lock);
+
+    return count;
+}
+
+size_t JSThreadPool::getIdle()
+{
+    size_t count = 0;
+
+    pthread_mutex_lock(&m_Lock);
+    for (Worker *worker : m_Workers) {
+        if (!worker->m_Stop && !worker->m_Job) {
+            count++;
+        }
+    }
+    pthread_mutex_unlock(&m_Lock);
+
+    return count;
+}
+
+JSThreadPool::Stats JSThreadPool::getStats()
+{
+    pthread_mutex_lock(&m_Lock);
+    Stats stats = m_Stats;
+    pthread_mutex_unlock(&m_Lock);
+
+    return stats;
+}
+
+void JSThreadPool::reap()
+{
+    for (size_t i = 0; i < m_Workers.size();) {
+        Worker *worker = m_Workers[i];
+
+        if (!worker->m_Exited) {
+            i++;
+            continue;
+        }
+
+        pthread_join(worker->m_Handle, NULL);
+        pthread_cond_destroy(&worker->m_Wakeup);
+
+        m_Workers.erase(m_Workers.begin() + i);
+
+        delete worker;
+    }
+}
+
+void *JSThreadPool::Work(void *arg)
+{
+    Worker *worker = static_cast<Worker *>(arg);
+
+    worker->m_Pool->work(worker);
+
+    return NULL;
+}
+
+void JSThreadPool::work(Worker *worker)
+{
+    JSRuntime *rt;
+    JSContext *cx;
+
+    if (!JSThread::InitRuntime(m_ParentRuntime, m_Njs, &rt, &cx)) {
+        pthread_mutex_lock(&m_Lock);
+
+        /* The pending job is lost, as it would with a dedicated thread */
+        worker->m_Stop   = true;
+        worker->m_Job    = NULL;
+        worker->m_Exited = true;
+
+        pthread_cond_broadcast(&m_Done);
+        pthread_mutex_unlock(&m_Lock);
+
+        return;
+    }
+
+    {
+        JSAutoRequest ar(cx);
+
+        JS::RootedObject global(cx, JSThread::CreateGlobal(cx));
+        JS::RootedObject snapshot(cx);
+        mozilla::Maybe<JSAutoCompartment> ac;
+
+        if (global) {
+            ac.emplace(cx, global);
+
+            snapshot = SnapshotGlobal(cx, global);
+            if (!snapshot) {
+                JS_ClearPendingException(cx);
+                global = nullptr;
+            }
+        }
+
+        pthread_mutex_lock(&m_Lock);
+        worker->m_Runtime = rt;
+
+        if (!global) {
+            /* Drop the pending job and exit */
+            worker->m_Stop = true;
+        }
+
+        for (;;) {
+            while (!worker->m_Job && !worker->m_Stop) {
+                pthread_cond_wait(&worker->m_Wakeup, &m_Lock);
+            }
+
+            JSThread *job = worker->m_Job;
+            if (!job) {
+                break;
+            }
+
+            pthread_mutex_unlock(&m_Lock);
+
+            if (global && !job->m_MarkedStop) {
+                job->m_JsRuntime = rt;
+                job->m_JsCx      = cx;
+
+                this->runJob(worker, job, cx, global);
+
+                job->m_JsRuntime = NULL;
+                job->m_JsCx      = NULL;
+
+                ResetGlobal(cx, global, snapshot);
+            }
+
+            JS_MaybeGC(cx);
+
+            pthread_mutex_lock(&m_Lock);
+
+            worker->m_Job  = NULL;
+            worker->m_Warm = true;
+
+            for (size_t i = 0; i < m_Workers.size(); i++) {
+                if (m_Workers[i] == worker) {
+                    m_Workers.erase(m_Workers.begin() + i);
+                    m_Workers.push_back(worker);
+                    break;
+                }
+            }
+
+            /*
+                Posted once the worker is idle : a Thread started from
+                oncomplete can run on it. The lock keeps cancel() from
+                returning (and the job from being deleted) meanwhile.
+            */
+            job->postComplete();
+
+            pthread_cond_broadcast(&m_Done);
+        }
+
+        worker->m_Runtime = NULL;
+        pthread_mutex_unlock(&m_Lock);
+
+        for (auto &cached : worker->m_Cache) {
+            delete cached.second;
+        }
+        worker->m_Cache.clear();
+    }
+
+    NidiumLocalContext *nlc = NidiumLocalContext::Get();
+    nlc->shutdown();
+
+    JS_DestroyContext(cx);
+    JS_DestroyRuntime(rt);
+
+    pthread_mutex_lock(&m_Lock);
+    worker->m_Exited = true;
+    pthread_mutex_unlock(&m_Lock);
+}
+
+void JSThreadPool::runJob(Worker *worker,
+                          JSThread *job,
+                          JSContext *cx,
+                          JS::HandleObject global)
+{
+    JS::RootedFunction fn(cx);
+
+    /*
+        The compiled function reports errors with the caller's file
+        and line, they are part of the key
+    */
+    std::string key(job->m_CallerFileName ? job->m_CallerFileName : "");
+
+    key += ":" + std::to_string(job->m_CallerLineNo) + ":";
+    key += job->m_JsFunction;
+
+    /* Hold the parent cx */
+    JS_SetContextPrivate(cx, job);
+
+    auto cached = worker->m_Cache.find(key);
+    if (cached != worker->m_Cache.end()) {
+        fn = *cached->second;
+
+        pthread_mutex_lock(&m_Lock);
+        m_Stats.cacheHits++;
+        pthread_mutex_unlock(&m_Lock);
+    } else if (job->compile(cx, &fn)) {
+        if (worker->m_Cache.size() >= NIDIUM_THREAD_POOL_CACHE_SIZE) {
+            for (auto &entry : worker->m_Cache) {
+                delete entry.second;
+            }
+            worker->m_Cache.clear();
+        }
+
+        worker->m_Cache[key] = new JS::PersistentRootedFunction(cx, fn);
+    }
+
+    /* Completes even if the compilation failed */
+    job->run(cx, global, fn);
+
+    JS_SetContextPrivate(cx, NULL);
+}
+// }}}
+
+} // namespace Binding
+} // namespace Nidium
@@ -0,0 +1,139 @@
+/*
+   Copyright 2016 Nidium Inc. All rights reserved.
+   Use of this source code is governed by a MIT license
+   that can be found in the LICENSE file.
+*/
+#ifndef binding_jsthreadpool_h__
+#define binding_jsthreadpool_h__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <pthread.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <jsapi.h>
+
+/* Default number of warm runtimes kept by the pool */
+#define NIDIUM_THREAD_POOL_SIZE 4
+
+/* Compiled functions kept by each worker */
+#define NIDIUM_THREAD_POOL_CACHE_SIZE 32
+
+namespace Nidium {
+namespace Binding {
+
+class NidiumJS;
+class JSThread;
+
+// {{{ JSThreadPool
+/*
+    Pool of worker threads, each one owning a JSRuntime and a global
+    that are kept alive between jobs.
+
+    A Thread started while a worker is idle is run by that worker, the
+    cost of creating the thread, the runtime and the global is only paid
+    once per worker. Workers also keep the functions they compiled, so
+    starting a Thread created at the same place again doesn't compile it.
+
+    Jobs are isolated from each other : each one gets a fresh |this|,
+    and the global of the worker is reset to its initial properties
+    once a job is done (changes made to the builtin prototypes are
+    not undone).
+
+    When every worker is busy and the pool is full, start() falls back
+    to a dedicated thread so that a long running job never delays others.
+*/
+class JSThreadPool
+{
+public:
+    struct Stats
+    {
+        /* Jobs run by a worker */
+        uint64_t jobs;
+        /* Jobs run by an already warm worker */
+        uint64_t reused;
+        /* Workers created */
+        uint64_t spawned;
+        /* Jobs that needed a dedicated thread */
+        uint64_t dedicated;
+        /* Jobs that didn't need to compile their function */
+        uint64_t cacheHits;
+    };
+
+    JSThreadPool(JSRuntime *parent, NidiumJS *njs);
+    ~JSThreadPool();
+
+    /*
+        Hand a job to a worker. Returns false if the job has to run
+        on a dedicated thread.
+    */
+    bool run(JSThread *job);
+
+    /*
+        Stop a job and wait for its worker to drop it.
+        Called from the main thread when the Thread is finalized.
+    */
+    void cancel(JSThread *job);
+
+    /*
+        Maximum number of workers. Extra idle workers are stopped,
+        0 disables the pool.
+    */
+    void setSize(size_t size);
+
+    size_t getSize() const
+    {
+        return m_Size;
+    }
+
+    size_t getWorkers();
+    size_t getIdle();
+
+    Stats getStats();
+
+private:
+    struct Worker
+    {
+        JSThreadPool *m_Pool;
+        pthread_t m_Handle;
+        pthread_cond_t m_Wakeup;
+        JSRuntime *m_Runtime;
+        JSThread *m_Job;
+        bool m_Stop;
+        bool m_Exited;
+        bool m_Warm;
+
+        /* Caller file, line and source of the function -> compiled function */
+        std::unordered_map<std::string, JS::PersistentRootedFunction *>
+            m_Cache;
+    };
+
+    static void *Work(void *arg);
+    void work(Worker *worker);
+    void runJob(Worker *worker,
+                JSThread *job,
+                JSContext *cx,
+                JS::HandleObject global);
+
+    /* Join the workers that stopped, m_Lock must be held */
+    void reap();
+
+    std::vector<Worker *> m_Workers;
+
+    pthread_mutex_t m_Lock;
+    /* Signaled each time a worker is done with a job */
+    pthread_cond_t m_Done;
+
+    JSRuntime *m_ParentRuntime;
+    NidiumJS *m_Njs;
+    size_t m_Size;
+    Stats m_Stats;
+};
+// }}}
+
+} // namespace Binding
+} // namespace Nidium
+
+#endif
@@ -332,10 +332,134 @@ bool JSUtils::ValuePercent(JSContext *cx, JS::HandleValue val, double *out)
 // }}}
 
 // {{{ JSTransferable
+JSObject *JSTransferable::GetSharedBuffer(JSContext *cx, JS::HandleValue val)
+{
+    if (!val.isObject()) {
+        return nullptr;
+    }
+
+    JS::RootedObject obj(cx, &val.toObject());
+
+    if (JS_IsSharedArrayBufferObject(obj)) {
+        return obj;
+    }
+
+    if (JS_IsArrayBufferViewObject(obj)) {
+        bool shared;
+        JS::RootedObject buffer(cx,
+            JS_GetArrayBufferViewBuffer(cx, obj, &shared));
+
+        return shared ? buffer.get() : nullptr;
+    }
+
+    return nullptr;
+}
+
+bool JSTransferable::Write(JSContext *cx,
+                           JS::HandleValue val,
+                           JS::HandleValue transfer,
+                           uint64_t **data,
+                           size_t *bytes)
+{
+    /*
+        SharedArrayBuffers are shared with the destination through the
+        transfer list (they are not detached). Only |val| itself is
+        looked at, nested ones have to be listed by the caller.
+    */
+    JS::RootedObject shared(cx, JSTransferable::GetSharedBuffer(cx, val));
+
+    if (!shared) {
+        return JS_WriteStructuredClone(cx, val, data, bytes,
+                                       NidiumJS::m_JsScc, nullptr, transfer);
+    }
+
+    JS::AutoValueVector list(cx);
+
+    if (!list.append(JS::ObjectValue(*shared))) {
+        return false;
+    }
+
+    if (!transfer.isNullOrUndefined()) {
+        bool isArray;
+        uint32_t len;
+        JS::RootedObject tlist(cx,
+            transfer.isObject() ? &transfer.toObject() : nullptr);
+
+        if (!tlist || !JS_IsArrayObject(cx, tlist, &isArray) || !isArray) {
+            JS_ReportError(cx, "Transfer list must be an array");
+            return false;
+        }
+
+        if (!JS_GetArrayLength(cx, tlist, &len)) {
+            return false;
+        }
+
+        for (uint32_t i = 0; i < len; i++) {
+            JS::RootedValue item(cx);
+
+            if (!JS_GetElement(cx, tlist, i, &item)) {
+                return false;
+            }
+
+            /* Already listed */
+            if (item.isObject() && &item.toObject() == shared.get()) {
+                continue;
+            }
+
+            if (!list.append(item)) {
+                return false;
+            }
+        }
+    }
+
+    JS::RootedObject array(cx, JS_NewArrayObject(cx, list));
+    if (!array) {
+        return false;
+    }
+
+    JS::RootedValue fullTransfer(cx, JS::ObjectValue(*array));
+
+    return JS_WriteStructuredClone(cx, val, data, bytes, NidiumJS::m_JsScc,
+                                   nullptr, fullTransfer);
+}
+
+bool JSTransferable::Read(JSContext *cx,
+                          uint64_t *data,
+                          size_t bytes,
+                          JS::MutableHandleValue val)
+{
+    bool ok = JS_ReadStructuredClone(cx, data, bytes,
+                                     JS_STRUCTURED_CLONE_VERSION, val,
+                                     NidiumJS::m_JsScc, nullptr);
+
+    /*
+        Transferred contents now belong to the read ArrayBuffers,
+        they are only freed here if the read failed
+    */
+    JSTransferable::Clear(data, bytes);
+
+    return ok;
+}
+
+void JSTransferable::Clear(uint64_t *data, size_t bytes)
+{
+    if (data == nullptr) {
+        return;
+    }
+
+    JS_ClearStructuredClone(data, bytes, NidiumJS::m_JsScc, nullptr);
+}
+
 bool JSTransferable::set(JSContext *cx, JS::HandleValue val)
 {
-    if (!JS_WriteStructuredClone(cx, val, &m_Data, &m_Bytes, NidiumJS::m_JsScc, nullptr,
-                                 JS::NullHandleValue)) {
+    return this->setWithTransfer(cx, val, JS::NullHandleValue);
+}
+
+bool JSTransferable::setWithTransfer(JSContext *cx,
+                                     JS::HandleValue val,
+                                     JS::HandleValue transfer)
+{
+    if (!JSTransferable::Write(cx, val, transfer, &m_Data, &m_Bytes)) {
         return false;
     }
 
@@ -344,11 +468,7 @@ bool JSTransferable::set(JSContext *cx, JS::HandleValue val)
 
 bool JSTransferable::transfert()
 {
-    bool ok = JS_ReadStructuredClone(m_DestCx, m_Data, m_Bytes,
-                                     JS_STRUCTURED_CLONE_VERSION, &m_Val,
-                                     NidiumJS::m_JsScc, nullptr);
-
-    JS_ClearStructuredClone(m_Data, m_Bytes, NidiumJS::m_JsScc, nullptr);
+    bool ok = JSTransferable::Read(m_DestCx, m_Data, m_Bytes, &m_Val);
 
     m_Data  = NULL;
     m_Bytes = 0;
@@ -361,9 +481,7 @@ JSTransferable::~JSTransferable()
     JSAutoRequest ar(m_DestCx);
     JSAutoCompartment ac(m_DestCx, m_DestGlobal);
 
-    if (m_Data != NULL) {
-        JS_ClearStructuredClone(m_Data, m_Bytes, NidiumJS::m_JsScc, NULL);
-    }
+    JSTransferable::Clear(m_Data, m_Bytes);
 
     m_Val = JS::UndefinedHandleValue;
 }
@@ -90,8 +90,52 @@ public:
 
     virtual bool set(JSContext *cx, JS::HandleValue val);
 
+    /*
+        Same as set(), except that the ArrayBuffers listed in |transfer|
+        are moved to the destination instead of being copied.
+    */
+    bool setWithTransfer(JSContext *cx,
+                         JS::HandleValue val,
+                         JS::HandleValue transfer);
+
     JS::Value get();
 
+    /*
+        Serialize |val| so that it can be read by another context, possibly
+        living on another thread.
+
+        |transfer| is either null/undefined or an array of ArrayBuffer.
+        Their contents are handed over to the serialized data without any
+        copy and the ArrayBuffers are detached from |cx|.
+
+        SharedArrayBuffers listed in |transfer| are shared instead (they
+        are not detached). So is |val| if it's a SharedArrayBuffer or a
+        view of one. Others found deeper in |val| make the write fail.
+
+        The data must be released with Clear() if it's never read.
+    */
+    static bool Write(JSContext *cx,
+                      JS::HandleValue val,
+                      JS::HandleValue transfer,
+                      uint64_t **data,
+                      size_t *bytes);
+
+    /*
+        Deserialize (and release) data serialized with Write().
+        Transferred ArrayBuffers are owned by |cx| afterward.
+    */
+    static bool Read(JSContext *cx,
+                     uint64_t *data,
+                     size_t bytes,
+                     JS::MutableHandleValue val);
+
+    static void Clear(uint64_t *data, size_t bytes);
+
+    /*
+        The SharedArrayBuffer |val| is (or is a view of), null otherwise
+    */
+    static JSObject *GetSharedBuffer(JSContext *cx, JS::HandleValue val);
+
     JSContext *getJSContext()
     {
         return m_DestCx;
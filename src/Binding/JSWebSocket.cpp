@@ -32,6 +32,8 @@ namespace Binding {
 JSWebSocketServer::JSWebSocketServer(const char *host,
                                      unsigned short port)
 {
+    this->setStatsName("JSWebSocketServer");
+
     m_WebSocketServer = new WebSocketServer(port, host);
     m_WebSocketServer->addListener(this);
 }
@@ -29,6 +29,8 @@ JSWebSocket::JSWebSocket(JSContext *cx,
                          const char *path,
                          bool ssl)
 {
+    this->setStatsName("JSWebSocket");
+
     m_WebSocketClient = new WebSocketClient(port, path, host);
     bool ret = m_WebSocketClient->connect(
         ssl, static_cast<ape_global *>(JS_GetContextPrivate(cx)));
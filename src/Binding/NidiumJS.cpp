@@ -22,6 +22,8 @@
 
 #include "Binding/JSSocket.h"
 #include "Binding/JSThread.h"
+#include "Binding/JSThreadPool.h"
+#include "Binding/JSAtomics.h"
 #include "Binding/JSHTTP.h"
 #include "Binding/JSFile.h"
 #include "Binding/JSModules.h"
@@ -50,6 +52,7 @@
 #endif
 
 #include "Core/Context.h"
+#include "Net/HTTPConnectionPool.h"
 
 #if defined(MOZ_ASAN) || (defined(DEBUG) && !defined(XP_WIN))
 static const size_t gMaxStackSize = 2 * 128 * sizeof(size_t) * 1024;
@@ -383,7 +386,8 @@ void reportError(JSContext *cx, const char *message, JSErrorReport *report)
 }
 
 NidiumJS::NidiumJS(ape_global *net, Context *context)
-    : m_JSStrictMode(false), m_Context(context)
+    : m_JSStrictMode(false), m_Context(context), m_ThreadPool(NULL),
+      m_Shutdown(false)
 {
     JSRuntime *rt;
     m_Modules = NULL;
@@ -471,6 +475,16 @@ NidiumJS::~NidiumJS()
     JSRuntime *rt;
     rt         = JS_GetRuntime(m_Cx);
 
+    /*
+        Stop the workers while the parent runtime is still alive.
+        Threads finalized later on no longer have a pool to cancel.
+    */
+    m_Shutdown = true;
+    if (m_ThreadPool) {
+        delete m_ThreadPool;
+        m_ThreadPool = NULL;
+    }
+
     NidiumLocalContext *nlc = NidiumLocalContext::Get();
     nlc->shutdown();
 
@@ -487,6 +501,9 @@ NidiumJS::~NidiumJS()
 
     JS_DestroyRuntime(rt);
 
+    /* Finalizers may have handed connections to the pool, close them last */
+    Net::HTTPConnectionPool::Destroy(net);
+
     if (m_Modules) {
         delete m_Modules;
     }
@@ -497,6 +514,15 @@ NidiumJS::~NidiumJS()
 }
 
 
+JSThreadPool *NidiumJS::getThreadPool(bool create)
+{
+    if (!m_ThreadPool && create && !m_Shutdown) {
+        m_ThreadPool = new JSThreadPool(JS_GetRuntime(m_Cx), this);
+    }
+
+    return m_ThreadPool;
+}
+
 void NidiumJS::bindNetObject(ape_global *net)
 {
     JS_SetContextPrivate(m_Cx, net);
@@ -770,6 +796,7 @@ void NidiumJS::loadGlobalObjects()
     JSFile::RegisterObject(m_Cx);
     JSSocket::RegisterObject(m_Cx);
     JSThread::RegisterObject(m_Cx);
+    JSAtomics::RegisterObject(m_Cx);
     JSHTTP::RegisterObject(m_Cx);
     JSStream::RegisterObject(m_Cx);
     JSWebSocketServer::RegisterObject(m_Cx);
@@ -29,6 +29,7 @@ class Context;
 namespace Binding {
 
 class JSModules;
+class JSThreadPool;
 template<typename T>class ClassMapper;
 
 typedef struct _ape_global ape_global;
@@ -143,6 +144,12 @@ public:
         return m_StructuredCloneAddition.write;
     }
 
+    /*
+        Workers used to run the Thread jobs.
+        Created on first use, NULL once the shutdown started.
+    */
+    JSThreadPool *getThreadPool(bool create = true);
+
     static JSObject *CreateJSGlobal(JSContext *cx, NidiumJS *njs = nullptr);
     static void SetJSRuntimeOptions(JSRuntime *rt, bool strictmode = false);
 
@@ -151,6 +158,8 @@ private:
     JSCompartment *m_Compartment;
     bool m_JSStrictMode;
     Core::Context *m_Context;
+    JSThreadPool *m_ThreadPool;
+    bool m_Shutdown;
 
     struct
     {
@@ -71,15 +71,12 @@ public:
         bool m_isSet;
     };
 
-    Args() : m_FillArgs(0)
+    Args() : m_NumArgs(kMaxArgs), m_FillArgs(0)
     {
-        m_NumArgs = 10;
-        m_Args    = new ArgsValue[m_NumArgs];
     }
 
     ~Args()
     {
-        delete[] m_Args;
     }
 
     ArgsValue &operator[](int idx)
@@ -116,7 +113,13 @@ public:
     }
 
 private:
-    ArgsValue *m_Args;
+    /*
+        Storage is inline so that objects embedding Args
+        (Message, Task) don't need an extra heap allocation
+    */
+    static const int kMaxArgs = 10;
+
+    ArgsValue m_Args[kMaxArgs];
     int m_NumArgs;
     int m_FillArgs;
 };
@@ -38,6 +38,12 @@ public:
                                        static_cast<long>(inc));
     };
 
+    static inline int64_t Add(int64_t *addr, int64_t inc)
+    {
+        return _InterlockedExchangeAdd64(reinterpret_cast<__int64 *>(addr),
+                                         static_cast<__int64>(inc));
+    };
+
     static inline int32_t Dec(int32_t *addr)
     {
         // InterlockedDecrement returns the new value, we want to return the
@@ -59,6 +65,11 @@ public:
         return InterlockedCompareExchangePointer(addr, after, before);
     };
 
+    static inline void *Swap(void **addr, void *val)
+    {
+        return InterlockedExchangePointer(addr, val);
+    };
+
     static inline void Membar_acquire__after_atomic_conditional_inc(){};
 // }}}
 #else
@@ -75,6 +86,12 @@ public:
         return __sync_fetch_and_add(addr, inc);
     };
 
+    static inline __attribute__((always_inline)) int64_t Add(int64_t *addr,
+                                                             int64_t inc)
+    {
+        return __sync_fetch_and_add(addr, inc);
+    };
+
     static inline __attribute__((always_inline)) int32_t Dec(int32_t *addr)
     {
         return __sync_fetch_and_add(addr, -1);
@@ -95,6 +112,18 @@ public:
         return __sync_val_compare_and_swap(addr, before, after);
     };
 
+    static inline __attribute__((always_inline)) void *
+    Swap(void **addr, void *val)
+    {
+        /*
+            __sync_lock_test_and_set() is only an acquire barrier,
+            issue a full barrier first so that the swap can be used
+            to publish as well as to consume.
+        */
+        __sync_synchronize();
+        return __sync_lock_test_and_set(addr, val);
+    };
+
     static inline __attribute__((always_inline)) void
     Membar_acquire__after_atomic_conditional_inc(){};
 // }}}
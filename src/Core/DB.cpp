@@ -11,15 +11,172 @@
 
 #include <leveldb/db.h>
 #include <leveldb/filter_policy.h>
+#include <leveldb/write_batch.h>
 
 #include "Core/Path.h"
 
 namespace Nidium {
 namespace Core {
 
+// {{{ Preamble
+
+enum DBTask
+{
+    kDBTask_Get,
+    kDBTask_Write,
+    kDBTask_Range,
+    kDBTask_Close
+};
+
+#define NIDIUM_DB_NOTIFY(param, success, event, arg)                         \
+    do {                                                                     \
+        SharedMessages::Message *__msg = new SharedMessages::Message(event); \
+        __msg->m_Args[0].set(param);                                         \
+        __msg->m_Args[1].set(static_cast<int64_t>(success));                 \
+        __msg->m_Args[7].set(arg);                                           \
+        this->postMessage(__msg);                                            \
+    } while (0)
+
+static bool StartsWith(const leveldb::Slice &key, const std::string &prefix)
+{
+    return key.size() >= prefix.size()
+           && memcmp(key.data(), prefix.data(), prefix.size()) == 0;
+}
+
+static leveldb::ReadOptions GetReadOptions(DBSnapshot *snapshot,
+                                           bool fill_cache = true)
+{
+    leveldb::ReadOptions options;
+
+    options.fill_cache = fill_cache;
+
+    if (snapshot) {
+        options.snapshot = snapshot->get();
+    }
+
+    return options;
+}
+// }}}
+
+// {{{ DBBatch
+DBBatch::DBBatch() : m_Batch(new leveldb::WriteBatch()), m_Count(0)
+{
+}
+
+void DBBatch::set(const char *key, const uint8_t *data, size_t data_len)
+{
+    m_Batch->Put(key,
+                 leveldb::Slice(reinterpret_cast<const char *>(data), data_len));
+    m_Count++;
+}
+
+void DBBatch::set(const char *key, const std::string &string)
+{
+    m_Batch->Put(key, string);
+    m_Count++;
+}
+
+void DBBatch::del(const char *key)
+{
+    m_Batch->Delete(key);
+    m_Count++;
+}
+
+void DBBatch::clear()
+{
+    m_Batch->Clear();
+    m_Count = 0;
+}
+
+DBBatch::~DBBatch()
+{
+    delete m_Batch;
+}
+// }}}
+
+// {{{ DBIterator
+DBIterator::DBIterator(leveldb::Iterator *iterator,
+                       const std::string &end,
+                       const std::string &prefix)
+    : m_Iterator(iterator), m_End(end), m_Prefix(prefix)
+{
+}
+
+bool DBIterator::valid() const
+{
+    if (!m_Iterator->Valid()) {
+        return false;
+    }
+
+    leveldb::Slice key = m_Iterator->key();
+
+    if (!m_End.empty() && key.compare(m_End) >= 0) {
+        return false;
+    }
+
+    return m_Prefix.empty() || StartsWith(key, m_Prefix);
+}
+
+void DBIterator::next()
+{
+    m_Iterator->Next();
+}
+
+std::string DBIterator::key() const
+{
+    return m_Iterator->key().ToString();
+}
+
+std::string DBIterator::value() const
+{
+    return m_Iterator->value().ToString();
+}
+
+DBIterator::~DBIterator()
+{
+    delete m_Iterator;
+}
+// }}}
+
+// {{{ DB
+static bool ReadRange(leveldb::DB *db,
+                      const DBRange &range,
+                      DBEntries &entries,
+                      DBSnapshot *snapshot)
+{
+    /* Don't evict hot blocks from the cache while scanning */
+    leveldb::Iterator *it = db->NewIterator(GetReadOptions(snapshot, false));
+
+    /* The range starts at the highest of |start| and |prefix| */
+    const std::string &start
+        = range.m_Start.compare(range.m_Prefix) > 0 ? range.m_Start
+                                                    : range.m_Prefix;
+
+    if (start.empty()) {
+        it->SeekToFirst();
+    } else {
+        it->Seek(start);
+    }
+
+    DBIterator iter(it, range.m_End, range.m_Prefix);
+
+    for (; iter.valid(); iter.next()) {
+        if (range.m_Limit && entries.size() >= range.m_Limit) {
+            break;
+        }
+
+        entries.push_back(std::make_pair(
+            iter.key(), range.m_KeysOnly ? std::string() : iter.value()));
+    }
+
+    return it->status().ok();
+}
+
 DB::DB(const char *name)
-    : m_Database(NULL), m_Status(false), m_Name(strdup(name))
+    : m_Database(NULL), m_Status(false), m_Closed(false), m_Pending(0),
+      m_Name(name ? strdup(name) : NULL)
 {
+    this->setStatsName("DB");
 
     if (name == NULL) {
         m_Status = false;
@@ -37,7 +194,7 @@ DB::DB(const char *name)
 
 bool DB::set(const char *key, const uint8_t *data, size_t data_len)
 {
-    if (m_Database == nullptr) {
+    if (this->isClosed()) {
         return false;
     }
 
@@ -50,7 +207,7 @@ bool DB::set(const char *key, const uint8_t *data, size_t data_len)
 
 bool DB::set(const char *key, const char *string)
 {
-    if (m_Database == nullptr) {
+    if (this->isClosed()) {
         return false;
     }
 
@@ -63,7 +220,7 @@ bool DB::set(const char *key, const char *string)
 
 bool DB::set(const char *key, const std::string &string)
 {
-    if (m_Database == nullptr) {
+    if (this->isClosed()) {
         return false;
     }
 
@@ -73,20 +230,21 @@ bool DB::set(const char *key, const std::string &string)
     return status.ok();
 }
 
-bool DB::get(const char *key, std::string &ret)
+bool DB::get(const char *key, std::string &ret, DBSnapshot *snapshot)
 {
-    if (m_Database == nullptr) {
+    if (this->isClosed()) {
         return false;
     }
 
-    leveldb::Status status = m_Database->Get(leveldb::ReadOptions(), key, &ret);
+    leveldb::Status status
+        = m_Database->Get(GetReadOptions(snapshot), key, &ret);
 
     return status.ok();
 }
 
 bool DB::del(const char *key)
 {
-    if (m_Database == nullptr) {
+    if (this->isClosed()) {
         return false;
     }
 
@@ -95,28 +253,331 @@ bool DB::del(const char *key)
     return status.ok();
 }
 
-bool DB::drop()
+bool DB::write(DBBatch *batch)
 {
-    this->close();
+    if (this->isClosed()) {
+        return false;
+    }
 
-    leveldb::DestroyDB(m_Name, leveldb::Options());
+    leveldb::Status status
+        = m_Database->Write(leveldb::WriteOptions(), batch->m_Batch);
 
-    return true;
+    return status.ok();
 }
 
-bool DB::close()
+DBIterator *DB::iterate(const char *start, const char *end, DBSnapshot *snapshot)
+{
+    if (this->isClosed()) {
+        return NULL;
+    }
+
+    leveldb::Iterator *it = m_Database->NewIterator(GetReadOptions(snapshot));
+
+    if (start) {
+        it->Seek(start);
+    } else {
+        it->SeekToFirst();
+    }
+
+    return new DBIterator(it, end ? end : "", "");
+}
+
+DBIterator *DB::iteratePrefix(const char *prefix, DBSnapshot *snapshot)
+{
+    if (this->isClosed()) {
+        return NULL;
+    }
+
+    leveldb::Iterator *it = m_Database->NewIterator(GetReadOptions(snapshot));
+
+    it->Seek(prefix);
+
+    return new DBIterator(it, "", prefix);
+}
+
+bool DB::range(const DBRange &range, DBEntries &entries, DBSnapshot *snapshot)
+{
+    if (this->isClosed()) {
+        return false;
+    }
+
+    return ReadRange(m_Database, range, entries, snapshot);
+}
+
+DBSnapshot *DB::getSnapshot()
+{
+    if (this->isClosed()) {
+        return NULL;
+    }
+
+    return new DBSnapshot(m_Database->GetSnapshot());
+}
+
+void DB::releaseSnapshot(DBSnapshot *snapshot)
+{
+    if (snapshot == NULL) {
+        return;
+    }
+
+    if (m_Database) {
+        m_Database->ReleaseSnapshot(snapshot->m_Snapshot);
+    }
+
+    delete snapshot;
+}
+
+/*
+    Must be called with the tasks lock held
+*/
+void DB::destroy(bool drop)
 {
     delete m_Database;
     m_Database = nullptr;
 
+    if (drop && m_Name) {
+        leveldb::DestroyDB(m_Name, leveldb::Options());
+    }
+}
+
+bool DB::shutdown(bool drop)
+{
+    m_Closed = true;
+
+    /*
+        Let the pending asynchronous operations complete first.
+        (Once all the results are delivered, no task can be running
+        past the tasks lock.)
+    */
+    if (m_Pending) {
+        this->closeTaskAsync(drop);
+        return true;
+    }
+
+    this->lockTasks();
+    this->destroy(drop);
+    this->unlockTasks();
+
     return true;
 }
 
+bool DB::drop()
+{
+    return this->shutdown(true);
+}
+
+bool DB::close()
+{
+    return this->shutdown(false);
+}
+
 DB::~DB()
 {
-    delete m_Database;
+    /* Tasks use the database, stop them before it goes away */
+    this->stopTasks();
+
+    /*
+        Free the results that weren't delivered yet while
+        DB::onMessageLost() can still be reached (~Messages can't)
+    */
+    this->cleanupMessages();
+    m_Pending = 0;
+
+    m_Closed = true;
+    this->destroy(false);
+
     free(m_Name);
 }
+// }}}
+
+// {{{ Tasks implementation
+
+/*
+    /!\ Exec in a worker thread
+*/
+void DB_dispatchTask(Task *task)
+{
+    DB *db        = static_cast<DB *>(task->getObject());
+    uint64_t type = task->m_Args[0].toInt64();
+    void *arg     = task->m_Args[7].toPtr();
+
+    switch (type) {
+        case kDBTask_Get: {
+            char *key = static_cast<char *>(task->m_Args[1].toPtr());
+            db->getTask(key, arg);
+            free(key);
+            break;
+        }
+        case kDBTask_Write: {
+            DBBatch *batch = static_cast<DBBatch *>(task->m_Args[1].toPtr());
+            db->writeTask(batch, arg);
+            delete batch;
+            break;
+        }
+        case kDBTask_Range: {
+            DBRange *range = static_cast<DBRange *>(task->m_Args[1].toPtr());
+            db->rangeTask(range, arg);
+            delete range;
+            break;
+        }
+        case kDBTask_Close: {
+            db->closeTask(task->m_Args[1].toBool());
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+void DB::getTask(const char *key, void *arg)
+{
+    std::string *value = new std::string();
+
+    if (!m_Database) {
+        delete value;
+        NIDIUM_DB_NOTIFY(static_cast<void *>(NULL), false, kEvents_Get, arg);
+        return;
+    }
+
+    leveldb::Status status
+        = m_Database->Get(leveldb::ReadOptions(), key, value);
+
+    if (!status.ok()) {
+        delete value;
+        /* A missing key isn't an error */
+        NIDIUM_DB_NOTIFY(static_cast<void *>(NULL), status.IsNotFound(),
+                         kEvents_Get, arg);
+        return;
+    }
+
+    NIDIUM_DB_NOTIFY(value, true, kEvents_Get, arg);
+}
+
+void DB::writeTask(DBBatch *batch, void *arg)
+{
+    bool success = false;
+
+    if (m_Database) {
+        success
+            = m_Database->Write(leveldb::WriteOptions(), batch->m_Batch).ok();
+    }
+
+    NIDIUM_DB_NOTIFY(static_cast<void *>(NULL), success, kEvents_Write, arg);
+}
+
+void DB::rangeTask(DBRange *range, void *arg)
+{
+    DBEntries *entries = new DBEntries();
+
+    /* m_Closed is already set if a close is pending, check the database */
+    bool success = m_Database && ReadRange(m_Database, *range, *entries, NULL);
+
+    SharedMessages::Message *msg = new SharedMessages::Message(kEvents_Range);
+    msg->m_Args[0].set(entries);
+    msg->m_Args[1].set(static_cast<int64_t>(success));
+    msg->m_Args[2].set(static_cast<int64_t>(range->m_KeysOnly));
+    msg->m_Args[7].set(arg);
+
+    this->postMessage(msg);
+}
+
+void DB::closeTask(bool drop)
+{
+    this->destroy(drop);
+}
+// }}}
+
+// {{{ Async operations
+void DB::getAsync(const char *key, void *arg)
+{
+    Task *task = new Task();
+    task->m_Args[0].set(kDBTask_Get);
+    task->m_Args[1].set(strdup(key));
+    task->m_Args[7].set(arg);
+
+    task->setFunction(DB_dispatchTask);
+
+    m_Pending++;
+    this->addTask(task);
+}
+
+void DB::setAsync(const char *key,
+                  const uint8_t *data,
+                  size_t data_len,
+                  void *arg)
+{
+    DBBatch *batch = new DBBatch();
+    batch->set(key, data, data_len);
+
+    this->writeAsync(batch, arg);
+}
+
+void DB::delAsync(const char *key, void *arg)
+{
+    DBBatch *batch = new DBBatch();
+    batch->del(key);
+
+    this->writeAsync(batch, arg);
+}
+
+void DB::writeAsync(DBBatch *batch, void *arg)
+{
+    Task *task = new Task();
+    task->m_Args[0].set(kDBTask_Write);
+    task->m_Args[1].set(batch);
+    task->m_Args[7].set(arg);
+
+    task->setFunction(DB_dispatchTask);
+
+    m_Pending++;
+    this->addTask(task);
+}
+
+void DB::rangeAsync(const DBRange &range, void *arg)
+{
+    Task *task = new Task();
+    task->m_Args[0].set(kDBTask_Range);
+    task->m_Args[1].set(new DBRange(range));
+    task->m_Args[7].set(arg);
+
+    task->setFunction(DB_dispatchTask);
+
+    m_Pending++;
+    this->addTask(task);
+}
+
+void DB::closeTaskAsync(bool drop)
+{
+    Task *task = new Task();
+    task->m_Args[0].set(kDBTask_Close);
+    task->m_Args[1].set(static_cast<int64_t>(drop));
+
+    task->setFunction(DB_dispatchTask);
+
+    this->addTask(task);
+}
+// }}}
+
+// {{{ Messages
+void DB::onMessage(const SharedMessages::Message &msg)
+{
+    m_Pending--;
+
+    this->onResult(msg);
+    this->onMessageLost(msg);
+}
+
+void DB::onMessageLost(const SharedMessages::Message &msg)
+{
+    switch (msg.event()) {
+        case kEvents_Get:
+            delete static_cast<std::string *>(msg.m_Args[0].toPtr());
+            break;
+        case kEvents_Range:
+            delete static_cast<DBEntries *>(msg.m_Args[0].toPtr());
+            break;
+    }
+}
+// }}}
 
 } // namespace Core
 } // namespace Nidium
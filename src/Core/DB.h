@@ -10,19 +10,154 @@
 #include <stdlib.h>
 #include <string.h>
 #include <string>
+#include <utility>
+#include <vector>
+
+#include "Core/Messages.h"
+#include "Core/TaskManager.h"
+
+#define NIDIUM_DB_MESSAGE_BITS(id) ((1 << 22) | id)
 
 namespace leveldb {
 class DB;
+class Iterator;
+class Snapshot;
+class WriteBatch;
 };
 
 namespace Nidium {
 namespace Core {
 
-class DB
+// {{{ DBSnapshot
+/*
+    Consistent read-only view of the database at the time it was taken
+    (see DB::getSnapshot())
+*/
+class DBSnapshot
+{
+public:
+    const leveldb::Snapshot *get() const
+    {
+        return m_Snapshot;
+    }
+
+    friend class DB;
+
+private:
+    explicit DBSnapshot(const leveldb::Snapshot *snapshot)
+        : m_Snapshot(snapshot)
+    {
+    }
+
+    const leveldb::Snapshot *m_Snapshot;
+};
+// }}}
+
+// {{{ DBBatch
+/*
+    Set of writes applied atomically by DB::write()
+*/
+class DBBatch
+{
+public:
+    DBBatch();
+    ~DBBatch();
+
+    void set(const char *key, const uint8_t *data, size_t data_len);
+    void set(const char *key, const std::string &string);
+    void del(const char *key);
+    void clear();
+
+    size_t count() const
+    {
+        return m_Count;
+    }
+
+    friend class DB;
+
+private:
+    leveldb::WriteBatch *m_Batch;
+    size_t m_Count;
+};
+// }}}
+
+// {{{ DBIterator
+/*
+    Iterate over the keys of a range, in order.
+    Iterators must be deleted before their DB is closed.
+*/
+class DBIterator
+{
+public:
+    DBIterator(leveldb::Iterator *iterator,
+               const std::string &end,
+               const std::string &prefix);
+    ~DBIterator();
+
+    /*
+        False once the end of the range is reached
+    */
+    bool valid() const;
+    void next();
+
+    std::string key() const;
+    std::string value() const;
+
+private:
+    leveldb::Iterator *m_Iterator;
+    /* Excluded upper bound (none if empty) */
+    std::string m_End;
+    std::string m_Prefix;
+};
+// }}}
+
+// {{{ DB
+/*
+    Range of keys : [start, end) restricted to the keys starting
+    with prefix. Empty strings leave the range unbounded.
+*/
+struct DBRange
+{
+    DBRange() : m_Limit(0), m_KeysOnly(false)
+    {
+    }
+
+    std::string m_Start;
+    std::string m_End;
+    std::string m_Prefix;
+    /* Maximum number of entries (0 for no limit) */
+    size_t m_Limit;
+    /* Don't read the values */
+    bool m_KeysOnly;
+};
+
+typedef std::vector<std::pair<std::string, std::string>> DBEntries;
+
+/*
+    leveldb store.
+
+    Operations are synchronous, or run on a TaskManager worker with the
+    *Async() variants. Results of asynchronous operations are posted
+    back to the DB and handed to onResult() with :
+     - m_Args[0] : the result (std::string * for kEvents_Get, NULL if the
+                   key doesn't exist ; DBEntries * for kEvents_Range)
+     - m_Args[1] : true on success
+     - m_Args[2] : DBRange::m_KeysOnly (kEvents_Range only)
+     - m_Args[7] : the |arg| given to the operation
+    Asynchronous operations run one at a time, in order.
+*/
+class DB : public Managed
 {
 public:
+    enum Events
+    {
+        kEvents_Get   = NIDIUM_DB_MESSAGE_BITS(1),
+        kEvents_Write = NIDIUM_DB_MESSAGE_BITS(2),
+        kEvents_Range = NIDIUM_DB_MESSAGE_BITS(3)
+    };
+
     explicit DB(const char *name);
-    ~DB();
+    virtual ~DB();
 
     /*
         Check status after the constructor is caller
@@ -35,18 +170,89 @@ public:
     bool set(const char *key, const uint8_t *data, size_t data_len);
     bool set(const char *key, const char *string);
     bool set(const char *key, const std::string &string);
-    bool get(const char *key, std::string &ret);
+    bool get(const char *key, std::string &ret, DBSnapshot *snapshot = NULL);
     bool del(const char *key);
+    bool write(DBBatch *batch);
+    bool range(const DBRange &range,
+               DBEntries &entries,
+               DBSnapshot *snapshot = NULL);
+
+    /*
+        Iterators over [start, end) (NULL for unbounded)
+        or over the keys starting with |prefix|
+    */
+    DBIterator *
+    iterate(const char *start, const char *end, DBSnapshot *snapshot = NULL);
+    DBIterator *iteratePrefix(const char *prefix, DBSnapshot *snapshot = NULL);
+
+    DBSnapshot *getSnapshot();
+    void releaseSnapshot(DBSnapshot *snapshot);
+
+    /*
+        Pending asynchronous operations are run before the database is
+        actually closed (or dropped). Synchronous operations fail
+        right away.
+    */
     bool close();
     bool drop();
 
+    bool isClosed() const
+    {
+        return m_Database == nullptr || m_Closed;
+    }
+
+    void getAsync(const char *key, void *arg = NULL);
+    void setAsync(const char *key,
+                  const uint8_t *data,
+                  size_t data_len,
+                  void *arg = NULL);
+    void delAsync(const char *key, void *arg = NULL);
+
+    /*
+        The batch is owned (and deleted) by the DB
+    */
+    void writeAsync(DBBatch *batch, void *arg = NULL);
+    void rangeAsync(const DBRange &range, void *arg = NULL);
+
+    void getTask(const char *key, void *arg);
+    void writeTask(DBBatch *batch, void *arg);
+    void rangeTask(DBRange *range, void *arg);
+    void closeTask(bool drop);
+
+    /*
+        Number of asynchronous operations whose result
+        wasn't delivered yet
+    */
+    uint32_t getPendingCount() const
+    {
+        return m_Pending;
+    }
+
+    /*
+        Result of an asynchronous operation.
+        The payload is freed once it returns.
+    */
+    virtual void onResult(const SharedMessages::Message &msg)
+    {
+    }
+
+    void onMessage(const SharedMessages::Message &msg) override;
+    void onMessageLost(const SharedMessages::Message &msg) override;
+
 protected:
     leveldb::DB *m_Database;
 
 private:
+    bool shutdown(bool drop);
+    void closeTaskAsync(bool drop);
+    void destroy(bool drop);
+
     bool m_Status;
+    bool m_Closed;
+    uint32_t m_Pending;
     char *m_Name;
 };
+// }}}
 
 } // namespace Core
 } // namespace Nidium
@@ -6,14 +6,24 @@
 #include "Core/Messages.h"
 
 #include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <pthread.h>
+#include <unistd.h>
+#include <fcntl.h>
 
 #include <assert.h>
 
+#ifdef __linux__
+#include <sys/eventfd.h>
+#endif
+
 #include <ape_netlib.h>
 
 #include "Core/Atomic.h"
 #include "Core/Events.h"
+#include "Core/Utils.h"
 
 namespace Nidium {
 namespace Core {
@@ -24,24 +34,103 @@ namespace Core {
 static SharedMessages *g_MessagesList;
 static SharedMessages::Message *g_PostingSyncMsg = nullptr;
 
-static int Messages_handle(void *arg)
+static struct
+{
+    int count;
+    uint64_t time;
+} g_Budget = { 256, 0 };
+
+static Messages::Stats g_Stats;
+static uint64_t g_StatsLastTick = 0;
+
+/*
+    Cross-thread posts wake up the event loop through an eventfd
+    (a pipe where eventfd isn't available). g_WakeupPending coalesces
+    the wakeups so that a burst of messages costs a single write().
+*/
+static int g_WakeupFd[2]        = { -1, -1 };
+static int32_t g_WakeupPending  = 0;
+static ape_global *g_WakeupAPE  = nullptr;
+static struct _ape_fd_delegate g_WakeupDelegate;
+
+/*
+    Open addressing over the fixed events table.
+    The class is identified by the address of its stats name.
+*/
+static Messages::EventStats *Messages_getEventStats(const char *className,
+                                                    int event)
+{
+    uintptr_t hash = (reinterpret_cast<uintptr_t>(className) >> 3)
+                     ^ (static_cast<uint32_t>(event) * 0x9E3779B1u);
+
+    for (int i = 0; i < Messages::kStats_MaxEvents; i++) {
+        Messages::EventStats *evstats
+            = &g_Stats.events[(hash + i) & (Messages::kStats_MaxEvents - 1)];
+
+        if (evstats->className == className && evstats->event == event) {
+            return evstats;
+        }
+
+        if (evstats->className == nullptr) {
+            evstats->className = className;
+            evstats->event     = event;
+
+            return evstats;
+        }
+    }
+
+    return &g_Stats.events[Messages::kStats_MaxEvents];
+}
+
+static void Messages_wakeup()
+{
+    if (!Atomic::Cas(&g_WakeupPending, 0, 1)) {
+        return;
+    }
+
+#ifdef __linux__
+    uint64_t val = 1;
+    ssize_t ret  = write(g_WakeupFd[1], &val, sizeof(val));
+#else
+    char val    = 1;
+    ssize_t ret = write(g_WakeupFd[1], &val, sizeof(val));
+#endif
+
+    (void)ret;
+}
+
+static void Messages_handle()
 {
-#define MAX_MSG_IN_ROW 256
     int nread        = 0;
     bool stopOnAsync = false;
+    uint64_t start   = g_Budget.time ? Utils::GetTick() : 0;
     SharedMessages::Message *msg;
 
-    while (++nread < MAX_MSG_IN_ROW
-           && (msg = g_MessagesList->readMessage(stopOnAsync))) {
+    g_Stats.ticks++;
+
+    while ((msg = g_MessagesList->readMessage(stopOnAsync))) {
 
         Messages *obj = static_cast<Messages *>(msg->dest());
 
         Atomic::Dec(&obj->_m_CountMessagePending);
 
+        /* Messages posted before the stats were enabled have no time */
+        if (g_Stats.enabled && msg->m_PostTime) {
+            uint64_t latency = Utils::GetTick() - msg->m_PostTime;
+            Messages::EventStats *evstats
+                = Messages_getEventStats(obj->getStatsName(), msg->event());
+
+            evstats->count++;
+            evstats->totalLatency += latency;
+            evstats->maxLatency = nidium_max(evstats->maxLatency, latency);
+        }
+
         obj->onMessage(*msg);
 
         delete msg;
 
+        g_Stats.handled++;
+
         if (g_PostingSyncMsg == msg) {
             /*
                 Found the message being synchronously processed.
@@ -50,9 +139,43 @@ static int Messages_handle(void *arg)
             */
             stopOnAsync = true;
         }
+
+        if (++nread >= g_Budget.count) {
+            g_Stats.countBudgetExhausted++;
+            break;
+        }
+
+        if (g_Budget.time && Utils::GetTick() - start >= g_Budget.time) {
+            g_Stats.timeBudgetExhausted++;
+            break;
+        }
+    }
+}
+
+static void Messages_onWakeup(int fd, int ev, void *data, ape_global *ape)
+{
+#ifdef __linux__
+    uint64_t val;
+#else
+    char val[64];
+#endif
+
+    while (read(fd, &val, sizeof(val)) > 0) {
+        /* Drain the eventfd counter (or the pipe) */
     }
 
-    return 8;
+    /*
+        Reset the flag after draining the descriptor but before reading
+        the queue : anything posted from now on triggers a new wakeup.
+    */
+    Atomic::Cas(&g_WakeupPending, 1, 0);
+
+    Messages_handle();
+
+    /* Budget exhausted, come back on the next loop iteration */
+    if (g_MessagesList && g_MessagesList->hasPendingMessages()) {
+        Messages_wakeup();
+    }
 }
 
 static void Messages_lost(const SharedMessages::Message &msg)
@@ -122,6 +245,9 @@ void Messages::postMessage(SharedMessages::Message *msg, bool forceAsync)
     assert(g_MessagesList != nullptr);
 
     msg->setDest(this);
+    if (g_Stats.enabled) {
+        msg->m_PostTime = Utils::GetTick();
+    }
 
     Atomic::Inc(&_m_CountMessagePending);
 
@@ -139,27 +265,59 @@ void Messages::postMessage(SharedMessages::Message *msg, bool forceAsync)
         // Ensure that we don't break the FIFO rule.
         // Post the message first and then read all pendings messages
         g_MessagesList->postMessage(msg);
-        (void)Messages_handle(nullptr);
+        Messages_handle();
 
         g_PostingSyncMsg = nullptr;
+
+        /* Deferred async messages or budget exhausted */
+        if (g_MessagesList->hasPendingMessages()) {
+            Messages_wakeup();
+        }
     } else {
         if (forceAsync) {
             msg->setForceAsync();
         }
 
         g_MessagesList->postMessage(msg);
+
+        Messages_wakeup();
     }
 }
 
 void Messages::InitReader(ape_global *ape)
 {
-    g_MessagesList = new SharedMessages();
+    g_MessagesList = new SharedMessages(SharedMessages::kQueue_LockFree);
 
     g_MessagesList->setCleaner(Messages_lost);
 
-    ape_timer_t *timer = APE_timer_create(ape, 1, Messages_handle, NULL);
+#ifdef __linux__
+    g_WakeupFd[0] = g_WakeupFd[1] = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+#else
+    if (pipe(g_WakeupFd) == 0) {
+        for (int i = 0; i < 2; i++) {
+            fcntl(g_WakeupFd[i], F_SETFL, O_NONBLOCK);
+            fcntl(g_WakeupFd[i], F_SETFD, FD_CLOEXEC);
+        }
+    }
+#endif
+
+    if (g_WakeupFd[0] == -1) {
+        ndm_log(NDM_LOG_ERROR, "Messages",
+                "Failed to create the wakeup descriptor, messages won't be "
+                "delivered across threads");
+        return;
+    }
+
+    g_WakeupPending = 0;
+    g_WakeupAPE     = ape;
+
+    g_WakeupDelegate.s.fd   = g_WakeupFd[0];
+    g_WakeupDelegate.s.type = APE_DELEGATE;
+    g_WakeupDelegate.data   = nullptr;
+    g_WakeupDelegate.on_io  = Messages_onWakeup;
 
-    APE_timer_unprotect(timer);
+    events_add(g_WakeupFd[0], &g_WakeupDelegate, EVENT_READ | EVENT_LEVEL,
+               ape);
 }
 
 void Messages::listenFor(Events *obj, bool enable)
@@ -178,11 +336,51 @@ void Messages::delMessages(int event)
 
 void Messages::DestroyReader()
 {
+    if (g_WakeupFd[0] != -1) {
+        events_del(g_WakeupFd[0], g_WakeupAPE);
+
+        close(g_WakeupFd[0]);
+        if (g_WakeupFd[1] != g_WakeupFd[0]) {
+            close(g_WakeupFd[1]);
+        }
+
+        g_WakeupFd[0] = g_WakeupFd[1] = -1;
+    }
+
     delete g_MessagesList;
 
     g_MessagesList = nullptr;
 }
 
+void Messages::SetBudget(int maxMessages, uint64_t maxTime)
+{
+    g_Budget.count = nidium_max(1, maxMessages);
+    g_Budget.time  = maxTime;
+}
+
+void Messages::SetStatsEnabled(bool enable)
+{
+    g_Stats.enabled = enable;
+}
+
+const Messages::Stats &Messages::GetStats()
+{
+    uint64_t now = Utils::GetTick();
+
+    g_Stats.elapsed = g_StatsLastTick ? (now - g_StatsLastTick) / 1e9 : 0;
+    g_StatsLastTick = now;
+
+    for (EventStats &evstats : g_Stats.events) {
+        evstats.perSec = g_Stats.elapsed > 0
+                             ? (evstats.count - evstats.lastCount)
+                                   / g_Stats.elapsed
+                             : 0;
+        evstats.lastCount = evstats.count;
+    }
+
+    return g_Stats;
+}
+
 SharedMessages *Messages::getSharedMessages()
 {
     return g_MessagesList;
@@ -55,16 +55,88 @@ public:
     static void InitReader(ape_global *ape);
     static void DestroyReader();
 
+    /*
+        Limit the work done by the reader on each event loop iteration.
+        |maxMessages| messages at most, and stop once |maxTime| ns
+        have been spent (0 to disable the time budget).
+    */
+    static void SetBudget(int maxMessages, uint64_t maxTime);
+
+    /*
+        Per class/event counters are off by default : they cost two
+        GetTick() per message.
+    */
+    static void SetStatsEnabled(bool enable);
+
+    struct EventStats
+    {
+        /*
+            Receiver class (as given to setStatsName(), nullptr for the
+            overflow slot) and event id
+        */
+        const char *className;
+        int event;
+        uint64_t count;
+        /* Post to onMessage() latency, in ns */
+        uint64_t totalLatency;
+        uint64_t maxLatency;
+        /* Messages per second since the previous GetStats() call */
+        double perSec;
+        uint64_t lastCount;
+    };
+
+    /* Must be a power of two */
+    static const int kStats_MaxEvents = 64;
+
+    struct Stats
+    {
+        bool enabled;
+        /* Number of times the reader was run */
+        uint64_t ticks;
+        uint64_t handled;
+        /* Ticks interrupted by the count or time budget */
+        uint64_t countBudgetExhausted;
+        uint64_t timeBudgetExhausted;
+        /* Seconds elapsed since the previous GetStats() call */
+        double elapsed;
+        /*
+            Slots with a non-zero count are in use. The last one gathers
+            the messages that didn't fit in the table.
+        */
+        EventStats events[kStats_MaxEvents + 1];
+    };
+
+    /*
+        Must be called from the thread running the reader.
+    */
+    static const Stats &GetStats();
+
     SharedMessages *getSharedMessages();
 
+    const char *getStatsName() const
+    {
+        return m_StatsName;
+    }
+
 
     int32_t _m_CountMessagePending = 0;
 protected:
     void cleanupMessages();
 
+    /*
+        Name the messages received by the object are reported under in the
+        stats. Must be a string literal : it's compared by address.
+        Each class calls it in its constructor, the most derived one wins.
+    */
+    void setStatsName(const char *name)
+    {
+        m_StatsName = name;
+    }
+
 private:
     void listenFor(Events *obj, bool enable);
     pthread_t m_GenesisThread;
+    const char *m_StatsName = "Messages";
 
     /* Keep track on which objects we are listening events */
     std::set<Events *> m_Listening_s;
@@ -0,0 +1,273 @@
+/*
+   Copyright 2016 Nidium Inc. All rights reserved.
+   Use of this source code is governed by a MIT license
+   that can be found in the LICENSE file.
+*/
+#include "Core/Pool.h"
+
+#include <stdlib.h>
+#include <pthread.h>
+
+#include "Core/Atomic.h"
+#include "Core/Utils.h"
+
+namespace Nidium {
+namespace Core {
+
+// {{{ Preamble
+static const size_t g_SizeClasses[Pool::kSizeClasses] = { 64, 128, 256, 512 };
+
+/* Blocks a thread keeps for itself before handing a batch to the depot */
+#define POOL_MAX_LOCAL (Pool::kBatchSize * 2)
+/*
+    A thread that keeps freeing blocks of a size class without allocating
+    any (e.g. the consumer of messages posted by another thread) hands
+    them back to the depot every POOL_RETURN_BATCH blocks
+*/
+#define POOL_RETURN_BATCH 16
+/* Blocks kept in the depot before they are given back to malloc() */
+#define POOL_MAX_DEPOT (Pool::kBatchSize * 64)
+
+struct PoolBlock
+{
+    PoolBlock *next;
+    /* Only meaningful on the first block of a batch in the depot */
+    PoolBlock *nextBatch;
+    int batchCount;
+};
+
+struct PoolThreadCache
+{
+    PoolBlock *list[Pool::kSizeClasses];
+    int count[Pool::kSizeClasses];
+    /* Blocks freed since the last allocation */
+    int freed[Pool::kSizeClasses];
+
+    int64_t allocated;
+    int64_t reused;
+    int ops;
+};
+
+static struct
+{
+    pthread_mutex_t lock;
+    PoolBlock *batches;
+    /* Number of blocks */
+    int count;
+} g_Depot[Pool::kSizeClasses] = {
+    { PTHREAD_MUTEX_INITIALIZER, NULL, 0 },
+    { PTHREAD_MUTEX_INITIALIZER, NULL, 0 },
+    { PTHREAD_MUTEX_INITIALIZER, NULL, 0 },
+    { PTHREAD_MUTEX_INITIALIZER, NULL, 0 },
+};
+
+static int64_t g_Allocated = 0;
+static int64_t g_Reused    = 0;
+
+static pthread_key_t g_CacheKey;
+static pthread_once_t g_CacheKeyOnce = PTHREAD_ONCE_INIT;
+
+static inline int Pool_getSizeClass(size_t size)
+{
+    for (int i = 0; i < Pool::kSizeClasses; i++) {
+        if (size <= g_SizeClasses[i]) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+static void Pool_flushStats(PoolThreadCache *cache)
+{
+    Atomic::Add(&g_Allocated, cache->allocated);
+    Atomic::Add(&g_Reused, cache->reused);
+
+    cache->allocated = 0;
+    cache->reused    = 0;
+    cache->ops       = 0;
+}
+
+/*
+    Hand the first |count| blocks of the local freelist to the depot
+*/
+static void Pool_releaseBatch(PoolThreadCache *cache, int cls, int count)
+{
+    PoolBlock *batch = cache->list[cls];
+    PoolBlock *last  = batch;
+
+    for (int i = 1; i < count; i++) {
+        last = last->next;
+    }
+
+    cache->list[cls] = last->next;
+    cache->count[cls] -= count;
+    last->next = NULL;
+
+    {
+        PthreadAutoLock lock(&g_Depot[cls].lock);
+
+        if (g_Depot[cls].count + count <= POOL_MAX_DEPOT) {
+            batch->nextBatch     = g_Depot[cls].batches;
+            batch->batchCount    = count;
+            g_Depot[cls].batches = batch;
+            g_Depot[cls].count += count;
+
+            return;
+        }
+    }
+
+    while (batch) {
+        PoolBlock *tmp = batch->next;
+        free(batch);
+        batch = tmp;
+    }
+}
+
+/*
+    Thread exit : everything cached locally goes back to the depot
+*/
+static void Pool_destroyThreadCache(void *arg)
+{
+    PoolThreadCache *cache = static_cast<PoolThreadCache *>(arg);
+
+    for (int i = 0; i < Pool::kSizeClasses; i++) {
+        while (cache->count[i] > 0) {
+            Pool_releaseBatch(cache, i,
+                              nidium_min(cache->count[i], Pool::kBatchSize));
+        }
+    }
+
+    Pool_flushStats(cache);
+
+    free(cache);
+}
+
+static void Pool_createKey()
+{
+    pthread_key_create(&g_CacheKey, Pool_destroyThreadCache);
+}
+
+static inline PoolThreadCache *Pool_getThreadCache()
+{
+    pthread_once(&g_CacheKeyOnce, Pool_createKey);
+
+    PoolThreadCache *cache
+        = static_cast<PoolThreadCache *>(pthread_getspecific(g_CacheKey));
+
+    if (cache == NULL) {
+        cache = static_cast<PoolThreadCache *>(
+            calloc(1, sizeof(PoolThreadCache)));
+        pthread_setspecific(g_CacheKey, cache);
+    }
+
+    return cache;
+}
+
+static inline void Pool_countOp(PoolThreadCache *cache)
+{
+    if (++cache->ops >= Pool::kBatchSize) {
+        Pool_flushStats(cache);
+    }
+}
+// }}}
+
+// {{{ Pool
+void *Pool::Alloc(size_t size)
+{
+    int cls = Pool_getSizeClass(size);
+
+    if (cls == -1) {
+        return malloc(size);
+    }
+
+    PoolThreadCache *cache = Pool_getThreadCache();
+    PoolBlock *block;
+
+    if (cache->list[cls] == NULL) {
+        PthreadAutoLock lock(&g_Depot[cls].lock);
+
+        if (g_Depot[cls].batches) {
+            PoolBlock *batch     = g_Depot[cls].batches;
+            g_Depot[cls].batches = batch->nextBatch;
+            g_Depot[cls].count -= batch->batchCount;
+
+            cache->list[cls]  = batch;
+            cache->count[cls] = batch->batchCount;
+        }
+    }
+
+    cache->freed[cls] = 0;
+
+    if ((block = cache->list[cls]) != NULL) {
+        cache->list[cls] = block->next;
+        cache->count[cls]--;
+        cache->reused++;
+    } else {
+        block = static_cast<PoolBlock *>(malloc(g_SizeClasses[cls]));
+        cache->allocated++;
+    }
+
+    Pool_countOp(cache);
+
+    return block;
+}
+
+void Pool::Free(void *ptr, size_t size)
+{
+    if (ptr == NULL) {
+        return;
+    }
+
+    int cls = Pool_getSizeClass(size);
+
+    if (cls == -1) {
+        free(ptr);
+        return;
+    }
+
+    PoolThreadCache *cache = Pool_getThreadCache();
+    PoolBlock *block       = static_cast<PoolBlock *>(ptr);
+
+    block->next      = cache->list[cls];
+    cache->list[cls] = block;
+    cache->count[cls]++;
+
+    if (cache->count[cls] > POOL_MAX_LOCAL) {
+        Pool_releaseBatch(cache, cls, kBatchSize);
+        cache->freed[cls] = 0;
+    } else if (++cache->freed[cls] >= POOL_RETURN_BATCH) {
+        /* Not allocating : the blocks are more useful to other threads */
+        Pool_releaseBatch(cache, cls, cache->freed[cls]);
+        cache->freed[cls] = 0;
+    }
+}
+
+void Pool::GetStats(Stats *stats)
+{
+    /* Each thread computes the rate since its own previous call */
+    static thread_local struct
+    {
+        uint64_t tick;
+        uint64_t reused;
+    } last = { 0, 0 };
+
+    uint64_t now = Utils::GetTick();
+
+    stats->allocated = Atomic::Add(&g_Allocated, 0);
+    stats->reused    = Atomic::Add(&g_Reused, 0);
+
+    if (last.tick != 0 && now > last.tick) {
+        stats->reusedPerSec = (stats->reused - last.reused)
+                              / (static_cast<double>(now - last.tick) / 1e9);
+    } else {
+        stats->reusedPerSec = 0;
+    }
+
+    last.tick   = now;
+    last.reused = stats->reused;
+}
+// }}}
+
+} // namespace Core
+} // namespace Nidium
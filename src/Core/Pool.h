@@ -0,0 +1,58 @@
+/*
+   Copyright 2016 Nidium Inc. All rights reserved.
+   Use of this source code is governed by a MIT license
+   that can be found in the LICENSE file.
+*/
+#ifndef core_pool_h__
+#define core_pool_h__
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace Nidium {
+namespace Core {
+
+/*
+    Size-classed freelists for small, short-lived objects that are
+    allocated on one thread and released on another
+    (e.g. SharedMessages::Message or Task).
+
+    Each thread owns a local freelist per size class. When a thread
+    releases more blocks than it keeps, or keeps releasing blocks without
+    allocating any, a batch of them is handed to a shared depot, where the
+    allocating thread picks them back up one batch at a time. The depot
+    lock is thus taken once per batch instead of once per object.
+*/
+class Pool
+{
+public:
+    static const int kSizeClasses = 4;
+    static const int kBatchSize   = 64;
+
+    struct Stats
+    {
+        /* Allocations served by malloc() */
+        uint64_t allocated;
+        /* Allocations served by a freelist (i.e. avoided) */
+        uint64_t reused;
+        /*
+            Allocations avoided per second since the last GetStats() call
+            made by the same thread
+        */
+        double reusedPerSec;
+    };
+
+    static void *Alloc(size_t size);
+    static void Free(void *ptr, size_t size);
+
+    /*
+        Counters are flushed by each thread every kBatchSize operations,
+        the values are therefore slightly lagging.
+    */
+    static void GetStats(Stats *stats);
+};
+
+} // namespace Core
+} // namespace Nidium
+
+#endif
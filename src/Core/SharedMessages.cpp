@@ -7,15 +7,14 @@
 
 #include <pthread.h>
 
+#include "Core/Atomic.h"
 #include "Utils.h"
 
 namespace Nidium {
 namespace Core {
 
-SharedMessages::SharedMessages()
-    :
-
-      m_Cleaner(NULL)
+SharedMessages::SharedMessages(QueueType type)
+    : m_Incoming(NULL), m_QueueType(type), m_Cleaner(NULL)
 {
     m_MessagesList.count      = 0;
     m_MessagesList.asyncCount = 0;
@@ -45,9 +44,13 @@ void SharedMessages::postMessage(uint64_t dataint, int event)
     this->addMessage(new Message(dataint, event));
 }
 
-void SharedMessages::addMessage(Message *msg)
+/*
+    Append a message at the end of the consumer list.
+    m_MessagesList.lock must be held.
+*/
+void SharedMessages::appendMessage(Message *msg)
 {
-    PthreadAutoLock lock(&m_MessagesList.lock);
+    msg->prev = NULL;
 
     if (m_MessagesList.head) {
         m_MessagesList.head->prev = msg;
@@ -57,18 +60,75 @@ void SharedMessages::addMessage(Message *msg)
         m_MessagesList.queue = msg;
     }
 
+    m_MessagesList.head = msg;
+}
+
+/*
+    Move everything pushed by the producers to the consumer list.
+    m_MessagesList.lock must be held.
+*/
+void SharedMessages::drainIncoming()
+{
+    if (m_Incoming == NULL) {
+        return;
+    }
+
+    Message *msg = static_cast<Message *>(
+        Atomic::Swap(reinterpret_cast<void **>(&m_Incoming), NULL));
+    Message *fifo = NULL;
+
+    /* The producer stack is LIFO, reverse it */
+    while (msg != NULL) {
+        Message *tmp = msg->prev;
+        msg->prev    = fifo;
+        fifo         = msg;
+        msg          = tmp;
+    }
+
+    while (fifo != NULL) {
+        Message *tmp = fifo->prev;
+        this->appendMessage(fifo);
+        fifo = tmp;
+    }
+}
+
+void SharedMessages::addMessage(Message *msg)
+{
+    /*
+        Counters are updated before the message is made visible so
+        that hasPendingMessages()/hasAsyncMessages() never under-report.
+    */
     if (msg->forceAsync()) {
-        m_MessagesList.asyncCount++;
+        Atomic::Inc(&m_MessagesList.asyncCount);
     }
 
-    m_MessagesList.head = msg;
-    m_MessagesList.count++;
+    Atomic::Inc(&m_MessagesList.count);
+
+    if (m_QueueType == kQueue_LockFree) {
+        Message *top;
+
+        do {
+            top       = m_Incoming;
+            msg->prev = top;
+        } while (Atomic::Cas(reinterpret_cast<void **>(&m_Incoming), top, msg)
+                 != top);
+
+        return;
+    }
+
+    PthreadAutoLock lock(&m_MessagesList.lock);
+
+    this->appendMessage(msg);
 }
 
 SharedMessages::Message *SharedMessages::readMessage(bool stopOnAsync)
 {
     PthreadAutoLock lock(&m_MessagesList.lock);
 
+    if (m_MessagesList.queue == NULL) {
+        this->drainIncoming();
+    }
+
     Message *message = m_MessagesList.queue;
 
     if (message == NULL) {
@@ -86,10 +146,10 @@ SharedMessages::Message *SharedMessages::readMessage(bool stopOnAsync)
     }
 
     if (message->forceAsync()) {
-        m_MessagesList.asyncCount--;
+        Atomic::Dec(&m_MessagesList.asyncCount);
     }
 
-    m_MessagesList.count--;
+    Atomic::Dec(&m_MessagesList.count);
 
     return message;
 }
@@ -98,6 +158,12 @@ void SharedMessages::delMessagesForDest(void *dest, int event)
 {
     PthreadAutoLock lock(&m_MessagesList.lock);
 
+    /*
+        Messages still sitting in the producer stack
+        must be considered as well
+    */
+    this->drainIncoming();
+
     Message *message = m_MessagesList.queue;
     Message *next    = NULL;
 
@@ -122,7 +188,7 @@ void SharedMessages::delMessagesForDest(void *dest, int event)
             }
 
             if (message->forceAsync()) {
-                m_MessagesList.asyncCount--;
+                Atomic::Dec(&m_MessagesList.asyncCount);
             }
 
             if (m_Cleaner) {
@@ -130,7 +196,7 @@ void SharedMessages::delMessagesForDest(void *dest, int event)
             }
 
             delete message;
-            m_MessagesList.count--;
+            Atomic::Dec(&m_MessagesList.count);
         } else {
             next = message;
         }
@@ -10,6 +10,7 @@
 #include <stdint.h>
 
 #include "Core/Args.h"
+#include "Core/Pool.h"
 
 /*
     TODO: Add "max messages in queue" to guard memory congestion in case of
@@ -55,6 +56,20 @@ public:
         {
         }
 
+        /*
+            Messages are usually allocated by one thread and
+            released by another, recycle them through Core::Pool
+        */
+        static void *operator new(size_t size)
+        {
+            return Pool::Alloc(size);
+        }
+
+        static void operator delete(void *ptr, size_t size)
+        {
+            Pool::Free(ptr, size);
+        }
+
         void *dataPtr() const
         {
             return m_Msgdata.dataptr;
@@ -93,6 +108,8 @@ public:
         Message *prev;
         Args m_Args;
         uint32_t m_Priv;
+        /* Set by Messages::postMessage(), used for latency stats */
+        uint64_t m_PostTime = 0;
 
     private:
         union
@@ -109,7 +126,19 @@ public:
     typedef void (*nidium_shared_message_cleaner)(
         const SharedMessages::Message &msg);
 
-    SharedMessages();
+    /*
+        kQueue_Mutex    : every post and read takes the queue lock.
+        kQueue_LockFree : producers push with a single CAS and never take
+                          a lock. Only the consumer side (readMessage() and
+                          delMessagesForDest()) is serialized.
+    */
+    enum QueueType
+    {
+        kQueue_Mutex,
+        kQueue_LockFree
+    };
+
+    SharedMessages(QueueType type = kQueue_Mutex);
     ~SharedMessages();
 
     void postMessage(Message *msg);
@@ -132,20 +161,35 @@ public:
         return m_MessagesList.count != 0;
     }
 
+    QueueType getQueueType() const
+    {
+        return m_QueueType;
+    }
+
 private:
     struct
     {
-        int count;
-        int asyncCount;
+        int32_t count;
+        int32_t asyncCount;
         Message *head;
         Message *queue;
         pthread_mutex_t lock;
 
     } m_MessagesList;
 
+    /*
+        Lock-free producer stack (LIFO, linked through Message::prev).
+        The consumer grabs it as a whole and appends it, reversed,
+        to m_MessagesList.
+    */
+    Message *m_Incoming;
+
+    QueueType m_QueueType;
     nidium_shared_message_cleaner m_Cleaner;
 
     void addMessage(Message *msg);
+    void appendMessage(Message *msg);
+    void drainIncoming();
 };
 
 } // namespace Core
@@ -8,8 +8,11 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <unistd.h>
 #include <pthread.h>
 
+#include <algorithm>
+
 #include "Core/Atomic.h"
 
 namespace Nidium {
@@ -18,44 +21,128 @@ namespace Core {
 // {{{ Preamble
 static pthread_key_t gManager = 0;
 
+/*
+    Maximum number of tasks run in a row for the same Managed object
+    before giving other objects of the worker a chance to run
+*/
+#define MAX_TASK_IN_ROW 32
+
 void *TaskManager_Worker(void *arg)
 {
     return static_cast<TaskManager::workerInfo *>(arg)->work();
 }
+
+static void Managed_TaskCleaner(const SharedMessages::Message &msg)
+{
+    Task *task = static_cast<Task *>(msg.dataPtr());
+    delete task;
+}
 // }}}
 
 // {{{ TaskManager::workerInfo
 void *TaskManager::workerInfo::work()
 {
     while (!m_Stop) {
-        pthread_mutex_lock(&m_Lock);
-        while (!m_Stop && !m_Messages.hasPendingMessages()) {
-            pthread_cond_wait(&m_Cond, &m_Lock);
-        }
-        if (m_Stop) {
-            return NULL;
-        }
-        pthread_mutex_unlock(&m_Lock);
+        ManagedHandle *handle = this->pop();
 
-        SharedMessages::Message *msg;
+        if (handle == NULL) {
+            handle = m_Manager->steal(this);
+        }
 
-        while ((msg = m_Messages.readMessage())) {
-            Task *task       = static_cast<Task *>(msg->dataPtr());
-            Managed *managed = task->getObject();
+        if (handle != NULL) {
+            Managed::RunTasks(handle, this);
+            continue;
+        }
 
-            managed->lockTasks();
-            task->getFunction()(task);
-            managed->unlockTasks();
+        PthreadAutoLock npal(&m_Lock);
 
-            Atomic::Dec(&managed->m_TaskQueued);
+        /*
+            Advertise the worker as waiting before the last check for
+            work (the Cas is a full barrier). schedule() pushes then looks
+            for a waiting worker : either it sees this one and wakes it
+            up (through m_Lock), or the push is seen below.
+        */
+        Atomic::Cas(&m_Waiting, 0, 1);
 
-            delete task;
-            delete msg;
+        while (!m_Stop && m_Runnable.empty()
+               && m_Manager->m_PendingCount == 0) {
+            pthread_cond_wait(&m_Cond, &m_Lock);
         }
+
+        m_Waiting = 0;
     }
+
     return NULL;
 }
 
+void TaskManager::workerInfo::push(Managed *obj)
+{
+    PthreadAutoLock npal(&m_Lock);
+
+    obj->m_Handle->ref();
+
+    m_Runnable.push_back(obj->m_Handle);
+    m_Queued++;
+    Atomic::Inc(&m_Manager->m_PendingCount);
+
+    pthread_cond_signal(&m_Cond);
+}
+
+/*
+    The owner pops from the front (oldest first),
+    thieves take from the back.
+*/
+ManagedHandle *TaskManager::workerInfo::pop(bool steal)
+{
+    PthreadAutoLock npal(&m_Lock);
+
+    if (m_Runnable.empty()) {
+        return NULL;
+    }
+
+    ManagedHandle *handle;
+
+    if (steal) {
+        handle = m_Runnable.back();
+        m_Runnable.pop_back();
+    } else {
+        handle = m_Runnable.front();
+        m_Runnable.pop_front();
+    }
+
+    m_Queued--;
+    Atomic::Dec(&m_Manager->m_PendingCount);
+
+    return handle;
+}
+
+bool TaskManager::workerInfo::remove(Managed *obj)
+{
+    PthreadAutoLock npal(&m_Lock);
+
+    std::deque<ManagedHandle *>::iterator it
+        = std::find(m_Runnable.begin(), m_Runnable.end(), obj->m_Handle);
+
+    if (it == m_Runnable.end()) {
+        return false;
+    }
+
+    m_Runnable.erase(it);
+    m_Queued--;
+    Atomic::Dec(&m_Manager->m_PendingCount);
+
+    /* The object holds its own reference */
+    obj->m_Handle->release();
+
+    return true;
+}
+
+void TaskManager::workerInfo::wakeup()
+{
+    PthreadAutoLock npal(&m_Lock);
+    pthread_cond_signal(&m_Cond);
+}
+
 void TaskManager::workerInfo::stop()
 {
     if (m_Stop) {
@@ -68,67 +155,60 @@ void TaskManager::workerInfo::stop()
 
 void TaskManager::workerInfo::waitTerminate()
 {
-    pthread_join(m_Handle, NULL);
-}
+    if (!m_Started) {
+        return;
+    }
 
-void TaskManager_workerInfo_MessageCleaner(const SharedMessages::Message &msg)
-{
-    Task *task = static_cast<Task *>(msg.dataPtr());
-    delete task;
+    pthread_join(m_Handle, NULL);
+    m_Started = false;
 }
 
-TaskManager::workerInfo::workerInfo() : m_Stop(false), m_Manager(NULL)
+TaskManager::workerInfo::workerInfo()
+    : m_Stop(false), m_Started(false), m_Waiting(0), m_Manager(NULL),
+      m_Queued(0)
 {
     pthread_mutex_init(&m_Lock, NULL);
     pthread_cond_init(&m_Cond, NULL);
-
-    m_Messages.setCleaner(TaskManager_workerInfo_MessageCleaner);
 }
 
 TaskManager::workerInfo::~workerInfo()
 {
     this->stop();
-    pthread_join(m_Handle, NULL);
-
-    m_Messages.delMessagesForDest(NULL);
+    this->waitTerminate();
 }
 
 void TaskManager::workerInfo::run()
 {
-    m_Stop = false;
+    m_Stop    = false;
+    m_Started = true;
     pthread_create(&m_Handle, NULL, TaskManager_Worker, this);
 }
-
-void TaskManager::workerInfo::addTask(Task *task)
-{
-    SharedMessages::Message *msg = new SharedMessages::Message(task, 0);
-
-    /*
-        Set the caller as destination so that messages
-        can be deleted "per caller" in a worker
-        (in case a worker handle multiple caller/task)
-    */
-    msg->setDest(task->getObject());
-    m_Messages.postMessage(msg);
-
-    PthreadAutoLock npal(&m_Lock);
-    pthread_cond_signal(&m_Cond);
-}
 // }}}
 
 // {{{ TaskManager
-TaskManager::TaskManager()
+TaskManager::TaskManager() : m_PendingCount(0)
 {
+    int cpus = static_cast<int>(sysconf(_SC_NPROCESSORS_ONLN));
+
     m_Threadpool.count = 0;
-    m_Threadpool.size  = NIDIUM_TASKMANAGER_MAX_THREAD;
+    m_Threadpool.next  = 0;
+    m_Threadpool.size  = nidium_max(cpus, NIDIUM_TASKMANAGER_MAX_IDLE_THREAD);
+
+    m_Threadpool.worker = new workerInfo[m_Threadpool.size];
+
+    for (int i = 0; i < m_Threadpool.size; i++) {
+        m_Threadpool.worker[i].setManager(this);
+    }
 
-    m_Threadpool.worker = new workerInfo[NIDIUM_TASKMANAGER_MAX_THREAD];
+    pthread_mutex_init(&m_Threadpool.lock, NULL);
 
     this->createWorker(NIDIUM_TASKMANAGER_MAX_IDLE_THREAD);
 }
 
 int TaskManager::createWorker(int count)
 {
+    PthreadAutoLock npal(&m_Threadpool.lock);
+
     int actualCount = count;
 
     /*
@@ -146,13 +226,13 @@ int TaskManager::createWorker(int count)
     }
 
     for (int i = 0; i < actualCount; i++) {
-
-        workerInfo *worker = &m_Threadpool.worker[m_Threadpool.count + i];
-
-        worker->setManager(this);
-        worker->run();
+        m_Threadpool.worker[m_Threadpool.count + i].run();
     }
 
+    /*
+        Only publish the new workers once they are running,
+        other threads read m_Threadpool.count without the lock.
+    */
     m_Threadpool.count += actualCount;
 
     return actualCount;
@@ -167,13 +247,112 @@ void TaskManager::stopAll()
 
     for (i = 0; i < count; i++) {
         m_Threadpool.worker[i].waitTerminate();
-        m_Threadpool.worker[i].getMessages()->delMessagesForDest(NULL);
     }
 }
 
+TaskManager::workerInfo *TaskManager::getIdleWorker()
+{
+    int count = m_Threadpool.count;
+
+    for (int i = 0; i < count; i++) {
+        if (m_Threadpool.worker[i].isWaiting()) {
+            return &m_Threadpool.worker[i];
+        }
+    }
+
+    return NULL;
+}
+
+/*
+    Idle worker first, otherwise the one with the shortest deque.
+    Values are read without locking and only used as a hint.
+*/
 TaskManager::workerInfo *TaskManager::getAvailableWorker()
 {
-    return &m_Threadpool.worker[rand() % m_Threadpool.count];
+    workerInfo *worker = this->getIdleWorker();
+
+    if (worker) {
+        return worker;
+    }
+
+    int count = m_Threadpool.count;
+    int start = static_cast<uint32_t>(Atomic::Inc(&m_Threadpool.next)) % count;
+    worker    = &m_Threadpool.worker[start];
+
+    for (int i = 1; i < count; i++) {
+        workerInfo *cur = &m_Threadpool.worker[(start + i) % count];
+
+        if (cur->getQueueSize() < worker->getQueueSize()) {
+            worker = cur;
+        }
+    }
+
+    return worker;
+}
+
+void TaskManager::schedule(Managed *obj, workerInfo *worker)
+{
+    if (worker == NULL) {
+        /* Keep the object on the worker that last ran it if it's free */
+        worker = obj->m_Worker;
+
+        if (worker == NULL || !worker->isWaiting()) {
+            worker = this->getAvailableWorker();
+        }
+    }
+
+    worker->push(obj);
+
+    if (worker->isWaiting()) {
+        return;
+    }
+
+    /*
+        The target worker is busy, let an idle one steal the object.
+        If every worker is busy, grow the pool (up to the CPU count).
+    */
+    workerInfo *idle = this->getIdleWorker();
+
+    if (idle) {
+        idle->wakeup();
+    } else if (m_Threadpool.count < m_Threadpool.size) {
+        this->createWorker(1);
+    }
+}
+
+void TaskManager::unschedule(Managed *obj)
+{
+    int count = m_Threadpool.count;
+
+    for (int i = 0; i < count; i++) {
+        m_Threadpool.worker[i].remove(obj);
+    }
+}
+
+ManagedHandle *TaskManager::steal(workerInfo *thief)
+{
+    int count = m_Threadpool.count;
+
+    if (m_PendingCount == 0) {
+        return NULL;
+    }
+
+    int start = (thief - m_Threadpool.worker) + 1;
+
+    for (int i = 0; i < count; i++) {
+        workerInfo *victim = &m_Threadpool.worker[(start + i) % count];
+        ManagedHandle *handle;
+
+        if (victim == thief) {
+            continue;
+        }
+
+        if ((handle = victim->pop(true)) != NULL) {
+            return handle;
+        }
+    }
+
+    return NULL;
 }
 
 TaskManager *TaskManager::GetManager()
@@ -212,15 +391,140 @@ TaskManager::~TaskManager()
 }
 // }}}
 
+// {{{ ManagedHandle
+ManagedHandle::ManagedHandle(Managed *obj) : m_Obj(obj), m_Refs(1)
+{
+    pthread_mutexattr_t attr;
+
+    /*
+        Recursive : a task may delete its own object, ~Managed() then
+        takes the lock already held by the worker running the task
+    */
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&m_Lock, &attr);
+    pthread_mutexattr_destroy(&attr);
+}
+
+ManagedHandle::~ManagedHandle()
+{
+    pthread_mutex_destroy(&m_Lock);
+}
+
+void ManagedHandle::ref()
+{
+    Atomic::Inc(&m_Refs);
+}
+
+void ManagedHandle::release()
+{
+    if (Atomic::Dec(&m_Refs) == 1) {
+        delete this;
+    }
+}
+// }}}
+
 // {{{ Managed
+Managed::Managed()
+    : m_TaskQueued(0), m_Worker(NULL),
+      m_Tasks(SharedMessages::kQueue_LockFree), m_Scheduled(0)
+{
+    this->setStatsName("Managed");
+
+    m_Manager = TaskManager::GetManager();
+    m_Handle  = new ManagedHandle(this);
+
+    m_Tasks.setCleaner(Managed_TaskCleaner);
+}
+
+Managed::~Managed()
+{
+    this->stopTasks();
+
+    /* Freed by the last worker holding it */
+    m_Handle->release();
+}
+
+void Managed::stopTasks()
+{
+    /*
+        Once the handle is detached (under the tasks lock) no worker
+        will run or reschedule the object anymore. A running task
+        holds the lock, it's the only thing we wait for.
+    */
+    this->lockTasks();
+    m_Handle->m_Obj = NULL;
+    this->unlockTasks();
+
+    if (m_Manager) {
+        m_Manager->unschedule(this);
+    }
+
+    m_Tasks.delMessagesForDest(NULL);
+}
+
 void Managed::lockTasks()
 {
-    pthread_mutex_lock(&m_Lock);
+    pthread_mutex_lock(&m_Handle->m_Lock);
 }
 
 void Managed::unlockTasks()
 {
-    pthread_mutex_unlock(&m_Lock);
+    pthread_mutex_unlock(&m_Handle->m_Lock);
+}
+
+/*
+    /!\ Exec in a worker thread
+*/
+void Managed::RunTasks(ManagedHandle *handle, TaskManager::workerInfo *worker)
+{
+    SharedMessages::Message *msg;
+    Managed *obj;
+
+    for (int i = 0; i < MAX_TASK_IN_ROW; i++) {
+        pthread_mutex_lock(&handle->m_Lock);
+
+        if ((obj = handle->get()) == NULL
+            || (msg = obj->m_Tasks.readMessage()) == NULL) {
+            pthread_mutex_unlock(&handle->m_Lock);
+            break;
+        }
+
+        Task *task = static_cast<Task *>(msg->dataPtr());
+        task->getFunction()(task);
+
+        /* The task may have deleted the object */
+        if ((obj = handle->get()) != NULL) {
+            Atomic::Dec(&obj->m_TaskQueued);
+        }
+
+        pthread_mutex_unlock(&handle->m_Lock);
+
+        delete task;
+        delete msg;
+    }
+
+    pthread_mutex_lock(&handle->m_Lock);
+
+    if ((obj = handle->get()) != NULL) {
+        obj->m_Worker = worker;
+
+        Atomic::Cas(&obj->m_Scheduled, 1, 0);
+
+        /*
+            Tasks were added while we were running (or we hit
+            MAX_TASK_IN_ROW) : requeue at the back of our deque
+        */
+        if (obj->m_Tasks.hasPendingMessages()
+            && Atomic::Cas(&obj->m_Scheduled, 0, 1)) {
+            obj->m_Manager->schedule(obj, worker);
+        }
+    }
+
+    pthread_mutex_unlock(&handle->m_Lock);
+
+    /* The object may be gone already */
+    handle->release();
 }
 
 void Managed::addTask(Task *task)
@@ -229,15 +533,16 @@ void Managed::addTask(Task *task)
         ndm_log(NDM_LOG_WARN, "TaskManager", "addTask() : Unknown manager");
         return;
     }
-    if (m_Worker == NULL) {
-        m_Worker = m_Manager->getAvailableWorker();
-    }
 
     task->setObject(this);
 
     Atomic::Inc(&m_TaskQueued);
 
-    m_Worker->addTask(task);
+    m_Tasks.postMessage(task, 0);
+
+    if (Atomic::Cas(&m_Scheduled, 0, 1)) {
+        m_Manager->schedule(this);
+    }
 }
 // }}}
 
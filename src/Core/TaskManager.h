@@ -8,21 +8,34 @@
 
 #include <stdio.h>
 #include <pthread.h>
+#include <deque>
 
 #include "Core/Messages.h"
 #include "Core/SharedMessages.h"
+#include "Core/Pool.h"
 
 namespace Nidium {
 namespace Core {
 
+/*
+    Number of workers started with the manager. More workers are
+    spawned on demand, up to the number of online CPUs.
+*/
 #define NIDIUM_TASKMANAGER_MAX_IDLE_THREAD 8
-#define NIDIUM_TASKMANAGER_MAX_THREAD 16
 
 // {{{ TaskManager
 class Task;
+class Managed;
+class ManagedHandle;
 class TaskManager
 {
 public:
+    /*
+        Each worker owns a deque of runnable Managed objects.
+        Workers pop from the front of their own deque and steal
+        from the back of the others when they run out of work.
+        The deques hold a reference to the objects handle.
+    */
     class workerInfo
     {
     public:
@@ -32,17 +45,31 @@ public:
         void *work();
         void stop();
         void run();
-        void addTask(Task *task);
         void waitTerminate();
 
-        void setManager(TaskManager *manager)
+        void push(Managed *obj);
+
+        /*
+            The reference held by the deque is handed to the caller,
+            it must be released once done with the object
+        */
+        ManagedHandle *pop(bool steal = false);
+        bool remove(Managed *obj);
+        void wakeup();
+
+        bool isWaiting() const
         {
-            m_Manager = manager;
+            return m_Waiting != 0;
         }
 
-        SharedMessages *getMessages()
+        int32_t getQueueSize() const
         {
-            return &m_Messages;
+            return m_Queued;
+        }
+
+        void setManager(TaskManager *manager)
+        {
+            m_Manager = manager;
         }
 
     private:
@@ -50,8 +77,11 @@ public:
         pthread_mutex_t m_Lock;
         pthread_cond_t m_Cond;
         bool m_Stop;
+        bool m_Started;
+        int32_t m_Waiting;
         TaskManager *m_Manager;
-        SharedMessages m_Messages;
+        std::deque<ManagedHandle *> m_Runnable;
+        int32_t m_Queued;
     };
 
     TaskManager();
@@ -59,17 +89,42 @@ public:
     int createWorker(int count = 1);
     void stopAll();
 
+    /*
+        Queue |obj| on |worker| (or on the best worker available)
+        and wake up a thread to run it
+    */
+    void schedule(Managed *obj, workerInfo *worker = NULL);
+    void unschedule(Managed *obj);
+    ManagedHandle *steal(workerInfo *thief);
+
     workerInfo *getAvailableWorker();
+    int getWorkerCount() const
+    {
+        return m_Threadpool.count;
+    }
+
+    int getMaxWorkerCount() const
+    {
+        return m_Threadpool.size;
+    }
+
     static TaskManager *GetManager();
     static void CreateManager();
 
+    /* Number of Managed objects waiting in the workers deques */
+    int32_t m_PendingCount;
+
 private:
+    workerInfo *getIdleWorker();
+
     struct
     {
         int count;
         int size;
+        int32_t next;
 
         workerInfo *worker;
+        pthread_mutex_t lock;
     } m_Threadpool;
 };
 // }}}
@@ -85,6 +140,16 @@ public:
     {
     }
 
+    static void *operator new(size_t size)
+    {
+        return Pool::Alloc(size);
+    }
+
+    static void operator delete(void *ptr, size_t size)
+    {
+        Pool::Free(ptr, size);
+    }
+
     void setFunction(task_func func)
     {
         m_Func = func;
@@ -116,25 +181,56 @@ private:
 };
 // }}}
 
-// {{{ Managed
-class Managed : public Messages
+// {{{ ManagedHandle
+/*
+    Part of a Managed object shared with the workers. Workers reach the
+    object through its handle only, and the handle outlives the object
+    until the last worker holding it is done. Deleting a Managed object
+    doesn't wait for the workers that popped it.
+*/
+class ManagedHandle
 {
 public:
-    Managed() : m_TaskQueued(0), m_Worker(NULL)
+    explicit ManagedHandle(Managed *obj);
+
+    void ref();
+    void release();
+
+    /*
+        NULL once the object is being destroyed.
+        The tasks lock must be held.
+    */
+    Managed *get() const
     {
-        m_Manager = TaskManager::GetManager();
-        pthread_mutex_init(&m_Lock, NULL);
+        return m_Obj;
     }
 
-    ~Managed()
-    {
-        if (m_Worker) {
-            m_Worker->getMessages()->delMessagesForDest(this);
-        }
-    };
+    pthread_mutex_t m_Lock;
+
+    friend class Managed;
+
+private:
+    ~ManagedHandle();
+
+    Managed *m_Obj;
+    int32_t m_Refs;
+};
+// }}}
+
+// {{{ Managed
+/*
+    Tasks of a Managed object are queued on the object itself and always
+    run in FIFO order, one at a time. The object (not the task) is what
+    gets scheduled on a worker, so any idle worker can pick it up.
+*/
+class Managed : public Messages
+{
+public:
+    Managed();
+    ~Managed();
 
     inline pthread_mutex_t &getManagedLock() {
-        return m_Lock;
+        return m_Handle->m_Lock;
     }
 
     bool hasTaskOrMessagePending() const {
@@ -146,10 +242,31 @@ public:
     void unlockTasks();
     int32_t m_TaskQueued;
 
+    friend class TaskManager;
+
+protected:
+    /*
+        Wait for the running task and drop the queued ones, no task runs
+        afterward. Called by ~Managed(), derived classes whose tasks use
+        their own members must call it first in their destructor.
+    */
+    void stopTasks();
+
 private:
+    /*
+        Run the tasks of the object behind |handle|, if it's still alive.
+        Releases the reference held by the worker.
+    */
+    static void RunTasks(ManagedHandle *handle,
+                         TaskManager::workerInfo *worker);
+
     TaskManager *m_Manager;
     TaskManager::workerInfo *m_Worker;
-    pthread_mutex_t m_Lock;
+    SharedMessages m_Tasks;
+    ManagedHandle *m_Handle;
+
+    /* Set while the object sits in a deque or is being run */
+    int32_t m_Scheduled;
 };
 // }}}
 
@@ -38,6 +38,8 @@ Assets::Item::Item(const char *url, FileType t, ape_global *net)
     : m_FileType(t), m_State(ITEM_LOADING), m_Stream(NULL), m_Url(url),
       m_Net(net), m_Assets(NULL), m_Name(NULL), m_Tagname(NULL)
 {
+    this->setStatsName("Assets::Item");
+
     m_Data.data = NULL;
     m_Data.len  = 0;
 }
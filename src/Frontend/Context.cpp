@@ -126,6 +126,7 @@ Context::Context(ape_global *net)
       m_UI(NULL), m_NML(NULL), m_GLState(NULL),
       m_JSWindow(NULL), m_SizeDirty(false)
 {
+    this->setStatsName("Frontend::Context");
 
     m_YogaConfig = YGConfigNew();
     YGConfigSetPointScaleFactor(m_YogaConfig,
@@ -300,8 +301,10 @@ void Context::postDraw()
                      m_Stats.lastdifftime / 1000000LL);
         s->drawTextf(5, 38, "Time : %lldns",
                      m_Stats.lastmeasuredtime - m_Stats.starttime);
-        s->drawTextf(5, 51, "FPS  : %.2f (%d/%d/%d)", m_Stats.fps,
-                     m_Stats.composed, m_Stats.repaint, m_Stats.resize);
+        s->drawTextf(5, 51, "FPS  : %.2f (%d/%d/%d/%d) %llupx", m_Stats.fps,
+                     m_Stats.composed, m_Stats.culled, m_Stats.repaint,
+                     m_Stats.resize,
+                     (unsigned long long)m_Stats.composedPixels);
 
         s->setLineWidth(0.0);
 
@@ -417,26 +420,83 @@ void Context::frame(bool draw)
     m_CanvasOrderedEvents.clear();
 
     m_RootHandler->computeLayoutPositions();
+
+    Rect root;
+    root.m_fLeft   = 0;
+    root.m_fTop    = 0;
+    root.m_fRight  = m_RootHandler->getComputedWidth();
+    root.m_fBottom = m_RootHandler->getComputedHeight();
+
+    /*
+        Layers are not reported when nothing is drawn,
+        the next drawn frame needs a full composition
+    */
+    if (draw) {
+        m_Damage.begin(getCurrentFrame(), root);
+        ctx.m_Damage = &m_Damage;
+    } else {
+        m_Damage.invalidate();
+    }
+
     /* Build the composition list */
     m_RootHandler->layerize(ctx, compList, draw, getCurrentFrame());
 
-    m_UI->makeMainGLCurrent();
-    rootctx->clear(0xffffffff);
-    rootctx->flush();
+    if (draw) {
+        m_Damage.end();
+    }
+
+    m_Stats.composed       = 0;
+    m_Stats.culled         = 0;
+    m_Stats.composedPixels = 0;
 
     /*
-        Compose canvas eachother on the main framebuffer
+        The root surface keeps the result of the previous composition.
+        Only the damaged area is cleared and recomposited.
     */
-    m_RootHandler->getContext()->flush();
-    m_RootHandler->getContext()->resetGLContext();
-    /* We draw on the UI fbo */
-    glBindFramebuffer(GL_FRAMEBUFFER, m_UI->getFBO());
+    if (!draw || !m_Damage.isEmpty()) {
+        const Rect &damage = draw ? m_Damage.getDamage() : root;
+        SkCanvas *rootCanvas = rootctx->getSkiaContext()->getCanvas();
+
+        m_Stats.culled = CanvasHandler::CullOccluded(compList, damage);
 
-    m_Stats.composed = 0;
-    for (auto &com : compList) {
-        m_Stats.composed++;
-        com.handler->m_Context->preComposeOn(rootctx, com.left,
-            com.top, com.opacity, com.zoom, com.needClip ? &com.clip : nullptr);
+        m_UI->makeMainGLCurrent();
+
+        rootCanvas->save();
+        rootCanvas->clipRect(SkRect::MakeLTRB(damage.m_fLeft, damage.m_fTop,
+                                              damage.m_fRight,
+                                              damage.m_fBottom));
+        rootctx->clear(0xffffffff);
+        rootCanvas->restore();
+        rootctx->flush();
+
+        /*
+            Compose canvas eachother on the main framebuffer
+        */
+        m_RootHandler->getContext()->flush();
+        m_RootHandler->getContext()->resetGLContext();
+        /* We draw on the UI fbo */
+        glBindFramebuffer(GL_FRAMEBUFFER, m_UI->getFBO());
+
+        for (auto &com : compList) {
+            Rect clip = damage;
+
+            if (com.occluded) {
+                continue;
+            }
+
+            if (!clip.intersect(com.bounds.m_fLeft, com.bounds.m_fTop,
+                                com.bounds.m_fRight, com.bounds.m_fBottom)) {
+                continue;
+            }
+
+            m_Stats.composed++;
+            m_Stats.composedPixels += static_cast<uint64_t>(
+                (clip.m_fRight - clip.m_fLeft)
+                * (clip.m_fBottom - clip.m_fTop));
+
+            com.handler->m_Context->preComposeOn(rootctx, com.left, com.top,
+                                                 com.opacity, com.zoom, &clip);
+        }
     }
 
     this->triggerEvents();
@@ -446,6 +506,8 @@ void Context::frame(bool draw)
     /* Skia context is dirty after a call to layerize */
     (static_cast<Canvas2DContext *>(m_RootHandler->getContext()))->getSkiaContext()->resetGrBackendContext();
 
+    m_ContextCache.collect(getCurrentFrame());
+
     m_Stats.repaint = 0;
     m_Stats.resize  = 0;
 }
@@ -25,6 +25,7 @@
 #include "Frontend/InputHandler.h"
 
 #include "Graphics/SurfaceCache.h"
+#include "Graphics/DamageTracker.h"
 
 #include <Yoga.h>
 
@@ -186,6 +187,26 @@ public:
         return m_Stats.nframe;
     }
 
+    /*
+        Number of (logical) pixels composited on the root surface
+        during the last frame
+    */
+    uint64_t getComposedPixels() const {
+        return m_Stats.composedPixels;
+    }
+
+    int getComposedLayers() const {
+        return m_Stats.composed;
+    }
+
+    /*
+        Number of layers skipped during the last frame because they were
+        hidden by opaque layers
+    */
+    int getCulledLayers() const {
+        return m_Stats.culled;
+    }
+
     void log(const char *str) override;
     void logClear() override;
     void logShow() override;
@@ -210,6 +231,7 @@ private:
     ShShaderOutput m_ShShaderOutput;
     Binding::JSWindow *m_JSWindow;
     bool m_SizeDirty;
+    Graphics::DamageTracker m_Damage;
 
     struct
     {
@@ -227,6 +249,8 @@ private:
         int repaint = 0;
         int resize = 0;
         int composed = 0;
+        int culled = 0;
+        uint64_t composedPixels = 0;
     } m_Stats;
 
     void statsIncRepaint() {
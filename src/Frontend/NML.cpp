@@ -44,6 +44,8 @@ NML::NML(ape_global *net)
       m_LoadedArg(NULL), m_JSObjectLST(NULL),
       m_DefaultItemsLoaded(false)
 {
+    this->setStatsName("NML");
+
     m_Meta.title       = NULL;
     m_Meta.size.width  = 0;
     m_Meta.size.height = 0;
@@ -148,6 +148,15 @@ public:
 
     virtual void markFrame(uint64_t frame) {}
 
+    /*
+        Returns a value that changes whenever the content is modified.
+        0 means the content can't be tracked and must always be recomposited
+    */
+    virtual uint32_t getContentGeneration()
+    {
+        return 0;
+    }
+
     /*
         Create a grid of |resolution^2| points using triangle strip
 
@@ -24,6 +24,9 @@ using Nidium::Graphics::CanvasHandler;
 using Nidium::Binding::Canvas2DContext;
 using Nidium::Interface::UIInterface;
 
+/* Maximum number of opaque layers tested by the occlusion culling pass */
+#define CANVAS_MAX_OCCLUDERS 16
+
 namespace Nidium {
 namespace Graphics {
 
@@ -587,7 +590,9 @@ void CanvasHandler::layerize(LayerizeContext &layerContext,
                 .opacity  = popacity,
                 .zoom     = m_Zoom,
                 .needClip = (m_CoordPosition != COORD_ABSOLUTE && layerContext.m_Clip),
-                .clip     = layerContext.m_Clip ? *layerContext.m_Clip : Rect()
+                .clip     = layerContext.m_Clip ? *layerContext.m_Clip : Rect(),
+                .bounds   = Rect(),
+                .occluded = false
             };
 
             m_Context->markFrame(frame);
@@ -610,6 +615,29 @@ void CanvasHandler::layerize(LayerizeContext &layerContext,
                 return;
             }
 
+            Rect &bounds = compctx.bounds;
+
+            bounds.m_fLeft   = compctx.left;
+            bounds.m_fTop    = compctx.top;
+            bounds.m_fRight  = compctx.left + p_Width.getCachedValue()
+                              + p_Coating * 2;
+            bounds.m_fBottom = compctx.top + p_Height.getCachedValue()
+                               + p_Coating * 2;
+
+            if (compctx.needClip
+                && !bounds.intersect(compctx.clip.m_fLeft, compctx.clip.m_fTop,
+                                     compctx.clip.m_fRight,
+                                     compctx.clip.m_fBottom)) {
+                bounds.m_fRight  = bounds.m_fLeft;
+                bounds.m_fBottom = bounds.m_fTop;
+            }
+
+            if (layerContext.m_Damage) {
+                layerContext.m_Damage->track(
+                    this->getIdentifier(), bounds, popacity,
+                    m_Context->getContentGeneration());
+            }
+
             compList.push_back(std::move(compctx));
 
             assert(m_Context != nullptr);
@@ -646,17 +674,11 @@ void CanvasHandler::layerize(LayerizeContext &layerContext,
         if (layerContext.m_Clip != NULL) {
             memcpy(&tmpClip, layerContext.m_Clip, sizeof(Rect));
         }
-/* Occlusion culling */
-#if 0
-        CanvasHandler **culling = static_cast<CanvasHandler **>(malloc(
-                                        sizeof(CanvasHandler *)
-                                        * m_nChildren));
-
-        Rect culRect;
-        for (cur = last; cur != NULL; cur = cur->prev) {
 
-        }
-#endif
+        /*
+            Occlusion culling needs the complete composition list,
+            see CullOccluded()
+        */
         for (cur = m_Children; cur != NULL; cur = cur->m_Next) {
             int offsetLeft = 0, offsetTop = 0;
             if (cur->m_CoordPosition != COORD_FIXED) {
@@ -670,7 +692,8 @@ void CanvasHandler::layerize(LayerizeContext &layerContext,
                    .m_pTop       = tmpTop  + layerContext.m_pTop  + offsetTop,
                    .m_aOpacity   = popacity,
                    .m_aZoom      = m_Zoom,
-                   .m_Clip       = layerContext.m_Clip};
+                   .m_Clip       = layerContext.m_Clip,
+                   .m_Damage     = layerContext.m_Damage};
 
             cur->layerize(ctx, compList, draw, frame);
 
@@ -721,6 +744,62 @@ void CanvasHandler::layerize(LayerizeContext &layerContext,
     }
 }
 
+int CanvasHandler::CullOccluded(std::vector<ComposeContext> &compList,
+                                const Rect &area)
+{
+    Rect occluders[CANVAS_MAX_OCCLUDERS];
+    int nOccluders = 0;
+    int culled     = 0;
+
+    /*
+        Walk the composition list from the top-most layer. Each layer
+        is tested against the opaque layers found above it.
+    */
+    for (int i = compList.size() - 1; i >= 0; i--) {
+        ComposeContext &com = compList[i];
+        Rect visible        = com.bounds;
+
+        if (!visible.intersect(area.m_fLeft, area.m_fTop, area.m_fRight,
+                               area.m_fBottom)) {
+            continue;
+        }
+
+        for (int j = 0; j < nOccluders; j++) {
+            if (occluders[j].contains(visible)) {
+                com.occluded = true;
+                break;
+            }
+        }
+
+        if (com.occluded) {
+            culled++;
+            continue;
+        }
+
+        /*
+            Only fully opaque layers (with their inherited opacity) occlude.
+            The coating area is not part of the opaque content.
+        */
+        if (nOccluders == CANVAS_MAX_OCCLUDERS || com.opacity < 1.0
+            || !com.handler->isOpaque()) {
+            continue;
+        }
+
+        CanvasHandler *handler = com.handler;
+        float coating          = handler->p_Coating;
+
+        if (visible.intersect(com.left + coating, com.top + coating,
+                              com.left + coating
+                                  + handler->p_Width.getCachedValue(),
+                              com.top + coating
+                                  + handler->p_Height.getCachedValue())) {
+            occluders[nOccluders++] = visible;
+        }
+    }
+
+    return culled;
+}
+
 // {{{ Getters
 int CanvasHandler::getContentWidth()
 {
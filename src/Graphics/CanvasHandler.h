@@ -16,6 +16,7 @@
 #include "Core/Events.h"
 #include "Frontend/InputHandler.h"
 #include "Graphics/Geometry.h"
+#include "Graphics/DamageTracker.h"
 
 #include <Yoga.h>
 #include <YGStringEnums.h>
@@ -55,6 +56,10 @@ struct ComposeContext
     double zoom;
     bool   needClip;
     Rect   clip;
+    /* Visible area on the root surface (clip applied) */
+    Rect   bounds;
+    /* Fully covered by opaque layers above it */
+    bool   occluded;
 };
 
 struct LayerizeContext
@@ -65,6 +70,7 @@ struct LayerizeContext
     double m_aOpacity;
     double m_aZoom;
     Rect *m_Clip;
+    DamageTracker *m_Damage;
 
     void reset()
     {
@@ -74,6 +80,7 @@ struct LayerizeContext
         m_aOpacity   = 1.0;
         m_aZoom      = 1.0;
         m_Clip       = NULL;
+        m_Damage     = NULL;
     }
 };
 
@@ -591,6 +598,20 @@ public:
         m_NeedPaint = true;
     }
 
+    /*
+        An opaque canvas promises to cover its whole area with opaque
+        pixels. Layers below it can be skipped during composition.
+    */
+    void setOpaque(bool opaque)
+    {
+        m_Opaque = opaque;
+    }
+
+    bool isOpaque() const
+    {
+        return m_Opaque;
+    }
+
     CanvasHandler *getParent() const
     {
         return m_Parent;
@@ -622,6 +643,14 @@ public:
     void layerize(LayerizeContext &layerContext,
         std::vector<ComposeContext> &compList, bool draw, uint64_t frame);
 
+    /*
+        Mark the layers of |compList| that are hidden by opaque layers
+        composed after them, within |area|.
+        Returns the number of occluded layers.
+    */
+    static int CullOccluded(std::vector<ComposeContext> &compList,
+                            const Rect &area);
+
     CanvasHandler *m_Parent;
     CanvasHandler *m_Children;
 
@@ -688,6 +717,7 @@ private:
     bool m_Loaded;
     int m_Cursor;
     bool m_NeedPaint = true;
+    bool m_Opaque = false;
 
 
     /* Reference to the Yoga node */
@@ -22,8 +22,8 @@ std::shared_ptr<CanvasSurface> CanvasSurface::Create(int width,
     /* Check for reusable surface */
     auto cached = nctx->m_ContextCache.getCachedSurface(width, height);
     if (cached) {
-        cached.get()->reset();
-        //printf("[Cached] Returned a cached surface %dx%d %p\n", width, height, cached.get());
+        cached->reset(width, height);
+
         return cached;
     }
 
@@ -49,10 +49,6 @@ bool CanvasSurface::resize(int width, int height)
         return false;
     }
 
-    //printf("Resize surface from %dx%d to %dx%d\n", m_Width, m_Height, width, height);
-
-    // TODO: replace surface in cache
-
     replaceSurface(newSurface, width, height);
 
     return true;
@@ -61,6 +57,9 @@ bool CanvasSurface::resize(int width, int height)
 void CanvasSurface::replaceSurface(sk_sp<SkSurface> newSurface, int width,
     int height, bool addToCache) {
 
+    int oldWidth  = this->backingWidth();
+    int oldHeight = this->backingHeight();
+
     m_Width  = width;
     m_Height = height;
 
@@ -74,6 +73,9 @@ void CanvasSurface::replaceSurface(sk_sp<SkSurface> newSurface, int width,
 
     m_SkiaSurface = newSurface;
 
+    Frontend::Context::GetObject<Frontend::Context>()
+        ->m_ContextCache.updateSize(this, oldWidth, oldHeight);
+
     if (addToCache) {
         Frontend::Context *nctx = Frontend::Context::GetObject<Frontend::Context>();
 #if 0
@@ -82,14 +84,10 @@ void CanvasSurface::replaceSurface(sk_sp<SkSurface> newSurface, int width,
     }
 }
 
-bool CanvasSurface::canBeClaimed(int width, int height)
+bool CanvasSurface::canBeClaimed()
 {
-    if (m_Width == width && m_Height == height) {
-        Frontend::Context *nctx = Frontend::Context::GetObject<Frontend::Context>();
-        return m_LastMarkedFrame > 0 && (m_LastMarkedFrame + CANVAS_FRAME_THRESHOLD) < nctx->getCurrentFrame();
-    }
-
-    return false;
+    Frontend::Context *nctx = Frontend::Context::GetObject<Frontend::Context>();
+    return m_LastMarkedFrame > 0 && (m_LastMarkedFrame + CANVAS_FRAME_THRESHOLD) < nctx->getCurrentFrame();
 }
 
 void CanvasSurface::touch()
@@ -98,7 +96,7 @@ void CanvasSurface::touch()
     m_LastMarkedFrame = nctx->getCurrentFrame();
 }
 
-void CanvasSurface::reset()
+void CanvasSurface::reset(int width, int height)
 {
     if (!m_SkiaSurface) {
         return;
@@ -107,9 +105,22 @@ void CanvasSurface::reset()
     SkCanvas *canvas = m_SkiaSurface.get()->getCanvas();
 
     canvas->flush();
+    /* Also drops the clip of the previous canvas (if any) */
+    canvas->restoreToCount(1);
     canvas->resetMatrix();
-    canvas->restoreToCount(canvas->getSaveCount());
     canvas->clear(0x00000000);
+
+    m_Width  = width;
+    m_Height = height;
+
+    /*
+        Keep the drawing inside the canvas. The clip lives in its own save
+        level, restore() from the canvas never pops it (see SkiaContext)
+    */
+    if (width != this->backingWidth() || height != this->backingHeight()) {
+        canvas->save();
+        canvas->clipRect(SkRect::MakeWH(width, height));
+    }
 }
 
 CanvasSurface *CanvasSurface::reclaim()
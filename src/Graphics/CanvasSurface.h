@@ -16,7 +16,9 @@ namespace Graphics {
 class SkiaContext;
 
 /*
-    All size are expressed in device pixel
+    All size are expressed in device pixel.
+    A surface taken from the cache can be slightly larger than the canvas
+    using it, drawing is then clipped to the canvas size.
 */
 class CanvasSurface
 {
@@ -39,11 +41,14 @@ public:
     void replaceSurface(sk_sp<SkSurface> newSurface, int width,
         int height, bool addToCache = false);
 
-    /* Reset the state of the underlying SkCanvas object */
-    void reset();
+    /*
+        Reset the state of the underlying SkCanvas object
+        for a canvas of |width|x|height|
+    */
+    void reset(int width, int height);
 
-    /* Check whether this surface can be reused */
-    bool canBeClaimed(int width, int height);
+    /* Check whether this surface can be reused by another canvas */
+    bool canBeClaimed();
 
     sk_sp<SkSurface> getSkiaSurface() {
         return m_SkiaSurface;
@@ -57,6 +62,15 @@ public:
         return m_Height;
     }
 
+    /* Size of the underlying SkSurface */
+    int backingWidth() const {
+        return m_SkiaSurface->width();
+    }
+
+    int backingHeight() const {
+        return m_SkiaSurface->height();
+    }
+
     void mark(uint64_t frame) {
         m_LastMarkedFrame = frame;
     }
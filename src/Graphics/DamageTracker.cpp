@@ -0,0 +1,108 @@
+/*
+   Copyright 2016 Nidium Inc. All rights reserved.
+   Use of this source code is governed by a MIT license
+   that can be found in the LICENSE file.
+*/
+#include "Graphics/DamageTracker.h"
+
+#include "Core/Utils.h"
+
+namespace Nidium {
+namespace Graphics {
+
+static bool DamageTracker_sameRect(const Rect &a, const Rect &b)
+{
+    return a.m_fLeft == b.m_fLeft && a.m_fTop == b.m_fTop
+           && a.m_fRight == b.m_fRight && a.m_fBottom == b.m_fBottom;
+}
+
+// {{{ DamageTracker
+void DamageTracker::begin(uint64_t frame, const Rect &root)
+{
+    if (!DamageTracker_sameRect(root, m_Root)) {
+        m_Full = true;
+    }
+
+    m_Frame    = frame;
+    m_Previous = 0;
+    m_Root     = root;
+
+    if (m_Full) {
+        m_Damage = m_Root;
+        m_Full   = false;
+    } else {
+        m_Damage.m_fLeft = m_Damage.m_fTop = m_Damage.m_fRight
+            = m_Damage.m_fBottom = 0;
+    }
+}
+
+void DamageTracker::add(const Rect &rect)
+{
+    Rect r = rect;
+
+    if (!r.intersect(m_Root.m_fLeft, m_Root.m_fTop, m_Root.m_fRight,
+                     m_Root.m_fBottom)) {
+        return;
+    }
+
+    if (m_Damage.isEmpty()) {
+        m_Damage = r;
+        return;
+    }
+
+    m_Damage.m_fLeft   = nidium_min(m_Damage.m_fLeft, r.m_fLeft);
+    m_Damage.m_fTop    = nidium_min(m_Damage.m_fTop, r.m_fTop);
+    m_Damage.m_fRight  = nidium_max(m_Damage.m_fRight, r.m_fRight);
+    m_Damage.m_fBottom = nidium_max(m_Damage.m_fBottom, r.m_fBottom);
+}
+
+void DamageTracker::track(uint64_t id,
+                          const Rect &bounds,
+                          double opacity,
+                          uint32_t generation)
+{
+    auto it = m_Layers.find(id);
+
+    if (it == m_Layers.end()) {
+        /* New layer */
+        this->add(bounds);
+        it = m_Layers.insert({ id, Layer() }).first;
+    } else {
+        Layer &layer = it->second;
+
+        if (!DamageTracker_sameRect(layer.m_Bounds, bounds)
+            || layer.m_Opacity != opacity || layer.m_Previous != m_Previous) {
+            /* Moved, resized, faded or reordered */
+            this->add(layer.m_Bounds);
+            this->add(bounds);
+        } else if (generation == 0 || generation != layer.m_Generation) {
+            /* Content changed */
+            this->add(bounds);
+        }
+    }
+
+    Layer &layer       = it->second;
+    layer.m_Bounds     = bounds;
+    layer.m_Opacity    = opacity;
+    layer.m_Generation = generation;
+    layer.m_Previous   = m_Previous;
+    layer.m_Frame      = m_Frame;
+
+    m_Previous = id;
+}
+
+void DamageTracker::end()
+{
+    for (auto it = m_Layers.begin(); it != m_Layers.end();) {
+        if (it->second.m_Frame != m_Frame) {
+            this->add(it->second.m_Bounds);
+            it = m_Layers.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+// }}}
+
+} // namespace Graphics
+} // namespace Nidium
@@ -0,0 +1,111 @@
+/*
+   Copyright 2016 Nidium Inc. All rights reserved.
+   Use of this source code is governed by a MIT license
+   that can be found in the LICENSE file.
+*/
+#ifndef graphics_damagetracker_h__
+#define graphics_damagetracker_h__
+
+#include <stdint.h>
+#include <unordered_map>
+
+#include "Graphics/Geometry.h"
+
+namespace Nidium {
+namespace Graphics {
+
+// {{{ DamageTracker
+/*
+    Keep track of the area of the root surface that needs to be
+    recomposited.
+
+    Each frame, every composed layer is reported with its visible bounds,
+    opacity and content generation. Comparing this with what was composed
+    during the previous frame gives the damaged area :
+     - A layer whose content changed damages its bounds
+     - A layer that moved, was resized, clipped differently, changed its
+       opacity or its position in the composition order damages both its
+       old and new bounds
+     - A layer that is no longer composed (hidden, removed, out of view)
+       damages its old bounds
+
+    The damage is kept as a single bounding rectangle.
+*/
+class DamageTracker
+{
+public:
+    DamageTracker() : m_Frame(0), m_Previous(0), m_Full(true)
+    {
+        m_Root.m_fLeft = m_Root.m_fTop = m_Root.m_fRight = m_Root.m_fBottom
+            = 0;
+        m_Damage = m_Root;
+    }
+
+    /*
+        Start a new frame. Everything is damaged if the root surface
+        geometry changed
+    */
+    void begin(uint64_t frame, const Rect &root);
+
+    /*
+        Report a layer composed during the current frame.
+        A |generation| of 0 means the content can't be tracked and the
+        layer is always damaged.
+    */
+    void track(uint64_t id,
+               const Rect &bounds,
+               double opacity,
+               uint32_t generation);
+
+    /*
+        Collect the layers that were not reported during this frame
+    */
+    void end();
+
+    /*
+        Force the next frame to be fully recomposited
+    */
+    void invalidate()
+    {
+        m_Full = true;
+    }
+
+    bool isEmpty() const
+    {
+        return m_Damage.isEmpty();
+    }
+
+    /*
+        Damaged area of the root surface for the current frame
+    */
+    const Rect &getDamage() const
+    {
+        return m_Damage;
+    }
+
+private:
+    struct Layer
+    {
+        Rect m_Bounds;
+        double m_Opacity;
+        uint32_t m_Generation;
+        uint64_t m_Previous;
+        uint64_t m_Frame;
+    };
+
+    void add(const Rect &rect);
+
+    std::unordered_map<uint64_t, Layer> m_Layers;
+
+    Rect m_Root;
+    Rect m_Damage;
+    uint64_t m_Frame;
+    uint64_t m_Previous;
+    bool m_Full;
+};
+// }}}
+
+} // namespace Graphics
+} // namespace Nidium
+
+#endif
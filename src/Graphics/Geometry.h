@@ -48,6 +48,12 @@ struct Rect
 
         return r;
     }
+    bool contains(const Rect &r) const
+    {
+        return !this->isEmpty() && m_fLeft <= r.m_fLeft && m_fTop <= r.m_fTop
+               && r.m_fRight <= m_fRight && r.m_fBottom <= m_fBottom;
+    }
+
     bool contains(double x, double y) const
     {
         return !this->isEmpty() && m_fLeft <= x && x < m_fRight && m_fTop <= y
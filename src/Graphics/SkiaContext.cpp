@@ -401,14 +401,17 @@ SkiaContext *SkiaContext::CreateWithFBOBackend(Frontend::Context *fctx,
 {
     float ratio = Interface::SystemInterface::GetInstance()->backingStorePixelRatio();
 
-    sk_sp<SkSurface> surface = CreateGLSurface(ceilf(width * ratio), ceilf(height * ratio), fctx, fbo);
+    int rwidth  = ceilf(width * ratio);
+    int rheight = ceilf(height * ratio);
+
+    sk_sp<SkSurface> surface = CreateGLSurface(rwidth, rheight, fctx, fbo);
 
     if (!surface) {
         ndm_log(NDM_LOG_ERROR, "SkiaContext", "Can't create surface");
         return nullptr;
     }
 
-    std::shared_ptr<CanvasSurface> cs = CanvasSurface::Wrap(width, height, surface);
+    std::shared_ptr<CanvasSurface> cs = CanvasSurface::Wrap(rwidth, rheight, surface);
 
     SkiaContext *skcontext = new SkiaContext(cs);
 
@@ -507,7 +510,7 @@ bool SkiaContext::setSize(float width, float height, bool redraw)
 
     if (this->m_CanvasBindMode == BIND_GL) {
         newSurface = CreateGLSurface(rwidth, rheight, nullptr);
-        m_CSurface.get()->replaceSurface(newSurface, width, height);
+        m_CSurface.get()->replaceSurface(newSurface, rwidth, rheight);
 
     } else {
         m_CSurface.get()->resize(rwidth,  rheight);
@@ -951,11 +954,11 @@ void SkiaContext::restore()
         delete m_State;
 
         m_State = dstate;
+
+        getCanvas()->restore();
     } else {
         ndm_logf(NDM_LOG_ERROR, "SkiaContext", "restore() without matching save()");
     }
-
-    getCanvas()->restore();
 }
 
 void SkiaContext::skew(double x, double y)
@@ -1122,12 +1125,13 @@ void SkiaContext::GetStringColor(uint32_t color, char *out)
 
 int SkiaContext::getWidth()
 {
-    return getCanvas()->getBaseLayerSize().fWidth;
+    /* The surface may be larger than the canvas */
+    return m_CSurface.get()->width();
 }
 
 int SkiaContext::getHeight()
 {
-    return getCanvas()->getBaseLayerSize().fHeight;
+    return m_CSurface.get()->height();
 }
 
 uint32_t SkiaContext::getFillColor() const
@@ -141,6 +141,18 @@ public:
         return m_CSurface.get()->getSkiaSurface();
     }
 
+    /*
+        Changes every time something is drawn on the surface
+    */
+    uint32_t getGeneration()
+    {
+        if (!m_CSurface) {
+            return 0;
+        }
+
+        return m_CSurface.get()->getSkiaSurface()->generationID();
+    }
+
     void mark(uint64_t frame)
     {
         if (m_CSurface) {
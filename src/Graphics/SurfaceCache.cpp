@@ -4,9 +4,15 @@
    that can be found in the LICENSE file.
 */
 #include "Graphics/SurfaceCache.h"
+
+#include <algorithm>
+
 #include "Graphics/CanvasSurface.h"
 #include "Binding/JSCanvas2DContext.h"
 
+/* Unused surfaces are only checked for age every N frames */
+#define SURFACE_CACHE_COLLECT_INTERVAL 60
+
 namespace Nidium {
 namespace Graphics {
 
@@ -16,24 +22,159 @@ void SurfaceCache::addToCache(int width, int height, std::shared_ptr<CanvasSurfa
 
     store.push_back(cs);
 
-    m_Counter++;
-
-    //printf("[%dx%d] Element added to cache %ld (total %d)\n", width, height, store.size(), m_Counter);
+    m_Stats.bytes += GetBytes(width, height);
+    m_Stats.count++;
 }
 
 std::shared_ptr<CanvasSurface> SurfaceCache::getCachedSurface(int width, int height)
 {
-    auto &store = m_Store[std::make_pair(width, height)];
+    int maxWidth  = width + width / NIDIUM_SURFACE_CACHE_SLACK;
+    int maxHeight = height + height / NIDIUM_SURFACE_CACHE_SLACK;
+
+    /*
+        Size classes are ordered by width then height,
+        the exact size (if any) is checked first.
+    */
+    for (auto it = m_Store.lower_bound(std::make_pair(width, height));
+         it != m_Store.end() && it->first.first <= maxWidth; ++it) {
+
+        int cheight = it->first.second;
 
-    for (auto &surface : store) {
-        CanvasSurface *cs = surface.get();
-        if (cs->canBeClaimed(width, height)) {
-            cs->reclaim();
-            return surface;
+        if (cheight < height || cheight > maxHeight) {
+            continue;
+        }
+
+        for (auto &surface : it->second) {
+            CanvasSurface *cs = surface.get();
+
+            /* Not used by any canvas anymore or not composed lately */
+            if (surface.use_count() == 1 || cs->canBeClaimed()) {
+                cs->reclaim();
+                m_Stats.hits++;
+
+                return surface;
+            }
         }
     }
 
+    m_Stats.misses++;
+
     return nullptr;
 }
 
+void SurfaceCache::updateSize(CanvasSurface *cs, int oldWidth, int oldHeight)
+{
+    if (cs->backingWidth() == oldWidth && cs->backingHeight() == oldHeight) {
+        return;
+    }
+
+    auto it = m_Store.find(std::make_pair(oldWidth, oldHeight));
+    if (it == m_Store.end()) {
+        return;
+    }
+
+    SurfaceList &list = it->second;
+
+    for (size_t i = 0; i < list.size(); i++) {
+        if (list[i].get() != cs) {
+            continue;
+        }
+
+        std::shared_ptr<CanvasSurface> surface = list[i];
+        list.erase(list.begin() + i);
+
+        if (list.empty()) {
+            m_Store.erase(it);
+        }
+
+        m_Stats.bytes -= GetBytes(oldWidth, oldHeight);
+        m_Stats.count--;
+
+        this->addToCache(cs->backingWidth(), cs->backingHeight(), surface);
+
+        return;
+    }
+}
+
+uint64_t SurfaceCache::GetBytes(const CanvasSurface *cs)
+{
+    return GetBytes(cs->backingWidth(), cs->backingHeight());
+}
+
+void SurfaceCache::collect(uint64_t frame)
+{
+    bool checkAge = (frame % SURFACE_CACHE_COLLECT_INTERVAL == 0);
+
+    if (!checkAge && m_Stats.bytes <= m_Budget) {
+        return;
+    }
+
+    /*
+        The mark of an unused surface doesn't change anymore :
+        sorted by mark, they are in LRU order.
+    */
+    std::vector<CanvasSurface *> lru;
+
+    for (auto &it : m_Store) {
+        for (auto &surface : it.second) {
+            if (surface.use_count() == 1) {
+                lru.push_back(surface.get());
+            }
+        }
+    }
+
+    std::sort(lru.begin(), lru.end(),
+              [](CanvasSurface *a, CanvasSurface *b) {
+                  return a->getMark() < b->getMark();
+              });
+
+    /*
+        Too old or over budget : evict from the least recently used.
+        Both conditions hold for a prefix of the list.
+    */
+    uint64_t bytes = m_Stats.bytes;
+    size_t count   = 0;
+
+    for (CanvasSurface *cs : lru) {
+        bool tooOld = checkAge
+                      && cs->getMark() + NIDIUM_SURFACE_CACHE_MAX_AGE < frame;
+
+        if (!tooOld && bytes <= m_Budget) {
+            break;
+        }
+
+        bytes -= GetBytes(cs);
+        count++;
+    }
+
+    if (count == 0) {
+        return;
+    }
+
+    lru.resize(count);
+    std::sort(lru.begin(), lru.end());
+
+    for (auto it = m_Store.begin(); it != m_Store.end();) {
+        SurfaceList &list = it->second;
+
+        list.erase(std::remove_if(list.begin(), list.end(),
+                                  [&lru](const std::shared_ptr<CanvasSurface> &s) {
+                                      return std::binary_search(
+                                          lru.begin(), lru.end(), s.get());
+                                  }),
+                   list.end());
+
+        if (list.empty()) {
+            it = m_Store.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    m_Stats.evicted += count;
+    m_Stats.evictedBytes += m_Stats.bytes - bytes;
+    m_Stats.bytes = bytes;
+    m_Stats.count -= count;
+}
+
 }}
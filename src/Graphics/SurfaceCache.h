@@ -6,34 +6,106 @@
 #ifndef graphics_contextcache_h__
 #define graphics_contextcache_h__
 
+#include <stdint.h>
+#include <stddef.h>
 #include <memory>
 #include <map>
 #include <utility>
 #include <vector>
 
+/* Memory used by the cached surfaces before unused ones are evicted */
+#define NIDIUM_SURFACE_CACHE_BUDGET (128 * 1024 * 1024)
 
+/* Number of frames after which an unused surface is evicted */
+#define NIDIUM_SURFACE_CACHE_MAX_AGE 600
+
+/*
+    A surface can be reused for a smaller canvas if it's at most
+    1/NIDIUM_SURFACE_CACHE_SLACK larger in each dimension
+*/
+#define NIDIUM_SURFACE_CACHE_SLACK 8
 
 namespace Nidium {
 namespace Graphics {
 
 class CanvasSurface;
 
+/*
+    Keep track of every CanvasSurface created.
+
+    Surfaces are stored by the size of their backing SkSurface. A surface
+    that wasn't composed during the last frames can be claimed by a new
+    canvas of the same size (or slightly smaller, the drawing is then
+    clipped to the canvas size). Surfaces no longer used by any canvas are
+    kept around for reuse and evicted, least recently used first, once they
+    get too old or once the memory budget is exceeded.
+*/
 class SurfaceCache
 {
 public:
-    SurfaceCache(){};
+    struct Stats
+    {
+        uint64_t hits;
+        uint64_t misses;
+        uint64_t evicted;
+        uint64_t evictedBytes;
+        /* Memory used by all the surfaces in the cache */
+        uint64_t bytes;
+        uint32_t count;
+    };
+
+    SurfaceCache() : m_Budget(NIDIUM_SURFACE_CACHE_BUDGET)
+    {
+        m_Stats = {};
+    };
     ~SurfaceCache(){};
 
-    void emptyCache() {
-        m_Store.empty();
+    void emptyCache()
+    {
+        m_Store.clear();
+        m_Stats.bytes = 0;
+        m_Stats.count = 0;
     }
 
     void addToCache(int width, int height, std::shared_ptr<CanvasSurface> cs);
     std::shared_ptr<CanvasSurface> getCachedSurface(int width, int height);
 
+    /*
+        Move a surface whose backing surface was replaced
+        to its new size class
+    */
+    void updateSize(CanvasSurface *cs, int oldWidth, int oldHeight);
+
+    /*
+        Evict unused surfaces that are too old or exceed the budget.
+        Called once per frame.
+    */
+    void collect(uint64_t frame);
+
+    void setBudget(uint64_t bytes)
+    {
+        m_Budget = bytes;
+    }
+
+    const Stats &getStats() const
+    {
+        return m_Stats;
+    }
+
 private:
-    std::map< std::pair<int /* width */, int /* height */>, std::vector< std::shared_ptr<CanvasSurface> > > m_Store;
-    uint32_t m_Counter = 0;
+    typedef std::pair<int /* width */, int /* height */> SizeClass;
+    typedef std::vector<std::shared_ptr<CanvasSurface>> SurfaceList;
+
+    static uint64_t GetBytes(int width, int height)
+    {
+        return static_cast<uint64_t>(width) * height * 4;
+    }
+
+    static uint64_t GetBytes(const CanvasSurface *cs);
+
+    std::map<SizeClass, SurfaceList> m_Store;
+    uint64_t m_Budget;
+    Stats m_Stats;
 };
 
 }}
@@ -58,6 +58,8 @@ File::File(const char *name)
     : m_Dir(NULL), m_Fd(NULL), m_Delegate(NULL), m_Filesize(0),
       m_AutoClose(true), m_Eof(false), m_OpenSync(false), m_isDir(false)
 {
+    this->setStatsName("File");
+
     m_Mmap.addr = NULL;
     m_Mmap.size = 0;
     m_Path      = strdup(name);
@@ -136,7 +138,8 @@ void File::rmrf()
 
 File::~File()
 {
-    Core::PthreadAutoLock tasksLock(&getManagedLock());
+    /* Tasks use the file descriptor and the mapping */
+    this->stopTasks();
 
     if (m_Mmap.addr) {
         munmap(m_Mmap.addr, m_Mmap.size);
@@ -19,6 +19,8 @@ namespace IO {
 FileStream::FileStream(const char *location)
     : Stream(location), m_File(location)
 {
+    this->setStatsName("FileStream");
+
     /* We don't want the file to close when end of file is reached */
     m_File.setAutoClose(false);
     m_File.setListener(this);
@@ -9,6 +9,12 @@
 #include <stdlib.h>
 #include <stdbool.h>
 #include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <algorithm>
 
 #include "Core/Path.h"
 
@@ -18,19 +24,22 @@ using Nidium::Core::Path;
 namespace Nidium {
 namespace IO {
 
-NFS::NFS(uint8_t *content, size_t size) : m_ContentPtr(0)
+NFS::NFS(uint8_t *content, size_t size)
+    : m_ContentPtr(0), m_Mapped(false), m_Index(NULL), m_IndexCount(0)
 {
     m_Content = content;
     m_Size    = size;
 
+    memset(&m_Header, 0, sizeof(struct nfs_header_s));
+
     this->initRoot();
 
-    if (!validateArchive()) {
-        return;
-    }
+    m_Valid = this->validateArchive();
 }
 
-NFS::NFS() : m_Content(NULL), m_ContentPtr(0), m_Size(0)
+NFS::NFS()
+    : m_Content(NULL), m_ContentPtr(0), m_Size(0), m_Mapped(false),
+      m_Valid(true), m_Index(NULL), m_IndexCount(0)
 {
     this->initRoot();
 
@@ -53,15 +62,39 @@ void NFS::initRoot()
     m_Hash.set(m_Root.filename_utf8, &m_Root);
 }
 
-#if 0
-struct nfs_file_header_s {
-    uint64_t size; // describe the number of files in case it's a directory
-    uint32_t crc32;
-    uint16_t flags;
-    uint16_t filename_length;
-    /* filename utf8 */
-};
-#endif
+NFS *NFS::Open(const char *path)
+{
+    struct stat st;
+    int fd = open(path, O_RDONLY);
+
+    if (fd == -1) {
+        return NULL;
+    }
+
+    if (fstat(fd, &st) == -1 || st.st_size == 0) {
+        close(fd);
+        return NULL;
+    }
+
+    void *addr = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    close(fd);
+
+    if (addr == MAP_FAILED) {
+        return NULL;
+    }
+
+    NFS *nfs = new NFS(static_cast<uint8_t *>(addr), st.st_size);
+
+    nfs->m_Mapped = true;
+
+    if (!nfs->m_Valid) {
+        delete nfs;
+        return NULL;
+    }
+
+    return nfs;
+}
 
 bool NFS::validateArchive()
 {
@@ -75,13 +108,81 @@ bool NFS::validateArchive()
         return false;
     }
 
+    if (m_Header.minversion >= NIDIUM_NFS_VERSION_INDEX) {
+        return this->readIndex();
+    }
+
     this->readTree(&m_Root);
 
     return true;
 }
 
+bool NFS::readIndex()
+{
+    uint64_t indexSize = static_cast<uint64_t>(m_Header.numfiles)
+                         * sizeof(struct nfs_index_entry_s);
+
+    if (m_ContentPtr + indexSize > m_Size) {
+        return false;
+    }
+
+    /*
+        Nothing else is read, entries are checked when they are looked up
+    */
+    m_Index      = m_Content + m_ContentPtr;
+    m_IndexCount = m_Header.numfiles;
+
+    return true;
+}
+
+bool NFS::lookup(const char *path, struct nfs_index_entry_s *entry) const
+{
+    int64_t low  = 0;
+    int64_t high = static_cast<int64_t>(m_IndexCount) - 1;
+
+    while (low <= high) {
+        int64_t mid = (low + high) / 2;
+
+        /* The archive may not be aligned (e.g. embedded in the binary) */
+        memcpy(entry, m_Index + mid * sizeof(struct nfs_index_entry_s),
+               sizeof(struct nfs_index_entry_s));
+
+        /* The filename and its null terminator must fit in the archive */
+        uint64_t nameEnd = static_cast<uint64_t>(entry->filename_offset)
+                           + entry->filename_length;
+
+        if (nameEnd >= m_Size || m_Content[nameEnd] != '\0') {
+            return false;
+        }
+
+        int cmp = strcmp(
+            path, reinterpret_cast<const char *>(m_Content)
+                      + entry->filename_offset);
+
+        if (cmp == 0) {
+            /* Written this way so that offset + size can't overflow */
+            return (entry->flags & kNFSFileType_Dir)
+                   || (entry->offset <= m_Size
+                       && entry->size <= m_Size - entry->offset);
+        }
+
+        if (cmp < 0) {
+            high = mid - 1;
+        } else {
+            low = mid + 1;
+        }
+    }
+
+    return false;
+}
+
 bool NFS::mkdir(const char *name_utf8, size_t name_len)
 {
+    /* Indexed archives are read-only */
+    if (m_Index) {
+        return false;
+    }
+
     bool outsideRoot = false;
     PtrAutoDelete<char *> path(Path::Sanitize(name_utf8, &outsideRoot), free);
     if (!path.ptr()) {
@@ -143,6 +244,9 @@ bool NFS::writeFile(const char *name_utf8,
                     size_t len,
                     int flags)
 {
+    if (m_Index) {
+        return false;
+    }
 
     PtrAutoDelete<char *> path(Path::Sanitize(name_utf8), free);
     int path_len = strlen(path.ptr());
@@ -194,6 +298,12 @@ bool NFS::writeFile(const char *name_utf8,
 int NFS::exists(const char *filename)
 {
     PtrAutoDelete<char *> path(Path::Sanitize(filename), free);
+    struct nfs_index_entry_s entry;
+
+    if (m_Index && this->lookup(path.ptr(), &entry)) {
+        return (entry.flags & kNFSFileType_Dir) ? 2 : 1;
+    }
+
     NFSTree *file = m_Hash.get(path.ptr());
 
     if (file == NULL) {
@@ -206,6 +316,24 @@ int NFS::exists(const char *filename)
 const char *NFS::readFile(const char *filename, size_t *len, int *flags) const
 {
     PtrAutoDelete<char *> path(Path::Sanitize(filename), free);
+
+    if (m_Index) {
+        struct nfs_index_entry_s entry;
+
+        if (!this->lookup(path.ptr(), &entry)
+            || (entry.flags & kNFSFileType_Dir)) {
+            return NULL;
+        }
+
+        if (flags) {
+            *flags = entry.flags;
+        }
+
+        *len = entry.size;
+
+        return reinterpret_cast<const char *>(m_Content) + entry.offset;
+    }
+
     NFSTree *file = m_Hash.get(path.ptr());
     if (file == NULL || (file->header.flags & kNFSFileType_Dir)) {
         return NULL;
@@ -220,33 +348,136 @@ const char *NFS::readFile(const char *filename, size_t *len, int *flags) const
     return reinterpret_cast<const char *>(file->meta.content);
 }
 
-bool NFS::save(FILE *fd)
+bool NFS::save(FILE *fd, int version)
 {
     if (!fd) {
         return false;
     }
 
-    fwrite(&m_Header, sizeof(struct nfs_header_s), 1, fd);
+    if (version >= NIDIUM_NFS_VERSION_INDEX) {
+        return this->writeIndex(fd);
+    }
+
+    struct nfs_header_s header = m_Header;
+    header.minversion          = NIDIUM_NFS_VERSION_TREE;
+
+    fwrite(&header, sizeof(struct nfs_header_s), 1, fd);
 
     writeTree(fd, m_Root.meta.children);
 
     return true;
 }
 
-bool NFS::save(const char *dest)
+bool NFS::save(const char *dest, int version)
 {
     FILE *fd = fopen(dest, "w+");
     if (!fd) {
         return false;
     }
 
-    bool ret = this->save(fd);
+    bool ret = this->save(fd, version);
 
     fclose(fd);
 
     return ret;
 }
 
+void NFS::collectTree(NFSTree *cur, std::vector<NFSTree *> &list)
+{
+    for (; cur != NULL; cur = cur->next) {
+        list.push_back(cur);
+
+        if (cur->header.flags & kNFSFileType_Dir) {
+            this->collectTree(cur->meta.children, list);
+        }
+    }
+}
+
+/* File contents are 8 bytes aligned within the archive */
+#define NFS_ALIGN(pos) (((pos) + 7) & ~static_cast<uint64_t>(7))
+
+bool NFS::writeIndex(FILE *fd)
+{
+    static const char padding[8] = { 0 };
+    std::vector<NFSTree *> files;
+
+    this->collectTree(m_Root.meta.children, files);
+
+    std::sort(files.begin(), files.end(), [](NFSTree *a, NFSTree *b) {
+        return strcmp(a->filename_utf8, b->filename_utf8) < 0;
+    });
+
+    struct nfs_header_s header = m_Header;
+    header.minversion          = NIDIUM_NFS_VERSION_INDEX;
+    header.numfiles            = files.size();
+
+    uint64_t namesPos = sizeof(struct nfs_header_s)
+                        + files.size() * sizeof(struct nfs_index_entry_s);
+    uint64_t dataPos = namesPos;
+
+    for (NFSTree *file : files) {
+        dataPos += file->header.filename_length + 1;
+    }
+
+    dataPos = NFS_ALIGN(dataPos);
+
+    if (dataPos > UINT32_MAX) {
+        return false;
+    }
+
+    fwrite(&header, sizeof(struct nfs_header_s), 1, fd);
+
+    /* Index */
+    uint64_t namePos = namesPos;
+    uint64_t filePos = dataPos;
+
+    for (NFSTree *file : files) {
+        struct nfs_index_entry_s entry;
+        bool isDir = file->header.flags & kNFSFileType_Dir;
+
+        memset(&entry, 0, sizeof(entry));
+
+        entry.offset          = isDir ? 0 : filePos;
+        entry.size            = file->header.size;
+        entry.crc32           = file->header.crc32;
+        entry.flags           = file->header.flags;
+        entry.filename_offset = namePos;
+        entry.filename_length = file->header.filename_length;
+
+        fwrite(&entry, sizeof(entry), 1, fd);
+
+        namePos += file->header.filename_length + 1;
+        if (!isDir) {
+            filePos = NFS_ALIGN(filePos + file->header.size);
+        }
+    }
+
+    /* Filenames */
+    for (NFSTree *file : files) {
+        fwrite(file->filename_utf8, 1, file->header.filename_length + 1, fd);
+    }
+
+    fwrite(padding, 1, dataPos - namePos, fd);
+
+    /* Contents */
+    filePos = dataPos;
+
+    for (NFSTree *file : files) {
+        if (file->header.flags & kNFSFileType_Dir) {
+            continue;
+        }
+
+        uint64_t end = filePos + file->header.size;
+
+        fwrite(file->meta.content, 1, file->header.size, fd);
+        fwrite(padding, 1, NFS_ALIGN(end) - end, fd);
+
+        filePos = NFS_ALIGN(end);
+    }
+
+    return true;
+}
+
 void NFS::writeTree(FILE *fd, NFSTree *cur)
 {
     if (cur == NULL) {
@@ -273,6 +504,7 @@ void NFS::readTree(NFSTree *parent)
 
     NFSTree *item = new NFSTree;
 
+    item->meta.children   = NULL;
     item->next            = parent->meta.children;
     parent->meta.children = item;
 
@@ -320,7 +552,7 @@ void NFS::releaseTree(NFSTree *root)
     }
 
     free(root->filename_utf8);
-    free(root);
+    delete root;
 }
 
 NFS::~NFS()
@@ -328,6 +560,10 @@ NFS::~NFS()
     free(m_Root.filename_utf8);
 
     this->releaseTree(m_Root.meta.children);
+
+    if (m_Mapped) {
+        munmap(m_Content, m_Size);
+    }
 }
 
 } // namespace IO
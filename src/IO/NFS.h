@@ -10,6 +10,8 @@
 #include <stdint.h>
 #include <stdio.h>
 
+#include <vector>
+
 #include "Core/Hash.h"
 
 namespace Nidium {
@@ -17,7 +19,16 @@ namespace IO {
 
 #define NIDIUM_NFS_MAGIC 0x27121986
 
-const uint16_t _nfs_version = 100;
+/*
+    100 : Tree of (file header, filename, content) records
+    200 : Sorted index, followed by the filenames and the contents.
+          Lookups are done in place, an archive can be used straight
+          from memory (or a mapped file) without being parsed.
+*/
+#define NIDIUM_NFS_VERSION_TREE 100
+#define NIDIUM_NFS_VERSION_INDEX 200
+
+const uint16_t _nfs_version = NIDIUM_NFS_VERSION_INDEX;
 
 struct nfs_header_s
 {
@@ -37,6 +48,22 @@ struct nfs_file_header_s
     /* filename utf8 */
 };
 
+/*
+    Index entry (version 200+). Entries are sorted by filename (strcmp).
+    Offsets are relative to the beginning of the archive,
+    filenames are null terminated.
+*/
+struct nfs_index_entry_s
+{
+    uint64_t offset;
+    uint64_t size; // number of files in case it's a directory
+    uint32_t crc32;
+    uint32_t filename_offset;
+    uint16_t flags;
+    uint16_t filename_length;
+    uint32_t reserved;
+};
+
 typedef struct nfs_tree_s
 {
     struct nfs_file_header_s header;
@@ -68,8 +95,14 @@ public:
     NFS();
     ~NFS();
 
-    bool save(const char *dest);
-    bool save(FILE *fd);
+    /*
+        Map an archive file in memory.
+        Returns NULL if the file can't be mapped or isn't a valid archive.
+    */
+    static NFS *Open(const char *path);
+
+    bool save(const char *dest, int version = _nfs_version);
+    bool save(FILE *fd, int version = _nfs_version);
 
     bool mkdir(const char *name_utf8, size_t name_len);
     bool writeFile(const char *name_utf8,
@@ -92,6 +125,18 @@ private:
     uint8_t *m_Content;
     off_t m_ContentPtr;
     size_t m_Size;
+    bool m_Mapped;
+    bool m_Valid;
+
+    /* Version 200+ : index read in place */
+    const uint8_t *m_Index;
+    uint32_t m_IndexCount;
+
+    bool readIndex();
+    bool lookup(const char *path, struct nfs_index_entry_s *entry) const;
+    void collectTree(NFSTree *cur, std::vector<NFSTree *> &list);
+    bool writeIndex(FILE *fd);
+
     void writeTree(FILE *fd, NFSTree *cur);
     void readTree(NFSTree *parent);
     void releaseTree(NFSTree *root);
@@ -40,6 +40,7 @@ extern UIInterface *__NidiumUI;
 AndroidUIInterface::AndroidUIInterface()
     : UIInterface(), m_Console(NULL)
 {
+    this->setStatsName("AndroidUIInterface");
 }
 
 void AndroidUIInterface::setGLContextAttribute()
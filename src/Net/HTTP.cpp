@@ -16,6 +16,7 @@
 #include <sys/socket.h>
 
 #include "Core/Path.h"
+#include "Net/HTTPConnectionPool.h"
 
 namespace Nidium {
 namespace Net {
@@ -88,6 +89,8 @@ static int message_begin_cb(http_parser *p)
 
     nhttp->m_HTTP.m_Data = buffer_new(0);
 
+    nhttp->m_Connection.received = true;
+
     return 0;
 }
 
@@ -189,6 +192,12 @@ static int body_cb(http_parser *p, const char *buf, size_t len)
 {
     HTTP *nhttp = static_cast<HTTP *>(p->data);
 
+    if (nhttp->isStreaming()) {
+        nhttp->onChunk(buf, len);
+
+        return 0;
+    }
+
     if (nhttp->m_HTTP.m_Data == NULL) {
         nhttp->m_HTTP.m_Data = buffer_new(2048);
     }
@@ -209,19 +218,9 @@ static int body_cb(http_parser *p, const char *buf, size_t len)
 // }}}
 
 // {{{ HTTP callbacks (connect/disconnect/read)
-static void
-nidium_http_connected(ape_socket *s, ape_global *ape, void *socket_arg)
+static void nidium_http_write_request(ape_socket *s, HTTPRequest *request)
 {
-    HTTP *nhttp = static_cast<HTTP *>(s->ctx);
-
-    if (nhttp == NULL) return;
-
-    http_parser_init(&nhttp->m_HTTP.parser, HTTP_RESPONSE);
-    nhttp->m_HTTP.parser.data = nhttp;
-    nhttp->m_HTTP.parser_rdy  = true;
-
-    HTTPRequest *request = nhttp->getRequest();
-    buffer *headers      = request->getHeadersData();
+    buffer *headers = request->getHeadersData();
 
     if (request->getData() != NULL
         && (request->m_Method == HTTPRequest::kHTTPMethod_Post
@@ -234,7 +233,7 @@ nidium_http_connected(ape_socket *s, ape_global *ape, void *socket_arg)
         the lifetime of the data is tied to the socket lifetime */
         // TODO: new style cast
         APE_socket_write(s, (unsigned char *)(request->getData()),
-                         nhttp->getRequest()->getDataLength(), APE_DATA_OWN);
+                         request->getDataLength(), APE_DATA_OWN);
         FLUSH_TCP(s->s.fd);
     } else {
         APE_socket_write(s, headers->data, headers->used, APE_DATA_COPY);
@@ -243,6 +242,25 @@ nidium_http_connected(ape_socket *s, ape_global *ape, void *socket_arg)
     buffer_destroy(headers);
 }
 
+static void
+nidium_http_connected(ape_socket *s, ape_global *ape, void *socket_arg)
+{
+    HTTP *nhttp = static_cast<HTTP *>(s->ctx);
+
+    if (nhttp == NULL) return;
+
+    http_parser_init(&nhttp->m_HTTP.parser, HTTP_RESPONSE);
+    nhttp->m_HTTP.parser.data = nhttp;
+    nhttp->m_HTTP.parser_rdy  = true;
+
+    nhttp->m_Connection.connected = true;
+
+    nidium_http_write_request(s, nhttp->getRequest());
+
+    /* Send the queued requests along if possible */
+    nhttp->pipeline();
+}
+
 static void
 nidium_http_disconnect(ape_socket *s, ape_global *ape, void *socket_arg)
 {
@@ -255,6 +273,31 @@ nidium_http_disconnect(ape_socket *s, ape_global *ape, void *socket_arg)
 
     nhttp->clearTimeout();
 
+    /*
+        Requests pipelined on this connection that didn't get their
+        response are sent again, one at a time.
+    */
+    nhttp->unpipeline();
+
+    /*
+        A pooled connection was closed by the server before it got our
+        request (or a pipelined request was left unanswered).
+        Send it again over a new connection.
+    */
+    if ((nhttp->m_Connection.reused || nhttp->m_Connection.pipelined)
+        && !nhttp->m_Connection.received && !nhttp->m_HTTP.m_Ended
+        && !nhttp->hasPendingError()
+        && nhttp->getRequest()->getData() == NULL) {
+
+        s->ctx               = NULL;
+        nhttp->m_CurrentSock = NULL;
+
+        nhttp->canDoRequest(true);
+        nhttp->request(nhttp->getRequest(), nhttp->m_Delegate, true);
+
+        return;
+    }
+
     if (!nhttp->isParsing() && nhttp->m_HTTP.parser_rdy) {
         http_parser_execute(&nhttp->m_HTTP.parser, &settings, NULL, 0);
     }
@@ -270,26 +313,50 @@ nidium_http_disconnect(ape_socket *s, ape_global *ape, void *socket_arg)
     nhttp->canDoRequest(true);
 
     s->ctx = NULL;
+
+    nhttp->next();
 }
 
-static void nidium_http_read(ape_socket *s,
-                             const uint8_t *data,
-                             size_t len,
-                             ape_global *ape,
-                             void *socket_arg)
+/*
+    Stop (or restart) polling the socket for incoming data,
+    so that the kernel applies backpressure to the server.
+    Write readiness is always polled : a pending request body
+    keeps being flushed while paused.
+*/
+static void nidium_http_socket_reading(ape_socket *s, bool enable)
 {
-    size_t nparsed;
-    HTTP *nhttp = static_cast<HTTP *>(s->ctx);
-
-    if (nhttp == NULL || nhttp->m_HTTP.m_Ended) {
+    if (s->s.fd < 0) {
         return;
     }
 
+    events_del(s->s.fd, s->ape);
+    events_add(s->s.fd, s, enable ? EVENT_READ | EVENT_WRITE : EVENT_WRITE,
+               s->ape);
+}
+
+static void nidium_http_parse(HTTP *nhttp,
+                              ape_socket *s,
+                              const char *data,
+                              size_t len)
+{
+    size_t nparsed;
+
     nhttp->parsing(true);
-    nparsed = http_parser_execute(&nhttp->m_HTTP.parser, &settings,
-                                  reinterpret_cast<const char *>(data), len);
+    nparsed = http_parser_execute(&nhttp->m_HTTP.parser, &settings, data, len);
     nhttp->parsing(false);
 
+    /*
+        The delegate paused the body, keep what wasn't parsed for later
+    */
+    if (HTTP_PARSER_ERRNO(&nhttp->m_HTTP.parser) == HPE_PAUSED) {
+        nhttp->setBacklog(data + nparsed, len - nparsed);
+        return;
+    }
+
+    if (nhttp->isStreaming() && !nhttp->m_HTTP.m_Ended) {
+        nhttp->flushStream();
+    }
+
     if (nparsed != len && !nhttp->m_HTTP.m_Ended) {
         ndm_logf(NDM_LOG_ERROR, "HTTP",
                  "(socket %p) Parser returned %ld with error %s", s,
@@ -301,6 +368,27 @@ static void nidium_http_read(ape_socket *s,
         APE_socket_shutdown_now(s);
     }
 }
+
+static void nidium_http_read(ape_socket *s,
+                             const uint8_t *data,
+                             size_t len,
+                             ape_global *ape,
+                             void *socket_arg)
+{
+    HTTP *nhttp = static_cast<HTTP *>(s->ctx);
+
+    if (nhttp == NULL || nhttp->m_HTTP.m_Ended) {
+        return;
+    }
+
+    /* Data read before the socket was paused */
+    if (nhttp->isPaused()) {
+        nhttp->setBacklog(reinterpret_cast<const char *>(data), len);
+        return;
+    }
+
+    nidium_http_parse(nhttp, s, reinterpret_cast<const char *>(data), len);
+}
 // }}}
 
 // {{{ HTTP Implementation
@@ -310,11 +398,27 @@ HTTP::HTTP(ape_global *n)
       m_FileSize(0), m_isParsing(false), m_Request(NULL), m_CanDoRequest(true),
       m_PendingError(ERROR_NOERR), m_MaxRedirect(8), m_FollowLocation(true)
 {
+    this->setStatsName("HTTP");
+
     memset(&m_HTTP, 0, sizeof(m_HTTP));
     memset(&m_Redirect, 0, sizeof(m_Redirect));
 
     m_HTTP.m_Headers.prevstate = HTTP::PSTATE_NOTHING;
     nidium_http_data_type      = DATA_NULL;
+
+    m_Connection.reused    = false;
+    m_Connection.received  = false;
+    m_Connection.connected = false;
+    m_Connection.pipelined = false;
+
+    m_Pipeline.enabled  = false;
+    m_Pipeline.fallback = false;
+    m_Pipeline.depth    = HTTP_PIPELINE_DEPTH;
+
+    m_Stream.window   = 0;
+    m_Stream.received = 0;
+    m_Stream.paused   = false;
+    m_Stream.backlog  = NULL;
 }
 
 void HTTP::reportPendingError()
@@ -341,6 +445,121 @@ void HTTP::onData(size_t offset, size_t len)
     m_Delegate->onProgress(offset, len, &m_HTTP, this->nidium_http_data_type);
 }
 
+void HTTP::onChunk(const char *data, size_t len)
+{
+    /* The body of a redirect isn't of any interest */
+    if (m_Redirect.enabled) {
+        return;
+    }
+
+    m_Stream.received += len;
+
+    if (m_HTTP.m_Data == NULL) {
+        m_HTTP.m_Data = buffer_new(0);
+    }
+
+    /* Large enough, no need to copy it */
+    if (m_HTTP.m_Data->used == 0 && len >= m_Stream.window) {
+        m_Delegate->onChunk(reinterpret_cast<const uint8_t *>(data), len);
+        return;
+    }
+
+    buffer_append_data(m_HTTP.m_Data,
+                       reinterpret_cast<const unsigned char *>(data), len);
+
+    if (m_HTTP.m_Data->used >= m_Stream.window) {
+        this->flushStream();
+    }
+}
+
+void HTTP::flushStream()
+{
+    if (m_HTTP.m_Data == NULL || m_HTTP.m_Data->used == 0) {
+        return;
+    }
+
+    /* The delegate may pause (and resume) from onChunk */
+    size_t len          = m_HTTP.m_Data->used;
+    m_HTTP.m_Data->used = 0;
+
+    m_Delegate->onChunk(m_HTTP.m_Data->data, len);
+}
+
+void HTTP::pause()
+{
+    if (m_Stream.paused || m_HTTP.m_Ended) {
+        return;
+    }
+
+    m_Stream.paused = true;
+
+    /* Stop right after the current chunk */
+    if (m_HTTP.parser_rdy) {
+        http_parser_pause(&m_HTTP.parser, 1);
+    }
+
+    if (m_CurrentSock) {
+        nidium_http_socket_reading(m_CurrentSock, false);
+    }
+}
+
+void HTTP::resume()
+{
+    if (!m_Stream.paused) {
+        return;
+    }
+
+    m_Stream.paused = false;
+
+    /*
+        The connection was closed while paused : the request is over
+        (the disconnect already reported it), drop what was left
+    */
+    if (!m_CurrentSock) {
+        if (m_Stream.backlog) {
+            m_Stream.backlog->used = 0;
+        }
+        return;
+    }
+
+    if (m_HTTP.parser_rdy) {
+        http_parser_pause(&m_HTTP.parser, 0);
+    }
+
+    /*
+        Parse what was received while paused (unless we are called
+        from a parser callback, the backlog is empty in this case)
+    */
+    if (!m_isParsing && m_Stream.backlog && m_Stream.backlog->used) {
+        buffer *backlog  = m_Stream.backlog;
+        m_Stream.backlog = NULL;
+
+        nidium_http_parse(this, m_CurrentSock,
+                          reinterpret_cast<const char *>(backlog->data),
+                          backlog->used);
+
+        buffer_destroy(backlog);
+    }
+
+    if (!m_Stream.paused && m_CurrentSock) {
+        nidium_http_socket_reading(m_CurrentSock, true);
+    }
+}
+
+void HTTP::setBacklog(const char *data, size_t len)
+{
+    if (len == 0) {
+        return;
+    }
+
+    if (m_Stream.backlog == NULL) {
+        m_Stream.backlog = buffer_new(len);
+    }
+
+    buffer_append_data(m_Stream.backlog,
+                       reinterpret_cast<const unsigned char *>(data), len);
+}
+
 void HTTP::headerEnded()
 {
 #define REQUEST_HEADER(header) \
@@ -419,7 +638,8 @@ void HTTP::headerEnded()
 
 /*
     stopRequest can be used to shutdown slow or maliscious connections
-    since the shutdown is not queued
+    since the shutdown is not queued.
+    Queued requests are dropped unless the request timed out.
 */
 void HTTP::stopRequest(bool timeout)
 {
@@ -431,10 +651,18 @@ void HTTP::stopRequest(bool timeout)
         /*
             Make sur the connection is closed right now
         */
-        this->close(true);
+        this->unpipeline();
+
+        if (m_CurrentSock) {
+            m_CurrentSock->ctx = NULL;
+            this->close(true);
+            m_CurrentSock = NULL;
+        }
 
         if (timeout) {
             this->setPendingError(ERROR_TIMEOUT);
+        } else {
+            this->clearQueue();
         }
 
         this->clearState();
@@ -444,6 +672,9 @@ void HTTP::stopRequest(bool timeout)
         }
 
         m_CanDoRequest = true;
+
+        /* A timed out request doesn't hold back the next ones */
+        this->next();
     }
 }
 
@@ -451,8 +682,24 @@ void HTTP::requestEnded()
 {
     m_CanDoRequest = true;
 
+    bool keepalive = this->isKeepAlive()
+                     && http_should_keep_alive(&m_HTTP.parser);
+
     if (m_Redirect.enabled && !hasPendingError()) {
 
+        /*
+            The responses to the requests pipelined after this one
+            are dropped along with the connection
+        */
+        if (this->unpipeline()) {
+            keepalive = false;
+        }
+
+        /* Hand the connection back before the request points elsewhere */
+        if (keepalive) {
+            this->releaseConnection();
+        }
+
         if (URLSCHEME_MATCH(m_Redirect.to, "http")) {
             m_Request->resetURL(m_Redirect.to);
 
@@ -460,13 +707,30 @@ void HTTP::requestEnded()
             m_Request->setPath(m_Redirect.to);
         }
         this->clearState();
-        this->request(m_Request, m_Delegate, true);
+        this->request(m_Request, m_Delegate, !keepalive);
         return;
     }
 
     if (!m_HTTP.m_Ended) {
         m_HTTP.m_Ended = 1;
-        bool doclose   = !this->isKeepAlive();
+        bool doclose   = !keepalive;
+
+        /*
+            Make the connection available right away,
+            the delegate may issue another request.
+            It's kept if queued requests are waiting for it.
+        */
+        if (!doclose && m_Queue.empty()) {
+            this->releaseConnection();
+        }
+
+        /* The whole body was handed to the delegate */
+        if (this->isStreaming()) {
+            this->flushStream();
+
+            buffer_destroy(m_HTTP.m_Data);
+            m_HTTP.m_Data = NULL;
+        }
 
         if (!hasPendingError()) {
             m_Delegate->onRequest(&m_HTTP, nidium_http_data_type);
@@ -474,13 +738,31 @@ void HTTP::requestEnded()
 
         this->clearState();
 
-        if (doclose) {
+        if (doclose && m_CurrentSock) {
             this->close();
             nidium_http_disconnect(m_CurrentSock, m_CurrentSock->ape, NULL);
+        } else {
+            this->next();
         }
     }
 }
 
+void HTTP::releaseConnection()
+{
+    if (!m_CurrentSock || !m_Request) {
+        return;
+    }
+
+    ape_socket *socket = m_CurrentSock;
+
+    m_CurrentSock = NULL;
+    socket->ctx   = NULL;
+
+    HTTPConnectionPool::GetInstance(m_Net)->release(
+        socket, m_Request->getHost(), m_Request->getPort(),
+        m_Request->isSSL());
+}
+
 void HTTP::clearState()
 {
     this->reportPendingError();
@@ -560,7 +842,19 @@ bool HTTP::createConnection()
         return false;
     }
 
-    socket->callbacks.on_connected  = nidium_http_connected;
+    socket->callbacks.on_connected = nidium_http_connected;
+
+    this->attachConnection(socket);
+
+    m_Connection.reused = false;
+
+    HTTPConnectionPool::GetInstance(m_Net)->connectionCreated();
+
+    return true;
+}
+
+void HTTP::attachConnection(ape_socket *socket)
+{
     socket->callbacks.on_read       = nidium_http_read;
     socket->callbacks.on_disconnect = nidium_http_disconnect;
 
@@ -568,18 +862,49 @@ bool HTTP::createConnection()
 
     this->m_CurrentSock = socket;
 
-    return true;
+    m_Connection.connected = false;
 }
 
 bool HTTP::request(HTTPRequest *req,
                    HTTPDelegate *delegate,
                    bool forceNewConnection)
 {
+    /*
+        Another request is running (or waiting),
+        this one is run once they are done
+    */
+    if (m_Request && req != m_Request
+        && (!m_CanDoRequest || !m_Queue.empty())) {
+
+        m_Queue.push_back({ req, delegate, false });
+
+        this->pipeline();
+
+        return true;
+    }
+
     if (!canDoRequest()) {
         this->clearState();
         return false;
     }
 
+    return this->send(req, delegate, forceNewConnection);
+}
+
+bool HTTP::send(HTTPRequest *req,
+                HTTPDelegate *delegate,
+                bool forceNewConnection)
+{
+    /*
+        The connection was kept for this request but it targets
+        another host
+    */
+    if (m_CurrentSock && m_Request && !forceNewConnection
+        && !IsSameOrigin(m_Request, req)) {
+
+        this->releaseConnection();
+    }
+
     /* A fresh request is given */
     if (m_Request && req != m_Request) {
         delete m_Request;
@@ -595,6 +920,23 @@ bool HTTP::request(HTTPRequest *req,
         APE_socket_shutdown_now(m_CurrentSock);
     }
 
+    /*
+        Otherwise, try to get an idle connection to the same host
+    */
+    if (!reusesock && !forceNewConnection) {
+        ape_socket *socket = HTTPConnectionPool::GetInstance(m_Net)->acquire(
+            req->getHost(), req->getPort(), req->isSSL());
+
+        if (socket) {
+            this->attachConnection(socket);
+
+            m_Connection.reused = true;
+            reusesock           = true;
+        }
+    }
+
+    m_Connection.pipelined = false;
+
     /*
         If we have an available socket, reuse it (keep alive)
     */
@@ -603,6 +945,19 @@ bool HTTP::request(HTTPRequest *req,
         return false;
     }
 
+    this->start(req, delegate);
+
+    if (reusesock) {
+        nidium_http_connected(m_CurrentSock, m_Net, NULL);
+    }
+
+    return true;
+}
+
+void HTTP::start(HTTPRequest *req, HTTPDelegate *delegate)
+{
+    m_Request = req;
+
     m_Path = req->isSSL()
                  ? std::string("https://")
                  : std::string("http://") + std::string(req->getHost());
@@ -616,7 +971,17 @@ bool HTTP::request(HTTPRequest *req,
     m_Delegate     = delegate;
     m_HTTP.m_Ended = 0;
 
+    m_Connection.received = false;
+
+    m_Stream.received = 0;
+    m_Stream.paused   = false;
+
+    if (m_Stream.backlog) {
+        m_Stream.backlog->used = 0;
+    }
+
     delegate->m_HTTPRef = this;
+    delegate->onStart(req);
 
     if (m_Timeout) {
         ape_timer_t *ctimer;
@@ -628,12 +993,133 @@ bool HTTP::request(HTTPRequest *req,
     }
 
     m_CanDoRequest = false;
+}
 
-    if (reusesock) {
-        nidium_http_connected(m_CurrentSock, m_Net, NULL);
+bool HTTP::IsSameOrigin(HTTPRequest *a, HTTPRequest *b)
+{
+    return a->isSSL() == b->isSSL() && a->getPort() == b->getPort()
+           && strcasecmp(a->getHost(), b->getHost()) == 0;
+}
+
+bool HTTP::canPipeline(HTTPRequest *req)
+{
+    const char *header_connection = req->getHeader("connection");
+
+    if (header_connection && strcasecmp(header_connection, "close") == 0) {
+        return false;
     }
 
-    return true;
+    /*
+        Only GET requests without a body. HEAD responses can't be
+        told apart from the next ones by the parser.
+    */
+    return req->m_Method == HTTPRequest::kHTTPMethod_Get
+           && req->getData() == NULL && IsSameOrigin(m_Request, req);
+}
+
+void HTTP::pipeline()
+{
+    if (!m_Pipeline.enabled || m_Pipeline.fallback || !m_CurrentSock
+        || !m_Connection.connected || m_HTTP.m_Ended
+        || !this->canPipeline(m_Request)) {
+        return;
+    }
+
+    /* The current request is in flight */
+    uint32_t inflight = 1;
+
+    /*
+        Requests are sent in order, the sent ones are always
+        at the front of the queue
+    */
+    for (QueuedRequest &queued : m_Queue) {
+        if (queued.m_Sent) {
+            inflight++;
+            continue;
+        }
+
+        if (inflight >= m_Pipeline.depth
+            || !this->canPipeline(queued.m_Request)) {
+            break;
+        }
+
+        nidium_http_write_request(m_CurrentSock, queued.m_Request);
+
+        queued.m_Sent = true;
+        inflight++;
+    }
+}
+
+bool HTTP::unpipeline()
+{
+    bool sent = false;
+
+    for (QueuedRequest &queued : m_Queue) {
+        if (queued.m_Sent) {
+            queued.m_Sent = false;
+            sent          = true;
+        }
+    }
+
+    /* The server may not support it, don't pipeline what's left */
+    if (sent) {
+        m_Pipeline.fallback = true;
+    }
+
+    return sent;
+}
+
+void HTTP::next()
+{
+    if (!m_CanDoRequest || m_Queue.empty()) {
+        return;
+    }
+
+    QueuedRequest queued = m_Queue.front();
+    m_Queue.pop_front();
+
+    if (m_Queue.empty()) {
+        m_Pipeline.fallback = false;
+    }
+
+    if (!queued.m_Sent) {
+        /* Errors are reported to the queued request delegate */
+        m_Delegate = queued.m_Delegate;
+
+        if (!this->send(queued.m_Request, queued.m_Delegate, false)) {
+            /* The error was reported to the delegate, move along */
+            this->next();
+        }
+
+        return;
+    }
+
+    /*
+        The request was already sent on the current connection,
+        its response is the next one to be parsed.
+    */
+    if (m_Request && queued.m_Request != m_Request) {
+        delete m_Request;
+    }
+
+    m_Connection.reused    = false;
+    m_Connection.pipelined = true;
+
+    this->start(queued.m_Request, queued.m_Delegate);
+
+    /* Keep the pipeline full */
+    this->pipeline();
+}
+
+void HTTP::clearQueue()
+{
+    for (QueuedRequest &queued : m_Queue) {
+        delete queued.m_Request;
+    }
+
+    m_Queue.clear();
+
+    m_Pipeline.fallback = false;
 }
 
 const char *HTTP::getHeader(const char *key)
@@ -701,10 +1187,14 @@ HTTP::~HTTP()
         this->clearTimeout();
     }
 
+    this->clearQueue();
+
     if (m_Request) {
         delete m_Request;
     }
 
+    buffer_destroy(m_Stream.backlog);
+
     m_Delegate     = NULL;
     m_PendingError = ERROR_NOERR;
 
@@ -7,6 +7,7 @@
 #define net_http_h__
 
 #include <string>
+#include <deque>
 
 #include <http_parser.h>
 
@@ -16,6 +17,12 @@
 #define HTTP_MAX_CL (1024ULL * 1024ULL * 1024ULL * 2ULL)
 #define HTTP_DEFAULT_TIMEOUT 15000
 
+/* Maximum number of requests in flight on a pipelined connection */
+#define HTTP_PIPELINE_DEPTH 8
+
+/* Body data buffered before being handed to the delegate (streaming mode) */
+#define HTTP_STREAM_WINDOW (64 * 1024)
+
 #include "Core/Messages.h"
 
 namespace Nidium {
@@ -201,6 +208,18 @@ public:
 
     HTTPDelegate *m_Delegate;
 
+    struct
+    {
+        /* The current connection was taken from the pool */
+        bool reused;
+        /* The response to the current request has started */
+        bool received;
+        /* The current connection is established */
+        bool connected;
+        /* The current request was pipelined */
+        bool pipelined;
+    } m_Connection;
+
     struct HTTPData
     {
         http_parser parser;
@@ -229,6 +248,17 @@ public:
     void stopRequest(bool timeout = false);
     void clearTimeout();
     void onData(size_t offset, size_t len);
+    void onChunk(const char *data, size_t len);
+
+    /*
+        Hand the buffered body data to the delegate
+    */
+    void flushStream();
+
+    /*
+        Keep data received while the body is paused
+    */
+    void setBacklog(const char *data, size_t len);
     void setPrivate(void *ptr);
     void *getPrivate();
 
@@ -279,9 +309,93 @@ public:
     }
 
     void clearState();
+
+    /*
+        Run a request. If another one is running, the request is queued
+        and run once the previous ones are done (the queue takes the
+        ownership of |req|).
+    */
     bool request(HTTPRequest *req,
                  HTTPDelegate *delegate,
                  bool forceNewConnection = false);
+
+    /*
+        Send the queued requests on the current connection without
+        waiting for the responses (HTTP/1.1 pipelining).
+        Only GET requests to the same host are pipelined.
+    */
+    void setPipelining(bool enabled, uint32_t depth = HTTP_PIPELINE_DEPTH)
+    {
+        m_Pipeline.enabled = enabled;
+        m_Pipeline.depth   = depth ? depth : 1;
+    }
+
+    bool isPipelining() const
+    {
+        return m_Pipeline.enabled;
+    }
+
+    size_t getQueueSize() const
+    {
+        return m_Queue.size();
+    }
+
+    /*
+        Hand the response body to HTTPDelegate::onChunk() instead of
+        buffering it. At most |window| bytes are buffered before being
+        handed over (0 disables streaming).
+    */
+    void setStreaming(size_t window)
+    {
+        m_Stream.window = window;
+    }
+
+    bool isStreaming() const
+    {
+        return m_Stream.window != 0;
+    }
+
+    size_t getStreamingWindow() const
+    {
+        return m_Stream.window;
+    }
+
+    /*
+        Body bytes handed to the delegate for the current request
+    */
+    uint64_t getStreamedBytes() const
+    {
+        return m_Stream.received;
+    }
+
+    /*
+        Stop receiving the response body until resume() is called.
+        The socket isn't read anymore, so that the server is slowed down
+        by TCP flow control.
+    */
+    void pause();
+    void resume();
+
+    bool isPaused() const
+    {
+        return m_Stream.paused;
+    }
+
+    /*
+        Write the queued requests that can be pipelined
+    */
+    void pipeline();
+
+    /*
+        Mark the pipelined requests as not sent (their connection is gone).
+        Returns true if there was any.
+    */
+    bool unpipeline();
+
+    /*
+        Run the next queued request
+    */
+    void next();
     bool isKeepAlive();
 
     bool canDoRequest() const
@@ -332,7 +446,30 @@ public:
 private:
     void reportPendingError();
 
+    struct QueuedRequest
+    {
+        HTTPRequest *m_Request;
+        HTTPDelegate *m_Delegate;
+        /* Already written on the current connection */
+        bool m_Sent;
+    };
+
+    static bool IsSameOrigin(HTTPRequest *a, HTTPRequest *b);
+
+    bool send(HTTPRequest *req,
+              HTTPDelegate *delegate,
+              bool forceNewConnection);
+    void start(HTTPRequest *req, HTTPDelegate *delegate);
+    bool canPipeline(HTTPRequest *req);
+    void clearQueue();
+
     bool createConnection();
+    void attachConnection(ape_socket *socket);
+
+    /*
+        Hand the current connection to the HTTPConnectionPool
+    */
+    void releaseConnection();
 
     uint64_t m_FileSize;
     bool m_isParsing; // http_parser_execute is working
@@ -345,6 +482,25 @@ private:
 
     std::string m_Path;
 
+    std::deque<QueuedRequest> m_Queue;
+
+    struct
+    {
+        bool enabled;
+        /* The server closed a pipelined connection */
+        bool fallback;
+        uint32_t depth;
+    } m_Pipeline;
+
+    struct
+    {
+        size_t window;
+        uint64_t received;
+        bool paused;
+        /* Data received but not parsed yet because of a pause */
+        buffer *backlog;
+    } m_Stream;
+
     struct
     {
         const char *to;
@@ -364,6 +520,18 @@ public:
         = 0;
     virtual void onError(HTTP::HTTPError err) = 0;
     virtual void onHeader() = 0;
+
+    /*
+        Response body data, in streaming mode only (see HTTP::setStreaming).
+        HTTP::pause() can be called to stop receiving data.
+    */
+    virtual void onChunk(const uint8_t *data, size_t len){};
+
+    /*
+        |req| is sent or, when pipelined, its response is the next one.
+        Called again with the same request when it's redirected.
+    */
+    virtual void onStart(HTTPRequest *req){};
     HTTP *m_HTTPRef;
 };
 // }}}
@@ -0,0 +1,291 @@
+/*
+   Copyright 2016 Nidium Inc. All rights reserved.
+   Use of this source code is governed by a MIT license
+   that can be found in the LICENSE file.
+*/
+#include "Net/HTTPConnectionPool.h"
+
+#include <pthread.h>
+
+#include "Core/Utils.h"
+
+namespace Nidium {
+namespace Net {
+
+/* One pool per event loop */
+static pthread_mutex_t g_PoolsLock = PTHREAD_MUTEX_INITIALIZER;
+static std::unordered_map<ape_global *, HTTPConnectionPool *> g_Pools;
+
+// {{{ HTTPConnectionPool
+HTTPConnectionPool::HTTPConnectionPool(ape_global *net)
+    : m_Net(net), m_IdleCount(0), m_IdleTimeout(HTTP_POOL_IDLE_TIMEOUT),
+      m_MaxPerHost(HTTP_POOL_MAX_PER_HOST), m_Timer(0)
+{
+    m_Stats = {};
+}
+
+HTTPConnectionPool::~HTTPConnectionPool()
+{
+    if (m_Timer) {
+        APE_timer_clearbyid(m_Net, m_Timer, 1);
+    }
+
+    this->clear();
+}
+
+HTTPConnectionPool *HTTPConnectionPool::GetInstance(ape_global *net)
+{
+    HTTPConnectionPool *pool;
+
+    pthread_mutex_lock(&g_PoolsLock);
+
+    auto it = g_Pools.find(net);
+    if (it == g_Pools.end()) {
+        pool         = new HTTPConnectionPool(net);
+        g_Pools[net] = pool;
+    } else {
+        pool = it->second;
+    }
+
+    pthread_mutex_unlock(&g_PoolsLock);
+
+    return pool;
+}
+
+void HTTPConnectionPool::Destroy(ape_global *net)
+{
+    HTTPConnectionPool *pool = NULL;
+
+    pthread_mutex_lock(&g_PoolsLock);
+
+    auto it = g_Pools.find(net);
+    if (it != g_Pools.end()) {
+        pool = it->second;
+        g_Pools.erase(it);
+    }
+
+    pthread_mutex_unlock(&g_PoolsLock);
+
+    delete pool;
+}
+
+std::string HTTPConnectionPool::GetKey(const char *host, u_short port, bool ssl)
+{
+    std::string key(ssl ? "https://" : "http://");
+
+    key += host;
+    key += ":" + std::to_string(port);
+
+    return key;
+}
+
+ape_socket *HTTPConnectionPool::acquire(const char *host, u_short port, bool ssl)
+{
+    if (m_IdleCount == 0) {
+        return NULL;
+    }
+
+    auto it = m_Idle.find(GetKey(host, port, ssl));
+    if (it == m_Idle.end() || it->second.empty()) {
+        return NULL;
+    }
+
+    /* The most recently used connection is the least likely to be closed */
+    ape_socket *socket = it->second.back().m_Socket;
+    it->second.pop_back();
+
+    if (it->second.empty()) {
+        m_Idle.erase(it);
+    }
+
+    m_IdleCount--;
+    m_Stats.reused++;
+
+    socket->ctx                     = NULL;
+    socket->callbacks.on_read       = NULL;
+    socket->callbacks.on_disconnect = NULL;
+
+    return socket;
+}
+
+void HTTPConnectionPool::release(ape_socket *socket,
+                                 const char *host,
+                                 u_short port,
+                                 bool ssl)
+{
+    ConnectionList &list = m_Idle[GetKey(host, port, ssl)];
+
+    if (list.size() >= m_MaxPerHost) {
+        if (list.empty()) {
+            m_Idle.erase(GetKey(host, port, ssl));
+        }
+
+        m_Stats.discarded++;
+        Close(socket);
+
+        return;
+    }
+
+    socket->ctx                     = this;
+    socket->callbacks.on_read       = HTTPConnectionPool::OnIdleRead;
+    socket->callbacks.on_disconnect = HTTPConnectionPool::OnIdleDisconnect;
+
+    list.push_back({ socket, Core::Utils::GetTick(true) });
+
+    m_IdleCount++;
+    m_Stats.released++;
+
+    if (!m_Timer) {
+        ape_timer_t *timer = APE_timer_create(m_Net, HTTP_POOL_SWEEP_INTERVAL,
+                                              HTTPConnectionPool::Sweep, this);
+        APE_timer_unprotect(timer);
+
+        m_Timer = APE_timer_getid(timer);
+    }
+}
+
+void HTTPConnectionPool::setMaxPerHost(uint32_t max)
+{
+    m_MaxPerHost = max;
+
+    for (auto it = m_Idle.begin(); it != m_Idle.end();) {
+        ConnectionList &list = it->second;
+
+        /* Oldest first */
+        while (list.size() > m_MaxPerHost) {
+            ape_socket *socket = list.front().m_Socket;
+            list.pop_front();
+
+            m_IdleCount--;
+            m_Stats.discarded++;
+
+            Close(socket);
+        }
+
+        if (list.empty()) {
+            it = m_Idle.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void HTTPConnectionPool::clear()
+{
+    for (auto &entry : m_Idle) {
+        for (Connection &conn : entry.second) {
+            Close(conn.m_Socket);
+        }
+    }
+
+    m_Idle.clear();
+    m_IdleCount = 0;
+}
+
+void HTTPConnectionPool::Close(ape_socket *socket)
+{
+    socket->ctx                     = NULL;
+    socket->callbacks.on_read       = NULL;
+    socket->callbacks.on_disconnect = NULL;
+
+    APE_socket_shutdown_now(socket);
+}
+
+bool HTTPConnectionPool::remove(ape_socket *socket)
+{
+    for (auto it = m_Idle.begin(); it != m_Idle.end(); ++it) {
+        ConnectionList &list = it->second;
+
+        for (auto conn = list.begin(); conn != list.end(); ++conn) {
+            if (conn->m_Socket != socket) {
+                continue;
+            }
+
+            list.erase(conn);
+            if (list.empty()) {
+                m_Idle.erase(it);
+            }
+
+            m_IdleCount--;
+
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void HTTPConnectionPool::sweep()
+{
+    uint64_t now = Core::Utils::GetTick(true);
+
+    for (auto it = m_Idle.begin(); it != m_Idle.end();) {
+        ConnectionList &list = it->second;
+
+        /* Oldest first */
+        while (!list.empty() && now - list.front().m_Since >= m_IdleTimeout) {
+            ape_socket *socket = list.front().m_Socket;
+            list.pop_front();
+
+            m_IdleCount--;
+            m_Stats.expired++;
+
+            Close(socket);
+        }
+
+        if (list.empty()) {
+            it = m_Idle.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+int HTTPConnectionPool::Sweep(void *arg)
+{
+    HTTPConnectionPool *pool = static_cast<HTTPConnectionPool *>(arg);
+
+    pool->sweep();
+
+    if (pool->m_IdleCount == 0) {
+        pool->m_Timer = 0;
+        return 0;
+    }
+
+    return HTTP_POOL_SWEEP_INTERVAL;
+}
+
+/*
+    Nothing is expected on an idle connection
+*/
+void HTTPConnectionPool::OnIdleRead(ape_socket *s,
+                                    const uint8_t *data,
+                                    size_t len,
+                                    ape_global *ape,
+                                    void *socket_arg)
+{
+    HTTPConnectionPool *pool = static_cast<HTTPConnectionPool *>(s->ctx);
+
+    if (pool && pool->remove(s)) {
+        pool->m_Stats.closed++;
+    }
+
+    Close(s);
+}
+
+void HTTPConnectionPool::OnIdleDisconnect(ape_socket *s,
+                                          ape_global *ape,
+                                          void *arg)
+{
+    HTTPConnectionPool *pool = static_cast<HTTPConnectionPool *>(s->ctx);
+
+    if (pool && pool->remove(s)) {
+        pool->m_Stats.closed++;
+    }
+
+    s->ctx = NULL;
+}
+// }}}
+
+} // namespace Net
+} // namespace Nidium
@@ -0,0 +1,167 @@
+/*
+   Copyright 2016 Nidium Inc. All rights reserved.
+   Use of this source code is governed by a MIT license
+   that can be found in the LICENSE file.
+*/
+#ifndef net_httpconnectionpool_h__
+#define net_httpconnectionpool_h__
+
+#include <stdint.h>
+#include <deque>
+#include <string>
+#include <unordered_map>
+
+#include <ape_netlib.h>
+
+/* Idle connections are closed after this delay (ms) */
+#define HTTP_POOL_IDLE_TIMEOUT 30000
+
+/* Idle connections kept for each host */
+#define HTTP_POOL_MAX_PER_HOST 8
+
+/* Interval at which idle connections are checked for expiration (ms) */
+#define HTTP_POOL_SWEEP_INTERVAL 1000
+
+namespace Nidium {
+namespace Net {
+
+// {{{ HTTPConnectionPool
+/*
+    Keep-alive connections of the HTTP client, shared by every HTTP
+    instance running on the same event loop.
+
+    Once a response is fully received on a keep-alive connection, the
+    socket is handed to the pool. The next request to the same host
+    (and port, and scheme) reuses it instead of paying for a new TCP
+    (and TLS) handshake.
+
+    Idle connections are closed after |idleTimeout| ms, when the server
+    closes them, or when more than |maxPerHost| are idle for a host.
+*/
+class HTTPConnectionPool
+{
+public:
+    struct Stats
+    {
+        /* Connections opened by the HTTP client */
+        uint64_t created;
+        /* Requests sent on a pooled connection */
+        uint64_t reused;
+        /* Connections handed to the pool */
+        uint64_t released;
+        /* Idle connections closed after the idle timeout */
+        uint64_t expired;
+        /* Connections closed because the host had too many idle ones */
+        uint64_t discarded;
+        /* Idle connections closed by the server */
+        uint64_t closed;
+    };
+
+    static HTTPConnectionPool *GetInstance(ape_global *net);
+
+    /*
+        Close the idle connections and free the pool of |net|.
+        Must be called before the event loop is destroyed.
+    */
+    static void Destroy(ape_global *net);
+
+    /*
+        Get an idle connection to the given host (or NULL).
+        The caller is responsible for setting the socket ctx and callbacks.
+    */
+    ape_socket *acquire(const char *host, u_short port, bool ssl);
+
+    /*
+        Hand a connection to the pool. If it can't be kept, the socket is
+        closed. The socket must not be used by the caller afterward.
+    */
+    void release(ape_socket *socket, const char *host, u_short port, bool ssl);
+
+    /*
+        Account for a connection opened outside of the pool
+    */
+    void connectionCreated()
+    {
+        m_Stats.created++;
+    }
+
+    /*
+        Close all idle connections
+    */
+    void clear();
+
+    void setIdleTimeout(uint32_t ms)
+    {
+        m_IdleTimeout = ms;
+    }
+
+    uint32_t getIdleTimeout() const
+    {
+        return m_IdleTimeout;
+    }
+
+    /*
+        0 disables the pool
+    */
+    void setMaxPerHost(uint32_t max);
+
+    uint32_t getMaxPerHost() const
+    {
+        return m_MaxPerHost;
+    }
+
+    size_t getIdleCount() const
+    {
+        return m_IdleCount;
+    }
+
+    const Stats &getStats() const
+    {
+        return m_Stats;
+    }
+
+private:
+    struct Connection
+    {
+        ape_socket *m_Socket;
+        uint64_t m_Since;
+    };
+
+    /* Most recently released connections last */
+    typedef std::deque<Connection> ConnectionList;
+
+    explicit HTTPConnectionPool(ape_global *net);
+    ~HTTPConnectionPool();
+
+    static std::string GetKey(const char *host, u_short port, bool ssl);
+
+    static void OnIdleRead(ape_socket *s,
+                           const uint8_t *data,
+                           size_t len,
+                           ape_global *ape,
+                           void *socket_arg);
+    static void OnIdleDisconnect(ape_socket *s, ape_global *ape, void *arg);
+    static int Sweep(void *arg);
+
+    /* Close a connection without going through the pool callbacks */
+    static void Close(ape_socket *socket);
+
+    bool remove(ape_socket *socket);
+    void sweep();
+
+    ape_global *m_Net;
+    std::unordered_map<std::string, ConnectionList> m_Idle;
+    size_t m_IdleCount;
+
+    uint32_t m_IdleTimeout;
+    uint32_t m_MaxPerHost;
+    uint64_t m_Timer;
+
+    Stats m_Stats;
+};
+// }}}
+
+} // namespace Net
+} // namespace Nidium
+
+#endif
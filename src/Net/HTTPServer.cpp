@@ -7,10 +7,17 @@
 #include <stdlib.h>
 #include <stdbool.h>
 #include <string.h>
+#include <strings.h>
 #include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <inttypes.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <sys/socket.h>
+#ifdef __linux__
+#include <sys/sendfile.h>
+#endif
 
 #include "Net/HTTPServer.h"
 #include "Binding/NidiumJS.h"
@@ -26,51 +33,123 @@ namespace Net {
     HTTPServer *___http___ = static_cast<HTTPServer *>(obj->ctx); \
     if (___http___ == NULL) return;
 
-static struct
+/*
+    Status lines are precomputed so that the response
+    headers start with a single copy
+*/
+#define HTTP_CODE(code, desc) \
+    { code, desc, CONST_STR_LEN("HTTP/1.1 " #code " " desc "\r\n") }
+
+static const struct HTTPCode
 {
     uint16_t code;
     const char *desc;
-} HTTPCodes[] = { { 100, "Continue" },
-                  { 101, "Switching Protocols" },
-                  { 200, "OK" },
-                  { 201, "Created" },
-                  { 202, "Accepted" },
-                  { 203, "Non-Authoritative Information" },
-                  { 204, "No Content" },
-                  { 205, "Reset Content" },
-                  { 206, "Partial Content" },
-                  { 300, "Multiple Choices" },
-                  { 301, "Moved Permanently" },
-                  { 302, "Found" },
-                  { 303, "See Other" },
-                  { 304, "Not Modified" },
-                  { 305, "Use Proxy" },
-                  { 307, "Temporary Redirect" },
-                  { 400, "Bad Request" },
-                  { 401, "Unauthorized" },
-                  { 402, "Payment Required" },
-                  { 403, "Forbidden" },
-                  { 404, "Not Found" },
-                  { 405, "Method Not Allowed" },
-                  { 406, "Not Acceptable" },
-                  { 407, "Proxy Authentication Required" },
-                  { 408, "Request Time-out" },
-                  { 409, "Conflict" },
-                  { 410, "Gone" },
-                  { 411, "Length Required" },
-                  { 412, "Precondition Failed" },
-                  { 413, "Request Entity Too Large" },
-                  { 414, "Request-URI Too Large" },
-                  { 415, "Unsupported Media Type" },
-                  { 416, "Requested range not satisfiable" },
-                  { 417, "Expectation Failed" },
-                  { 500, "Internal Server Error" },
-                  { 501, "Not Implemented" },
-                  { 502, "Bad Gateway" },
-                  { 503, "Service Unavailable" },
-                  { 504, "Gateway Time-out" },
-                  { 505, "HTTP Version not support" },
-                  { 0, NULL } };
+    const char *line;
+    size_t linelen;
+} HTTPCodes[] = {
+    HTTP_CODE(100, "Continue"),
+    HTTP_CODE(101, "Switching Protocols"),
+    HTTP_CODE(200, "OK"),
+    HTTP_CODE(201, "Created"),
+    HTTP_CODE(202, "Accepted"),
+    HTTP_CODE(203, "Non-Authoritative Information"),
+    HTTP_CODE(204, "No Content"),
+    HTTP_CODE(205, "Reset Content"),
+    HTTP_CODE(206, "Partial Content"),
+    HTTP_CODE(300, "Multiple Choices"),
+    HTTP_CODE(301, "Moved Permanently"),
+    HTTP_CODE(302, "Found"),
+    HTTP_CODE(303, "See Other"),
+    HTTP_CODE(304, "Not Modified"),
+    HTTP_CODE(305, "Use Proxy"),
+    HTTP_CODE(307, "Temporary Redirect"),
+    HTTP_CODE(400, "Bad Request"),
+    HTTP_CODE(401, "Unauthorized"),
+    HTTP_CODE(402, "Payment Required"),
+    HTTP_CODE(403, "Forbidden"),
+    HTTP_CODE(404, "Not Found"),
+    HTTP_CODE(405, "Method Not Allowed"),
+    HTTP_CODE(406, "Not Acceptable"),
+    HTTP_CODE(407, "Proxy Authentication Required"),
+    HTTP_CODE(408, "Request Time-out"),
+    HTTP_CODE(409, "Conflict"),
+    HTTP_CODE(410, "Gone"),
+    HTTP_CODE(411, "Length Required"),
+    HTTP_CODE(412, "Precondition Failed"),
+    HTTP_CODE(413, "Request Entity Too Large"),
+    HTTP_CODE(414, "Request-URI Too Large"),
+    HTTP_CODE(415, "Unsupported Media Type"),
+    HTTP_CODE(416, "Requested range not satisfiable"),
+    HTTP_CODE(417, "Expectation Failed"),
+    HTTP_CODE(500, "Internal Server Error"),
+    HTTP_CODE(501, "Not Implemented"),
+    HTTP_CODE(502, "Bad Gateway"),
+    HTTP_CODE(503, "Service Unavailable"),
+    HTTP_CODE(504, "Gateway Time-out"),
+    HTTP_CODE(505, "HTTP Version not support"),
+    { 0, NULL, NULL, 0 }
+};
+
+#undef HTTP_CODE
+
+/* Every status code maps to its HTTPCodes entry (or NULL) */
+static const HTTPCode *HTTPServer_GetCode(uint16_t code)
+{
+    static const HTTPCode *index[600];
+    static bool ready = []() {
+        for (int i = 0; HTTPCodes[i].desc != NULL; i++) {
+            index[HTTPCodes[i].code] = &HTTPCodes[i];
+        }
+        return true;
+    }();
+
+    (void)ready;
+
+    return code < 600 ? index[code] : NULL;
+}
+
+/*
+    The Date header only changes once per second,
+    format it once and reuse it for every response.
+*/
+static size_t HTTPServer_GetDate(const char **date)
+{
+    static thread_local struct
+    {
+        time_t sec;
+        size_t len;
+        char str[64];
+    } cache = { 0, 0, { 0 } };
+
+    time_t now = time(NULL);
+
+    if (now != cache.sec) {
+        Utils::HTTPTime(cache.str);
+
+        cache.len = strlen(cache.str);
+        cache.sec = now;
+    }
+
+    *date = cache.str;
+
+    return cache.len;
+}
+
+/*
+    Stop (or restart) polling the client for incoming data.
+    Write readiness is always polled : a response written while
+    reading is paused keeps being flushed (and drained).
+*/
+static void HTTPServer_SetReading(ape_socket *s, bool enable)
+{
+    if (s->s.fd < 0) {
+        return;
+    }
+
+    events_del(s->s.fd, s->ape);
+    events_add(s->s.fd, s, enable ? EVENT_READ | EVENT_WRITE : EVENT_WRITE,
+               s->ape);
+}
 
 // }}}
 
@@ -98,6 +177,8 @@ static int message_begin_cb(http_parser *p)
     HTTPClientConnection *con                 = static_cast<HTTPClientConnection *>(p->data);
     HTTPClientConnection::HTTPData *http_data = con->getHTTPState();
 
+    con->onRequestBegin();
+
     /*
         Resets the headers (in the case of keepalive)
     */
@@ -179,20 +260,27 @@ static int headers_complete_cb(http_parser *p)
 
     if (p->content_length >= UINT32_MAX) {
         http_data->contentlength = 0;
-        con->onHeaderEnded();
-        return 0;
-    }
-
-    if (p->content_length > HTTP_MAX_CL) {
+    } else if (p->content_length > HTTP_MAX_CL) {
         return -1;
-    }
+    } else {
+        /* /!\ TODO: what happend if there is no content-length? */
+        // if (p->content_length) http_data->data = buffer_new(p->content_length);
 
-    /* /!\ TODO: what happend if there is no content-length? */
-    // if (p->content_length) http_data->data = buffer_new(p->content_length);
+        http_data->contentlength = p->content_length;
+    }
 
-    http_data->contentlength = p->content_length;
     con->onHeaderEnded();
 
+    HTTPServer *server = con->getHTTPServer();
+
+    /*
+        The request is handed over right away, its body will follow
+    */
+    if (server && server->isStreaming()) {
+        con->_createResponse();
+        server->onHeaders(con);
+    }
+
     return 0;
 }
 
@@ -200,7 +288,10 @@ static int message_complete_cb(http_parser *p)
 {
     HTTPClientConnection *client = static_cast<HTTPClientConnection *>(p->data);
 
-    client->_createResponse();
+    /* Already created with the headers in streaming mode */
+    if (!client->getHTTPServer()->isStreaming()) {
+        client->_createResponse();
+    }
     client->increaseRequestsCount();
 
     if (client->getHTTPServer()->onEnd(client)) {
@@ -221,6 +312,12 @@ static int body_cb(http_parser *p, const char *buf, size_t len)
 {
     HTTPClientConnection *client = static_cast<HTTPClientConnection *>(p->data);
 
+    if (client->getHTTPServer()->isStreaming()) {
+        client->getHTTPServer()->onData(client, buf, len);
+
+        return 0;
+    }
+
     if (client->getHTTPState()->data == NULL) {
         client->getHTTPState()->data = buffer_new(2048);
     }
@@ -299,6 +396,19 @@ static void nidium_socket_client_read_after_upgrade(ape_socket *socket_client,
     con->onContent(reinterpret_cast<const char *>(data), len);
 }
 
+static void nidium_socket_client_drain(ape_socket *socket_client,
+                                       ape_global *ape,
+                                       void *socket_arg)
+{
+    HTTPClientConnection *con
+        = static_cast<HTTPClientConnection *>(socket_client->ctx);
+    if (!con) {
+        return;
+    }
+
+    con->onDrain();
+}
+
 static void nidium_socket_client_disconnect(ape_socket *socket_client,
                                             ape_global *ape,
                                             void *socket_arg)
@@ -320,13 +430,16 @@ static void nidium_socket_client_disconnect(ape_socket *socket_client,
 
 // {{{ HTTPServer Implementation
 HTTPServer::HTTPServer(uint16_t port, const char *ip, bool secure)
+    : m_IdleTimers(Binding::NidiumJS::GetNet())
 {
     ape_global *ape = Binding::NidiumJS::GetNet();
     m_Socket        = APE_socket_new(secure ?
                       APE_SOCKET_PT_SSL : APE_SOCKET_PT_TCP, 0, ape);
 
-    m_IP   = strdup(ip);
-    m_Port = port;
+    m_IP        = strdup(ip);
+    m_Port      = port;
+    m_Secure    = secure;
+    m_Streaming = false;
 }
 
 bool HTTPServer::start(bool reuseport, int timeout)
@@ -339,7 +452,7 @@ bool HTTPServer::start(bool reuseport, int timeout)
     m_Socket->callbacks.on_read       = nidium_socket_client_read;
     m_Socket->callbacks.on_disconnect = nidium_socket_client_disconnect;
     m_Socket->callbacks.on_message    = NULL; // no udp on http
-    m_Socket->callbacks.on_drain      = NULL;
+    m_Socket->callbacks.on_drain      = nidium_socket_client_drain;
     m_Socket->callbacks.arg           = NULL;
     m_Socket->ctx                     = this;
 
@@ -388,20 +501,6 @@ HTTPClientConnection *HTTPServer::onClientConnect(ape_socket *client, ape_global
     return con;
 }
 
-int HTTPClientConnection_checktimeout(void *arg)
-{
-    HTTPClientConnection *con = static_cast<HTTPClientConnection *>(arg);
-    uint64_t timeout          = con->getTimeoutAfterMs();
-    /*
-        Never timeout if set to 0
-    */
-    if (timeout && Utils::GetTick(true) - con->getLastActivity() > timeout) {
-        con->close();
-    }
-
-    return 1000;
-}
-
 // }}}
 
 // {{{ HTTPClientConnection Implementation
@@ -409,10 +508,17 @@ int HTTPClientConnection_checktimeout(void *arg)
 HTTPClientConnection::HTTPClientConnection(HTTPServer *httpserver,
                                            ape_socket *socket)
     : m_Ctx(NULL), m_SocketClient(socket), m_HTTPServer(httpserver),
-      m_Response(NULL), m_RequestsCount(0), m_MaxRequestsCount(0)
+      m_Response(NULL), m_RequestsCount(0), m_MaxRequestsCount(0),
+      m_Backlog(NULL), m_Parsing(false), m_ReadPaused(false)
 {
     m_HttpState.headers.prevstate = PSTATE_NOTHING;
 
+    m_File.fd        = -1;
+    m_File.offset    = 0;
+    m_File.remaining = 0;
+    m_File.secure    = false;
+    m_File.close     = false;
+
     m_HttpState.headers.list = NULL;
     m_HttpState.headers.tkey = NULL;
     m_HttpState.headers.tval = NULL;
@@ -425,12 +531,60 @@ HTTPClientConnection::HTTPClientConnection(HTTPServer *httpserver,
     http_parser_init(&m_HttpState.parser, HTTP_REQUEST);
     m_HttpState.parser.data = this;
 
-    ape_timer_t *timer = APE_timer_create(
-        socket->ape, 1000, HTTPClientConnection_checktimeout, this);
+    m_LastAcitivty = Utils::GetTick(true);
+
+    this->armTimeout(m_ClientTimeoutMs);
+}
 
-    m_TimeoutTimer = APE_timer_getid(timer);
+void HTTPClientConnection::setTimeout(int val)
+{
+    m_ClientTimeoutMs = val;
 
-    m_LastAcitivty = Utils::GetTick(true);
+    this->armTimeout(val);
+}
+
+void HTTPClientConnection::armTimeout(uint64_t delay)
+{
+    if (!m_HTTPServer) {
+        return;
+    }
+
+    TimerWheel *wheel = m_HTTPServer->getIdleTimers();
+
+    /*
+        Never timeout if set to 0
+    */
+    if (m_ClientTimeoutMs <= 0) {
+        wheel->remove(this);
+        return;
+    }
+
+    wheel->add(this, delay);
+}
+
+void HTTPClientConnection::onExpire()
+{
+    /* The timeout was disabled without disarming the entry */
+    if (m_ClientTimeoutMs <= 0) {
+        return;
+    }
+
+    uint64_t idle = Utils::GetTick(true) - m_LastAcitivty;
+
+    /* Reads paused by the application : not the client's fault */
+    if (m_ReadPaused) {
+        idle = 0;
+    }
+
+    if (idle < static_cast<uint64_t>(m_ClientTimeoutMs)) {
+        /* There was some activity meanwhile */
+        this->armTimeout(m_ClientTimeoutMs - idle);
+        return;
+    }
+
+    /* Idle, or stopped reading the file being sent */
+    this->stopFile();
+    this->close();
 }
 
 void HTTPClientConnection::onRead(const char *data, size_t len, ape_global *ape)
@@ -440,8 +594,26 @@ void HTTPClientConnection::onRead(const char *data, size_t len, ape_global *ape)
 
     m_LastAcitivty = Utils::GetTick(true);
 
-    int nparsed
+    m_Parsing = true;
+    size_t nparsed
         = http_parser_execute(&m_HttpState.parser, &settings, data, len);
+    m_Parsing = false;
+
+    /*
+        A file is being sent or the reads are paused, hold the
+        next data until it's done
+    */
+    if (HTTP_PARSER_ERRNO(&m_HttpState.parser) == HPE_PAUSED) {
+        if (nparsed < len) {
+            if (m_Backlog == NULL) {
+                m_Backlog = buffer_new(len - nparsed);
+            }
+            buffer_append_data(m_Backlog,
+                reinterpret_cast<const unsigned char *>(&data[nparsed]),
+                len - nparsed);
+        }
+        return;
+    }
 
     if (m_HttpState.parser.upgrade) {
         buffer *upgrade_header = REQUEST_HEADER("upgrade");
@@ -466,11 +638,200 @@ void HTTPClientConnection::onRead(const char *data, size_t len, ape_global *ape)
 
 void HTTPClientConnection::close()
 {
+    if (this->isSendingFile()) {
+        m_File.close = true;
+        return;
+    }
+
     if (m_SocketClient) {
         APE_socket_shutdown(m_SocketClient);
     }
 }
 
+void HTTPClientConnection::sendFile(int fd, off_t offset, uint64_t length)
+{
+    this->stopFile();
+
+    m_File.fd        = fd;
+    m_File.offset    = offset;
+    m_File.remaining = length;
+    m_File.secure    = m_HTTPServer && m_HTTPServer->isSecure();
+    m_File.close     = false;
+
+    http_parser_pause(&m_HttpState.parser, 1);
+
+    this->flushFile();
+}
+
+void HTTPClientConnection::stopFile()
+{
+    if (m_File.fd == -1) {
+        return;
+    }
+
+    ::close(m_File.fd);
+
+    m_File.fd        = -1;
+    m_File.remaining = 0;
+}
+
+void HTTPClientConnection::onDrain()
+{
+    if (this->isSendingFile()) {
+        m_LastAcitivty = Utils::GetTick(true);
+        this->flushFile();
+    }
+}
+
+/*
+    Send the file until the socket would block.
+    APE calls on_drain once the socket is writable again :
+     - after the data it queued (e.g. the headers) is written
+     - after a write returned EAGAIN (the socket is flagged as such)
+*/
+void HTTPClientConnection::flushFile()
+{
+    ape_socket *s = m_SocketClient;
+
+    if (s == NULL || !this->isSendingFile()) {
+        return;
+    }
+
+    /* The headers (or a previous response) are still queued */
+    if (s->states.flags & APE_SOCKET_WOULD_BLOCK) {
+        return;
+    }
+
+    while (m_File.remaining) {
+        size_t chunk = m_File.remaining > HTTP_SENDFILE_CHUNK
+                           ? HTTP_SENDFILE_CHUNK
+                           : m_File.remaining;
+        ssize_t nwrite;
+
+#ifdef __linux__
+        if (!m_File.secure) {
+            nwrite = sendfile(s->s.fd, m_File.fd, &m_File.offset, chunk);
+
+            if (nwrite == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                s->states.flags |= APE_SOCKET_WOULD_BLOCK;
+                return;
+            }
+        } else
+#endif
+        {
+            /*
+                TLS (or no sendfile()) : the data goes through APE
+            */
+            char *buf = static_cast<char *>(malloc(chunk));
+
+            nwrite = pread(m_File.fd, buf, chunk, m_File.offset);
+
+            if (nwrite > 0) {
+                m_File.offset += nwrite;
+                APE_socket_write(s, buf, nwrite, APE_DATA_AUTORELEASE);
+            } else {
+                free(buf);
+            }
+        }
+
+        if (nwrite <= 0) {
+            /* I/O error or file truncated : the response can't be completed */
+            ndm_logf(NDM_LOG_ERROR, "HTTPServer", "sendFile() failed : %s",
+                     nwrite == 0 ? "unexpected end of file" : strerror(errno));
+
+            this->stopFile();
+            APE_socket_shutdown_now(s);
+            return;
+        }
+
+        m_File.remaining -= nwrite;
+
+        if (m_File.remaining && (s->states.flags & APE_SOCKET_WOULD_BLOCK)) {
+            return;
+        }
+    }
+
+    bool close = m_File.close || this->shouldCloseConnection();
+
+    this->stopFile();
+
+    if (close) {
+        this->close();
+        return;
+    }
+
+    if (m_ReadPaused) {
+        return;
+    }
+
+    /* Process the requests received in the meantime */
+    http_parser_pause(&m_HttpState.parser, 0);
+
+    if (!m_Parsing) {
+        this->parseBacklog();
+    }
+}
+
+void HTTPClientConnection::pauseReading()
+{
+    if (m_ReadPaused) {
+        return;
+    }
+
+    m_ReadPaused = true;
+
+    http_parser_pause(&m_HttpState.parser, 1);
+
+    if (m_SocketClient) {
+        HTTPServer_SetReading(m_SocketClient, false);
+    }
+}
+
+void HTTPClientConnection::resumeReading()
+{
+    if (!m_ReadPaused) {
+        return;
+    }
+
+    m_ReadPaused   = false;
+    m_LastAcitivty = Utils::GetTick(true);
+
+    if (m_SocketClient) {
+        HTTPServer_SetReading(m_SocketClient, true);
+    }
+
+    /* The parser stays paused until the file is sent */
+    if (this->isSendingFile()) {
+        return;
+    }
+
+    http_parser_pause(&m_HttpState.parser, 0);
+
+    /*
+        Parse what was received while paused (unless we are called
+        from a parser callback, the backlog is empty in this case)
+    */
+    if (!m_Parsing) {
+        this->parseBacklog();
+    }
+}
+
+void HTTPClientConnection::parseBacklog()
+{
+    buffer *backlog = m_Backlog;
+
+    if (backlog == NULL || m_SocketClient == NULL) {
+        return;
+    }
+
+    m_Backlog = NULL;
+
+    this->onRead(reinterpret_cast<const char *>(backlog->data), backlog->used,
+                 m_SocketClient->ape);
+
+    buffer_destroy(backlog);
+}
+
 void HTTPClientConnection::write(char *buf, size_t len)
 {
     APE_socket_write(m_SocketClient, buf, len, APE_DATA_COPY);
@@ -490,6 +851,10 @@ HTTPResponse *HTTPClientConnection::onCreateResponse()
 
 void HTTPClientConnection::dettach()
 {
+    if (m_HTTPServer) {
+        m_HTTPServer->getIdleTimers()->remove(this);
+    }
+
     m_HTTPServer = nullptr;
 
     if (m_SocketClient) {
@@ -501,12 +866,8 @@ void HTTPClientConnection::dettach()
 
 HTTPClientConnection::~HTTPClientConnection()
 {
-    if (m_TimeoutTimer) {
-        ape_global *ape = Binding::NidiumJS::GetNet();
-
-        APE_timer_clearbyid(ape, m_TimeoutTimer, 1);
-
-        m_TimeoutTimer = 0;
+    if (m_HTTPServer) {
+        m_HTTPServer->getIdleTimers()->remove(this);
     }
 
     if (m_HttpState.headers.list) {
@@ -521,6 +882,12 @@ HTTPClientConnection::~HTTPClientConnection()
         buffer_destroy(m_HttpState.url);
     }
 
+    if (m_Backlog) {
+        buffer_destroy(m_Backlog);
+    }
+
+    this->stopFile();
+
     if (m_Response) {
         delete m_Response;
     }
@@ -541,7 +908,8 @@ HTTPClientConnection::~HTTPClientConnection()
 
 HTTPResponse::HTTPResponse(uint16_t code)
     : m_Headers(ape_array_new(8)), m_Statuscode(code), m_Content(NULL),
-      m_Headers_str(NULL), m_HeaderSent(false), m_Chunked(false)
+      m_Headers_str(NULL), m_HeaderSent(false), m_Chunked(false),
+      m_ContentLength(-1)
 {
     this->setHeader("Server", "nidium/" NIDIUM_VERSION_STR);
 }
@@ -590,7 +958,8 @@ void HTTPResponse::sendChunk(char *buf,
                              ape_socket_data_autorelease datatype,
                              bool willEnd)
 {
-    if (!m_Con || m_Con->getSocket() == NULL || !len) {
+    if (!m_Con || m_Con->getSocket() == NULL || !len
+        || m_Con->isSendingFile()) {
         return;
     }
 
@@ -627,7 +996,7 @@ void HTTPResponse::sendChunk(char *buf,
 
 void HTTPResponse::send(ape_socket_data_autorelease datatype)
 {
-    if (!m_Con || m_Con->getSocket() == NULL) {
+    if (!m_Con || m_Con->getSocket() == NULL || m_Con->isSendingFile()) {
         return;
     }
 
@@ -636,7 +1005,23 @@ void HTTPResponse::send(ape_socket_data_autorelease datatype)
     const buffer *data = this->getDataBuffer();
 
     if (!m_HeaderSent) {
-        const buffer &headers = this->getHeadersString();
+        /* Small bodies are sent along with the headers in a single write */
+        size_t inline_len
+            = data && data->used <= HTTP_INLINE_BODY_MAX ? data->used : 0;
+
+        const buffer &headers = this->buildHeaders(inline_len);
+
+        if (inline_len) {
+            buffer_append_string_n(m_Headers_str,
+                                   reinterpret_cast<char *>(data->data),
+                                   inline_len);
+
+            if (datatype == APE_DATA_AUTORELEASE) {
+                free(data->data);
+            }
+
+            data = NULL;
+        }
 
         APE_socket_write(m_Con->getSocket(), headers.data, headers.used,
                          APE_DATA_AUTORELEASE);
@@ -662,6 +1047,165 @@ void HTTPResponse::send(ape_socket_data_autorelease datatype)
     }
 }
 
+/*
+    Parse a single range "Range: bytes=start-end" header.
+    Returns 1 if |start| and |len| were set, -1 if the range can't be
+    satisfied and 0 if the header must be ignored (invalid or multiple
+    ranges : the whole file is sent).
+*/
+static int HTTPServer_ParseRange(const char *header,
+                                 uint64_t size,
+                                 uint64_t *start,
+                                 uint64_t *len)
+{
+    const char *p = header;
+    char *end;
+    uint64_t first, last;
+
+    if (strncasecmp(p, "bytes=", 6) != 0 || strchr(p, ',') != NULL) {
+        return 0;
+    }
+
+    p += 6;
+
+    while (*p == ' ') {
+        p++;
+    }
+
+    if (*p == '-') {
+        /* Suffix range : the last N bytes */
+        uint64_t suffix = strtoull(p + 1, &end, 10);
+        if (end == p + 1 || *end != '\0') {
+            return 0;
+        }
+        if (suffix == 0 || size == 0) {
+            return -1;
+        }
+
+        first = size > suffix ? size - suffix : 0;
+        last  = size - 1;
+    } else {
+        first = strtoull(p, &end, 10);
+        if (end == p || *end != '-') {
+            return 0;
+        }
+
+        p = end + 1;
+
+        if (*p == '\0') {
+            last = size - 1;
+        } else {
+            last = strtoull(p, &end, 10);
+            if (*end != '\0' || last < first) {
+                return 0;
+            }
+            if (last >= size) {
+                last = size - 1;
+            }
+        }
+
+        if (first >= size) {
+            return -1;
+        }
+    }
+
+    *start = first;
+    *len   = last - first + 1;
+
+    return 1;
+}
+
+bool HTTPResponse::sendFile(const char *path, off_t offset, int64_t length)
+{
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+
+    if (fd == -1) {
+        return false;
+    }
+
+    return this->sendFile(fd, offset, length);
+}
+
+bool HTTPResponse::sendFile(int fd, off_t offset, int64_t length)
+{
+    struct stat st;
+    char tmpbuf[128];
+
+    if (!m_Con || m_Con->getSocket() == NULL || m_HeaderSent
+        || m_Con->isSendingFile() || fstat(fd, &st) == -1
+        || !S_ISREG(st.st_mode) || offset < 0 || offset > st.st_size) {
+
+        close(fd);
+        return false;
+    }
+
+    uint64_t size = st.st_size;
+    uint64_t len  = length < 0 ? size - offset : length;
+
+    if (offset + len > size) {
+        len = size - offset;
+    }
+
+    /* The whole file is requested : honour the client Range header */
+    if (offset == 0 && length < 0) {
+        const char *range = m_Con->getHeader("range");
+        uint64_t start;
+
+        this->setHeader("Accept-Ranges", "bytes");
+
+        switch (range ? HTTPServer_ParseRange(range, size, &start, &len)
+                      : 0) {
+            case 1:
+                offset = start;
+
+                sprintf(tmpbuf, "bytes %" PRIu64 "-%" PRIu64 "/%" PRIu64,
+                        start, start + len - 1, size);
+
+                this->setStatusCode(206);
+                this->setHeader("Content-Range", tmpbuf);
+                break;
+            case -1:
+                sprintf(tmpbuf, "bytes */%" PRIu64, size);
+
+                this->setStatusCode(416);
+                this->setHeader("Content-Range", tmpbuf);
+
+                close(fd);
+                this->send();
+
+                return true;
+            default:
+                len = size;
+                break;
+        }
+    }
+
+    m_Chunked       = false;
+    m_ContentLength = len;
+
+    int sfd = m_Con->getSocket()->s.fd;
+
+    /* Headers and the beginning of the file in the same packet */
+    PACK_TCP(sfd);
+
+    this->sendHeaders();
+
+    /* No body for HEAD requests */
+    if (len == 0 || m_Con->getHTTPState()->parser.method == HTTP_HEAD) {
+        FLUSH_TCP(sfd);
+        close(fd);
+        this->end();
+
+        return true;
+    }
+
+    m_Con->sendFile(fd, offset, len);
+
+    FLUSH_TCP(sfd);
+
+    return true;
+}
+
 void HTTPResponse::end()
 {
     if (!m_Con || m_Con->getSocket() == NULL) {
@@ -705,58 +1249,127 @@ void HTTPResponse::setData(char *buf, size_t len)
     m_Content->size = m_Content->used = len;
 }
 
+static bool HTTPServer_IsHeader(const buffer *k, const char *name, size_t len)
+{
+    return k->used == len
+           && strncasecmp(reinterpret_cast<const char *>(k->data), name, len)
+                  == 0;
+}
+
 const buffer &HTTPResponse::getHeadersString()
 {
-    if (m_Headers_str == NULL) {
-        m_Headers_str = buffer_new(512);
-    } else {
-        m_Headers_str->used = 0;
-    }
+    return this->buildHeaders(0);
+}
 
-    char tmpbuf[32];
-    sprintf(tmpbuf, "HTTP/1.1 %u ", m_Statuscode);
+/*
+    The headers computed for every response (Date, Content-Length,
+    Connection, Transfer-Encoding) are written straight into the buffer
+    instead of being inserted in m_Headers. The size is computed first so
+    that everything (plus |extra| bytes of body) fits in one allocation.
+*/
+const buffer &HTTPResponse::buildHeaders(size_t extra)
+{
+#define HEADER_APPEND(str, len) \
+    buffer_append_string_n(m_Headers_str, str, len)
 
-    buffer_append_string(m_Headers_str, tmpbuf);
-    buffer_append_string(m_Headers_str, this->getStatusDesc());
+    const HTTPCode *code = HTTPServer_GetCode(m_Statuscode);
+    char statusbuf[64];
+    const char *status;
+    size_t statuslen;
 
-    char httpdate[256];
-    Utils::HTTPTime(httpdate);
+    if (code) {
+        status    = code->line;
+        statuslen = code->linelen;
+    } else {
+        statuslen = sprintf(statusbuf, "HTTP/1.1 %u Unknown\r\n", m_Statuscode);
+        status    = statusbuf;
+    }
 
-    this->setHeader("Date", httpdate);
+    const char *date;
+    size_t datelen = HTTPServer_GetDate(&date);
 
-    buffer_append_string_n(m_Headers_str, CONST_STR_LEN("\r\n"));
+    char clen[32];
+    size_t clenlen = 0;
 
     if (!m_Chunked) {
-        if (m_Content && m_Content->used) {
-            sprintf(tmpbuf, "%zu", m_Content->used);
-            this->setHeader("Content-Length", tmpbuf);
+        if (m_ContentLength != -1) {
+            clenlen = sprintf(clen, "%" PRId64, m_ContentLength);
         } else {
-            this->setHeader("Content-Length", "0");
+            clenlen = sprintf(clen, "%zu",
+                              m_Content && m_Content->used ? m_Content->used : 0);
         }
-    } else {
-        this->setHeader("Transfer-Encoding", "chunked");
-        this->removeHeader("Content-Length");
     }
 
-    if (m_Con && m_Con->shouldCloseConnection()) {
-        this->setHeader("Connection", "close");
-    }
+    bool close = m_Con && m_Con->shouldCloseConnection();
+
+    size_t size = statuslen + datelen + clenlen + extra
+                  + sizeof("Date: \r\n") + sizeof("Content-Length: \r\n")
+                  + sizeof("Transfer-Encoding: chunked\r\n")
+                  + sizeof("Connection: close\r\n") + 2;
 
     buffer *k, *v;
-    if (this->getHeaders()) {
-        APE_A_FOREACH(this->getHeaders(), k, v)
+
+#define SKIP_HEADER(k)                                                 \
+    (HTTPServer_IsHeader(k, CONST_STR_LEN("Date"))                     \
+     || HTTPServer_IsHeader(k, CONST_STR_LEN("Content-Length"))        \
+     || (m_Chunked                                                     \
+         && HTTPServer_IsHeader(k, CONST_STR_LEN("Transfer-Encoding"))) \
+     || (close && HTTPServer_IsHeader(k, CONST_STR_LEN("Connection"))))
+
+    if (m_Headers) {
+        APE_A_FOREACH(m_Headers, k, v)
         {
-            buffer_append_string_n(m_Headers_str,
-                                   reinterpret_cast<char *>(k->data), k->used);
-            buffer_append_string_n(m_Headers_str, ": ", 2);
-            buffer_append_string_n(m_Headers_str,
-                                   reinterpret_cast<char *>(v->data), v->used);
-            buffer_append_string_n(m_Headers_str, CONST_STR_LEN("\r\n"));
+            size += k->used + v->used + 4;
         }
+    }
+
+    if (m_Headers_str && m_Headers_str->size < size) {
+        buffer_destroy(m_Headers_str);
+        m_Headers_str = NULL;
+    }
+
+    if (m_Headers_str == NULL) {
+        m_Headers_str = buffer_new(size);
     } else {
-        buffer_append_string_n(m_Headers_str, CONST_STR_LEN("\r\n"));
+        m_Headers_str->used = 0;
+    }
+
+    HEADER_APPEND(status, statuslen);
+
+    HEADER_APPEND(CONST_STR_LEN("Date: "));
+    HEADER_APPEND(date, datelen);
+    HEADER_APPEND(CONST_STR_LEN("\r\n"));
+
+    if (!m_Chunked) {
+        HEADER_APPEND(CONST_STR_LEN("Content-Length: "));
+        HEADER_APPEND(clen, clenlen);
+        HEADER_APPEND(CONST_STR_LEN("\r\n"));
+    } else {
+        HEADER_APPEND(CONST_STR_LEN("Transfer-Encoding: chunked\r\n"));
+    }
+
+    if (close) {
+        HEADER_APPEND(CONST_STR_LEN("Connection: close\r\n"));
+    }
+
+    if (m_Headers) {
+        APE_A_FOREACH(m_Headers, k, v)
+        {
+            if (SKIP_HEADER(k)) {
+                continue;
+            }
+
+            HEADER_APPEND(reinterpret_cast<char *>(k->data), k->used);
+            HEADER_APPEND(": ", 2);
+            HEADER_APPEND(reinterpret_cast<char *>(v->data), v->used);
+            HEADER_APPEND(CONST_STR_LEN("\r\n"));
+        }
     }
-    buffer_append_string_n(m_Headers_str, CONST_STR_LEN("\r\n"));
+
+    HEADER_APPEND(CONST_STR_LEN("\r\n"));
+
+#undef SKIP_HEADER
+#undef HEADER_APPEND
 
     return *m_Headers_str;
 }
@@ -768,13 +1381,9 @@ const buffer *HTTPResponse::getDataBuffer()
 
 const char *HTTPResponse::getStatusDesc() const
 {
-    for (int i = 0; HTTPCodes[i].desc != NULL; i++) {
-        if (HTTPCodes[i].code == m_Statuscode) {
-            return HTTPCodes[i].desc;
-        }
-    }
+    const HTTPCode *code = HTTPServer_GetCode(m_Statuscode);
 
-    return "Unknown";
+    return code ? code->desc : "Unknown";
 }
 
 void HTTPResponse::dataOwnershipTransfered(bool onlyHeaders)
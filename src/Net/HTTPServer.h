@@ -7,6 +7,7 @@
 #define net_httpserver_h__
 
 #include <stdio.h>
+#include <sys/types.h>
 
 #include <http_parser.h>
 
@@ -16,10 +17,17 @@
 
 #include "Core/Messages.h"
 #include "Core/Events.h"
+#include "Net/TimerWheel.h"
 
 #define HTTP_MAX_CL (1024ULL * 1024ULL * 1024ULL * 2ULL)
 #define HTTP_DEFAULT_TIMEOUT 15000
 
+/* Bodies up to this size are copied after the headers (single write) */
+#define HTTP_INLINE_BODY_MAX 4096
+
+/* Maximum number of bytes of a file sent per sendfile() call */
+#define HTTP_SENDFILE_CHUNK (256 * 1024)
+
 namespace Nidium {
 namespace Net {
 
@@ -68,6 +76,12 @@ public:
     */
     virtual void onClientConnect(HTTPClientConnection *client){};
     virtual void onClientDisconnect(HTTPClientConnection *client){};
+
+    /*
+        Headers of a request received (streaming mode only).
+        The response is already created, the body follows with onData().
+    */
+    virtual void onHeaders(HTTPClientConnection *client){};
     virtual void
     onData(HTTPClientConnection *client, const char *buf, size_t len){};
 
@@ -87,8 +101,35 @@ public:
         return m_IP;
     }
 
+    bool isSecure() const
+    {
+        return m_Secure;
+    }
+
+    /*
+        In streaming mode, request bodies are only handed to onData() as
+        they are received instead of being accumulated in HTTPData::data
+        (getData() stays NULL).
+    */
+    void setStreaming(bool enable)
+    {
+        m_Streaming = enable;
+    }
+
+    bool isStreaming() const
+    {
+        return m_Streaming;
+    }
+
     void shutdownClients();
 
+    /*
+        Idle timeouts of the client connections
+    */
+    TimerWheel *getIdleTimers()
+    {
+        return &m_IdleTimers;
+    }
 
     std::unordered_map<HTTPClientConnection *, HTTPClientConnection *> m_ClientConnections;
 private:
@@ -96,14 +137,13 @@ private:
     ape_socket *m_Socket;
     char *m_IP;
     uint16_t m_Port;
-
+    bool m_Secure;
+    bool m_Streaming;
+    TimerWheel m_IdleTimers;
 };
 // }}}
 
 //  {{{ HTTPResponse
-/*
-    TODO: add APE_socket_sendfile() support
-*/
 class HTTPResponse
 {
 public:
@@ -147,6 +187,21 @@ public:
         |datatype| defines how data ownership is managed
     */
     void send(ape_socket_data_autorelease datatype = APE_DATA_AUTORELEASE);
+
+    /*
+        Send the headers followed by |length| bytes of the file
+        starting at |offset| (up to the end of the file if |length| is -1).
+        The body is sent by the kernel (sendfile()) as the socket drains.
+
+        When the whole file is sent, the Range header of the
+        request is honoured (206 or 416 responses).
+
+        |fd| is closed once sent (or on failure).
+        Returns false if the file can't be sent.
+    */
+    bool sendFile(int fd, off_t offset = 0, int64_t length = -1);
+    bool sendFile(const char *path, off_t offset = 0, int64_t length = -1);
+
     void sendHeaders(bool chunked = false);
     void end();
     bool isHeadersAlreadySent() const
@@ -162,12 +217,19 @@ public:
     void dataOwnershipTransfered(bool onlyHeaders = false);
 
 private:
+    /*
+        Build the headers in a buffer with room for |extra| more bytes
+    */
+    const buffer &buildHeaders(size_t extra);
+
     ape_array_t *m_Headers;
     uint16_t m_Statuscode;
     buffer *m_Content;
     buffer *m_Headers_str;
     bool m_HeaderSent;
     bool m_Chunked;
+    /* Content-Length of a body that isn't in m_Content (-1 if none) */
+    int64_t m_ContentLength;
 
     HTTPClientConnection *m_Con;
 
@@ -177,7 +239,7 @@ protected:
 // }}}
 
 // {{{ HTTPClientConnection
-class HTTPClientConnection
+class HTTPClientConnection : public TimerWheelEntry
 {
 public:
     HTTPClientConnection(HTTPServer *httpserver, ape_socket *socket);
@@ -245,6 +307,37 @@ public:
 
     void onRead(const char *data, size_t len, ape_global *ape);
     void write(char *buf, size_t len);
+
+    /*
+        Send |length| bytes of |fd| from |offset| once the pending
+        writes are flushed. |fd| is closed once sent.
+        The next requests are held until the whole file is sent.
+    */
+    void sendFile(int fd, off_t offset, uint64_t length);
+    void stopFile();
+    bool isSendingFile() const
+    {
+        return m_File.fd != -1;
+    }
+
+    /*
+        Stop reading the request : the parser stops right after the
+        current callback and the socket isn't polled for reading anymore,
+        letting TCP flow control slow the client down (responses are
+        still sent). Data already read is kept unparsed until
+        resumeReading().
+    */
+    void pauseReading();
+    void resumeReading();
+    bool isReadingPaused() const
+    {
+        return m_ReadPaused;
+    }
+
+    /*
+        The socket can be written again
+    */
+    void onDrain();
     void setContext(void *arg)
     {
         m_Ctx = arg;
@@ -259,10 +352,10 @@ public:
         return m_Response;
     }
 
-    void setTimeout(int val)
-    {
-        m_ClientTimeoutMs = val;
-    }
+    /*
+        Close the connection after |val| ms without activity (0 to never)
+    */
+    void setTimeout(int val);
 
     uint64_t getTimeoutAfterMs() const
     {
@@ -298,12 +391,28 @@ public:
     virtual HTTPResponse *onCreateResponse();
 
     virtual void onHeaderEnded(){};
+
+    /*
+        A new request starts : the headers of the previous one are about
+        to be destroyed (subclasses can take them over)
+    */
+    virtual void onRequestBegin(){};
     virtual void onDisconnect(ape_global *ape){};
     virtual void onUpgrade(const char *to){};
     virtual void onContent(const char *data, size_t len){};
 
+    /*
+        The connection is closed once the file being sent (if any)
+        is done
+    */
     virtual void close();
 
+    /*
+        The idle timeout elapsed since the connection was armed, check
+        the actual last activity (it isn't re-armed on every read)
+    */
+    void onExpire() override;
+
     void _createResponse()
     {
         HTTPResponse *resp = onCreateResponse();
@@ -321,11 +430,29 @@ protected:
     ape_socket *m_SocketClient;
     HTTPServer *m_HTTPServer;
     HTTPResponse *m_Response;
-    uint64_t m_TimeoutTimer;
     uint64_t m_LastAcitivty;
     int m_ClientTimeoutMs;
     uint64_t m_RequestsCount;
     uint64_t m_MaxRequestsCount;
+
+private:
+    void flushFile();
+    void parseBacklog();
+    void armTimeout(uint64_t delay);
+
+    struct
+    {
+        int fd;
+        off_t offset;
+        uint64_t remaining;
+        bool secure;
+        bool close;
+    } m_File;
+
+    /* Data received while the parser is paused */
+    buffer *m_Backlog;
+    bool m_Parsing;
+    bool m_ReadPaused;
 };
 // }}}
 
@@ -0,0 +1,166 @@
+/*
+   Copyright 2016 Nidium Inc. All rights reserved.
+   Use of this source code is governed by a MIT license
+   that can be found in the LICENSE file.
+*/
+#include "Net/TimerWheel.h"
+
+namespace Nidium {
+namespace Net {
+
+// {{{ TimerWheelEntry
+TimerWheelEntry::~TimerWheelEntry()
+{
+    if (m_Wheel) {
+        m_Wheel->remove(this);
+    }
+}
+// }}}
+
+// {{{ TimerWheel
+TimerWheel::TimerWheel(ape_global *net) : m_Net(net), m_Cursor(0), m_Timer(0)
+{
+    m_Stats = {};
+
+    for (int i = 0; i < TIMER_WHEEL_SLOTS; i++) {
+        m_Slots[i].m_Prev = m_Slots[i].m_Next = &m_Slots[i];
+    }
+}
+
+TimerWheel::~TimerWheel()
+{
+    for (int i = 0; i < TIMER_WHEEL_SLOTS; i++) {
+        TimerWheelEntry *head = &m_Slots[i];
+
+        while (head->m_Next != head) {
+            TimerWheelEntry *entry = head->m_Next;
+
+            Unlink(entry);
+            entry->m_Wheel = nullptr;
+        }
+    }
+
+    if (m_Timer) {
+        APE_timer_clearbyid(m_Net, m_Timer, 1);
+    }
+}
+
+void TimerWheel::Unlink(TimerWheelEntry *entry)
+{
+    entry->m_Prev->m_Next = entry->m_Next;
+    entry->m_Next->m_Prev = entry->m_Prev;
+
+    entry->m_Prev = entry->m_Next = nullptr;
+}
+
+void TimerWheel::Append(TimerWheelEntry *head, TimerWheelEntry *entry)
+{
+    entry->m_Prev = head->m_Prev;
+    entry->m_Next = head;
+
+    head->m_Prev->m_Next = entry;
+    head->m_Prev         = entry;
+}
+
+void TimerWheel::add(TimerWheelEntry *entry, uint64_t delay)
+{
+    if (entry->m_Wheel) {
+        entry->m_Wheel->remove(entry);
+    }
+
+    /*
+        The next tick can happen anytime before TIMER_WHEEL_TICK,
+        round up so that the entry never expires early
+    */
+    uint64_t ticks = delay / TIMER_WHEEL_TICK + 1;
+
+    entry->m_Rounds = (ticks - 1) / TIMER_WHEEL_SLOTS;
+    entry->m_Wheel  = this;
+
+    Append(&m_Slots[(m_Cursor + ticks) % TIMER_WHEEL_SLOTS], entry);
+
+    m_Stats.armed++;
+
+    if (!m_Timer) {
+        ape_timer_t *timer
+            = APE_timer_create(m_Net, TIMER_WHEEL_TICK, TimerWheel::Tick, this);
+        APE_timer_unprotect(timer);
+
+        m_Timer = APE_timer_getid(timer);
+    }
+}
+
+void TimerWheel::remove(TimerWheelEntry *entry)
+{
+    if (entry->m_Wheel != this) {
+        return;
+    }
+
+    Unlink(entry);
+
+    entry->m_Wheel = nullptr;
+    m_Stats.armed--;
+}
+
+int TimerWheel::Tick(void *arg)
+{
+    TimerWheel *wheel = static_cast<TimerWheel *>(arg);
+
+    wheel->tick();
+
+    /* The timer is recreated by the next add() */
+    if (wheel->m_Stats.armed == 0) {
+        wheel->m_Timer = 0;
+        return 0;
+    }
+
+    return TIMER_WHEEL_TICK;
+}
+
+void TimerWheel::tick()
+{
+    m_Cursor = (m_Cursor + 1) % TIMER_WHEEL_SLOTS;
+    m_Stats.ticks++;
+
+    TimerWheelEntry *slot = &m_Slots[m_Cursor];
+
+    if (slot->m_Next == slot) {
+        return;
+    }
+
+    /*
+        Detach the slot first : onExpire() can re-arm entries (possibly
+        in this very slot) or delete the ones not visited yet
+    */
+    Head pending;
+    pending.m_Next         = slot->m_Next;
+    pending.m_Prev         = slot->m_Prev;
+    pending.m_Next->m_Prev = &pending;
+    pending.m_Prev->m_Next = &pending;
+
+    slot->m_Prev = slot->m_Next = slot;
+
+    while (pending.m_Next != &pending) {
+        TimerWheelEntry *entry = pending.m_Next;
+
+        Unlink(entry);
+
+        if (entry->m_Rounds) {
+            entry->m_Rounds--;
+            m_Stats.skipped++;
+
+            Append(slot, entry);
+            continue;
+        }
+
+        entry->m_Wheel = nullptr;
+        m_Stats.armed--;
+        m_Stats.expired++;
+
+        entry->onExpire();
+    }
+}
+// }}}
+
+} // namespace Net
+} // namespace Nidium
@@ -0,0 +1,125 @@
+/*
+   Copyright 2016 Nidium Inc. All rights reserved.
+   Use of this source code is governed by a MIT license
+   that can be found in the LICENSE file.
+*/
+#ifndef net_timerwheel_h__
+#define net_timerwheel_h__
+
+#include <stdint.h>
+
+#include <ape_netlib.h>
+
+/* Duration of a tick (ms) */
+#define TIMER_WHEEL_TICK 1000
+
+/* Number of slots, timers further than that wait for more rounds */
+#define TIMER_WHEEL_SLOTS 64
+
+namespace Nidium {
+namespace Net {
+
+class TimerWheel;
+
+// {{{ TimerWheelEntry
+/*
+    Object that can be armed on a TimerWheel.
+    It's removed from its wheel when deleted.
+*/
+class TimerWheelEntry
+{
+public:
+    TimerWheelEntry()
+        : m_Prev(nullptr), m_Next(nullptr), m_Wheel(nullptr), m_Rounds(0)
+    {
+    }
+
+    virtual ~TimerWheelEntry();
+
+    bool isArmed() const
+    {
+        return m_Wheel != nullptr;
+    }
+
+    /*
+        The delay given to TimerWheel::add() elapsed.
+        The entry is disarmed and can be re-armed from there.
+    */
+    virtual void onExpire() = 0;
+
+    friend class TimerWheel;
+
+private:
+    TimerWheelEntry *m_Prev;
+    TimerWheelEntry *m_Next;
+    TimerWheel *m_Wheel;
+    uint32_t m_Rounds;
+};
+// }}}
+
+// {{{ TimerWheel
+/*
+    Hashed timing wheel : a single APE timer ticks every TIMER_WHEEL_TICK
+    ms and only visits the slot of the current tick. Arming or disarming
+    an entry is O(1), whatever the number of entries.
+
+    Meant for (large numbers of) coarse timeouts that are mostly pushed
+    back, such as idle timeouts : instead of re-arming on every activity,
+    entries check their own deadline when they expire and re-arm for the
+    remaining time.
+*/
+class TimerWheel
+{
+public:
+    struct Stats
+    {
+        /* Number of entries armed */
+        uint64_t armed;
+        uint64_t ticks;
+        /* Entries that reached their delay */
+        uint64_t expired;
+        /* Entries visited in a slot but not due yet (rounds left) */
+        uint64_t skipped;
+    };
+
+    explicit TimerWheel(ape_global *net);
+    ~TimerWheel();
+
+    /*
+        Arm |entry| to expire in |delay| ms (rounded up to the next tick).
+        The entry is moved if it was already armed.
+    */
+    void add(TimerWheelEntry *entry, uint64_t delay);
+    void remove(TimerWheelEntry *entry);
+
+    const Stats &getStats() const
+    {
+        return m_Stats;
+    }
+
+private:
+    static int Tick(void *arg);
+    void tick();
+
+    static void Unlink(TimerWheelEntry *entry);
+    static void Append(TimerWheelEntry *head, TimerWheelEntry *entry);
+
+    /* List heads of the slots (circular lists) */
+    class Head : public TimerWheelEntry
+    {
+    public:
+        void onExpire() override{};
+    };
+
+    ape_global *m_Net;
+    Head m_Slots[TIMER_WHEEL_SLOTS];
+    uint32_t m_Cursor;
+    uint64_t m_Timer;
+    Stats m_Stats;
+};
+// }}}
+
+} // namespace Net
+} // namespace Nidium
+
+#endif
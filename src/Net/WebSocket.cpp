@@ -63,7 +63,7 @@ WebSocketClientConnection::WebSocketClientConnection(HTTPServer *httpserver,
     : HTTPClientConnection(httpserver, socket), m_Handshaked(false),
       m_PingTimer(0), m_Data(NULL)
 {
-    m_ClientTimeoutMs = 0; /* Disable HTTP timeout */
+    this->setTimeout(0); /* Disable HTTP timeout */
     ape_ws_init(&m_WSState, 0);
     m_WSState.socket   = socket;
     m_WSState.on_frame = nidium_on_ws_frame;
@@ -28,6 +28,8 @@ namespace Server {
 Context::Context(ape_global *net, Worker *worker, bool jsstrict, bool runInREPL)
     : Core::Context(net), m_Worker(worker), m_RunInREPL(runInREPL)
 {
+    this->setStatsName("Server::Context");
+
     char cwd[PATH_MAX];
 
     memset(&cwd[0], '\0', sizeof(cwd));
@@ -78,6 +78,8 @@ repl:
 REPL::REPL(Nidium::Binding::NidiumJS *js)
     : m_JS(js), m_Continue(false), m_ExitCount(0)
 {
+    this->setStatsName("REPL");
+
     m_Buffer = buffer_new(512);
 
     sem_init(&m_ReadLineLock, 0, 0);
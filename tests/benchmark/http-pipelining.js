@@ -0,0 +1,80 @@
+/*
+   Copyright 2016 Nidium Inc. All rights reserved.
+   Use of this source code is governed by a MIT license
+   that can be found in the LICENSE file.
+*/
+
+/*
+    Bulk fetches against a local HTTP server.
+
+    COUNT small GET requests are run with a single HTTP instance and the
+    number of requests per second is measured with :
+     - sequential : a request is made once the previous response is
+                    received
+     - queued     : all the requests are queued at once, each one is sent
+                    once the previous response is received
+     - pipelined  : all the requests are queued at once and sent without
+                    waiting for the responses (pipeline option)
+*/
+
+var PORT = 8090;
+var COUNT = 5000;
+
+var MODES = ["sequential", "queued", "pipelined"];
+
+var server = new HTTPServer("127.0.0.1", PORT);
+
+server.onrequest = function(request, response) {
+    response.end("Hello World !");
+}
+
+function run(idx) {
+    if (idx == MODES.length) {
+        console.log("done");
+        return;
+    }
+
+    var mode = MODES[idx];
+    var received = 0;
+    var start = Date.now();
+
+    var h = new HTTP("http://127.0.0.1:" + PORT + "/",
+                     {pipeline: mode == "pipelined"});
+
+    h.addEventListener("error", function(ev) {
+        console.log("[" + mode + "] error " + ev.error);
+    });
+
+    h.addEventListener("response", function(ev) {
+        received++;
+
+        if (received == COUNT) {
+            var elapsed = (Date.now() - start) / 1000;
+
+            console.log("[" + mode + "] " + (COUNT / elapsed).toFixed(0) +
+                        " requests/s");
+            console.log("[" + mode + "] pool " +
+                        JSON.stringify(HTTP.getPoolStats()));
+
+            setTimeout(function() {
+                run(idx + 1);
+            }, 100);
+
+            return;
+        }
+
+        if (mode == "sequential") {
+            h.request();
+        }
+    });
+
+    if (mode == "sequential") {
+        h.request();
+    } else {
+        for (var i = 0; i < COUNT; i++) {
+            h.request();
+        }
+    }
+}
+
+run(0);
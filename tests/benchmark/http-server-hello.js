@@ -0,0 +1,112 @@
+/*
+   Copyright 2016 Nidium Inc. All rights reserved.
+   Use of this source code is governed by a MIT license
+   that can be found in the LICENSE file.
+*/
+
+/*
+    Hello world responses per second of HTTPServer.
+
+    CONNECTIONS raw sockets send GET requests on keep-alive connections
+    for DURATION ms (the client side is kept as cheap as possible so that
+    the server dominates) with :
+     - keepalive : one request in flight per connection
+     - pipelined : DEPTH requests in flight per connection
+
+    The response headers (status line, Date, Content-Length) are built
+    for every response, this is mostly what is measured.
+*/
+
+var PORT = 8091;
+var CONNECTIONS = 16;
+var DEPTH = 16;
+var DURATION = 5000;
+
+var BODY = "Hello World !";
+var REQUEST = "GET / HTTP/1.1\r\nHost: 127.0.0.1\r\n\r\n";
+
+var MODES = ["keepalive", "pipelined"];
+
+var server = new HTTPServer("127.0.0.1", PORT);
+
+server.onrequest = function(request, response) {
+    response.end(BODY);
+}
+
+/* Count the responses in a stream, a body may be split over two reads */
+function counter() {
+    var tail = "";
+
+    return function(data) {
+        var str = tail + data;
+        var count = 0;
+        var pos = 0;
+
+        while ((pos = str.indexOf(BODY, pos)) != -1) {
+            count++;
+            pos += BODY.length;
+        }
+
+        tail = str.slice(-(BODY.length - 1));
+
+        return count;
+    }
+}
+
+function run(idx) {
+    if (idx == MODES.length) {
+        console.log("done");
+        return;
+    }
+
+    var mode = MODES[idx];
+    var inflight = mode == "pipelined" ? DEPTH : 1;
+    var responses = 0;
+    var running = true;
+    var clients = [];
+    var start = Date.now();
+
+    function connect() {
+        var client = new Socket("127.0.0.1", PORT).connect();
+        var count = counter();
+
+        client.onconnect = function() {
+            client.write(REQUEST.repeat(inflight));
+        }
+
+        client.onread = function(data) {
+            var n = count(data);
+
+            responses += n;
+
+            if (running && n) {
+                client.write(REQUEST.repeat(n));
+            }
+        }
+
+        return client;
+    }
+
+    for (var i = 0; i < CONNECTIONS; i++) {
+        clients.push(connect());
+    }
+
+    setTimeout(function() {
+        running = false;
+
+        var elapsed = (Date.now() - start) / 1000;
+
+        console.log("[" + mode + "] " + (responses / elapsed).toFixed(0) +
+                    " responses/s");
+
+        clients.forEach(function(client) {
+            client.disconnect();
+        });
+
+        setTimeout(function() {
+            run(idx + 1);
+        }, 100);
+    }, DURATION);
+}
+
+run(0);
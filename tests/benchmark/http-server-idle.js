@@ -0,0 +1,122 @@
+/*
+   Copyright 2016 Nidium Inc. All rights reserved.
+   Use of this source code is governed by a MIT license
+   that can be found in the LICENSE file.
+*/
+
+/*
+    CPU used by HTTPServer to keep idle connections around.
+
+    For each run, CONNECTIONS raw sockets connect to the server and never
+    send anything. Once they are all connected, the CPU time used by the
+    process (process.getStats().cpu) is measured during WINDOW ms, that is
+    what it costs to watch the idle timeouts of the connections.
+
+    WINDOW must stay below the idle timeout of the connections (10s) so
+    that nothing gets closed during the measure.
+
+    Both sides of each connection live in this process : the file
+    descriptors limit must be raised first (ulimit -n 250000).
+*/
+
+var PORT = 8092;
+var RUNS = [0, 10000, 50000, 100000];
+var BATCH = 500;
+var SETTLE = 500;
+var WINDOW = 5000;
+
+var server = new HTTPServer("127.0.0.1", PORT);
+
+server.onrequest = function(request, response) {
+    response.end("");
+}
+
+function cpuTime() {
+    var cpu = process.getStats().cpu;
+
+    return cpu.user + cpu.system;
+}
+
+function run(idx) {
+    if (idx == RUNS.length) {
+        console.log("done");
+        return;
+    }
+
+    var count = RUNS[idx];
+    var clients = [];
+    /* Clients connected or that failed to */
+    var settled = 0;
+    var open = 0;
+    var measuring = false;
+
+    function measure() {
+        measuring = true;
+
+        var cpu = cpuTime();
+        var start = Date.now();
+
+        setTimeout(function() {
+            var elapsed = Date.now() - start;
+            var used = cpuTime() - cpu;
+
+            console.log("[" + count + "] " + open +
+                        " idle connections, " +
+                        (used * 100 / elapsed).toFixed(2) + "% CPU (" +
+                        used.toFixed(0) + "ms in " + elapsed + "ms)");
+
+            clients.forEach(function(client) {
+                client.disconnect();
+            });
+
+            setTimeout(function() {
+                run(idx + 1);
+            }, 1000);
+        }, WINDOW);
+    }
+
+    function settle() {
+        if (++settled == count) {
+            /* Let the server accept the last ones */
+            setTimeout(measure, SETTLE);
+        }
+    }
+
+    function onconnect() {
+        this.connected = true;
+        open++;
+        settle();
+    }
+
+    function ondisconnect() {
+        if (this.connected) {
+            open--;
+        } else if (!measuring) {
+            settle();
+        }
+    }
+
+    /* Don't overflow the listen backlog */
+    function connect() {
+        for (var i = 0; i < BATCH && clients.length < count; i++) {
+            var client = new Socket("127.0.0.1", PORT).connect();
+
+            client.onconnect = onconnect;
+            client.ondisconnect = ondisconnect;
+
+            clients.push(client);
+        }
+
+        if (clients.length < count) {
+            setTimeout(connect, 1);
+        }
+    }
+
+    if (count == 0) {
+        measure();
+    } else {
+        connect();
+    }
+}
+
+run(0);
@@ -0,0 +1,136 @@
+/*
+   Copyright 2016 Nidium Inc. All rights reserved.
+   Use of this source code is governed by a MIT license
+   that can be found in the LICENSE file.
+*/
+
+/*
+    Cost of the request objects handed to HTTPServer.onrequest.
+
+    CONNECTIONS raw sockets send GET requests with HEADERS headers on
+    keep-alive connections for DURATION ms. The handler :
+     - none : doesn't look at the request
+     - one  : reads a single header
+     - all  : reads every header (JSON.stringify(request.headers))
+
+    The request strings are created on access : the number of strings
+    created per request (server.getStats()) is compared to what building
+    the whole request upfront costs (every header, the url and the
+    method).
+*/
+
+var PORT = 8093;
+var CONNECTIONS = 16;
+var HEADERS = 12;
+var DURATION = 5000;
+
+var BODY = "ok";
+var REQUEST = "GET /some/path?with=query HTTP/1.1\r\nHost: 127.0.0.1\r\n";
+
+for (var i = 1; i < HEADERS; i++) {
+    REQUEST += "X-Header-" + i + ": value of the header " + i + "\r\n";
+}
+REQUEST += "\r\n";
+
+var EAGER = HEADERS + 2;
+
+var MODES = ["none", "one", "all"];
+var mode;
+
+var server = new HTTPServer("127.0.0.1", PORT);
+
+server.onrequest = function(request, response) {
+    switch (mode) {
+        case "one":
+            request.headers["x-header-1"];
+            break;
+        case "all":
+            JSON.stringify(request.headers);
+            break;
+    }
+
+    response.end(BODY);
+}
+
+/* Count the responses in a stream, a body may be split over two reads */
+function counter() {
+    var tail = "";
+
+    return function(data) {
+        var str = tail + data;
+        var count = 0;
+        var pos = 0;
+
+        while ((pos = str.indexOf("\r\n\r\n" + BODY, pos)) != -1) {
+            count++;
+            pos += BODY.length + 4;
+        }
+
+        tail = str.slice(-(BODY.length + 3));
+
+        return count;
+    }
+}
+
+function run(idx) {
+    if (idx == MODES.length) {
+        console.log("done");
+        return;
+    }
+
+    mode = MODES[idx];
+
+    var responses = 0;
+    var running = true;
+    var clients = [];
+    var start = Date.now();
+    var stats = server.getStats();
+
+    function connect() {
+        var client = new Socket("127.0.0.1", PORT).connect();
+        var count = counter();
+
+        client.onconnect = function() {
+            client.write(REQUEST);
+        }
+
+        client.onread = function(data) {
+            var n = count(data);
+
+            responses += n;
+
+            if (running && n) {
+                client.write(REQUEST.repeat(n));
+            }
+        }
+
+        return client;
+    }
+
+    for (var i = 0; i < CONNECTIONS; i++) {
+        clients.push(connect());
+    }
+
+    setTimeout(function() {
+        running = false;
+
+        var elapsed = (Date.now() - start) / 1000;
+        var now = server.getStats();
+        var requests = now.requests - stats.requests;
+        var strings = (now.strings - stats.strings) / requests;
+
+        console.log("[" + mode + "] " + (responses / elapsed).toFixed(0) +
+                    " responses/s, " + strings.toFixed(2) +
+                    " strings/request (" + EAGER + " when built upfront)");
+
+        clients.forEach(function(client) {
+            client.disconnect();
+        });
+
+        setTimeout(function() {
+            run(idx + 1);
+        }, 100);
+    }, DURATION);
+}
+
+run(0);
@@ -0,0 +1,84 @@
+/*
+   Copyright 2016 Nidium Inc. All rights reserved.
+   Use of this source code is governed by a MIT license
+   that can be found in the LICENSE file.
+*/
+
+/*
+    Stack LAYERS full-screen canvases, all repainted on every frame.
+    The scene is first run with transparent canvases (every layer is
+    composited), then with opaque canvases (only the top-most one is).
+*/
+
+var LAYERS = 64;
+var FRAMES = 300;
+
+var layers = [];
+
+for (var i = 0; i < LAYERS; i++) {
+    var canvas = new Canvas(window.innerWidth, window.innerHeight);
+    canvas.position = "absolute";
+    document.canvas.add(canvas);
+
+    layers.push({
+        canvas: canvas,
+        ctx: canvas.getContext("2d"),
+        hue: (i * 360 / LAYERS) | 0
+    });
+}
+
+function setOpaque(opaque) {
+    for (var i = 0; i < layers.length; i++) {
+        layers[i].canvas.opaque = opaque;
+    }
+}
+
+function run(opaque, done) {
+    var frame = 0;
+    var pixels = 0, composed = 0, culled = 0;
+    var start;
+
+    setOpaque(opaque);
+
+    var step = function() {
+        var stats = document.getCompositionStats();
+
+        if (frame > 0) {
+            pixels += stats.pixels;
+            composed += stats.composed;
+            culled += stats.culled;
+        } else {
+            start = Date.now();
+        }
+
+        if (frame++ == FRAMES) {
+            var elapsed = Date.now() - start;
+
+            console.log((opaque ? "[opaque]      " : "[transparent] ") +
+                (elapsed / FRAMES).toFixed(2) + " ms/frame, " +
+                (composed / FRAMES).toFixed(1) + " layers composed, " +
+                (culled / FRAMES).toFixed(1) + " culled, " +
+                ((pixels / FRAMES) / 1e6).toFixed(2) + " Mpx/frame");
+
+            done();
+            return;
+        }
+
+        /* Damage the whole stack */
+        for (var i = 0; i < layers.length; i++) {
+            var l = layers[i];
+            l.ctx.fillStyle = "hsl(" + ((l.hue + frame) % 360) + ", 60%, 50%)";
+            l.ctx.fillRect(0, 0, l.canvas.width, l.canvas.height);
+        }
+
+        window.requestAnimationFrame(step);
+    };
+
+    window.requestAnimationFrame(step);
+}
+
+run(false, function() {
+    run(true, function() {
+        window.quit();
+    });
+});
@@ -0,0 +1,123 @@
+/*
+   Copyright 2016 Nidium Inc. All rights reserved.
+   Use of this source code is governed by a MIT license
+   that can be found in the LICENSE file.
+*/
+
+/*
+    Receive path throughput against a local echo server.
+
+    The client sends WINDOW bytes and then echoes back everything it
+    receives, so that WINDOW bytes are always in flight. Each run lasts
+    DURATION ms and is done with :
+     - string    : data is decoded to a string
+     - binary    : a new ArrayBuffer is allocated for every packet
+     - pooled    : packets are received in pooled buffers (Socket.bufferPool)
+     - coalesced : packets of a loop iteration are handed to a single
+                   onread call (Socket.coalesce)
+*/
+
+var PORT = 9090;
+var WINDOW = 256 * 1024;
+var CHUNK = 16 * 1024;
+var DURATION = 5000;
+
+var MODES = ["string", "binary", "pooled", "coalesced"];
+
+function setMode(socket, mode) {
+    socket.binary = (mode != "string");
+    socket.bufferPool = (mode == "pooled");
+    socket.coalesce = (mode == "coalesced");
+}
+
+/* Call fn for each packet, coalesced reads are an array of packets */
+function forEachPacket(mode, data, fn) {
+    if (mode == "coalesced") {
+        data.forEach(fn);
+    } else {
+        fn(data);
+    }
+}
+
+function run(idx) {
+    if (idx == MODES.length) {
+        console.log("done");
+        return;
+    }
+
+    var mode = MODES[idx];
+    var port = PORT + idx;
+    var received = 0;
+    var packets = 0;
+    var running = true;
+
+    var server = new Socket("127.0.0.1", port).listen();
+    setMode(server, mode);
+
+    server.onread = function(client, data) {
+        forEachPacket(mode, data, function(packet) {
+            client.write(packet);
+            if (mode == "pooled") {
+                server.release(packet);
+            }
+        });
+    }
+
+    var client = new Socket("127.0.0.1", port).connect();
+    setMode(client, mode);
+
+    client.onconnect = function() {
+        var chunk = mode == "string" ? "x".repeat(CHUNK)
+                                     : new ArrayBuffer(CHUNK);
+
+        for (var i = 0; i < WINDOW / CHUNK; i++) {
+            this.write(chunk);
+        }
+
+        var start = Date.now();
+
+        setTimeout(function() {
+            running = false;
+
+            var elapsed = (Date.now() - start) / 1000;
+            var mb = received / (1024 * 1024);
+
+            console.log("[" + mode + "] " + (mb / elapsed).toFixed(1) +
+                        " MB/s, " + (packets / elapsed).toFixed(0) +
+                        " packets/s");
+
+            if (mode == "pooled") {
+                console.log("[" + mode + "] client pool " +
+                            JSON.stringify(client.getBufferPoolStats()));
+                console.log("[" + mode + "] server pool " +
+                            JSON.stringify(server.getBufferPoolStats()));
+            }
+
+            console.log("[" + mode + "] client reads " +
+                        JSON.stringify(client.getReadStats()));
+
+            client.disconnect();
+
+            run(idx + 1);
+        }, DURATION);
+    }
+
+    client.onread = function(data) {
+        if (!running) {
+            return;
+        }
+
+        forEachPacket(mode, data, function(packet) {
+            received += packet.length || packet.byteLength;
+            packets++;
+
+            client.write(packet);
+
+            if (mode == "pooled") {
+                client.release(packet);
+            }
+        });
+    }
+}
+
+run(0);
@@ -0,0 +1,111 @@
+/*
+   Copyright 2016 Nidium Inc. All rights reserved.
+   Use of this source code is governed by a MIT license
+   that can be found in the LICENSE file.
+*/
+
+/*
+    Thread start latency and throughput.
+
+    Each run is done with :
+     - dedicated : Thread.setPoolSize(0), every job creates its own
+                   thread and runtime (previous behaviour)
+     - pooled    : jobs are run by warm workers (Thread.setPoolSize(4))
+
+    latency    : time between start() and oncomplete for a trivial job,
+                 one job at a time
+    throughput : jobs/s with CONCURRENCY jobs in flight
+*/
+
+var LATENCY_JOBS = 200;
+var THROUGHPUT_JOBS = 2000;
+var CONCURRENCY = 4;
+
+var RUNS = [
+    { name: "dedicated", size: 0 },
+    { name: "pooled", size: 4 }
+];
+
+function job(n) {
+    return n * 2;
+}
+
+function latency(run, done) {
+    var count = 0;
+    var total = 0;
+
+    var next = function() {
+        if (count == LATENCY_JOBS) {
+            console.log("[" + run.name + "] latency " +
+                        (total / LATENCY_JOBS).toFixed(3) + " ms/job");
+            done();
+            return;
+        }
+
+        var t = new Thread(job);
+        var start = Date.now();
+
+        t.oncomplete = function() {
+            total += Date.now() - start;
+            count++;
+            next();
+        }
+
+        t.start(count);
+    }
+
+    next();
+}
+
+function throughput(run, done) {
+    var started = 0;
+    var completed = 0;
+    var start = Date.now();
+
+    var spawn = function() {
+        var t = new Thread(job);
+
+        t.oncomplete = function() {
+            completed++;
+
+            if (completed == THROUGHPUT_JOBS) {
+                var elapsed = (Date.now() - start) / 1000;
+
+                console.log("[" + run.name + "] " +
+                            (THROUGHPUT_JOBS / elapsed).toFixed(0) +
+                            " jobs/s");
+                done();
+            } else if (started < THROUGHPUT_JOBS) {
+                spawn();
+            }
+        }
+
+        started++;
+        t.start(started);
+    }
+
+    for (var i = 0; i < CONCURRENCY; i++) {
+        spawn();
+    }
+}
+
+function run(idx) {
+    if (idx == RUNS.length) {
+        console.log("done");
+        return;
+    }
+
+    var current = RUNS[idx];
+
+    Thread.setPoolSize(current.size);
+
+    latency(current, function() {
+        throughput(current, function() {
+            console.log("[" + current.name + "] pool " +
+                        JSON.stringify(Thread.getPoolStats()));
+            run(idx + 1);
+        });
+    });
+}
+
+run(0);
@@ -0,0 +1,174 @@
+/*
+   Copyright 2016 Nidium Inc. All rights reserved.
+   Use of this source code is governed by a MIT license
+   that can be found in the LICENSE file.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "unittest.h"
+
+#include <Core/Utils.h>
+#include <AV/AudioVector.h>
+#include <AV/processor/Gain.h>
+#include <AV/processor/Delay.h>
+
+using Nidium::AV::AudioVector;
+using Nidium::AV::AudioProcessor;
+using Nidium::AV::AudioProcessorGain;
+using Nidium::AV::AudioProcessorDelay;
+
+#define FRAMES 256
+#define SAMPLE_RATE 44100
+
+static void FillFrames(float *buf, int frames, int seed)
+{
+    for (int i = 0; i < frames; i++) {
+        buf[i] = sinf((i + seed) * 0.01f);
+    }
+}
+
+static void ProcessPerSample(AudioProcessor *p, float *buf, int frames)
+{
+    for (int i = 0; i < frames; i++) {
+        p->process(&buf[i], &i);
+    }
+}
+
+TEST(AudioVector, Kernels)
+{
+    /* Odd size and unaligned start to exercise the scalar tail */
+    float dst[FRAMES + 3], src[FRAMES + 3];
+
+    for (int i = 0; i < FRAMES + 3; i++) {
+        dst[i] = i;
+        src[i] = 1;
+    }
+
+    AudioVector::Scale(&dst[1], 2, FRAMES + 1);
+    EXPECT_EQ(0, dst[0]);
+    EXPECT_EQ(2, dst[1]);
+    EXPECT_EQ(2 * (FRAMES + 1), dst[FRAMES + 1]);
+    EXPECT_EQ(FRAMES + 2, dst[FRAMES + 2]);
+
+    AudioVector::Mix(&dst[1], &src[1], FRAMES + 1);
+    EXPECT_EQ(3, dst[1]);
+    EXPECT_EQ(2 * (FRAMES + 1) + 1, dst[FRAMES + 1]);
+
+    AudioVector::MixScaled(&dst[1], &src[1], 0.5, FRAMES + 1);
+    EXPECT_EQ(3.5, dst[1]);
+    EXPECT_EQ(0, dst[0]);
+}
+
+TEST(AudioProcessor, GainBlock)
+{
+    float block[FRAMES], sample[FRAMES];
+    AudioProcessorGain gain;
+
+    gain.setGain(0.5);
+
+    FillFrames(block, FRAMES, 0);
+    FillFrames(sample, FRAMES, 0);
+
+    gain.process(block, FRAMES);
+    ProcessPerSample(&gain, sample, FRAMES);
+
+    for (int i = 0; i < FRAMES; i++) {
+        EXPECT_FLOAT_EQ(sample[i], block[i]);
+    }
+}
+
+TEST(AudioProcessor, DelayBlock)
+{
+    float block[FRAMES], sample[FRAMES];
+    AudioProcessorDelay delayBlock(SAMPLE_RATE, 2000);
+    AudioProcessorDelay delaySample(SAMPLE_RATE, 2000);
+
+    /* 1ms is shorter than a block, the delay line is read and written within
+     * the same callback */
+    delayBlock.setDelay(1);
+    delaySample.setDelay(1);
+    delayBlock.setFeedback(0.5);
+    delaySample.setFeedback(0.5);
+
+    for (int n = 0; n < 2000; n++) {
+        FillFrames(block, FRAMES, n * FRAMES);
+        FillFrames(sample, FRAMES, n * FRAMES);
+
+        delayBlock.process(block, FRAMES);
+        ProcessPerSample(&delaySample, sample, FRAMES);
+
+        for (int i = 0; i < FRAMES; i++) {
+            ASSERT_NEAR(sample[i], block[i], 1e-5);
+        }
+    }
+}
+
+/*
+    How many processor nodes can be run within the time budget of a single
+    audio callback (FRAMES at SAMPLE_RATE), with the per sample fallback and
+    with the block API.
+*/
+TEST(AudioProcessor, DISABLED_BenchNodesPerCallback)
+{
+    const int nodes = 64;
+    const int iterations = 200;
+    const double budget = (double)FRAMES / SAMPLE_RATE * 1e9;
+
+    for (int mode = 0; mode < 2; mode++) {
+        AudioProcessor *processors[nodes][2];
+        float *frames[2];
+
+        for (int c = 0; c < 2; c++) {
+            frames[c] = static_cast<float *>(malloc(FRAMES * sizeof(float)));
+            FillFrames(frames[c], FRAMES, c);
+        }
+
+        for (int i = 0; i < nodes; i++) {
+            for (int c = 0; c < 2; c++) {
+                if (i % 2) {
+                    AudioProcessorGain *gain = new AudioProcessorGain();
+                    gain->setGain(0.99);
+                    processors[i][c] = gain;
+                } else {
+                    AudioProcessorDelay *delay
+                        = new AudioProcessorDelay(SAMPLE_RATE, 2000);
+                    delay->setDelay(20);
+                    processors[i][c] = delay;
+                }
+            }
+        }
+
+        uint64_t start = Nidium::Core::Utils::GetTick();
+
+        for (int n = 0; n < iterations; n++) {
+            for (int i = 0; i < nodes; i++) {
+                for (int c = 0; c < 2; c++) {
+                    if (mode == 0) {
+                        ProcessPerSample(processors[i][c], frames[c], FRAMES);
+                    } else {
+                        processors[i][c]->process(frames[c], FRAMES);
+                    }
+                }
+            }
+        }
+
+        uint64_t elapsed = Nidium::Core::Utils::GetTick() - start;
+        double perNode = (double)elapsed / (iterations * nodes);
+
+        printf("[%s] %8.1f ns/node, %8.0f nodes per %d frames callback\n",
+               mode == 0 ? "per-sample" : "block     ", perNode,
+               budget / perNode, FRAMES);
+
+        for (int i = 0; i < nodes; i++) {
+            for (int c = 0; c < 2; c++) {
+                delete processors[i][c];
+            }
+        }
+
+        for (int c = 0; c < 2; c++) {
+            free(frames[c]);
+        }
+    }
+}
@@ -75,6 +75,97 @@ TEST(DB, Del)
     delete db;
 }
 
+TEST(DB, Batch)
+{
+    std::string ret;
+    class Nidium::Core::DB *db = new Nidium::Core::DB("testrun");
+    Nidium::Core::DBBatch batch;
+
+    batch.set("batch:a", "1");
+    batch.set("batch:b", "2");
+    batch.set("pernod", "3");
+    batch.del("pernod");
+    EXPECT_EQ(batch.count(), 4);
+
+    EXPECT_TRUE(db->write(&batch));
+
+    EXPECT_TRUE(db->get("batch:a", ret));
+    EXPECT_TRUE(ret == "1");
+    EXPECT_TRUE(db->get("batch:b", ret));
+    EXPECT_TRUE(ret == "2");
+    EXPECT_FALSE(db->get("pernod", ret));
+
+    delete db;
+}
+
+TEST(DB, Range)
+{
+    Nidium::Core::DBEntries entries;
+    Nidium::Core::DBRange range;
+    class Nidium::Core::DB *db = new Nidium::Core::DB("testrun");
+
+    db->set("range:1", "a");
+    db->set("range:2", "b");
+    db->set("range:3", "c");
+    db->set("rangf", "d");
+
+    range.m_Prefix = "range:";
+    EXPECT_TRUE(db->range(range, entries));
+    EXPECT_EQ(entries.size(), 3);
+    EXPECT_TRUE(entries[0].first == "range:1");
+    EXPECT_TRUE(entries[2].second == "c");
+
+    entries.clear();
+    range.m_Start = "range:2";
+    range.m_End   = "range:3";
+    EXPECT_TRUE(db->range(range, entries));
+    EXPECT_EQ(entries.size(), 1);
+    EXPECT_TRUE(entries[0].first == "range:2");
+
+    entries.clear();
+    range          = Nidium::Core::DBRange();
+    range.m_Start  = "range:";
+    range.m_Limit  = 2;
+    range.m_KeysOnly = true;
+    EXPECT_TRUE(db->range(range, entries));
+    EXPECT_EQ(entries.size(), 2);
+    EXPECT_TRUE(entries[1].first == "range:2");
+    EXPECT_TRUE(entries[1].second.length() == 0);
+
+    int count = 0;
+    Nidium::Core::DBIterator *it = db->iteratePrefix("range:");
+    for (; it->valid(); it->next()) {
+        count++;
+    }
+    delete it;
+    EXPECT_EQ(count, 3);
+
+    delete db;
+}
+
+TEST(DB, Snapshot)
+{
+    std::string ret;
+    class Nidium::Core::DB *db = new Nidium::Core::DB("testrun");
+
+    db->set("snapshot", "before");
+
+    Nidium::Core::DBSnapshot *snapshot = db->getSnapshot();
+    EXPECT_TRUE(snapshot != NULL);
+
+    db->set("snapshot", "after");
+
+    EXPECT_TRUE(db->get("snapshot", ret, snapshot));
+    EXPECT_TRUE(ret == "before");
+
+    EXPECT_TRUE(db->get("snapshot", ret));
+    EXPECT_TRUE(ret == "after");
+
+    db->releaseSnapshot(snapshot);
+
+    delete db;
+}
+
 TEST(DB, Cleanup)
 {
     std::string ret;
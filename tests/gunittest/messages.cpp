@@ -47,3 +47,23 @@ TEST(Messages, Simple)
     delete m;
 }
 
+
+class NamedMessages : public Nidium::Core::Messages
+{
+public:
+    NamedMessages(const char *name)
+    {
+        if (name) {
+            this->setStatsName(name);
+        }
+    }
+};
+
+TEST(Messages, StatsName)
+{
+    NamedMessages unnamed(NULL);
+    NamedMessages named("NamedMessages");
+
+    EXPECT_STREQ(unnamed.getStatsName(), "Messages");
+    EXPECT_STREQ(named.getStatsName(), "NamedMessages");
+}
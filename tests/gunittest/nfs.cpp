@@ -3,11 +3,18 @@
    Use of this source code is governed by a MIT license
    that can be found in the LICENSE file.
 */
+#include <stdio.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
 
 #include "unittest.h"
 
+#include <Core/Utils.h>
 #include <IO/NFS.h>
 
 
@@ -20,3 +27,241 @@ TEST(NFS, Simple)
     delete nfs;
 }
 
+
+static const char *NFS_FILES[][2] = {
+    { "/lib/a.js", "var a = 1;" },
+    { "/lib/b.js", "var b = 2;" },
+    { "/lib/sub/c.txt", "hello" },
+    { "/main.js", "require('lib/a.js');" },
+};
+
+static Nidium::IO::NFS *BuildNFS()
+{
+    Nidium::IO::NFS *nfs = new Nidium::IO::NFS();
+
+    EXPECT_TRUE(nfs->mkdir("/lib", 4));
+    EXPECT_TRUE(nfs->mkdir("/lib/sub", 8));
+
+    for (size_t i = 0; i < sizeof(NFS_FILES) / sizeof(NFS_FILES[0]); i++) {
+        EXPECT_TRUE(nfs->writeFile(NFS_FILES[i][0], strlen(NFS_FILES[i][0]),
+                                   const_cast<char *>(NFS_FILES[i][1]),
+                                   strlen(NFS_FILES[i][1]),
+                                   Nidium::IO::NFS::kNFSFileType_Text));
+    }
+
+    return nfs;
+}
+
+static void CheckNFS(Nidium::IO::NFS *nfs)
+{
+    for (size_t i = 0; i < sizeof(NFS_FILES) / sizeof(NFS_FILES[0]); i++) {
+        size_t len = 0;
+        int flags  = 0;
+        const char *data = nfs->readFile(NFS_FILES[i][0], &len, &flags);
+
+        ASSERT_TRUE(data != NULL);
+        EXPECT_EQ(strlen(NFS_FILES[i][1]), len);
+        EXPECT_EQ(0, memcmp(data, NFS_FILES[i][1], len));
+        EXPECT_EQ(Nidium::IO::NFS::kNFSFileType_Text, flags);
+        EXPECT_EQ(1, nfs->exists(NFS_FILES[i][0]));
+    }
+
+    size_t len;
+    EXPECT_EQ(2, nfs->exists("/lib"));
+    EXPECT_EQ(2, nfs->exists("/lib/sub"));
+    EXPECT_EQ(0, nfs->exists("/nope.js"));
+    EXPECT_TRUE(nfs->readFile("/lib", &len) == NULL);
+    EXPECT_TRUE(nfs->readFile("/lib/c.txt", &len) == NULL);
+}
+
+TEST(NFS, Index)
+{
+    char path[] = "/tmp/nidium-nfs-XXXXXX";
+    int fd = mkstemp(path);
+    ASSERT_TRUE(fd != -1);
+    close(fd);
+
+    Nidium::IO::NFS *nfs = BuildNFS();
+    CheckNFS(nfs);
+    EXPECT_TRUE(nfs->save(path));
+    delete nfs;
+
+    nfs = Nidium::IO::NFS::Open(path);
+    ASSERT_TRUE(nfs != NULL);
+    CheckNFS(nfs);
+
+    /* Indexed archives are read-only */
+    EXPECT_FALSE(nfs->mkdir("/foo", 4));
+
+    delete nfs;
+
+    unlink(path);
+}
+
+/* Patch every index entry of the archive at |path| */
+static void CorruptNFSIndex(const char *path, bool filename, bool size)
+{
+    FILE *fp = fopen(path, "r+b");
+    ASSERT_TRUE(fp != NULL);
+
+    std::vector<uint8_t> data;
+    int c;
+    while ((c = fgetc(fp)) != EOF) {
+        data.push_back(static_cast<uint8_t>(c));
+    }
+
+    struct Nidium::IO::nfs_header_s header;
+    memcpy(&header, &data[0], sizeof(header));
+
+    for (uint32_t i = 0; i < header.numfiles; i++) {
+        struct Nidium::IO::nfs_index_entry_s entry;
+        size_t pos = sizeof(header) + i * sizeof(entry);
+
+        memcpy(&entry, &data[pos], sizeof(entry));
+
+        if (filename) {
+            /* Drop the null terminator */
+            data[entry.filename_offset + entry.filename_length] = 'x';
+        }
+
+        if (size) {
+            /* offset + size wraps around */
+            entry.size = UINT64_MAX - entry.offset + 2;
+        }
+
+        memcpy(&data[pos], &entry, sizeof(entry));
+    }
+
+    rewind(fp);
+    EXPECT_EQ(data.size(), fwrite(&data[0], 1, data.size(), fp));
+    fclose(fp);
+}
+
+TEST(NFS, IndexCorrupted)
+{
+    for (int i = 0; i < 2; i++) {
+        char path[] = "/tmp/nidium-nfs-XXXXXX";
+        int fd = mkstemp(path);
+        ASSERT_TRUE(fd != -1);
+        close(fd);
+
+        Nidium::IO::NFS *nfs = BuildNFS();
+        EXPECT_TRUE(nfs->save(path));
+        delete nfs;
+
+        CorruptNFSIndex(path, i == 0, i == 1);
+
+        nfs = Nidium::IO::NFS::Open(path);
+        ASSERT_TRUE(nfs != NULL);
+
+        for (size_t j = 0; j < sizeof(NFS_FILES) / sizeof(NFS_FILES[0]); j++) {
+            size_t len;
+            EXPECT_TRUE(nfs->readFile(NFS_FILES[j][0], &len) == NULL);
+        }
+
+        delete nfs;
+
+        unlink(path);
+    }
+}
+
+TEST(NFS, Tree)
+{
+    char path[] = "/tmp/nidium-nfs-XXXXXX";
+    int fd = mkstemp(path);
+    ASSERT_TRUE(fd != -1);
+    close(fd);
+
+    Nidium::IO::NFS *nfs = BuildNFS();
+    EXPECT_TRUE(nfs->save(path, NIDIUM_NFS_VERSION_TREE));
+    delete nfs;
+
+    nfs = Nidium::IO::NFS::Open(path);
+    ASSERT_TRUE(nfs != NULL);
+    CheckNFS(nfs);
+    delete nfs;
+
+    EXPECT_TRUE(Nidium::IO::NFS::Open("/tmp/nidium-nfs-does-not-exist") == NULL);
+
+    unlink(path);
+}
+
+static long NFSResidentKB()
+{
+    long size = 0, resident = 0;
+    FILE *fp = fopen("/proc/self/statm", "r");
+
+    if (!fp) {
+        return 0;
+    }
+
+    if (fscanf(fp, "%ld %ld", &size, &resident) != 2) {
+        resident = 0;
+    }
+
+    fclose(fp);
+
+    return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+/*
+    Load a large archive (a framework of 20k files) with both formats :
+    time to open the archive, heap/RSS growth and lookup time
+*/
+TEST(NFS, DISABLED_BenchLoad)
+{
+    const int nfiles = 20000;
+    char content[2048];
+    char path[] = "/tmp/nidium-nfs-XXXXXX";
+    int fd = mkstemp(path);
+    ASSERT_TRUE(fd != -1);
+    close(fd);
+
+    memset(content, 'x', sizeof(content));
+
+    std::vector<std::string> names;
+
+    for (int i = 0; i < nfiles; i++) {
+        char name[64];
+        snprintf(name, sizeof(name), "/framework/module%05d.js", i);
+        names.push_back(name);
+    }
+
+    int versions[] = { NIDIUM_NFS_VERSION_TREE, NIDIUM_NFS_VERSION_INDEX };
+
+    for (int version : versions) {
+        Nidium::IO::NFS *writer = new Nidium::IO::NFS();
+        writer->mkdir("/framework", 10);
+
+        for (auto &name : names) {
+            writer->writeFile(name.c_str(), name.length(), content,
+                              sizeof(content));
+        }
+
+        writer->save(path, version);
+        delete writer;
+
+        long rss         = NFSResidentKB();
+        uint64_t start   = Nidium::Core::Utils::GetTick();
+        Nidium::IO::NFS *nfs = Nidium::IO::NFS::Open(path);
+        uint64_t opened  = Nidium::Core::Utils::GetTick();
+        long rssOpened   = NFSResidentKB();
+
+        ASSERT_TRUE(nfs != NULL);
+
+        size_t len;
+        for (auto &name : names) {
+            ASSERT_TRUE(nfs->readFile(name.c_str(), &len) != NULL);
+        }
+
+        uint64_t looked = Nidium::Core::Utils::GetTick();
+
+        printf("[v%d] open %8.2f ms, RSS +%6ld KB, lookup %6.0f ns/file\n",
+               version, (opened - start) / 1e6, rssOpened - rss,
+               (double)(looked - opened) / nfiles);
+
+        delete nfs;
+    }
+
+    unlink(path);
+}
@@ -0,0 +1,160 @@
+/*
+   Copyright 2016 Nidium Inc. All rights reserved.
+   Use of this source code is governed by a MIT license
+   that can be found in the LICENSE file.
+*/
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "unittest.h"
+
+#include <Core/Pool.h>
+#include <Core/SharedMessages.h>
+
+TEST(Pool, Reuse)
+{
+    Nidium::Core::Pool::Stats before, after;
+    void *ptr, *ptr2;
+
+    Nidium::Core::Pool::GetStats(&before);
+
+    ptr = Nidium::Core::Pool::Alloc(100);
+    EXPECT_TRUE(ptr != NULL);
+    Nidium::Core::Pool::Free(ptr, 100);
+
+    /* Same size class, same thread : the block is recycled */
+    ptr2 = Nidium::Core::Pool::Alloc(120);
+    EXPECT_EQ(ptr, ptr2);
+    Nidium::Core::Pool::Free(ptr2, 120);
+
+    /* Oversized allocations go straight to malloc() */
+    ptr = Nidium::Core::Pool::Alloc(4096);
+    EXPECT_TRUE(ptr != NULL);
+    Nidium::Core::Pool::Free(ptr, 4096);
+
+    for (int i = 0; i < Nidium::Core::Pool::kBatchSize; i++) {
+        Nidium::Core::Pool::Free(Nidium::Core::Pool::Alloc(32), 32);
+    }
+
+    Nidium::Core::Pool::GetStats(&after);
+    EXPECT_TRUE(after.reused > before.reused);
+}
+
+static void *releaseMessages(void *arg)
+{
+    Nidium::Core::SharedMessages *messages
+        = static_cast<Nidium::Core::SharedMessages *>(arg);
+    Nidium::Core::SharedMessages::Message *msg;
+
+    while ((msg = messages->readMessage())) {
+        delete msg;
+    }
+
+    return NULL;
+}
+
+TEST(Pool, CrossThread)
+{
+    Nidium::Core::SharedMessages messages;
+    Nidium::Core::Pool::Stats before, after;
+    pthread_t thread;
+    int count = Nidium::Core::Pool::kBatchSize * 4;
+
+    /* Messages are released by another thread and handed back in batches */
+    for (int i = 0; i < count; i++) {
+        messages.postMessage(static_cast<uint64_t>(i), 1);
+    }
+
+    pthread_create(&thread, NULL, releaseMessages, &messages);
+    pthread_join(thread, NULL);
+
+    EXPECT_FALSE(messages.hasPendingMessages());
+
+    Nidium::Core::Pool::GetStats(&before);
+
+    for (int i = 0; i < count; i++) {
+        messages.postMessage(static_cast<uint64_t>(i), 1);
+    }
+
+    Nidium::Core::Pool::GetStats(&after);
+
+    /* At least the batches handed back at thread exit are reused */
+    EXPECT_TRUE(after.reused - before.reused
+                >= static_cast<uint64_t>(Nidium::Core::Pool::kBatchSize));
+}
+
+
+struct PoolConsumer
+{
+    void *blocks[32];
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    bool freed;
+    bool done;
+};
+
+static void *releaseBlocks(void *arg)
+{
+    PoolConsumer *consumer = static_cast<PoolConsumer *>(arg);
+
+    for (int i = 0; i < 32; i++) {
+        Nidium::Core::Pool::Free(consumer->blocks[i], 500);
+    }
+
+    /* Stay alive : the blocks must be handed back before the thread exits */
+    pthread_mutex_lock(&consumer->lock);
+    consumer->freed = true;
+    pthread_cond_signal(&consumer->cond);
+    while (!consumer->done) {
+        pthread_cond_wait(&consumer->cond, &consumer->lock);
+    }
+    pthread_mutex_unlock(&consumer->lock);
+
+    return NULL;
+}
+
+TEST(Pool, ConsumerThread)
+{
+    PoolConsumer consumer;
+    pthread_t thread;
+    void *ptr;
+    bool found = false;
+
+    pthread_mutex_init(&consumer.lock, NULL);
+    pthread_cond_init(&consumer.cond, NULL);
+    consumer.freed = false;
+    consumer.done  = false;
+
+    for (int i = 0; i < 32; i++) {
+        consumer.blocks[i] = Nidium::Core::Pool::Alloc(500);
+    }
+
+    pthread_create(&thread, NULL, releaseBlocks, &consumer);
+
+    pthread_mutex_lock(&consumer.lock);
+    while (!consumer.freed) {
+        pthread_cond_wait(&consumer.cond, &consumer.lock);
+    }
+    pthread_mutex_unlock(&consumer.lock);
+
+    /* A thread that only frees doesn't keep the blocks for itself */
+    ptr = Nidium::Core::Pool::Alloc(500);
+    for (int i = 0; i < 32; i++) {
+        if (consumer.blocks[i] == ptr) {
+            found = true;
+        }
+    }
+    EXPECT_TRUE(found);
+    Nidium::Core::Pool::Free(ptr, 500);
+
+    pthread_mutex_lock(&consumer.lock);
+    consumer.done = true;
+    pthread_cond_signal(&consumer.cond);
+    pthread_mutex_unlock(&consumer.lock);
+
+    pthread_join(thread, NULL);
+
+    pthread_mutex_destroy(&consumer.lock);
+    pthread_cond_destroy(&consumer.cond);
+}
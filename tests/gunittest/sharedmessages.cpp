@@ -5,10 +5,16 @@
 */
 #include <stdlib.h>
 #include <string.h>
+#include <pthread.h>
 
 #include "unittest.h"
 
+#include <ape_netlib.h>
+
 #include <Core/SharedMessages.h>
+#include <Core/Messages.h>
+#include <Core/TaskManager.h>
+#include <Core/Utils.h>
 
 TEST(SharedMessages, Simple)
 {
@@ -56,3 +62,186 @@ TEST(SharedMessages, constuctorIntMessage)
 
 }
 
+TEST(SharedMessages, LockFreeQueue)
+{
+    struct dummy d1, d2;
+    Nidium::Core::SharedMessages::Message *msg;
+    Nidium::Core::SharedMessages m(
+        Nidium::Core::SharedMessages::kQueue_LockFree);
+
+    EXPECT_FALSE(m.hasPendingMessages());
+
+    for (int i = 0; i < 4; i++) {
+        msg = new Nidium::Core::SharedMessages::Message(i, 15,
+                                                        i % 2 ? &d2 : &d1);
+        if (i == 3) {
+            msg->setForceAsync();
+        }
+        m.postMessage(msg);
+    }
+
+    EXPECT_TRUE(m.hasPendingMessages());
+    EXPECT_TRUE(m.hasAsyncMessages());
+
+    /* Messages are read in FIFO order */
+    msg = m.readMessage();
+    EXPECT_EQ(msg->dataUInt(), 0);
+    delete msg;
+
+    m.delMessagesForDest(&d1);
+
+    msg = m.readMessage();
+    EXPECT_EQ(msg->dataUInt(), 1);
+    delete msg;
+
+    /* Message 3 is async */
+    EXPECT_TRUE(m.readMessage(true) == NULL);
+    EXPECT_TRUE(m.hasAsyncMessages());
+
+    m.delMessagesForDest(&d2);
+
+    EXPECT_FALSE(m.hasAsyncMessages());
+    EXPECT_FALSE(m.hasPendingMessages());
+    EXPECT_TRUE(m.readMessage() == NULL);
+}
+
+struct benchProducer {
+    Nidium::Core::SharedMessages *messages;
+    int count;
+};
+
+static void *benchProducerThread(void *arg)
+{
+    struct benchProducer *producer = static_cast<struct benchProducer *>(arg);
+
+    for (int i = 0; i < producer->count; i++) {
+        producer->messages->postMessage(static_cast<uint64_t>(i), 1);
+    }
+
+    return NULL;
+}
+
+/*
+    Contention microbenchmark, mutex vs lock-free queue.
+    Run with : --gtest_also_run_disabled_tests --gtest_filter=*Bench*
+*/
+TEST(SharedMessages, DISABLED_BenchContention)
+{
+#define BENCH_MSG_PER_PRODUCER 200000
+    static const Nidium::Core::SharedMessages::QueueType types[] = {
+        Nidium::Core::SharedMessages::kQueue_Mutex,
+        Nidium::Core::SharedMessages::kQueue_LockFree
+    };
+
+    for (int producers = 1; producers <= 16; producers *= 2) {
+        for (int t = 0; t < 2; t++) {
+            Nidium::Core::SharedMessages m(types[t]);
+            pthread_t threads[16];
+            struct benchProducer producer = { &m, BENCH_MSG_PER_PRODUCER };
+            int total = producers * BENCH_MSG_PER_PRODUCER;
+            int read = 0;
+
+            uint64_t start = Nidium::Core::Utils::GetTick();
+
+            for (int i = 0; i < producers; i++) {
+                pthread_create(&threads[i], NULL, benchProducerThread,
+                               &producer);
+            }
+
+            while (read < total) {
+                Nidium::Core::SharedMessages::Message *msg = m.readMessage();
+                if (msg) {
+                    delete msg;
+                    read++;
+                }
+            }
+
+            for (int i = 0; i < producers; i++) {
+                pthread_join(threads[i], NULL);
+            }
+
+            uint64_t elapsed = Nidium::Core::Utils::GetTick() - start;
+
+            printf("[%s] %2d producers : %8.2f ms, %6.1f ns/msg\n",
+                   t == 0 ? "mutex   " : "lockfree", producers,
+                   elapsed / 1000000., static_cast<double>(elapsed) / total);
+
+            EXPECT_FALSE(m.hasPendingMessages());
+        }
+    }
+#undef BENCH_MSG_PER_PRODUCER
+}
+
+#define BENCH_LATENCY_COUNT 10000
+
+static void latencyTask(Nidium::Core::Task *task);
+
+class LatencyMessages : public Nidium::Core::Managed
+{
+public:
+    LatencyMessages() : m_Count(0), m_Total(0), m_Max(0)
+    {
+    }
+
+    void next()
+    {
+        Nidium::Core::Task *task = new Nidium::Core::Task();
+        task->setFunction(latencyTask);
+
+        this->addTask(task);
+    }
+
+    void onMessage(const Nidium::Core::SharedMessages::Message &msg)
+    {
+        uint64_t latency = Nidium::Core::Utils::GetTick() - msg.dataUInt();
+
+        m_Total += latency;
+        m_Max = nidium_max(m_Max, latency);
+
+        if (++m_Count == BENCH_LATENCY_COUNT) {
+            APE_loop_stop();
+            return;
+        }
+
+        this->next();
+    }
+
+    int m_Count;
+    uint64_t m_Total;
+    uint64_t m_Max;
+};
+
+static void latencyTask(Nidium::Core::Task *task)
+{
+    /* Runs in a worker thread, the message crosses back to the loop */
+    task->getObject()->postMessage(Nidium::Core::Utils::GetTick(), 1);
+}
+
+/*
+    Post-to-onMessage latency for messages sent by a TaskManager worker.
+    Run with : --gtest_also_run_disabled_tests --gtest_filter=*Bench*
+*/
+TEST(Messages, DISABLED_BenchWorkerLatency)
+{
+    ape_global *ape = APE_init();
+
+    Nidium::Core::TaskManager::CreateManager();
+    Nidium::Core::Messages::InitReader(ape);
+
+    LatencyMessages *obj = new LatencyMessages();
+    obj->next();
+
+    APE_loop_run(ape);
+
+    EXPECT_EQ(obj->m_Count, BENCH_LATENCY_COUNT);
+
+    printf("%d messages : avg %.2f us, max %.2f us\n", obj->m_Count,
+           obj->m_Total / 1000. / obj->m_Count, obj->m_Max / 1000.);
+
+    delete obj;
+
+    Nidium::Core::Messages::DestroyReader();
+    APE_destroy(ape);
+}
+#undef BENCH_LATENCY_COUNT
+
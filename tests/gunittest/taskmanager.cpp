@@ -5,6 +5,8 @@
 */
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
+#include <pthread.h>
 
 #include "unittest.h"
 
@@ -39,34 +41,194 @@ TEST(TaskManager, Task)
 }
 TEST(TaskManager, Managed)
 {
-    Nidium::Core::Task nt;
+    Nidium::Core::TaskManager::CreateManager();
+    Nidium::Core::Task *nt = new Nidium::Core::Task();
     Nidium::Core::Managed nm;
 
     EXPECT_EQ(nm.m_TaskQueued, 0);
-    nm.addTask(&nt);
+
+    /* The task is deleted once run */
+    dummy = 0;
+    nt->setFunction(dummyTask);
+    nm.addTask(nt);
+
+    while (nm.m_TaskQueued) {
+        usleep(1000);
+    }
+
+    EXPECT_EQ(dummy, 1);
+}
+
+TEST(TaskManager, ManagedDelete)
+{
+    Nidium::Core::TaskManager::CreateManager();
+
+    for (int i = 0; i < 100; i++) {
+        Nidium::Core::Managed *nm = new Nidium::Core::Managed();
+
+        for (int j = 0; j < 10; j++) {
+            Nidium::Core::Task *task = new Nidium::Core::Task();
+            task->setFunction(dummyTask);
+
+            nm->addTask(task);
+        }
+
+        /* Doesn't wait for a worker holding the object */
+        delete nm;
+    }
+}
+
+static int selfDeleted;
+
+void selfDeleteTask(Nidium::Core::Task *task)
+{
+    /* Runs with the tasks lock held */
+    delete task->getObject();
+    __sync_fetch_and_add(&selfDeleted, 1);
+}
+
+TEST(TaskManager, ManagedDeleteFromTask)
+{
+    Nidium::Core::TaskManager::CreateManager();
+
+    selfDeleted = 0;
+
+    for (int i = 0; i < 100; i++) {
+        Nidium::Core::Managed *nm = new Nidium::Core::Managed();
+        Nidium::Core::Task *task = new Nidium::Core::Task();
+
+        /* Queue both before the first one can run */
+        nm->lockTasks();
+
+        task->setFunction(selfDeleteTask);
+        nm->addTask(task);
+
+        /* Dropped along with the object */
+        task = new Nidium::Core::Task();
+        task->setFunction(dummyTask);
+        nm->addTask(task);
+
+        nm->unlockTasks();
+    }
+
+    for (int i = 0; i < 5000 && selfDeleted < 100; i++) {
+        usleep(1000);
+    }
+
+    EXPECT_EQ(selfDeleted, 100);
 }
 
 TEST(TaskManager, WorkerInfo)
 {
     Nidium::Core::TaskManager::workerInfo *wi = new Nidium::Core::TaskManager::workerInfo();
-    Nidium::Core::Task *t = new Nidium::Core::Task();
-    wi->addTask(t);
+    Nidium::Core::TaskManager::workerInfo *wi2 = new Nidium::Core::TaskManager::workerInfo();
+    Nidium::Core::TaskManager *tm;
+    Nidium::Core::ManagedHandle *handle;
+    Nidium::Core::Managed *nm = new Nidium::Core::Managed();
+    Nidium::Core::Managed *nm2 = new Nidium::Core::Managed();
+
+    Nidium::Core::TaskManager::CreateManager();
+    tm = Nidium::Core::TaskManager::GetManager();
+
+    wi->setManager(tm);
+    wi2->setManager(tm);
+
+    wi->push(nm);
+    wi->push(nm2);
+    EXPECT_EQ(wi->getQueueSize(), 2);
+
+    /* Owner pops the oldest, thieves take the newest */
+    handle = wi->pop(true);
+    EXPECT_EQ(handle->get(), nm2);
+    handle->release();
+
+    handle = wi->pop();
+    EXPECT_EQ(handle->get(), nm);
+    handle->release();
+
+    EXPECT_TRUE(wi->pop() == NULL);
+
+    wi2->push(nm);
+    EXPECT_TRUE(wi2->remove(nm));
+    EXPECT_FALSE(wi2->remove(nm));
+    EXPECT_EQ(wi2->getQueueSize(), 0);
 
-    delete t;
     delete wi;
+    delete wi2;
+    delete nm;
+    delete nm2;
 }
 
-TEST(TaksManager,  TaskManager)
+static int orderedCount;
+static int orderedErrors;
+
+void orderedTask(Nidium::Core::Task *task)
+{
+    if (task->m_Args[0].toInt() != orderedCount) {
+        orderedErrors++;
+    }
+    orderedCount++;
+}
+
+TEST(TaskManager, ManagedFIFO)
+{
+    Nidium::Core::TaskManager::CreateManager();
+    Nidium::Core::Managed *nm = new Nidium::Core::Managed();
+    int count = 1000;
+
+    orderedCount  = 0;
+    orderedErrors = 0;
+
+    for (int i = 0; i < count; i++) {
+        Nidium::Core::Task *task = new Nidium::Core::Task();
+        task->setFunction(orderedTask);
+        task->m_Args[0].set(static_cast<int64_t>(i));
+
+        nm->addTask(task);
+    }
+
+    while (nm->m_TaskQueued) {
+        usleep(1000);
+    }
+
+    EXPECT_EQ(orderedCount, count);
+    EXPECT_EQ(orderedErrors, 0);
+
+    delete nm;
+}
+
+static void *TaskManagerThread(void *arg)
 {
     int i;
     Nidium::Core::TaskManager::workerInfo * wi;
-    Nidium::Core::TaskManager *tm = Nidium::Core::TaskManager::GetManager();
+    Nidium::Core::TaskManager *tm;
+
+    Nidium::Core::TaskManager::CreateManager();
+    tm = Nidium::Core::TaskManager::GetManager();
 
-    tm->CreateManager();
+    /* The pool grows up to the number of CPUs */
+    int room = tm->getMaxWorkerCount() - tm->getWorkerCount();
     i = tm->createWorker();
-    EXPECT_EQ(i, 1);
+    EXPECT_EQ(i, room > 0 ? 1 : 0);
 
     tm->stopAll();
     wi = tm->getAvailableWorker();
+    EXPECT_TRUE(wi != NULL);
+
+    delete tm;
+
+    return NULL;
+}
+
+TEST(TaksManager,  TaskManager)
+{
+    pthread_t thread;
+
+    /*
+        Managers are per thread, use our own one :
+        stopAll() would stop the workers of the other tests
+    */
+    pthread_create(&thread, NULL, TaskManagerThread, NULL);
+    pthread_join(thread, NULL);
 }
 
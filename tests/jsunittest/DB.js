@@ -73,3 +73,109 @@ Tests.register("DB.drop", function() {
 
     db.close(); // noop
 });
+
+Tests.register("DB.batch", function() {
+    var db = new DB("private://tests");
+
+    db.set("batchDel", "bar");
+
+    db.batch([
+        {type: "set", key: "batch1", value: "foo"},
+        {type: "set", key: "batch2", value: {"foo": "bar"}},
+        {type: "delete", key: "batchDel"}
+    ]);
+
+    Assert.equal(db.get("batch1"), "foo");
+    Assert.equal(db.get("batch2").foo, "bar");
+    Assert.equal(db.get("batchDel"), undefined);
+
+    Assert.throws(function() {
+        db.batch([{type: "foo", key: "bar"}]);
+    });
+
+    db.close();
+});
+
+Tests.register("DB.range", function() {
+    var db = new DB("private://tests");
+
+    db.batch([
+        {type: "set", key: "range:1", value: 1},
+        {type: "set", key: "range:2", value: 2},
+        {type: "set", key: "range:3", value: 3},
+        {type: "set", key: "rangf", value: 4}
+    ]);
+
+    var entries = db.range({prefix: "range:"});
+    Assert.equal(entries.length, 3);
+    Assert.equal(entries[0].key, "range:1");
+    Assert.equal(entries[2].value, 3);
+
+    entries = db.range({start: "range:2", end: "range:3"});
+    Assert.equal(entries.length, 1);
+    Assert.equal(entries[0].key, "range:2");
+
+    var keys = db.range({prefix: "range:", limit: 2, keys: true});
+    Assert.equal(keys.length, 2);
+    Assert.equal(keys[1], "range:2");
+
+    db.close();
+});
+
+Tests.registerAsync("DB.set/get/delete (async)", function(next) {
+    var db = new DB("private://tests");
+
+    db.set("fooAsync", {"foo": "bar"}, function(err) {
+        Assert.equal(err, null);
+
+        db.get("fooAsync", function(err, value) {
+            Assert.equal(err, null);
+            Assert.equal(value.foo, "bar");
+
+            db.delete("fooAsync", function(err) {
+                Assert.equal(err, null);
+                Assert.equal(db.get("fooAsync"), undefined);
+
+                db.close();
+                next();
+            });
+        });
+    });
+}, 5000);
+
+Tests.registerAsync("DB.batch/range (async)", function(next) {
+    var db = new DB("private://tests");
+
+    db.batch([
+        {type: "set", key: "asyncRange:1", value: "a"},
+        {type: "set", key: "asyncRange:2", value: "b"}
+    ], function(err) {
+        Assert.equal(err, null);
+
+        db.range({prefix: "asyncRange:"}, function(err, entries) {
+            Assert.equal(err, null);
+            Assert.equal(entries.length, 2);
+            Assert.equal(entries[1].value, "b");
+
+            db.close();
+            next();
+        });
+    });
+}, 5000);
+
+Tests.registerAsync("DB.close (pending async operations)", function(next) {
+    // Closed in the background, don't reuse the other tests DB
+    var db = new DB("private://tests-pending");
+
+    db.set("fooPending", "bar", function(err) {
+        Assert.equal(err, null);
+        next();
+    });
+
+    // The pending set completes before the DB is closed
+    db.close();
+
+    Assert.throws(function() {
+        db.get("fooPending");
+    });
+}, 5000);
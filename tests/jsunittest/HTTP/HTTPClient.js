@@ -413,3 +413,139 @@ Tests.registerAsync("HTTP.request (multiple request)", function(next) {
 
     h.request();
 }, 4000);
+
+Tests.registerAsync("HTTP (connection pool)", function(next) {
+    var before = HTTP.getPoolStats();
+
+    new HTTP(HTTP_TEST_URL + "/hello", function(ev) {
+        Assert.equal(ev.data, "Hello World !", "Unexpected data");
+
+        setTimeout(function() {
+            new HTTP(HTTP_TEST_URL + "/hello", function(ev) {
+                Assert.equal(ev.data, "Hello World !", "Unexpected data");
+
+                var stats = HTTP.getPoolStats();
+
+                Assert(stats.reused > before.reused,
+                       "Expected the connection to be reused " + JSON.stringify(stats));
+                Assert(stats.reuseRate > 0, "Expected a reuse rate");
+
+                next();
+            });
+        }, 1);
+    });
+}, 4000);
+
+Tests.register("HTTP.setPoolOptions", function() {
+    HTTP.setPoolOptions({idleTimeout: 30000, maxPerHost: 8});
+
+    Assert.throws(function() {
+        HTTP.setPoolOptions();
+    });
+});
+
+Tests.registerAsync("HTTP.request (queued requests)", function(next) {
+    var h = new HTTP(HTTP_TEST_URL + "/hello");
+    var counter = 0;
+
+    h.addEventListener("error", function(err) {
+        throw new Error("Was not expecting an error event " + JSON.stringify(err));
+    });
+
+    h.addEventListener("response", function(ev) {
+        if (counter < 2) {
+            Assert.equal(ev.data, "Hello World !", "Unexpected data");
+        } else {
+            Assert.equal(ev.data, "hello", "Unexpected data");
+            next();
+        }
+
+        counter++;
+    });
+
+    h.request();
+    h.request();
+    h.request({path: "/http/echo", method: "POST", data: "hello"});
+}, 4000);
+
+Tests.registerAsync("HTTP.request (queued requests with callbacks)", function(next) {
+    var h = new HTTP(HTTP_TEST_URL + "/hello");
+    var first = false;
+
+    h.addEventListener("error", function(err) {
+        throw new Error("Was not expecting an error event " + JSON.stringify(err));
+    });
+
+    h.request({path: "/http/echo", method: "POST", data: "[1]", eval: false}, function(ev) {
+        Assert(!first, "First callback called twice");
+        Assert.equal(ev.data, "[1]", "Unexpected data");
+        Assert.equal(ev.type, "string", "Response shouldn't be evaluated");
+
+        first = true;
+    });
+
+    h.request({path: "/hello"}, function(ev) {
+        Assert(first, "Callbacks called out of order");
+        Assert.equal(ev.data, "Hello World !", "Unexpected data");
+
+        next();
+    });
+}, 4000);
+
+Tests.registerAsync("HTTP.request (pipelining)", function(next) {
+    var h = new HTTP(HTTP_TEST_URL + "/hello", {pipeline: true});
+    var counter = 0;
+
+    h.addEventListener("error", function(err) {
+        throw new Error("Was not expecting an error event " + JSON.stringify(err));
+    });
+
+    h.addEventListener("response", function(ev) {
+        testResponse(ev);
+        Assert.equal(ev.data, "Hello World !", "Unexpected data");
+
+        if (++counter == 5) {
+            next();
+        }
+    });
+
+    for (var i = 0; i < 5; i++) {
+        h.request();
+    }
+}, 4000);
+
+Tests.registerAsync("HTTP.request (stream)", function(next) {
+    var h = new HTTP(HTTP_TEST_URL + "/progress", {stream: true});
+    var received = 0;
+    var paused = false;
+
+    h.addEventListener("error", function(ev) {
+        throw new Error("Was not expecting an error event " + JSON.stringify(ev));
+    });
+
+    h.addEventListener("data", function(ev) {
+        Assert(!paused, "Received data while paused");
+        Assert(ev.data instanceof ArrayBuffer, "Expected an ArrayBuffer");
+
+        received += ev.data.byteLength;
+        Assert.equal(ev.read, received, "Invalid read count");
+
+        h.pause();
+        paused = true;
+
+        setTimeout(function() {
+            paused = false;
+            h.resume();
+        }, 10);
+    });
+
+    h.addEventListener("response", function(ev) {
+        testResponse(ev);
+        Assert(received > 0, "Expected data events");
+        Assert.equal(ev.data, null, "Body shouldn't be buffered");
+
+        next();
+    });
+
+    h.request();
+}, 5000);
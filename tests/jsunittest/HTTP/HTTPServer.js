@@ -15,3 +15,213 @@ Tests.register("HTTPServer constructor", function() {
     });
 });
 */
+
+Tests.registerAsync("HTTPServerResponse.sendFile", function(next) {
+    var server = new HTTPServer("127.0.0.1", 4243);
+
+    server.onrequest = function(req, res) {
+        if (req.url == "/missing") {
+            Assert.equal(res.sendFile("File/doesexists/missing.txt"), false);
+            res.writeHead(404);
+            res.end();
+            return;
+        }
+
+        Assert(res.sendFile("File/doesexists/simplefile.txt",
+                            {headers: {"Content-Type": "text/plain"}}));
+    }
+
+    var h = new HTTP("http://127.0.0.1:4243/file");
+    var counter = 0;
+
+    h.addEventListener("error", function(err) {
+        throw new Error("Was not expecting an error event " + JSON.stringify(err));
+    });
+
+    h.addEventListener("response", function(ev) {
+        if (counter++ == 0) {
+            Assert.equal(ev.data, "123456789");
+            Assert.equal(ev.headers["accept-ranges"], "bytes");
+            Assert.equal(ev.headers["content-type"], "text/plain");
+        } else {
+            Assert.equal(ev.statusCode, 404);
+            next();
+        }
+    });
+
+    h.request();
+    h.request({path: "/missing"});
+}, 5000);
+
+Tests.registerAsync("HTTPServerResponse.sendFile (range)", function(next) {
+    var server = new HTTPServer("127.0.0.1", 4244);
+
+    server.onrequest = function(req, res) {
+        res.sendFile("File/doesexists/simplefile.txt");
+    }
+
+    var h = new HTTP("http://127.0.0.1:4244/file");
+    var counter = 0;
+
+    h.addEventListener("error", function(err) {
+        throw new Error("Was not expecting an error event " + JSON.stringify(err));
+    });
+
+    h.addEventListener("response", function(ev) {
+        switch (counter++) {
+            case 0:
+                Assert.equal(ev.statusCode, 206);
+                Assert.equal(ev.data, "345");
+                Assert.equal(ev.headers["content-range"], "bytes 2-4/9");
+                break;
+            case 1:
+                Assert.equal(ev.statusCode, 206);
+                Assert.equal(ev.data, "89");
+                break;
+            case 2:
+                Assert.equal(ev.statusCode, 416);
+                Assert.equal(ev.headers["content-range"], "bytes */9");
+                next();
+                break;
+        }
+    });
+
+    h.request({headers: {"Range": "bytes=2-4"}});
+    h.request({headers: {"Range": "bytes=-2"}});
+    h.request({headers: {"Range": "bytes=20-"}});
+}, 5000);
+
+Tests.registerAsync("HTTPServer stream", function(next) {
+    var server = new HTTPServer("127.0.0.1", 4245, {stream: true});
+    var body = "x".repeat(256 * 1024);
+
+    server.onrequest = function(req, res) {
+        var received = 0;
+        var chunks = 0;
+
+        Assert.equal(req.method, "POST");
+        Assert.equal(req.data, undefined);
+
+        req.ondata = function(data) {
+            Assert(data instanceof ArrayBuffer);
+
+            received += data.byteLength;
+
+            /* Slow consumer */
+            if (chunks++ % 4 == 0) {
+                req.client.pause();
+                setTimeout(function() {
+                    req.client.resume();
+                }, 1);
+            }
+        }
+
+        req.onend = function() {
+            res.end(String(received));
+        }
+    }
+
+    var h = new HTTP("http://127.0.0.1:4245/upload");
+
+    h.addEventListener("error", function(err) {
+        throw new Error("Was not expecting an error event " + JSON.stringify(err));
+    });
+
+    h.addEventListener("response", function(ev) {
+        Assert.equal(ev.data, String(body.length));
+        next();
+    });
+
+    h.request({method: "POST", data: body});
+}, 5000);
+
+Tests.registerAsync("HTTPServer large response while paused", function(next) {
+    var server = new HTTPServer("127.0.0.1", 4247);
+    var body = "x".repeat(8 * 1024 * 1024);
+
+    server.onrequest = function(req, res) {
+        // Larger than the socket buffers : needs write readiness
+        req.client.pause();
+        res.end(body);
+    }
+
+    var h = new HTTP("http://127.0.0.1:4247/");
+
+    h.addEventListener("error", function(err) {
+        throw new Error("Was not expecting an error event " + JSON.stringify(err));
+    });
+
+    h.addEventListener("response", function(ev) {
+        Assert.equal(ev.data.length, body.length);
+        next();
+    });
+
+    h.request();
+}, 5000);
+
+Tests.registerAsync("HTTPServer request method and body", function(next) {
+    var server = new HTTPServer("127.0.0.1", 4248);
+
+    server.onrequest = function(req, res) {
+        res.end(req.method + ":" + req.data);
+    }
+
+    var h = new HTTP("http://127.0.0.1:4248/");
+    var expected = ["PUT:abc", "DELETE:undefined"];
+
+    h.addEventListener("error", function(err) {
+        throw new Error("Was not expecting an error event " + JSON.stringify(err));
+    });
+
+    h.addEventListener("response", function(ev) {
+        Assert.equal(ev.data, expected.shift());
+
+        if (expected.length == 0) {
+            next();
+        }
+    });
+
+    h.request({method: "PUT", data: "abc"});
+    h.request({method: "DELETE"});
+}, 5000);
+
+Tests.registerAsync("HTTPServer request (lazy)", function(next) {
+    var server = new HTTPServer("127.0.0.1", 4246);
+    var requests = [];
+
+    server.onrequest = function(req, res) {
+        requests.push(req);
+        res.end(req.method);
+    }
+
+    var h = new HTTP("http://127.0.0.1:4246/first");
+    var counter = 0;
+
+    h.addEventListener("error", function(err) {
+        throw new Error("Was not expecting an error event " + JSON.stringify(err));
+    });
+
+    h.addEventListener("response", function(ev) {
+        Assert.equal(ev.data, "GET");
+
+        if (++counter < 2) {
+            return;
+        }
+
+        /* Read once the connection moved on to the next request */
+        Assert.equal(requests[0].url, "/first");
+        Assert.equal(requests[0].headers["x-test"], "1");
+        Assert.equal(requests[0].headers["x-missing"], undefined);
+        Assert.equal(requests[1].url, "/second");
+        Assert(Object.keys(requests[1].headers).indexOf("x-test") != -1);
+        Assert.equal(JSON.parse(JSON.stringify(requests[1].headers))["x-test"], "2");
+
+        var stats = server.getStats();
+        Assert.equal(stats.requests, 2);
+
+        next();
+    });
+
+    h.request({headers: {"X-Test": "1"}});
+    h.request({path: "/second", headers: {"X-Test": "2"}});
+}, 5000);
@@ -58,3 +58,29 @@ Tests.register("process.setOwner(user, group)/getOwner", function() {
 Tests.register("process.cwd", function() {
     Assert.equal(global.__dirname.substr(0, global.__dirname.length -8), process.cwd());
 });
+
+Tests.register("process.getStats", function() {
+    var stats = process.getStats();
+
+    Assert.equal(typeof stats.pool.allocated, "number");
+    Assert.equal(typeof stats.pool.reused, "number");
+    Assert.equal(typeof stats.messages.handled, "number");
+    Assert.equal(typeof stats.messages.events, "object");
+});
+
+Tests.register("process.setMessagesStats", function() {
+    process.setMessagesStats(true);
+    Assert.equal(process.getStats().messages.statsEnabled, true);
+
+    process.setMessagesStats(false);
+    Assert.equal(process.getStats().messages.statsEnabled, false);
+});
+
+Tests.register("process.setMessagesBudget", function() {
+    Assert.throws(function() {
+        process.setMessagesBudget(0);
+    });
+
+    process.setMessagesBudget(64, 4);
+    process.setMessagesBudget(256, 0);
+});
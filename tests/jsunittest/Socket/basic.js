@@ -126,3 +126,96 @@ Tests.registerAsync("Socket lz4", function(next) {
     }
 
 }, 500);
+
+Tests.registerAsync("Socket buffer pool", function(next) {
+    var server = new Socket("127.0.0.1", 9030).listen();
+    var client = new Socket("127.0.0.1", 9030).connect();
+
+    server.binary = true;
+    server.bufferPool = 2;
+
+    Assert.equal(server.bufferPool, 2);
+
+    client.onconnect = function() {
+        this.write("hello");
+    }
+
+    server.onread = function(new_client, data) {
+        Assert(data instanceof Uint8Array);
+        Assert.equal(data.length, 5);
+        Assert.equal(String.fromCharCode.apply(null, data), "hello");
+
+        Assert.equal(this.getBufferPoolStats().inUse, 1);
+        Assert.equal(this.release(data), true);
+        Assert.equal(this.release(data), false);
+        Assert.equal(this.getBufferPoolStats().inUse, 0);
+
+        new_client.disconnect();
+        next();
+    }
+
+}, 500);
+
+Tests.registerAsync("Socket length prefix framing", function(next) {
+    var server = new Socket("127.0.0.1", 9031).listen();
+    var client = new Socket("127.0.0.1", 9031).connect();
+
+    client.binary = true;
+    client.framing = "uint16be";
+
+    Assert.equal(client.framing, "uint16be");
+
+    client.framing = "readline";
+    Assert.equal(client.readline, true);
+    Assert.equal(client.framing, "readline");
+
+    client.framing = "uint16be";
+
+    var messages = [];
+
+    server.onaccept = function(new_client) {
+        var data = new Uint8Array([0, 3, 1, 2, 3, 0, 0, 0, 2, 4]);
+
+        new_client.write(data.buffer);
+
+        setTimeout(function() {
+            new_client.write(new Uint8Array([5]).buffer);
+        }, 50);
+    }
+
+    client.onread = function(data) {
+        messages.push(Array.prototype.slice.call(new Uint8Array(data)));
+
+        if (messages.length == 3) {
+            Assert.equal(JSON.stringify(messages), "[[1,2,3],[],[4,5]]");
+            this.disconnect();
+            next();
+        }
+    }
+
+}, 500);
+
+Tests.registerAsync("Socket coalesce", function(next) {
+    var server = new Socket("127.0.0.1", 9032).listen();
+    var client = new Socket("127.0.0.1", 9032).connect();
+
+    client.readline = true;
+    client.coalesce = true;
+
+    server.onaccept = function(new_client) {
+        new_client.write("a\nb\nc\n");
+    }
+
+    client.onread = function(lines) {
+        Assert.equal(JSON.stringify(lines), '["a","b","c"]');
+
+        var stats = this.getReadStats();
+        Assert.equal(stats.messages, 3);
+        Assert.equal(stats.callbacks, 1);
+        Assert.equal(stats.saved, 2);
+
+        this.disconnect();
+        next();
+    }
+
+}, 500);
@@ -57,3 +57,230 @@ Tests.registerAsync("Thread (threaded errors)", function(next) {
     }, 300);
 
 }, 1000);
+
+Tests.registerAsync("Thread (non cloneable result)", function(next) {
+    var t = new Thread(function() {
+        return function() {};
+    });
+
+    t.oncomplete = function(e) {
+        Assert.equal(e.data, undefined);
+        next();
+    };
+
+    t.start();
+
+}, 1000);
+
+Tests.registerAsync("Thread (pool reuse)", function(next) {
+    // Compiled functions are cached per call site
+    var spawn = function() {
+        return new Thread(function(n) {
+            return n + 1;
+        });
+    };
+
+    var before = Thread.getPoolStats();
+
+    var first = spawn();
+    first.oncomplete = function(e) {
+        Assert.equal(e.data, 1);
+
+        // The worker is idle by the time oncomplete is fired
+        var second = spawn();
+        second.oncomplete = function(e) {
+            Assert.equal(e.data, 2);
+
+            var stats = Thread.getPoolStats();
+            Assert(stats.reused > before.reused);
+            Assert(stats.cacheHits > before.cacheHits);
+
+            next();
+        };
+
+        second.start(1);
+    };
+
+    first.start(0);
+
+}, 1000);
+
+Tests.registerAsync("Thread (jobs isolation)", function(next) {
+    var spawn = function() {
+        return new Thread(function(write) {
+            var seen = [typeof leakedGlobal, typeof this.leakedThis,
+                        typeof Math.max];
+
+            if (write) {
+                leakedGlobal = 1;
+                this.leakedThis = 1;
+                Math = null;
+            }
+
+            return seen.join(",");
+        });
+    };
+
+    var first = spawn();
+    first.oncomplete = function(e) {
+        Assert.equal(e.data, "undefined,undefined,function");
+
+        // Run by the same (now idle) worker
+        var second = spawn();
+        second.oncomplete = function(e) {
+            Assert.equal(e.data, "undefined,undefined,function");
+            next();
+        };
+
+        second.start(false);
+    };
+
+    first.start(true);
+
+}, 1000);
+
+Tests.registerAsync("Thread (transfer)", function(next) {
+    var t = new Thread(function(size) {
+        var sent = new ArrayBuffer(size);
+        new Uint8Array(sent)[0] = 42;
+
+        this.send(sent, [sent]);
+
+        var ret = new ArrayBuffer(size);
+        new Uint8Array(ret)[1] = 43;
+
+        this.transferOnComplete([ret]);
+
+        // Detached once transferred
+        return {"buffer": ret, "sentLength": sent.byteLength};
+    });
+
+    var gotMessage = false;
+
+    t.onmessage = function(ev) {
+        Assert.equal(ev.data.byteLength, 1024);
+        Assert.equal(new Uint8Array(ev.data)[0], 42);
+        gotMessage = true;
+    }
+
+    t.oncomplete = function(ev) {
+        Assert(gotMessage);
+        Assert.equal(ev.data.sentLength, 0);
+        Assert.equal(ev.data.buffer.byteLength, 1024);
+        Assert.equal(new Uint8Array(ev.data.buffer)[1], 43);
+        next();
+    };
+
+    t.start(1024);
+
+}, 1000);
+
+Tests.registerAsync("Thread (start with transfer)", function(next) {
+    var buffer = new ArrayBuffer(1024);
+    new Uint8Array(buffer)[0] = 42;
+
+    var t = new Thread(function(buffer, extra) {
+        return [buffer.byteLength, new Uint8Array(buffer)[0], extra];
+    });
+
+    t.oncomplete = function(ev) {
+        Assert.equal(ev.data.join(","), "1024,42,foo");
+        next();
+    };
+
+    t.startWithTransfer([buffer, "foo"], [buffer]);
+
+    // Moved to the thread
+    Assert.equal(buffer.byteLength, 0);
+
+    Assert.throws(function() {
+        new Thread(function() {}).startWithTransfer(1);
+    });
+
+}, 1000);
+
+Tests.registerAsync("Thread (shared memory)", function(next) {
+    var ia = new Int32Array(new SharedArrayBuffer(2 * 4));
+    var results = [];
+
+    var waiter = new Thread(function(ia) {
+        for (var i = 0; i < 10000; i++) {
+            Atomics.add(ia, 0, 1);
+        }
+
+        return Atomics.wait(ia, 1, 0, 5000);
+    });
+
+    var waker = new Thread(function(ia) {
+        for (var i = 0; i < 10000; i++) {
+            Atomics.add(ia, 0, 1);
+        }
+
+        Atomics.store(ia, 1, 1);
+        Atomics.wake(ia, 1);
+
+        return "done";
+    });
+
+    var complete = function(ev) {
+        results.push(ev.data);
+
+        if (results.length < 2) {
+            return;
+        }
+
+        Assert.equal(Atomics.load(ia, 0), 20000);
+        Assert.equal(ia[1], 1);
+        Assert(results.indexOf("timed-out") == -1);
+
+        next();
+    };
+
+    waiter.oncomplete = complete;
+    waker.oncomplete = complete;
+
+    waiter.start(ia);
+    waker.start(ia);
+
+}, 6000);
+
+Tests.registerAsync("Thread (shared memory in a message)", function(next) {
+    var ia = new Int32Array(new SharedArrayBuffer(4));
+
+    var t = new Thread(function(ia) {
+        // Nested SharedArrayBuffers are only shared when listed
+        this.send({"view": ia}, [ia.buffer]);
+    });
+
+    t.onmessage = function(ev) {
+        ev.data.view[0] = 42;
+        Assert.equal(ia[0], 42);
+
+        next();
+    };
+
+    t.start(ia);
+
+}, 1000);
+
+Tests.register("SharedArrayBuffer (instanceof)", function() {
+    var sab = new SharedArrayBuffer(4);
+
+    Assert(sab instanceof SharedArrayBuffer);
+    Assert(new Int32Array(sab).buffer instanceof SharedArrayBuffer);
+    Assert(!(new ArrayBuffer(4) instanceof SharedArrayBuffer));
+    Assert.equal(sab.byteLength, 4);
+});
+
+Tests.register("Atomics (main thread)", function() {
+    var ia = new Int32Array(new SharedArrayBuffer(4));
+
+    Assert.equal(Atomics.compareExchange(ia, 0, 0, 5), 0);
+    Assert.equal(Atomics.exchange(ia, 0, 7), 5);
+    Assert.equal(Atomics.sub(ia, 0, 2), 7);
+    Assert.equal(Atomics.load(ia, 0), 5);
+
+    Assert.throws(function() {
+        Atomics.wait(ia, 0, 5, 0);
+    });
+});